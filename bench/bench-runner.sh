@@ -0,0 +1,8 @@
+#!/bin/bash
+# runs every benchmark, passing the arguments on to each of them
+for fname in *Bench.o; do
+    echo ======================================
+    echo running benchmark: $fname
+    echo ======================================
+    ./$fname "$@" || exit 1
+done
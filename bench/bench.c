@@ -0,0 +1,210 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "bench.h"
+#include "hlsparse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Benchmark harness
+ *
+ * Every bench file defines setup() which calls bench() for each of its
+ * benchmarks. Results are printed as a table and, with -j <file>, appended
+ * to <file> as one JSON object per line so runs can be tracked over time.
+ * Runs are timed with clock_gettime, on Linux the CPU cycles spent in each
+ * run are also counted with perf_event_open when the kernel allows it,
+ * otherwise the cycle columns are left out.
+ */
+
+#define BENCH_MAX_ITERATIONS    1000000
+
+int bench_quick = 0;
+
+static double bench_min_time = 0.5;
+static FILE *bench_json = NULL;
+
+static uint64_t bench_allocs = 0;
+static uint64_t bench_alloc_bytes = 0;
+
+static void *bench_malloc(size_t size)
+{
+    ++bench_allocs;
+    bench_alloc_bytes += size;
+    return malloc(size);
+}
+
+static void bench_free(void *ptr)
+{
+    free(ptr);
+}
+
+static int bench_cycles_fd = -1;
+
+static void bench_cycles_open(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    bench_cycles_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if(bench_cycles_fd >= 0) {
+        ioctl(bench_cycles_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+static uint64_t bench_cycles(void)
+{
+    uint64_t count = 0;
+    if(bench_cycles_fd < 0 || read(bench_cycles_fd, &count, sizeof(count)) != sizeof(count)) {
+        return 0;
+    }
+    return count;
+}
+
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-q] [-t seconds] [-j file]\n", name);
+    fprintf(stderr, "  -q          skip the largest inputs\n");
+    fprintf(stderr, "  -t seconds  minimum time spent on each benchmark (default 0.5)\n");
+    fprintf(stderr, "  -j file     append the results to file as JSON lines\n");
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    for(i = 1; i < argc; ++i) {
+        if(!strcmp(argv[i], "-q")) {
+            bench_quick = 1;
+        } else if(!strcmp(argv[i], "-t") && i + 1 < argc) {
+            bench_min_time = atof(argv[++i]);
+        } else if(!strcmp(argv[i], "-j") && i + 1 < argc) {
+            bench_json = fopen(argv[++i], "a");
+            if(!bench_json) {
+                fprintf(stderr, "unable to open %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // count every allocation made by the library
+    hlsparse_global_init_mem(bench_malloc, bench_free);
+
+    bench_cycles_open();
+    if(bench_cycles_fd < 0) {
+        fprintf(stderr, "cpu cycles unavailable, timing with clock_gettime only\n");
+    }
+
+    setup();
+
+    if(bench_cycles_fd >= 0) {
+        close(bench_cycles_fd);
+    }
+    if(bench_json) {
+        fclose(bench_json);
+    }
+    return 0;
+}
+
+int bench(const bench_t *b)
+{
+    if(!b || !b->run || b->items <= 0) {
+        return 1;
+    }
+
+    // warm up the caches and the allocator before timing
+    b->run(b->ctx);
+    if(b->reset) {
+        b->reset(b->ctx);
+    }
+
+    uint64_t budget = (uint64_t)(bench_min_time * 1e9);
+    uint64_t total = 0;
+    uint64_t best = UINT64_MAX;
+    uint64_t cycles = 0;
+    uint64_t allocs = 0;
+    uint64_t alloc_bytes = 0;
+    int iterations = 0;
+
+    do {
+        uint64_t allocs_start = bench_allocs;
+        uint64_t bytes_start = bench_alloc_bytes;
+        uint64_t cycles_start = bench_cycles();
+        uint64_t start = bench_now();
+        b->run(b->ctx);
+        uint64_t elapsed = bench_now() - start;
+        cycles += bench_cycles() - cycles_start;
+        allocs += bench_allocs - allocs_start;
+        alloc_bytes += bench_alloc_bytes - bytes_start;
+
+        if(b->reset) {
+            b->reset(b->ctx);
+        }
+
+        total += elapsed;
+        if(elapsed < best) {
+            best = elapsed;
+        }
+        ++iterations;
+    } while(total < budget && iterations < BENCH_MAX_ITERATIONS);
+
+    double ns_per_op = (double)total / iterations;
+    double ns_per_item = ns_per_op / b->items;
+    double items_per_s = 1e9 / ns_per_item;
+    double mb_per_s = (double)b->bytes / ns_per_op * 1e3;
+    double allocs_per_op = (double)allocs / iterations;
+    double alloc_bytes_per_op = (double)alloc_bytes / iterations;
+
+    printf("%-14s %8d %-8s %10.2f MB/s %14.0f %s/s %10.1f ns/%s %12.1f allocs/op",
+           b->name, b->items, b->unit, mb_per_s, items_per_s, b->unit,
+           ns_per_item, b->unit, allocs_per_op);
+    if(bench_cycles_fd >= 0) {
+        printf(" %10.1f cycles/%s", (double)cycles / iterations / b->items, b->unit);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    if(bench_json) {
+        fprintf(bench_json, "{\"name\":\"%s\",\"unit\":\"%s\",\"items\":%d,\"bytes\":%zu,"
+                "\"iterations\":%d,\"ns_per_op\":%.1f,\"ns_per_op_min\":%llu,"
+                "\"mb_per_s\":%.3f,\"items_per_s\":%.1f,\"ns_per_item\":%.3f,"
+                "\"allocs_per_op\":%.1f,\"alloc_bytes_per_op\":%.1f,",
+                b->name, b->unit, b->items, b->bytes, iterations, ns_per_op,
+                (unsigned long long)best, mb_per_s, items_per_s, ns_per_item,
+                allocs_per_op, alloc_bytes_per_op);
+        if(bench_cycles_fd >= 0) {
+            fprintf(bench_json, "\"cycles_per_item\":%.2f,", (double)cycles / iterations / b->items);
+        }
+        fprintf(bench_json, "\"timestamp\":%lld}\n", (long long)time(NULL));
+    }
+
+    return 0;
+}
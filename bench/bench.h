@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void (*bench_fn_t)(void *ctx);
+
+/**
+ * Describes a single benchmark.
+ * 'run' is the timed operation, 'reset' is called after every run outside of
+ * the timed section and may be NULL.
+ * 'unit' names the items processed by one run, e.g. "segment" or "variant".
+ * 'bytes' is the size of the playlist text parsed or written by one run.
+ */
+typedef struct {
+    const char *name;
+    const char *unit;
+    int         items;
+    size_t      bytes;
+    bench_fn_t  run;
+    bench_fn_t  reset;
+    void       *ctx;
+} bench_t;
+
+/**
+ * Runs a benchmark, prints its results and appends them to the JSON output
+ * when one was requested on the command line.
+ *
+ * @returns 0 on success.
+ */
+int bench(const bench_t *b);
+
+/**
+ * Non-zero when the suite should skip its largest inputs (-q).
+ */
+extern int bench_quick;
+
+/**
+ * Registers and runs the benchmarks of a bench file.
+ */
+void setup(void);
+
+#endif
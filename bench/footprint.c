@@ -0,0 +1,459 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "generate.h"
+#include "../src/parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/*
+ * footprint reports how much memory parsed playlists hold, per segment for
+ * media playlists and per variant for master playlists.
+ *
+ * Three totals are measured for every input:
+ *
+ *   requested  bytes asked of hls_malloc, from hlsparse_alloc_stats
+ *   allocator  bytes the C library actually reserved for those requests,
+ *              including its rounding (glibc only)
+ *   rss        growth of the resident set while parsing (Linux only)
+ *
+ * The requested bytes are then broken down by the structure which owns them
+ * so memory reductions in the data structures can be measured, e.g.
+ *
+ *   ./footprint -n 100000
+ */
+
+#define FOOTPRINT_MAX_PARTS 16
+
+typedef struct {
+    const char  *name;
+    size_t      bytes;
+    int         count;
+} footprint_part_t;
+
+typedef struct {
+    footprint_part_t    parts[FOOTPRINT_MAX_PARTS];
+    int                 nb_parts;
+} footprint_t;
+
+static int footprint_quick = 0;
+static FILE *footprint_json = NULL;
+
+static size_t allocator_live = 0;
+
+static void *footprint_malloc(size_t size)
+{
+    void *ptr = malloc(size);
+#ifdef __GLIBC__
+    if(ptr) {
+        allocator_live += malloc_usable_size(ptr);
+    }
+#endif
+    return ptr;
+}
+
+static void footprint_free(void *ptr)
+{
+#ifdef __GLIBC__
+    if(ptr) {
+        allocator_live -= malloc_usable_size(ptr);
+    }
+#endif
+    free(ptr);
+}
+
+/**
+ * @returns the resident set size of the process in bytes, 0 when unknown.
+ */
+static size_t resident_bytes(void)
+{
+    size_t rss = 0;
+#ifdef __linux__
+    FILE *file = fopen("/proc/self/statm", "r");
+    if(file) {
+        unsigned long pages_total, pages_resident;
+        if(fscanf(file, "%lu %lu", &pages_total, &pages_resident) == 2) {
+            rss = (size_t)pages_resident * (size_t)sysconf(_SC_PAGESIZE);
+        }
+        fclose(file);
+    }
+#endif
+    return rss;
+}
+
+static void release_free_memory(void)
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+static size_t str_size(const char *str)
+{
+    return str ? strlen(str) + 1 : 0;
+}
+
+static void add(footprint_t *fp, const char *name, size_t bytes)
+{
+    int i;
+    for(i = 0; i < fp->nb_parts; ++i) {
+        if(!strcmp(fp->parts[i].name, name)) {
+            break;
+        }
+    }
+    if(i == fp->nb_parts) {
+        if(fp->nb_parts == FOOTPRINT_MAX_PARTS) {
+            return;
+        }
+        fp->parts[fp->nb_parts].name = name;
+        ++(fp->nb_parts);
+    }
+    fp->parts[i].bytes += bytes;
+    ++(fp->parts[i].count);
+}
+
+static void add_key(footprint_t *fp, const char *name, const hls_key_t *key)
+{
+    add(fp, name, sizeof(hls_key_t) + sizeof(key_list_t) + str_size(key->uri) +
+        key_iv_size(key) + str_size(key->key_format) + str_size(key->key_format_versions));
+}
+
+static void media_playlist_parts(const media_playlist_t *playlist, footprint_t *fp)
+{
+    const segment_list_t *seg = &playlist->segments;
+    while(seg && seg->data) {
+        const segment_t *s = seg->data;
+        add(fp, "segment_t", sizeof(segment_t));
+        // the first list node is part of the playlist
+        if(seg != &playlist->segments) {
+            add(fp, "segment_list_t", sizeof(segment_list_t));
+        }
+        add(fp, "segment uri", str_size(s->uri));
+        if(s->title) {
+            add(fp, "segment title", str_size(s->title));
+        }
+        const string_list_t *tag = &s->custom_tags;
+        while(tag && tag->data) {
+            add(fp, "segment custom tags", str_size(tag->data) +
+                (tag != &s->custom_tags ? sizeof(string_list_t) : 0));
+            tag = tag->next;
+        }
+        seg = seg->next;
+    }
+
+    const key_list_t *key = &playlist->keys;
+    while(key && key->data) {
+        add_key(fp, "keys", key->data);
+        key = key->next;
+    }
+
+    const map_list_t *map = &playlist->maps;
+    while(map && map->data) {
+        add(fp, "maps", sizeof(map_t) + sizeof(map_list_t) + str_size(map->data->uri));
+        map = map->next;
+    }
+
+    const daterange_list_t *daterange = &playlist->dateranges;
+    while(daterange && daterange->data) {
+        const daterange_t *dr = daterange->data;
+        size_t bytes = sizeof(daterange_t) + sizeof(daterange_list_t) + str_size(dr->id) +
+                       str_size(dr->klass) + dr->scte35_cmd_size + dr->scte35_out_size +
+                       dr->scte35_in_size;
+        const param_list_t *param = &dr->client_attributes;
+        while(param && param->value_type != PARAM_TYPE_NONE) {
+            bytes += str_size(param->key) + param->value_size +
+                     (param != &dr->client_attributes ? sizeof(param_list_t) : 0);
+            param = param->next;
+        }
+        add(fp, "dateranges", bytes);
+        daterange = daterange->next;
+    }
+
+    size_t other = str_size(playlist->uri) + sizeof(uint64_t) * playlist->nb_merkle_leaves * 2;
+    const string_list_t *tag = &playlist->custom_tags;
+    while(tag && tag->data) {
+        other += str_size(tag->data) + sizeof(string_list_t);
+        tag = tag->next;
+    }
+    if(other > 0) {
+        add(fp, "playlist", other);
+    }
+}
+
+static void master_parts(const master_t *master, footprint_t *fp)
+{
+    const stream_inf_list_t *inf = &master->stream_infs;
+    while(inf && inf->data) {
+        const stream_inf_t *s = inf->data;
+        add(fp, "stream_inf_t", sizeof(stream_inf_t) + sizeof(stream_inf_list_t));
+        add(fp, "stream_inf strings", str_size(s->codecs) + str_size(s->video) +
+            str_size(s->audio) + str_size(s->uri) + str_size(s->subtitles) +
+            str_size(s->closed_captions));
+        inf = inf->next;
+    }
+
+    const iframe_stream_inf_list_t *iframe = &master->iframe_stream_infs;
+    while(iframe && iframe->data) {
+        const iframe_stream_inf_t *s = iframe->data;
+        add(fp, "iframe_stream_inf", sizeof(iframe_stream_inf_t) + sizeof(iframe_stream_inf_list_t) +
+            str_size(s->codecs) + str_size(s->video) + str_size(s->uri));
+        iframe = iframe->next;
+    }
+
+    const media_list_t *media = &master->media;
+    while(media && media->data) {
+        const media_t *m = media->data;
+        add(fp, "media_t", sizeof(media_t) + sizeof(media_list_t));
+        add(fp, "media strings", str_size(m->name) + str_size(m->group_id) +
+            str_size(m->language) + str_size(m->assoc_language) + str_size(m->uri) +
+            str_size(m->characteristics) + str_size(m->channels));
+        media = media->next;
+    }
+
+    const session_data_list_t *sess = &master->session_data;
+    while(sess && sess->data) {
+        const session_data_t *s = sess->data;
+        add(fp, "session data", sizeof(session_data_t) + sizeof(session_data_list_t) +
+            str_size(s->data_id) + str_size(s->value) + str_size(s->uri) + str_size(s->language));
+        sess = sess->next;
+    }
+
+    const key_list_t *key = &master->session_keys;
+    while(key && key->data) {
+        add_key(fp, "session keys", key->data);
+        key = key->next;
+    }
+
+    size_t other = str_size(master->uri);
+    const string_list_t *tag = &master->custom_tags;
+    while(tag && tag->data) {
+        other += str_size(tag->data) + sizeof(string_list_t);
+        tag = tag->next;
+    }
+    if(other > 0) {
+        add(fp, "playlist", other);
+    }
+}
+
+static void report(const char *name, const char *unit, int items, size_t src_size,
+                   const hlsparse_alloc_stats_t *stats, size_t allocator, size_t rss,
+                   const footprint_t *fp)
+{
+    printf("%s: %d %ss, %zu bytes of playlist text\n", name, items, unit, src_size);
+    printf("  %-22s %12s %12s %12s\n", "", "bytes", "bytes/item", "allocs/item");
+    printf("  %-22s %12zu %12.1f %12.2f\n", "requested", stats->live_bytes,
+           (double)stats->live_bytes / items, (double)stats->nb_live / items);
+    if(allocator) {
+        printf("  %-22s %12zu %12.1f\n", "allocator", allocator, (double)allocator / items);
+    }
+    if(rss) {
+        printf("  %-22s %12zu %12.1f\n", "rss", rss, (double)rss / items);
+    }
+
+    size_t accounted = 0;
+    int i;
+    for(i = 0; i < fp->nb_parts; ++i) {
+        const footprint_part_t *p = &fp->parts[i];
+        printf("  %-22s %12zu %12.1f %11.1f%%\n", p->name, p->bytes, (double)p->bytes / items,
+               100.0 * p->bytes / (stats->live_bytes ? stats->live_bytes : 1));
+        accounted += p->bytes;
+    }
+    if(stats->live_bytes > accounted) {
+        printf("  %-22s %12zu %12.1f %11.1f%%\n", "unaccounted", stats->live_bytes - accounted,
+               (double)(stats->live_bytes - accounted) / items,
+               100.0 * (stats->live_bytes - accounted) / stats->live_bytes);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    if(footprint_json) {
+        fprintf(footprint_json, "{\"name\":\"footprint_%s\",\"unit\":\"%s\",\"items\":%d,\"bytes\":%zu,"
+                "\"requested_bytes\":%zu,\"allocator_bytes\":%zu,\"rss_bytes\":%zu,\"allocs\":%llu,"
+                "\"requested_per_item\":%.1f,\"breakdown\":{",
+                name, unit, items, src_size, stats->live_bytes, allocator, rss,
+                (unsigned long long)stats->nb_live, (double)stats->live_bytes / items);
+        for(i = 0; i < fp->nb_parts; ++i) {
+            fprintf(footprint_json, "%s\"%s\":%zu", i ? "," : "", fp->parts[i].name, fp->parts[i].bytes);
+        }
+        fprintf(footprint_json, "},\"timestamp\":%lld}\n", (long long)time(NULL));
+    }
+}
+
+/**
+ * Parses and terms a playlist while measuring the resident set and the bytes
+ * held by the C library, without the allocation statistics whose own
+ * bookkeeping would be counted in the resident set.
+ */
+static void measure_process(bool_t master, const char *src, int size, size_t *allocator, size_t *rss)
+{
+    media_playlist_t playlist;
+    master_t m;
+
+    release_free_memory();
+    size_t allocator_start = allocator_live;
+    size_t rss_start = resident_bytes();
+
+    if(master) {
+        hlsparse_master_init(&m);
+        hlsparse_master(src, size, &m);
+    } else {
+        hlsparse_media_playlist_init(&playlist);
+        hlsparse_media_playlist(src, size, &playlist);
+    }
+
+    size_t rss_end = resident_bytes();
+    *allocator = allocator_live - allocator_start;
+    *rss = rss_end > rss_start ? rss_end - rss_start : 0;
+
+    if(master) {
+        hlsparse_master_term(&m);
+    } else {
+        hlsparse_media_playlist_term(&playlist);
+    }
+}
+
+static void measure_media(const char *name, const generate_opts_t *opts)
+{
+    char *src = NULL;
+    int size = 0;
+    if(generate_media_source(opts, &src, &size) != HLS_OK) {
+        return;
+    }
+
+    size_t allocator, rss;
+    measure_process(HLS_FALSE, src, size, &allocator, &rss);
+
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hlsparse_media_playlist(src, size, &playlist);
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats(&stats);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    footprint_t fp;
+    memset(&fp, 0, sizeof(footprint_t));
+    media_playlist_parts(&playlist, &fp);
+    report(name, "segment", playlist.nb_segments, size, &stats, allocator, rss, &fp);
+
+    hlsparse_media_playlist_term(&playlist);
+    hls_free(src);
+}
+
+static void measure_master(const char *name, const generate_opts_t *opts)
+{
+    char *src = NULL;
+    int size = 0;
+    if(generate_master_source(opts, &src, &size) != HLS_OK) {
+        return;
+    }
+
+    size_t allocator, rss;
+    measure_process(HLS_TRUE, src, size, &allocator, &rss);
+
+    master_t master;
+    hlsparse_master_init(&master);
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hlsparse_master(src, size, &master);
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats(&stats);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    footprint_t fp;
+    memset(&fp, 0, sizeof(footprint_t));
+    master_parts(&master, &fp);
+    report(name, "variant", master.nb_stream_infs, size, &stats, allocator, rss, &fp);
+
+    hlsparse_master_term(&master);
+    hls_free(src);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-q] [-n segments] [-v variants] [-j file]\n", name);
+    fprintf(stderr, "  -q           only measure the default inputs at a small size\n");
+    fprintf(stderr, "  -n segments  segments in the media playlists (default 100000)\n");
+    fprintf(stderr, "  -v variants  variants in the master playlist (default 100)\n");
+    fprintf(stderr, "  -j file      append the results to file as JSON lines\n");
+}
+
+int main(int argc, char **argv)
+{
+    int nb_segments = 100000;
+    int nb_variants = 100;
+    int c;
+
+    while((c = getopt(argc, argv, "qn:v:j:h")) != -1) {
+        switch(c) {
+            case 'q': footprint_quick = 1; break;
+            case 'n': nb_segments = atoi(optarg); break;
+            case 'v': nb_variants = atoi(optarg); break;
+            case 'j':
+                footprint_json = fopen(optarg, "a");
+                if(!footprint_json) {
+                    fprintf(stderr, "unable to open %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(footprint_quick) {
+        nb_segments = nb_segments < 10000 ? nb_segments : 10000;
+    }
+    if(nb_segments <= 0 || nb_variants <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    hlsparse_global_init_mem(footprint_malloc, footprint_free);
+
+    generate_opts_t opts;
+
+    // transport stream VOD with keys, ad breaks and program date times
+    generate_opts_init(&opts);
+    opts.nb_segments = nb_segments;
+    measure_media("media_ts", &opts);
+
+    // live fMP4 with byte ranges into larger files
+    generate_opts_init(&opts);
+    opts.nb_segments = nb_segments;
+    opts.live = HLS_TRUE;
+    opts.fmp4 = HLS_TRUE;
+    opts.segments_per_file = 10;
+    opts.discontinuity_interval = 500;
+    measure_media("media_fmp4", &opts);
+
+    if(!footprint_quick) {
+        // bare segments, the floor of what a segment costs
+        generate_opts_init(&opts);
+        opts.nb_segments = nb_segments;
+        opts.key_rotation = 0;
+        opts.pdt = HLS_FALSE;
+        opts.ad_interval = 0;
+        opts.custom_tag_interval = 0;
+        opts.uri_token_size = 0;
+        measure_media("media_bare", &opts);
+    }
+
+    generate_opts_init(&opts);
+    opts.nb_variants = nb_variants;
+    measure_master("master", &opts);
+
+    if(footprint_json) {
+        fclose(footprint_json);
+    }
+    return 0;
+}
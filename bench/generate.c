@@ -0,0 +1,610 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "generate.h"
+#include "../src/parse.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define GENERATE_START_PDT      (1735689600000ULL) // 2025-01-01T00:00:00.000Z
+#define GENERATE_MAX_TOKEN      (1024)
+#define GENERATE_SCTE35_SIZE    (32)
+
+static const char *token_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static const char *languages[][2] = {
+    { "en", "English" }, { "es", "Spanish" }, { "fr", "French" }, { "de", "German" },
+    { "it", "Italian" }, { "pt", "Portuguese" }, { "ja", "Japanese" }, { "ko", "Korean" },
+    { "zh", "Chinese" }, { "ru", "Russian" }, { "ar", "Arabic" }, { "hi", "Hindi" },
+    { "nl", "Dutch" }, { "sv", "Swedish" }, { "pl", "Polish" }, { "tr", "Turkish" }
+};
+#define NB_LANGUAGES    (int)(sizeof(languages) / sizeof(languages[0]))
+
+// audio group name, codec and channels
+static const char *audio_codecs[][3] = {
+    { "aac", "mp4a.40.2", "2" }, { "heaac", "mp4a.40.5", "2" },
+    { "ec3", "ec-3", "6" }, { "ac3", "ac-3", "6" }
+};
+#define NB_AUDIO_CODECS (int)(sizeof(audio_codecs) / sizeof(audio_codecs[0]))
+
+// video ladder height and bandwidth
+static const int ladder[][2] = {
+    { 2160, 16000000 }, { 1440, 9000000 }, { 1080, 6000000 }, { 720, 3500000 },
+    { 540, 2000000 }, { 432, 1200000 }, { 360, 800000 }, { 270, 500000 },
+    { 234, 300000 }, { 180, 150000 }
+};
+#define NB_LADDER       (int)(sizeof(ladder) / sizeof(ladder[0]))
+
+/**
+ * splitmix64, small and good enough to give every seed its own playlist.
+ */
+typedef struct {
+    uint64_t state;
+} gen_rand_t;
+
+static uint64_t gen_next(gen_rand_t *rand)
+{
+    uint64_t z = (rand->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int gen_range(gen_rand_t *rand, int n)
+{
+    return n > 0 ? (int)(gen_next(rand) % (uint64_t)n) : 0;
+}
+
+/**
+ * Builds a '?token=' query string of 'size' random url safe characters.
+ */
+static void gen_token(gen_rand_t *rand, int size, char *dest)
+{
+    if(size <= 0) {
+        dest[0] = '\0';
+        return;
+    }
+    if(size > GENERATE_MAX_TOKEN) {
+        size = GENERATE_MAX_TOKEN;
+    }
+
+    memcpy(dest, "?token=", 7);
+    int i;
+    for(i = 0; i < size; ++i) {
+        dest[7 + i] = token_chars[gen_range(rand, 64)];
+    }
+    dest[7 + size] = '\0';
+}
+
+/**
+ * Allocates 'size' random bytes, the first ones set to 'prefix'.
+ */
+static char *gen_bytes(gen_rand_t *rand, int size, const char *prefix, int prefix_size)
+{
+    char *bytes = hls_malloc(size);
+    if(bytes) {
+        int i;
+        for(i = 0; i < size; ++i) {
+            bytes[i] = i < prefix_size ? prefix[i] : (char)gen_range(rand, 256);
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Formats a string allocated with hls_malloc.
+ */
+static char *gen_printf(const char *fmt, ...)
+{
+    char buf[2048 + GENERATE_MAX_TOKEN];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    return str_utils_dup(buf);
+}
+
+/**
+ * Defines a function adding 'data' after 'tail', the last node of a list
+ * whose first node is 'head'. Returns the new last node or NULL when it
+ * could not be allocated.
+ */
+#define DEFINE_LIST_PUSH(name, list_type, data_type, init)                  \
+static list_type *name(list_type *head, list_type *tail, data_type *data)  \
+{                                                                           \
+    if(!head->data) {                                                       \
+        head->data = data;                                                  \
+        return head;                                                        \
+    }                                                                       \
+    list_type *node = hls_malloc(sizeof(list_type));                        \
+    if(!node) {                                                             \
+        return NULL;                                                        \
+    }                                                                       \
+    init(node);                                                             \
+    node->data = data;                                                      \
+    (tail ? tail : head)->next = node;                                      \
+    return node;                                                            \
+}
+
+DEFINE_LIST_PUSH(push_key, key_list_t, hls_key_t, hlsparse_key_list_init)
+DEFINE_LIST_PUSH(push_map, map_list_t, map_t, hlsparse_map_list_init)
+DEFINE_LIST_PUSH(push_daterange, daterange_list_t, daterange_t, hlsparse_daterange_list_init)
+DEFINE_LIST_PUSH(push_string, string_list_t, char, hlsparse_string_list_init)
+DEFINE_LIST_PUSH(push_media, media_list_t, media_t, hlsparse_media_list_init)
+DEFINE_LIST_PUSH(push_stream_inf, stream_inf_list_t, stream_inf_t, hlsparse_stream_inf_list_init)
+DEFINE_LIST_PUSH(push_iframe_stream_inf, iframe_stream_inf_list_t, iframe_stream_inf_t, hlsparse_iframe_stream_inf_list_init)
+
+/**
+ * Adds a custom tag to the end of a segment's tags.
+ */
+static HLSCode add_custom_tag(segment_t *segment, char *tag)
+{
+    string_list_t *tail = &segment->custom_tags;
+    while(tail->next) {
+        tail = tail->next;
+    }
+    if(!tag || !push_string(&segment->custom_tags, tail, tag)) {
+        if(tag) {
+            hls_free(tag);
+        }
+        return HLS_ERROR;
+    }
+    return HLS_OK;
+}
+
+void generate_opts_init(generate_opts_t *opts)
+{
+    if(opts) {
+        memset(opts, 0, sizeof(generate_opts_t));
+        opts->seed = 1;
+        opts->nb_segments = 1000;
+        opts->segment_duration = 6.006f;
+        opts->key_rotation = 100;
+        opts->pdt = HLS_TRUE;
+        opts->ad_interval = 50;
+        opts->ad_length = 5;
+        opts->uri_token_size = 64;
+        opts->custom_tag_interval = 10;
+        opts->nb_variants = 10;
+        opts->nb_audio_groups = 2;
+        opts->nb_audio_languages = 4;
+        opts->nb_subtitle_languages = 4;
+    }
+}
+
+/**
+ * The state carried between the segments of a generated media playlist.
+ */
+typedef struct {
+    gen_rand_t          rand;
+    char                asset[17];
+    const char          *ext;
+    timestamp_t         pdt;
+    int                 ad_break;       // number of ad breaks started
+    int                 ad_remaining;   // segments left in the current ad break
+    bool_t              ad_ended;       // the previous segment ended an ad break
+    timestamp_t         ad_start;
+    int                 nb_content;     // content segments written so far
+    int                 file_offset;
+    key_list_t          *keys_tail;
+    map_list_t          *maps_tail;
+    daterange_list_t    *dateranges_tail;
+} gen_media_t;
+
+static HLSCode add_key(const generate_opts_t *opts, gen_media_t *gen, media_playlist_t *dest)
+{
+    char token[GENERATE_MAX_TOKEN + 8];
+    hls_key_t *key = hls_malloc(sizeof(hls_key_t));
+    if(!key) {
+        return HLS_ERROR;
+    }
+    hlsparse_key_init(key);
+    key->method = KEY_METHOD_AES128;
+    gen_token(&gen->rand, opts->uri_token_size, token);
+    key->uri = gen_printf("https://keys.example.com/v1/%s/%016llx.key%s", gen->asset,
+                          (unsigned long long)gen_next(&gen->rand), token);
+    key->iv = gen_bytes(&gen->rand, 16, NULL, 0);
+    key->iv_size = 16;
+
+    key_list_t *tail = push_key(&dest->keys, gen->keys_tail, key);
+    if(!key->uri || !key->iv || !tail) {
+        hlsparse_key_term(key);
+        hls_free(key);
+        return HLS_ERROR;
+    }
+    gen->keys_tail = tail;
+    ++(dest->nb_keys);
+    return HLS_OK;
+}
+
+static HLSCode add_map(gen_media_t *gen, media_playlist_t *dest, bool_t ad)
+{
+    map_t *map = hls_malloc(sizeof(map_t));
+    if(!map) {
+        return HLS_ERROR;
+    }
+    hlsparse_map_init(map);
+    if(ad) {
+        map->uri = gen_printf("https://ads.example.com/creative/%04d/init.mp4", gen->ad_break);
+    } else {
+        map->uri = gen_printf("https://cdn1.example.com/vod/%s/1080p/init-%d.mp4", gen->asset, dest->nb_maps);
+    }
+
+    map_list_t *tail = push_map(&dest->maps, gen->maps_tail, map);
+    if(!map->uri || !tail) {
+        hlsparse_map_term(map);
+        hls_free(map);
+        return HLS_ERROR;
+    }
+    gen->maps_tail = tail;
+    ++(dest->nb_maps);
+    return HLS_OK;
+}
+
+/**
+ * Adds the SCTE-35 daterange starting or ending an ad break.
+ */
+static HLSCode add_splice(const generate_opts_t *opts, gen_media_t *gen, media_playlist_t *dest, bool_t out)
+{
+    static const char splice_info[] = { (char)0xFC, 0x30 };
+    daterange_t *daterange = hls_malloc(sizeof(daterange_t));
+    if(!daterange) {
+        return HLS_ERROR;
+    }
+    hlsparse_daterange_init(daterange);
+    daterange->pdt = gen->pdt;
+    daterange->id = gen_printf("splice-%d", gen->ad_break);
+    daterange->klass = gen_printf("urn:scte:scte35:2014:bin");
+    daterange->start_date = gen->ad_start;
+
+    char *scte35 = gen_bytes(&gen->rand, GENERATE_SCTE35_SIZE, splice_info, 2);
+    if(out) {
+        daterange->planned_duration = opts->ad_length * opts->segment_duration;
+        daterange->scte35_out = scte35;
+        daterange->scte35_out_size = GENERATE_SCTE35_SIZE;
+        daterange->client_attributes.key = gen_printf("X-AD-ID");
+        daterange->client_attributes.value.data = gen_printf("creative-%04d", gen->ad_break);
+        daterange->client_attributes.value_type = PARAM_TYPE_STRING;
+        daterange->client_attributes.value_size = daterange->client_attributes.value.data ?
+                strlen(daterange->client_attributes.value.data) : 0;
+    } else {
+        daterange->end_date = gen->pdt;
+        daterange->duration = (float)(gen->pdt - gen->ad_start) / 1000.f;
+        daterange->scte35_in = scte35;
+        daterange->scte35_in_size = GENERATE_SCTE35_SIZE;
+    }
+
+    daterange_list_t *tail = push_daterange(&dest->dateranges, gen->dateranges_tail, daterange);
+    if(!daterange->id || !daterange->klass || !scte35 || !tail) {
+        hlsparse_daterange_term(daterange);
+        hls_free(daterange);
+        return HLS_ERROR;
+    }
+    gen->dateranges_tail = tail;
+    ++(dest->nb_dateranges);
+    return HLS_OK;
+}
+
+static HLSCode add_segment(const generate_opts_t *opts, gen_media_t *gen, media_playlist_t *dest, int index)
+{
+    char token[GENERATE_MAX_TOKEN + 8];
+    HLSCode res = HLS_OK;
+
+    bool_t ad_start = opts->ad_interval > 0 && opts->ad_length > 0 && index > 0 &&
+                      index % opts->ad_interval == 0 && gen->ad_remaining == 0;
+    bool_t ad_end = gen->ad_ended;
+    bool_t discontinuity = ad_start || ad_end ||
+                           (opts->discontinuity_interval > 0 && index > 0 && index % opts->discontinuity_interval == 0);
+    gen->ad_ended = HLS_FALSE;
+
+    if(opts->key_rotation > 0 && index % opts->key_rotation == 0) {
+        res |= add_key(opts, gen, dest);
+    }
+
+    if(ad_start) {
+        ++(gen->ad_break);
+        gen->ad_remaining = opts->ad_length;
+        gen->ad_start = gen->pdt;
+        res |= add_splice(opts, gen, dest, HLS_TRUE);
+    } else if(ad_end) {
+        res |= add_splice(opts, gen, dest, HLS_FALSE);
+    }
+    bool_t ad = gen->ad_remaining > 0;
+
+    if(opts->fmp4 && (index == 0 || discontinuity)) {
+        res |= add_map(gen, dest, ad);
+    }
+
+    if(res != HLS_OK) {
+        return HLS_ERROR;
+    }
+
+    segment_t *segment = media_playlist_alloc_segment(dest);
+    if(!segment) {
+        return HLS_ERROR;
+    }
+
+    // most segments have the nominal duration, some are cut short at scene changes
+    int duration_ms = (int)(opts->segment_duration * 1000.f + 0.5f);
+    if(!ad && gen_range(&gen->rand, 8) == 0) {
+        duration_ms -= gen_range(&gen->rand, duration_ms / 2);
+    }
+
+    segment->sequence_num = index;
+    segment->duration = duration_ms / 1000.f;
+    segment->discontinuity = discontinuity;
+    segment->pdt = gen->pdt;
+    segment->pdt_end = gen->pdt + duration_ms;
+    segment->pdt_discontinuity = opts->pdt;
+    segment->key_index = dest->nb_keys - 1;
+    segment->map_index = dest->nb_maps - 1;
+    segment->daterange_index = dest->nb_dateranges - 1;
+    gen->pdt = segment->pdt_end;
+
+    gen_token(&gen->rand, opts->uri_token_size, token);
+    if(ad) {
+        segment->uri = gen_printf("https://ads.example.com/creative/%04d/segment-%03d.%s%s", gen->ad_break,
+                                  opts->ad_length - gen->ad_remaining, gen->ext, token);
+    } else if(opts->segments_per_file > 0) {
+        if(gen->nb_content % opts->segments_per_file == 0) {
+            gen->file_offset = 0;
+        }
+        segment->byte_range.n = 400000 + gen_range(&gen->rand, 400000);
+        segment->byte_range.o = gen->file_offset;
+        gen->file_offset += segment->byte_range.n;
+        segment->uri = gen_printf("https://cdn%d.example.com/vod/%s/1080p/media-%05d.%s%s", 1 + index % 4, gen->asset,
+                                  gen->nb_content / opts->segments_per_file, gen->ext, token);
+    } else {
+        segment->uri = gen_printf("https://cdn%d.example.com/vod/%s/1080p/segment-%07d.%s%s", 1 + index % 4, gen->asset,
+                                  gen->nb_content, gen->ext, token);
+    }
+
+    if(ad_start) {
+        res |= add_custom_tag(segment, gen_printf("EXT-X-CUE-OUT:DURATION=%.3f", opts->ad_length * opts->segment_duration));
+    } else if(ad_end) {
+        res |= add_custom_tag(segment, gen_printf("EXT-X-CUE-IN"));
+    }
+    if(opts->custom_tag_interval > 0 && index % opts->custom_tag_interval == 0) {
+        res |= add_custom_tag(segment, gen_printf("EXT-X-BITRATE:%d", 4000 + gen_range(&gen->rand, 2000)));
+    }
+
+    segment_list_t *tail = dest->segments_tail ? dest->segments_tail : &dest->segments;
+    if(tail->data) {
+        segment_list_t *node = media_playlist_alloc_segment_node(dest);
+        if(node) {
+            tail->next = node;
+            tail = node;
+        } else {
+            res = HLS_ERROR;
+        }
+    }
+    if(!segment->uri || res != HLS_OK) {
+        hlsparse_segment_term(segment);
+        hls_free(segment);
+        return HLS_ERROR;
+    }
+    tail->data = segment;
+    dest->segments_tail = tail;
+    dest->last_segment = segment;
+    ++(dest->nb_segments);
+    dest->duration += segment->duration;
+    if(segment->duration > dest->target_duration) {
+        dest->target_duration = segment->duration;
+    }
+
+    if(ad) {
+        if(--(gen->ad_remaining) == 0) {
+            gen->ad_ended = HLS_TRUE;
+        }
+    } else {
+        ++(gen->nb_content);
+    }
+
+    return HLS_OK;
+}
+
+HLSCode generate_media_playlist(const generate_opts_t *opts, media_playlist_t *dest)
+{
+    if(!opts || !dest || opts->nb_segments < 0 || dest->nb_segments > 0) {
+        return HLS_ERROR;
+    }
+
+    gen_media_t gen;
+    memset(&gen, 0, sizeof(gen_media_t));
+    gen.rand.state = opts->seed;
+    snprintf(gen.asset, sizeof(gen.asset), "%016llx", (unsigned long long)gen_next(&gen.rand));
+    gen.ext = opts->fmp4 ? "m4s" : "ts";
+    gen.pdt = GENERATE_START_PDT;
+
+    dest->m3u = HLS_TRUE;
+    dest->version = opts->fmp4 ? 6 : (opts->segments_per_file > 0 ? 4 : 3);
+    dest->media_sequence = opts->media_sequence;
+    dest->independent_segments = HLS_TRUE;
+    if(!opts->live) {
+        dest->playlist_type = PLAYLIST_TYPE_VOD;
+        dest->end_list = HLS_TRUE;
+    }
+
+    int i;
+    for(i = 0; i < opts->nb_segments; ++i) {
+        if(add_segment(opts, &gen, dest, i) != HLS_OK) {
+            return HLS_ERROR;
+        }
+    }
+
+    dest->target_duration = ceilf(dest->target_duration);
+    dest->next_segment_media_sequence = dest->nb_segments;
+    dest->next_segment_pdt = gen.pdt;
+    dest->keys_tail = gen.keys_tail;
+    dest->maps_tail = gen.maps_tail;
+    dest->dateranges_tail = gen.dateranges_tail;
+
+    if(dest->segment_hashes) {
+        return hlsparse_media_playlist_hash_segments(dest);
+    }
+    return HLS_OK;
+}
+
+HLSCode generate_master(const generate_opts_t *opts, master_t *dest)
+{
+    if(!opts || !dest || opts->nb_variants < 0 || dest->nb_stream_infs > 0) {
+        return HLS_ERROR;
+    }
+
+    char token[GENERATE_MAX_TOKEN + 8];
+    gen_rand_t rand = { opts->seed };
+    char asset[17];
+    snprintf(asset, sizeof(asset), "%016llx", (unsigned long long)gen_next(&rand));
+
+    media_list_t *media_tail = NULL;
+    stream_inf_list_t *inf_tail = NULL;
+    iframe_stream_inf_list_t *iframe_tail = NULL;
+    int nb_groups = opts->nb_audio_groups < NB_AUDIO_CODECS ? opts->nb_audio_groups : NB_AUDIO_CODECS;
+    int nb_audio = opts->nb_audio_languages < NB_LANGUAGES ? opts->nb_audio_languages : NB_LANGUAGES;
+    int nb_subtitles = opts->nb_subtitle_languages < NB_LANGUAGES ? opts->nb_subtitle_languages : NB_LANGUAGES;
+    int g, l, i;
+
+    dest->m3u = HLS_TRUE;
+    dest->version = 6;
+    dest->independent_segments = HLS_TRUE;
+
+    for(g = 0; g < nb_groups + 1; ++g) {
+        int nb_languages = g < nb_groups ? nb_audio : nb_subtitles;
+        for(l = 0; l < nb_languages; ++l) {
+            media_t *media = hls_malloc(sizeof(media_t));
+            if(!media) {
+                return HLS_ERROR;
+            }
+            hlsparse_media_init(media);
+            media->language = str_utils_dup(languages[l][0]);
+            media->name = str_utils_dup(languages[l][1]);
+            media->is_default = l == 0 ? HLS_TRUE : HLS_FALSE;
+            media->auto_select = HLS_TRUE;
+            gen_token(&rand, opts->uri_token_size, token);
+            if(g < nb_groups) {
+                media->type = MEDIA_TYPE_AUDIO;
+                media->group_id = gen_printf("audio-%s", audio_codecs[g][0]);
+                media->channels = str_utils_dup(audio_codecs[g][2]);
+                media->uri = gen_printf("https://cdn1.example.com/vod/%s/audio/%s/%s/index.m3u8%s", asset,
+                                        audio_codecs[g][0], languages[l][0], token);
+            } else {
+                media->type = MEDIA_TYPE_SUBTITLES;
+                media->group_id = gen_printf("subs");
+                media->uri = gen_printf("https://cdn1.example.com/vod/%s/subtitles/%s/index.m3u8%s", asset,
+                                        languages[l][0], token);
+            }
+
+            media_list_t *tail = push_media(&dest->media, media_tail, media);
+            if(!tail) {
+                hlsparse_media_term(media);
+                hls_free(media);
+                return HLS_ERROR;
+            }
+            media_tail = tail;
+        }
+    }
+
+    for(i = 0; i < opts->nb_variants; ++i) {
+        stream_inf_t *inf = hls_malloc(sizeof(stream_inf_t));
+        iframe_stream_inf_t *iframe = hls_malloc(sizeof(iframe_stream_inf_t));
+        if(!inf || !iframe) {
+            if(inf) {
+                hls_free(inf);
+            }
+            if(iframe) {
+                hls_free(iframe);
+            }
+            return HLS_ERROR;
+        }
+        hlsparse_stream_inf_init(inf);
+        hlsparse_iframe_stream_inf_init(iframe);
+
+        // every pass through the ladder switches between AVC and HEVC
+        int rung = i % NB_LADDER;
+        int pass = i / NB_LADDER;
+        const char *video = pass % 2 ? "hvc1.2.4.L123.B0" : "avc1.640028";
+        int height = ladder[rung][0];
+        int width = (height * 16 / 9 + 1) & ~1;
+        float bandwidth = (float)(ladder[rung][1] + pass * 10000);
+
+        inf->bandwidth = bandwidth;
+        inf->avg_bandwidth = bandwidth * 0.8f;
+        inf->resolution.width = width;
+        inf->resolution.height = height;
+        inf->frame_rate = height >= 720 ? 59.94f : 29.97f;
+        if(nb_groups > 0) {
+            const char **codec = audio_codecs[i % nb_groups];
+            inf->codecs = gen_printf("%s,%s", video, codec[1]);
+            inf->audio = gen_printf("audio-%s", codec[0]);
+        } else {
+            inf->codecs = str_utils_dup(video);
+        }
+        if(nb_subtitles > 0) {
+            inf->subtitles = gen_printf("subs");
+        }
+        gen_token(&rand, opts->uri_token_size, token);
+        inf->uri = gen_printf("https://cdn1.example.com/vod/%s/v%03d/index.m3u8%s", asset, i, token);
+
+        iframe->bandwidth = bandwidth / 10.f;
+        iframe->resolution = inf->resolution;
+        iframe->codecs = str_utils_dup(video);
+        iframe->uri = gen_printf("https://cdn1.example.com/vod/%s/v%03d/iframes.m3u8%s", asset, i, token);
+
+        stream_inf_list_t *tail = push_stream_inf(&dest->stream_infs, inf_tail, inf);
+        if(!tail) {
+            hlsparse_stream_inf_term(inf);
+            hls_free(inf);
+            hlsparse_iframe_stream_inf_term(iframe);
+            hls_free(iframe);
+            return HLS_ERROR;
+        }
+        inf_tail = tail;
+        ++(dest->nb_stream_infs);
+
+        iframe_stream_inf_list_t *iframe_list = push_iframe_stream_inf(&dest->iframe_stream_infs, iframe_tail, iframe);
+        if(!iframe_list) {
+            hlsparse_iframe_stream_inf_term(iframe);
+            hls_free(iframe);
+            return HLS_ERROR;
+        }
+        iframe_tail = iframe_list;
+        ++(dest->nb_iframe_stream_infs);
+    }
+
+    return HLS_OK;
+}
+
+HLSCode generate_media_source(const generate_opts_t *opts, char **dest, int *dest_size)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+
+    HLSCode res = generate_media_playlist(opts, &playlist);
+    if(res == HLS_OK) {
+        res = hlswrite_media(dest, dest_size, &playlist);
+    }
+
+    hlsparse_media_playlist_term(&playlist);
+    return res;
+}
+
+HLSCode generate_master_source(const generate_opts_t *opts, char **dest, int *dest_size)
+{
+    master_t master;
+    hlsparse_master_init(&master);
+
+    HLSCode res = generate_master(opts, &master);
+    if(res == HLS_OK) {
+        res = hlswrite_master(dest, dest_size, &master);
+    }
+
+    hlsparse_master_term(&master);
+    return res;
+}
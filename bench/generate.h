@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#ifndef _GENERATE_H
+#define _GENERATE_H
+
+#include "hlsparse.h"
+
+/**
+ * Options describing the shape of a synthetic playlist.
+ * A value of 0 disables the feature it controls.
+ */
+typedef struct {
+    uint64_t    seed;                   // the same seed always generates the same playlist
+    int         nb_segments;
+    float       segment_duration;       // nominal segment duration in seconds
+    int         media_sequence;
+    bool_t      live;                   // no EXT-X-ENDLIST or EXT-X-PLAYLIST-TYPE
+    int         key_rotation;           // segments per EXT-X-KEY
+    int         segments_per_file;      // segments per file addressed with EXT-X-BYTERANGE
+    bool_t      fmp4;                   // fMP4 segments with an EXT-X-MAP per discontinuity
+    bool_t      pdt;                    // EXT-X-PROGRAM-DATE-TIME on every segment
+    int         ad_interval;            // segments between SCTE-35 ad breaks
+    int         ad_length;              // segments per ad break
+    int         discontinuity_interval; // segments between discontinuities
+    int         uri_token_size;         // characters in the CDN token of each uri
+    int         custom_tag_interval;    // segments between custom tags
+    int         nb_variants;            // master: variant streams
+    int         nb_audio_groups;        // master: audio groups, one per audio codec
+    int         nb_audio_languages;     // master: renditions per audio group
+    int         nb_subtitle_languages;  // master: subtitle renditions
+} generate_opts_t;
+
+/**
+ * Initializes the options with a production like VOD playlist: 6s segments,
+ * keys rotating every 100 segments, per-segment PDT, an ad break every 5
+ * minutes and 64 character CDN tokens. Masters have 2 audio groups of 4
+ * languages and 4 subtitle languages.
+ *
+ * @param opts The options to initialize
+ */
+void generate_opts_init(generate_opts_t *opts);
+
+/**
+ * Generates a media playlist.
+ *
+ * @param opts The shape of the playlist
+ * @param dest An initialized playlist which receives the segments
+ * @returns HLS_OK on success
+ */
+HLSCode generate_media_playlist(const generate_opts_t *opts, media_playlist_t *dest);
+
+/**
+ * Generates a master playlist.
+ *
+ * @param opts The shape of the playlist
+ * @param dest An initialized master which receives the variants and renditions
+ * @returns HLS_OK on success
+ */
+HLSCode generate_master(const generate_opts_t *opts, master_t *dest);
+
+/**
+ * Generates a media playlist and writes it with hlswrite_media.
+ *
+ * @param opts The shape of the playlist
+ * @param dest A NULL pointer which will be assigned the playlist, free with hls_free
+ * @param dest_size The size of the string assigned to 'dest'
+ * @returns HLS_OK on success
+ */
+HLSCode generate_media_source(const generate_opts_t *opts, char **dest, int *dest_size);
+
+/**
+ * Generates a master playlist and writes it with hlswrite_master.
+ *
+ * @param opts The shape of the playlist
+ * @param dest A NULL pointer which will be assigned the playlist, free with hls_free
+ * @param dest_size The size of the string assigned to 'dest'
+ * @returns HLS_OK on success
+ */
+HLSCode generate_master_source(const generate_opts_t *opts, char **dest, int *dest_size);
+
+#endif
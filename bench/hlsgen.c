@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "generate.h"
+#include "../src/parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * hlsgen writes a synthetic media or master playlist to stdout, e.g.
+ *
+ *   ./hlsgen -n 100000 -k 10 -b 6 -f > vod.m3u8
+ *   ./hlsgen -m -v 200 -g 4 -A 16 > master.m3u8
+ */
+
+static void usage(const char *name)
+{
+    generate_opts_t opts;
+    generate_opts_init(&opts);
+
+    fprintf(stderr, "usage: %s [options]\n", name);
+    fprintf(stderr, "  -s seed        random seed (default %llu)\n", (unsigned long long)opts.seed);
+    fprintf(stderr, "  -o file        write to file instead of stdout\n");
+    fprintf(stderr, "media playlists:\n");
+    fprintf(stderr, "  -n segments    number of segments (default %d)\n", opts.nb_segments);
+    fprintf(stderr, "  -d seconds     segment duration (default %.3f)\n", opts.segment_duration);
+    fprintf(stderr, "  -q sequence    media sequence of the first segment (default 0)\n");
+    fprintf(stderr, "  -L             live playlist, without EXT-X-ENDLIST\n");
+    fprintf(stderr, "  -k segments    segments per key, 0 for clear segments (default %d)\n", opts.key_rotation);
+    fprintf(stderr, "  -b segments    segments per file using EXT-X-BYTERANGE (default 0)\n");
+    fprintf(stderr, "  -f             fMP4 segments with EXT-X-MAP\n");
+    fprintf(stderr, "  -P             only write EXT-X-PROGRAM-DATE-TIME where needed\n");
+    fprintf(stderr, "  -a segments    segments between SCTE-35 ad breaks (default %d)\n", opts.ad_interval);
+    fprintf(stderr, "  -l segments    segments per ad break (default %d)\n", opts.ad_length);
+    fprintf(stderr, "  -D segments    segments between discontinuities (default 0)\n");
+    fprintf(stderr, "  -t characters  size of the CDN token in each uri (default %d)\n", opts.uri_token_size);
+    fprintf(stderr, "  -c segments    segments between custom tags (default %d)\n", opts.custom_tag_interval);
+    fprintf(stderr, "master playlists:\n");
+    fprintf(stderr, "  -m             write a master playlist\n");
+    fprintf(stderr, "  -v variants    number of variant streams (default %d)\n", opts.nb_variants);
+    fprintf(stderr, "  -g groups      number of audio groups (default %d)\n", opts.nb_audio_groups);
+    fprintf(stderr, "  -A languages   audio renditions per group (default %d)\n", opts.nb_audio_languages);
+    fprintf(stderr, "  -S languages   subtitle renditions (default %d)\n", opts.nb_subtitle_languages);
+}
+
+int main(int argc, char **argv)
+{
+    generate_opts_t opts;
+    const char *output = NULL;
+    int master = 0;
+    int c;
+
+    hlsparse_global_init();
+    generate_opts_init(&opts);
+
+    while((c = getopt(argc, argv, "s:o:n:d:q:Lk:b:fPa:l:D:t:c:mv:g:A:S:h")) != -1) {
+        switch(c) {
+            case 's': opts.seed = strtoull(optarg, NULL, 10); break;
+            case 'o': output = optarg; break;
+            case 'n': opts.nb_segments = atoi(optarg); break;
+            case 'd': opts.segment_duration = atof(optarg); break;
+            case 'q': opts.media_sequence = atoi(optarg); break;
+            case 'L': opts.live = HLS_TRUE; break;
+            case 'k': opts.key_rotation = atoi(optarg); break;
+            case 'b': opts.segments_per_file = atoi(optarg); break;
+            case 'f': opts.fmp4 = HLS_TRUE; break;
+            case 'P': opts.pdt = HLS_FALSE; break;
+            case 'a': opts.ad_interval = atoi(optarg); break;
+            case 'l': opts.ad_length = atoi(optarg); break;
+            case 'D': opts.discontinuity_interval = atoi(optarg); break;
+            case 't': opts.uri_token_size = atoi(optarg); break;
+            case 'c': opts.custom_tag_interval = atoi(optarg); break;
+            case 'm': master = 1; break;
+            case 'v': opts.nb_variants = atoi(optarg); break;
+            case 'g': opts.nb_audio_groups = atoi(optarg); break;
+            case 'A': opts.nb_audio_languages = atoi(optarg); break;
+            case 'S': opts.nb_subtitle_languages = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    char *out = NULL;
+    int size = 0;
+    HLSCode res = master ? generate_master_source(&opts, &out, &size) :
+                           generate_media_source(&opts, &out, &size);
+    if(res != HLS_OK) {
+        fprintf(stderr, "unable to generate the playlist\n");
+        return 1;
+    }
+
+    FILE *file = output ? fopen(output, "w") : stdout;
+    if(!file) {
+        fprintf(stderr, "unable to open %s\n", output);
+        hls_free(out);
+        return 1;
+    }
+
+    size_t written = fwrite(out, 1, size, file);
+    if(output) {
+        fclose(file);
+    }
+    hls_free(out);
+
+    return written == (size_t)size ? 0 : 1;
+}
@@ -0,0 +1,442 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "bench.h"
+#include "../src/parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Benchmarks of the value parsing kernels on their own.
+ *
+ * Each run parses a batch of KERNEL_BATCH values drawn from the shapes these
+ * kernels see in real playlists, so a regression in one kernel shows up here
+ * even when a whole playlist benchmark can't tell which kernel it was.
+ * The values sit one per line in a single block of text, as they would in a
+ * playlist, and every kernel is given the rest of its line as its size.
+ */
+
+#define KERNEL_BATCH    4096
+
+typedef struct {
+    char           *text;
+    int             text_size;
+    int             text_cap;
+    int             offsets[KERNEL_BATCH];
+    int             sizes[KERNEL_BATCH];
+    int             nb;
+    const char     *bases[KERNEL_BATCH];    // base URIs for path_combine
+    char           *out[KERNEL_BATCH];      // strings allocated by the last run
+    uint64_t        sink;                   // keeps parsed numbers alive
+} kernel_ctx_t;
+
+static uint64_t kernel_state = 0x2545F4914F6CDD1DULL;
+
+// splitmix64, the inputs are the same on every run
+static uint64_t kernel_rand(void)
+{
+    uint64_t z = (kernel_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int kernel_range(int n)
+{
+    return (int)(kernel_rand() % (uint64_t)n);
+}
+
+static void kernel_ctx_init(kernel_ctx_t *c)
+{
+    memset(c, 0, sizeof(kernel_ctx_t));
+    kernel_state = 0x2545F4914F6CDD1DULL;
+}
+
+static void kernel_ctx_term(kernel_ctx_t *c)
+{
+    free(c->text);
+    memset(c, 0, sizeof(kernel_ctx_t));
+}
+
+/**
+ * Appends a value as its own line, 'value_size' is the length of the value
+ * within 'line' and what follows it is the rest of the line, e.g. the
+ * remaining attributes.
+ */
+static void kernel_add(kernel_ctx_t *c, const char *line, int value_size)
+{
+    int size = (int)strlen(line);
+    if(c->text_size + size + 2 > c->text_cap) {
+        c->text_cap = (c->text_cap + size + 2) * 2;
+        c->text = realloc(c->text, c->text_cap);
+    }
+    c->offsets[c->nb] = c->text_size;
+    c->sizes[c->nb] = value_size < 0 ? size : value_size;
+    memcpy(&c->text[c->text_size], line, size);
+    c->text_size += size;
+    c->text[c->text_size++] = '\n';
+    c->text[c->text_size] = '\0';
+    ++c->nb;
+}
+
+static const char *kernel_src(const kernel_ctx_t *c, int i)
+{
+    return &c->text[c->offsets[i]];
+}
+
+// the line sizes are only known once the text is complete
+static size_t kernel_rest(const kernel_ctx_t *c, int i)
+{
+    return (size_t)(c->text_size - c->offsets[i]);
+}
+
+static size_t kernel_bytes(const kernel_ctx_t *c)
+{
+    size_t bytes = 0;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        bytes += c->sizes[i];
+    }
+    return bytes;
+}
+
+/*
+ * inputs
+ */
+
+static void kernel_gen_ints(kernel_ctx_t *c)
+{
+    char line[64];
+    while(c->nb < KERNEL_BATCH) {
+        int len;
+        switch(kernel_range(5)) {
+        case 0: len = snprintf(line, sizeof(line), "%d", 1 + kernel_range(9)); strcat(line, "\n"); break;                     // version, target duration
+        case 1: len = snprintf(line, sizeof(line), "%d", 100000 + kernel_range(20000000)); strcat(line, ",AVERAGE-BANDWIDTH=1"); break;  // bandwidth
+        case 2: len = snprintf(line, sizeof(line), "%d", 240 + kernel_range(1920)); strcat(line, ",FRAME-RATE=30"); break;   // resolution
+        case 3: len = snprintf(line, sizeof(line), "%d", kernel_range(2000000000)); strcat(line, "\n"); break;                // media sequence
+        default: len = snprintf(line, sizeof(line), "%d", kernel_range(4000000)); strcat(line, "@0"); break;                  // byte range
+        }
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_ranges(kernel_ctx_t *c)
+{
+    static const int heights[] = { 240, 360, 480, 720, 1080, 1440, 2160 };
+    char line[64];
+    while(c->nb < KERNEL_BATCH) {
+        int len;
+        if(kernel_range(2)) {
+            int height = heights[kernel_range(7)];
+            len = snprintf(line, sizeof(line), "%dx%d", height * 16 / 9, height);
+            strcat(line, ",FRAME-RATE=30");                                         // resolution
+        } else {
+            len = snprintf(line, sizeof(line), "%d@%d", 1000 + kernel_range(4000000), kernel_range(2000000000));
+            strcat(line, "\n");                                                     // byte range
+        }
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_floats(kernel_ctx_t *c)
+{
+    static const char *durations[] = { "6.006", "6", "10.000", "5.005000", "4.8", "2.002", "3.96", "9.97663" };
+    char line[64];
+    while(c->nb < KERNEL_BATCH) {
+        int len;
+        if(kernel_range(4)) {
+            len = snprintf(line, sizeof(line), "%s", durations[kernel_range(8)]);
+            strcat(line, ",");                                                      // EXTINF duration
+        } else {
+            len = snprintf(line, sizeof(line), "%d.%03d", 23 + kernel_range(38), kernel_range(1000));
+            strcat(line, ",CODECS=\"x\"");                                          // frame rate
+        }
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_dates(kernel_ctx_t *c)
+{
+    char line[64];
+    while(c->nb < KERNEL_BATCH) {
+        int year = 2015 + kernel_range(15), month = 1 + kernel_range(12), day = 1 + kernel_range(28);
+        int hour = kernel_range(24), min = kernel_range(60), sec = kernel_range(60);
+        int len;
+        switch(kernel_range(4)) {
+        case 0:
+            len = snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", year, month, day, hour, min, sec, kernel_range(1000));
+            break;
+        case 1:
+            len = snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02dZ", year, month, day, hour, min, sec);
+            break;
+        case 2:
+            len = snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d.%03d+%02d:00", year, month, day, hour, min, sec, kernel_range(1000), kernel_range(13));
+            break;
+        default:
+            len = snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d-0%d:30", year, month, day, hour, min, sec, kernel_range(10));
+            break;
+        }
+        strcat(line, "\"");     // DATERANGE dates are quoted
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_attrib_strs(kernel_ctx_t *c)
+{
+    static const char *codecs[] = { "avc1.64001f,mp4a.40.2", "avc1.4d401e", "hvc1.2.4.L123.B0,ec-3", "mp4a.40.5" };
+    static const char *langs[] = { "en", "fr", "es-419", "pt-BR", "ja" };
+    char line[256];
+    while(c->nb < KERNEL_BATCH) {
+        int len;
+        switch(kernel_range(3)) {
+        case 0:
+            len = snprintf(line, sizeof(line), "\"https://cdn%d.example.com/live/%08x/keys/%d.key\"", kernel_range(10), (unsigned)kernel_rand(), kernel_range(100000));
+            strcat(line, ",IV=0x1");
+            break;
+        case 1:
+            len = snprintf(line, sizeof(line), "\"%s\"", codecs[kernel_range(4)]);
+            strcat(line, ",RESOLUTION=1280x720");
+            break;
+        default:
+            len = snprintf(line, sizeof(line), "\"%s\"", langs[kernel_range(5)]);
+            strcat(line, ",NAME=\"x\"");
+            break;
+        }
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_attrib_data(kernel_ctx_t *c)
+{
+    static const char hex[] = "0123456789abcdef0123456789ABCDEF";
+    char line[512];
+    while(c->nb < KERNEL_BATCH) {
+        // mostly 16 byte IVs, some SCTE-35 payloads
+        int nb_chars = kernel_range(4) ? 32 : 64 + 2 * kernel_range(100);
+        int len = 2, i;
+        line[0] = '0';
+        line[1] = 'x';
+        int upper = kernel_range(2) * 16;
+        for(i = 0; i < nb_chars; ++i) {
+            line[len++] = hex[upper + kernel_range(16)];
+        }
+        line[len] = '\0';
+        strcat(line, ",KEYFORMAT=\"identity\"");
+        kernel_add(c, line, len);
+    }
+}
+
+static void kernel_gen_lines(kernel_ctx_t *c)
+{
+    char line[512];
+    while(c->nb < KERNEL_BATCH) {
+        int len;
+        switch(kernel_range(3)) {
+        case 0:
+            len = snprintf(line, sizeof(line), "segment%d.ts", kernel_range(100000));
+            break;
+        case 1:
+            len = snprintf(line, sizeof(line), "https://cdn.example.com/live/channel%d/1080p/seg-%d.m4s", kernel_range(500), kernel_range(10000000));
+            break;
+        default: {
+            // signed urls with long tokens
+            len = snprintf(line, sizeof(line), "https://edge.example.com/v/%08x/%d.ts?token=", (unsigned)kernel_rand(), kernel_range(100000));
+            int nb = 64 + kernel_range(128), i;
+            for(i = 0; i < nb; ++i) {
+                line[len++] = 'a' + kernel_range(26);
+            }
+            line[len] = '\0';
+            break;
+        }
+        }
+        // a few lines end with \r\n
+        if(!kernel_range(8)) {
+            line[len++] = '\r';
+            line[len] = '\0';
+        }
+        kernel_add(c, line, -1);
+    }
+}
+
+static void kernel_gen_paths(kernel_ctx_t *c)
+{
+    static const char *bases[] = {
+        "https://cdn.example.com/live/channel/1080p/index.m3u8",
+        "https://cdn.example.com/live/channel/master.m3u8?token=abcdef0123456789",
+        "http://a/b/c/d;p?q",
+    };
+    char line[256];
+    while(c->nb < KERNEL_BATCH) {
+        int n = c->nb;
+        switch(kernel_range(5)) {
+        case 0:
+        case 1:
+            snprintf(line, sizeof(line), "segment%d.ts", kernel_range(100000));
+            break;
+        case 2:
+            snprintf(line, sizeof(line), "../720p/seg-%d.m4s", kernel_range(100000));
+            break;
+        case 3:
+            snprintf(line, sizeof(line), "/live/channel/init-%d.mp4", kernel_range(10));
+            break;
+        default:
+            snprintf(line, sizeof(line), "https://other.example.com/seg-%d.ts", kernel_range(100000));
+            break;
+        }
+        kernel_add(c, line, -1);
+        // path_combine reads up to the terminator so each path is its own string
+        c->text[c->text_size - 1] = '\0';
+        c->bases[n] = bases[kernel_range(3)];
+    }
+}
+
+/*
+ * kernels
+ */
+
+static void bench_str_to_int(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    uint64_t sum = 0;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        int value = 0;
+        parse_str_to_int(kernel_src(c, i), &value, kernel_rest(c, i));
+        sum += value;
+    }
+    c->sink += sum;
+}
+
+static void bench_str_to_float(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    float sum = 0.f;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        float value = 0.f;
+        parse_str_to_float(kernel_src(c, i), &value, kernel_rest(c, i));
+        sum += value;
+    }
+    c->sink += (uint64_t)sum;
+}
+
+static void bench_ranges(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    uint64_t sum = 0;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        const char *src = kernel_src(c, i);
+        if(memchr(src, 'x', c->sizes[i])) {
+            resolution_t resolution;
+            parse_resolution(src, kernel_rest(c, i), &resolution);
+            sum += resolution.width + resolution.height;
+        } else {
+            byte_range_t byte_range;
+            parse_byte_range(src, kernel_rest(c, i), &byte_range);
+            sum += byte_range.n + byte_range.o;
+        }
+    }
+    c->sink += sum;
+}
+
+static void bench_date(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    uint64_t sum = 0;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        uint64_t value = 0;
+        parse_date(kernel_src(c, i), &value, kernel_rest(c, i));
+        sum += value;
+    }
+    c->sink += sum;
+}
+
+static void bench_attrib_str(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        parse_attrib_str(kernel_src(c, i), &c->out[i], kernel_rest(c, i));
+    }
+}
+
+static void bench_attrib_data(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        parse_attrib_data(kernel_src(c, i), &c->out[i], kernel_rest(c, i));
+    }
+}
+
+static void bench_line_to_str(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        parse_line_to_str(kernel_src(c, i), &c->out[i], kernel_rest(c, i));
+    }
+}
+
+static void bench_path_combine(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        path_combine(&c->out[i], c->bases[i], kernel_src(c, i));
+    }
+}
+
+static void bench_kernel_reset(void *ctx)
+{
+    kernel_ctx_t *c = ctx;
+    int i;
+    for(i = 0; i < c->nb; ++i) {
+        if(c->out[i]) {
+            hls_free(c->out[i]);
+            c->out[i] = NULL;
+        }
+    }
+}
+
+typedef struct {
+    const char     *name;
+    void          (*generate)(kernel_ctx_t *c);
+    bench_fn_t      run;
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    { "str_to_int", kernel_gen_ints, bench_str_to_int },
+    { "str_to_float", kernel_gen_floats, bench_str_to_float },
+    { "ranges", kernel_gen_ranges, bench_ranges },
+    { "date", kernel_gen_dates, bench_date },
+    { "attrib_str", kernel_gen_attrib_strs, bench_attrib_str },
+    { "attrib_data", kernel_gen_attrib_data, bench_attrib_data },
+    { "line_to_str", kernel_gen_lines, bench_line_to_str },
+    { "path_combine", kernel_gen_paths, bench_path_combine },
+};
+
+void setup(void)
+{
+    // too large for the stack
+    static kernel_ctx_t ctx;
+    int i;
+
+    for(i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); ++i) {
+        kernel_ctx_init(&ctx);
+        kernels[i].generate(&ctx);
+
+        bench_t b = { kernels[i].name, "value", ctx.nb, kernel_bytes(&ctx), kernels[i].run, bench_kernel_reset, &ctx };
+        bench(&b);
+
+        bench_kernel_reset(&ctx);
+        kernel_ctx_term(&ctx);
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "bench.h"
+#include "generate.h"
+#include "../src/parse.h"
+#include <stdio.h>
+
+typedef struct {
+    char               *src;
+    int                 size;
+    media_playlist_t    playlist;
+    master_t            master;
+} parse_ctx_t;
+
+static void bench_parse_media(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_media_playlist_init(&c->playlist);
+    hlsparse_media_playlist(c->src, c->size, &c->playlist);
+}
+
+// the parse of a segment prefetcher which only needs the uris, durations and byte ranges
+static void bench_parse_media_skip(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_media_playlist_init(&c->playlist);
+    c->playlist.skip_fields = PARSE_FIELD_TITLES | PARSE_FIELD_CUSTOM_TAGS | PARSE_FIELD_DATERANGES |
+                              PARSE_FIELD_KEYS | PARSE_FIELD_MAPS;
+    hlsparse_media_playlist(c->src, c->size, &c->playlist);
+}
+
+// the reload of a live player which only needs the segments near the live edge
+static void bench_parse_media_tail(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_media_playlist_init(&c->playlist);
+    c->playlist.tail_segments = 5;
+    hlsparse_media_playlist(c->src, c->size, &c->playlist);
+}
+
+// the check of a reload scheduler which only needs the playlist's numbers
+static void bench_parse_media_summary(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    playlist_summary_t summary;
+    hlsparse_media_playlist_summary(c->src, c->size, &summary);
+}
+
+// the prefetcher reading the segments one at a time without building the playlist
+static void bench_parse_media_reader(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    segment_reader_t reader;
+    segment_view_t segment;
+    hlsparse_segment_reader_init(&reader, c->src, c->size);
+    while(hlsparse_segment_reader_next(&reader, &segment) > 0) {
+    }
+}
+
+static void bench_parse_media_reset(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_media_playlist_term(&c->playlist);
+}
+
+static void bench_parse_master(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_master_init(&c->master);
+    hlsparse_master(c->src, c->size, &c->master);
+}
+
+// the lazy parse of an edge server which only looks at the bandwidth and resolution
+static void bench_parse_master_lazy(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_master_init(&c->master);
+    c->master.lazy_attributes = HLS_TRUE;
+    hlsparse_master(c->src, c->size, &c->master);
+
+    stream_inf_list_t *inf = &c->master.stream_infs;
+    while(inf && inf->data) {
+        hlsparse_stream_inf_decode(inf->data, STREAM_INF_ATTR_BANDWIDTH | STREAM_INF_ATTR_RESOLUTION);
+        inf = inf->next;
+    }
+}
+
+static void bench_parse_master_reset(void *ctx)
+{
+    parse_ctx_t *c = ctx;
+    hlsparse_master_term(&c->master);
+}
+
+void setup(void)
+{
+    const int segments[] = { 1000, 10000, 100000, 1000000 };
+    const int variants[] = { 10, 50, 100, 500 };
+    int nb_sizes = bench_quick ? 3 : 4;
+    parse_ctx_t ctx;
+    generate_opts_t opts;
+    int i;
+
+    generate_opts_init(&opts);
+
+    for(i = 0; i < nb_sizes; ++i) {
+        opts.nb_segments = segments[i];
+        ctx.src = NULL;
+        if(generate_media_source(&opts, &ctx.src, &ctx.size) != HLS_OK) {
+            fprintf(stderr, "unable to generate a %d segment playlist\n", segments[i]);
+            continue;
+        }
+        bench_t b = { "parse_media", "segment", segments[i], (size_t)ctx.size, bench_parse_media, bench_parse_media_reset, &ctx };
+        bench(&b);
+        bench_t skip = { "parse_media_skip", "segment", segments[i], (size_t)ctx.size, bench_parse_media_skip, bench_parse_media_reset, &ctx };
+        bench(&skip);
+        bench_t tail = { "parse_media_tail", "segment", segments[i], (size_t)ctx.size, bench_parse_media_tail, bench_parse_media_reset, &ctx };
+        bench(&tail);
+        bench_t summary = { "parse_media_summary", "segment", segments[i], (size_t)ctx.size, bench_parse_media_summary, NULL, &ctx };
+        bench(&summary);
+        bench_t reader = { "parse_media_reader", "segment", segments[i], (size_t)ctx.size, bench_parse_media_reader, NULL, &ctx };
+        bench(&reader);
+        hls_free(ctx.src);
+    }
+
+    for(i = 0; i < 4; ++i) {
+        opts.nb_variants = variants[i];
+        ctx.src = NULL;
+        if(generate_master_source(&opts, &ctx.src, &ctx.size) != HLS_OK) {
+            fprintf(stderr, "unable to generate a %d variant master playlist\n", variants[i]);
+            continue;
+        }
+        bench_t b = { "parse_master", "variant", variants[i], (size_t)ctx.size, bench_parse_master, bench_parse_master_reset, &ctx };
+        bench(&b);
+        bench_t lazy = { "parse_master_lazy", "variant", variants[i], (size_t)ctx.size, bench_parse_master_lazy, bench_parse_master_reset, &ctx };
+        bench(&lazy);
+        hls_free(ctx.src);
+    }
+}
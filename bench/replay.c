@@ -0,0 +1,609 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "generate.h"
+#include "../src/parse.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * replay measures the steady state cost of reloading a live media playlist.
+ *
+ * It replays consecutive snapshots of a live playlist, either captured into a
+ * directory (replayed in file name order) or synthesized by sliding a window
+ * over a generated playlist, the way a polling player or origin handles them:
+ *
+ *   full    every snapshot is parsed into a new playlist, written and termed
+ *   update  a long running playlist with a window only parses the segments
+ *           which are new in each snapshot, then is written
+ *
+ * Latency percentiles are reported for every step along with the peak memory
+ * held while handling a snapshot, e.g.
+ *
+ *   ./replay -n 1000 -w 300 -r 10
+ *   ./replay -d captures/
+ */
+
+typedef struct {
+    char        *src;
+    int         size;
+    int         media_sequence;
+    int         nb_segments;
+} snapshot_t;
+
+typedef struct {
+    const char  *name;
+    uint64_t    *samples;
+    int         nb_samples;
+    size_t      peak_bytes;
+    double      allocs_per_op;
+} replay_result_t;
+
+static int replay_quick = 0;
+static FILE *replay_json = NULL;
+
+static uint64_t replay_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @returns the offset just past the end of the line starting at 'offset'.
+ */
+static int next_line(const char *src, int size, int offset)
+{
+    const char *end = memchr(&src[offset], '\n', size - offset);
+    return end ? end - src + 1 : size;
+}
+
+static int is_uri_line(const char *line, int size)
+{
+    return size > 0 && line[0] != '#' && line[0] != '\n' && line[0] != '\r';
+}
+
+/**
+ * Finds the offset just past the uri line of segment 'index', or 0 when the
+ * snapshot has fewer segments.
+ */
+static int segment_end(const char *src, int size, int index)
+{
+    int offset = 0;
+    while(offset < size) {
+        int next = next_line(src, size, offset);
+        if(is_uri_line(&src[offset], size - offset) && index-- == 0) {
+            return next;
+        }
+        offset = next;
+    }
+    return 0;
+}
+
+static void snapshot_init(snapshot_t *snap, char *src, int size)
+{
+    snap->src = src;
+    snap->size = size;
+    snap->nb_segments = 0;
+
+    const char *seq = strstr(src, "#" EXTXMEDIASEQUENCE ":");
+    snap->media_sequence = seq ? atoi(&seq[sizeof(EXTXMEDIASEQUENCE) + 1]) : 0;
+
+    int offset = 0;
+    while(offset < size) {
+        if(is_uri_line(&src[offset], size - offset)) {
+            ++(snap->nb_segments);
+        }
+        offset = next_line(src, size, offset);
+    }
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(const char**)a, *(const char**)b);
+}
+
+static char *read_file(const char *path, int *size)
+{
+    FILE *file = fopen(path, "rb");
+    if(!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *src = malloc(length + 1);
+    if(src && fread(src, 1, length, file) != (size_t)length) {
+        free(src);
+        src = NULL;
+    }
+    fclose(file);
+
+    if(src) {
+        src[length] = '\0';
+        *size = (int)length;
+    }
+    return src;
+}
+
+/**
+ * Loads every regular file of a directory as a snapshot, in file name order.
+ */
+static int load_snapshots(const char *dir, snapshot_t **dest)
+{
+    DIR *d = opendir(dir);
+    if(!d) {
+        return -1;
+    }
+
+    char **names = NULL;
+    int nb_names = 0;
+    struct dirent *entry;
+    while((entry = readdir(d))) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+        names = realloc(names, (nb_names + 1) * sizeof(char*));
+        names[nb_names++] = strdup(entry->d_name);
+    }
+    closedir(d);
+
+    qsort(names, nb_names, sizeof(char*), compare_names);
+
+    snapshot_t *snaps = calloc(nb_names ? nb_names : 1, sizeof(snapshot_t));
+    int nb_snaps = 0;
+    int i;
+    for(i = 0; i < nb_names; ++i) {
+        char path[4096];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        int size = 0;
+        char *src = NULL;
+        if(stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            src = read_file(path, &size);
+        }
+        if(src) {
+            snapshot_init(&snaps[nb_snaps++], src, size);
+        }
+        free(names[i]);
+    }
+    free(names);
+
+    *dest = snaps;
+    return nb_snaps;
+}
+
+/**
+ * Synthesizes snapshots the way an origin produces them: a generated live
+ * playlist is fed into a playlist with a window of 'window' segments, 'step'
+ * segments at a time, and the window is written out after each step.
+ */
+static int synthesize_snapshots(const generate_opts_t *opts, int nb_snapshots, int window, int step, snapshot_t **dest)
+{
+    generate_opts_t gen = *opts;
+    gen.live = HLS_TRUE;
+    gen.nb_segments = window + (nb_snapshots - 1) * step;
+
+    char *src = NULL;
+    int size = 0;
+    if(generate_media_source(&gen, &src, &size) != HLS_OK) {
+        return -1;
+    }
+
+    media_playlist_t origin;
+    hlsparse_media_playlist_init(&origin);
+    origin.window_size = window;
+
+    snapshot_t *snaps = calloc(nb_snapshots, sizeof(snapshot_t));
+    int offset = 0;
+    int i;
+    for(i = 0; i < nb_snapshots; ++i) {
+        int end = segment_end(&src[offset], size - offset, i == 0 ? window - 1 : step - 1);
+        if(end == 0) {
+            break;
+        }
+        hlsparse_media_playlist(&src[offset], end, &origin);
+        offset += end;
+
+        char *out = NULL;
+        int out_size = 0;
+        hlswrite_media(&out, &out_size, &origin);
+        snapshot_init(&snaps[i], out, out_size);
+    }
+
+    hlsparse_media_playlist_term(&origin);
+    hls_free(src);
+
+    *dest = snaps;
+    return i;
+}
+
+static int save_snapshots(const char *dir, const snapshot_t *snaps, int nb_snaps)
+{
+    int i;
+    for(i = 0; i < nb_snaps; ++i) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%06d.m3u8", dir, i);
+        FILE *file = fopen(path, "wb");
+        if(!file) {
+            return -1;
+        }
+        fwrite(snaps[i].src, 1, snaps[i].size, file);
+        fclose(file);
+    }
+    return 0;
+}
+
+/**
+ * Brings a long running playlist up to date with a snapshot by parsing only
+ * the text after the last segment it already holds. Falls back to parsing the
+ * whole snapshot when the two don't overlap.
+ *
+ * @returns HLS_TRUE when the whole snapshot was parsed.
+ */
+static bool_t update_playlist(media_playlist_t *live, const snapshot_t *snap)
+{
+    int next = live->media_sequence + live->nb_segments;
+    int skip = next - snap->media_sequence;
+
+    live->window_size = snap->nb_segments;
+
+    if(live->nb_segments > 0 && skip > 0 && skip <= snap->nb_segments) {
+        int offset = segment_end(snap->src, snap->size, skip - 1);
+        if(offset < snap->size) {
+            hlsparse_media_playlist(&snap->src[offset], snap->size - offset, live);
+        }
+        return HLS_FALSE;
+    }
+
+    hlsparse_media_playlist_term(live);
+    hlsparse_media_playlist_init(live);
+    live->window_size = snap->nb_segments;
+    hlsparse_media_playlist(snap->src, snap->size, live);
+    return HLS_TRUE;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, int n, double p)
+{
+    int index = (int)(p * n + 0.999999) - 1;
+    if(index < 0) {
+        index = 0;
+    }
+    return sorted[index < n ? index : n - 1];
+}
+
+static void report(replay_result_t *r, int nb_snaps, int nb_segments)
+{
+    qsort(r->samples, r->nb_samples, sizeof(uint64_t), compare_samples);
+    uint64_t p50 = percentile(r->samples, r->nb_samples, 0.50);
+    uint64_t p99 = percentile(r->samples, r->nb_samples, 0.99);
+    uint64_t p999 = percentile(r->samples, r->nb_samples, 0.999);
+    uint64_t max = r->samples[r->nb_samples - 1];
+
+    printf("%-14s %8d %10.1f %10.1f %10.1f %10.1f %12zu %10.1f\n",
+           r->name, r->nb_samples, p50 / 1e3, p99 / 1e3, p999 / 1e3, max / 1e3,
+           r->peak_bytes, r->allocs_per_op);
+    fflush(stdout);
+
+    if(replay_json) {
+        fprintf(replay_json, "{\"name\":\"replay_%s\",\"snapshots\":%d,\"segments\":%d,\"ops\":%d,"
+                "\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,"
+                "\"peak_bytes\":%zu,\"allocs_per_op\":%.1f,\"timestamp\":%lld}\n",
+                r->name, nb_snaps, nb_segments, r->nb_samples,
+                (unsigned long long)p50, (unsigned long long)p99,
+                (unsigned long long)p999, (unsigned long long)max,
+                r->peak_bytes, r->allocs_per_op, (long long)time(NULL));
+    }
+}
+
+/**
+ * Keeps the highest peak seen by a step and adds up its allocations, less
+ * those made by the steps before it since the statistics were reset.
+ */
+static void record_memory(replay_result_t *r, const hlsparse_alloc_stats_t *stats, uint64_t allocs_before)
+{
+    if(stats->peak_live_bytes > r->peak_bytes) {
+        r->peak_bytes = stats->peak_live_bytes;
+    }
+    r->allocs_per_op += stats->nb_allocs - allocs_before;
+}
+
+#define FULL_PARSE  0
+#define FULL_WRITE  1
+#define FULL_TERM   2
+#define FULL_TOTAL  3
+
+static void replay_full(const snapshot_t *snaps, int nb_snaps, int rounds, int nb_segments)
+{
+    replay_result_t results[4] = {
+        { "full.parse" }, { "full.write" }, { "full.term" }, { "full" }
+    };
+    int nb_ops = nb_snaps * rounds;
+    int i, r;
+    for(i = 0; i < 4; ++i) {
+        results[i].samples = malloc(nb_ops * sizeof(uint64_t));
+    }
+
+    for(r = 0; r < rounds; ++r) {
+        for(i = 0; i < nb_snaps; ++i) {
+            media_playlist_t playlist;
+            char *out = NULL;
+            int size = 0;
+
+            uint64_t t0 = replay_now();
+            hlsparse_media_playlist_init(&playlist);
+            hlsparse_media_playlist(snaps[i].src, snaps[i].size, &playlist);
+            uint64_t t1 = replay_now();
+            hlswrite_media(&out, &size, &playlist);
+            uint64_t t2 = replay_now();
+            hlsparse_media_playlist_term(&playlist);
+            hls_free(out);
+            uint64_t t3 = replay_now();
+
+            int n = results[FULL_TOTAL].nb_samples;
+            results[FULL_PARSE].samples[n] = t1 - t0;
+            results[FULL_WRITE].samples[n] = t2 - t1;
+            results[FULL_TERM].samples[n] = t3 - t2;
+            results[FULL_TOTAL].samples[n] = t3 - t0;
+            int k;
+            for(k = 0; k < 4; ++k) {
+                ++(results[k].nb_samples);
+            }
+        }
+    }
+
+    // a separate untimed pass records the memory held while handling each
+    // snapshot, recording slows down every allocation
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    for(i = 0; i < nb_snaps; ++i) {
+        media_playlist_t playlist;
+        char *out = NULL;
+        int size = 0;
+
+        hlsparse_alloc_stats_reset();
+        hlsparse_media_playlist_init(&playlist);
+        hlsparse_media_playlist(snaps[i].src, snaps[i].size, &playlist);
+        hlsparse_alloc_stats(&stats);
+        record_memory(&results[FULL_PARSE], &stats, 0);
+        uint64_t parse_allocs = stats.nb_allocs;
+
+        hlswrite_media(&out, &size, &playlist);
+        hlsparse_alloc_stats(&stats);
+        record_memory(&results[FULL_WRITE], &stats, parse_allocs);
+
+        hlsparse_media_playlist_term(&playlist);
+        hls_free(out);
+        hlsparse_alloc_stats(&stats);
+        record_memory(&results[FULL_TERM], &stats, stats.nb_allocs);
+        record_memory(&results[FULL_TOTAL], &stats, 0);
+    }
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    for(i = 0; i < 4; ++i) {
+        results[i].allocs_per_op /= nb_snaps;
+    }
+
+    for(i = 0; i < 4; ++i) {
+        report(&results[i], nb_snaps, nb_segments);
+        free(results[i].samples);
+    }
+}
+
+#define UPDATE_PARSE    0
+#define UPDATE_WRITE    1
+#define UPDATE_TOTAL    2
+
+static void replay_update(const snapshot_t *snaps, int nb_snaps, int rounds, int nb_segments)
+{
+    replay_result_t results[3] = {
+        { "update.parse" }, { "update.write" }, { "update" }
+    };
+    int nb_ops = nb_snaps * rounds;
+    int resyncs = 0;
+    int i, r;
+    for(i = 0; i < 3; ++i) {
+        results[i].samples = malloc(nb_ops * sizeof(uint64_t));
+    }
+
+    for(r = 0; r < rounds; ++r) {
+        media_playlist_t live;
+        hlsparse_media_playlist_init(&live);
+
+        for(i = 0; i < nb_snaps; ++i) {
+            char *out = NULL;
+            int size = 0;
+
+            uint64_t t0 = replay_now();
+            resyncs += update_playlist(&live, &snaps[i]);
+            uint64_t t1 = replay_now();
+            hlswrite_media(&out, &size, &live);
+            hls_free(out);
+            uint64_t t2 = replay_now();
+
+            int n = results[UPDATE_TOTAL].nb_samples;
+            results[UPDATE_PARSE].samples[n] = t1 - t0;
+            results[UPDATE_WRITE].samples[n] = t2 - t1;
+            results[UPDATE_TOTAL].samples[n] = t2 - t0;
+            int k;
+            for(k = 0; k < 3; ++k) {
+                ++(results[k].nb_samples);
+            }
+        }
+
+        hlsparse_media_playlist_term(&live);
+    }
+
+    // the long running playlist stays live between reloads so it is part of
+    // every peak
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    media_playlist_t live;
+    hlsparse_media_playlist_init(&live);
+    for(i = 0; i < nb_snaps; ++i) {
+        char *out = NULL;
+        int size = 0;
+
+        hlsparse_alloc_stats_reset();
+        update_playlist(&live, &snaps[i]);
+        hlsparse_alloc_stats(&stats);
+        record_memory(&results[UPDATE_PARSE], &stats, 0);
+        record_memory(&results[UPDATE_TOTAL], &stats, 0);
+
+        hlsparse_alloc_stats_reset();
+        hlswrite_media(&out, &size, &live);
+        hls_free(out);
+        hlsparse_alloc_stats(&stats);
+        record_memory(&results[UPDATE_WRITE], &stats, 0);
+        record_memory(&results[UPDATE_TOTAL], &stats, 0);
+    }
+    hlsparse_media_playlist_term(&live);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    for(i = 0; i < 3; ++i) {
+        results[i].allocs_per_op /= nb_snaps;
+    }
+
+    for(i = 0; i < 3; ++i) {
+        report(&results[i], nb_snaps, nb_segments);
+        free(results[i].samples);
+    }
+    if(resyncs > rounds) {
+        printf("update parsed %d whole snapshots, the snapshots don't overlap\n", resyncs - rounds);
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [options] [generator options]\n", name);
+    fprintf(stderr, "  -d dir         replay the snapshots in dir, in file name order\n");
+    fprintf(stderr, "  -n snapshots   number of snapshots to synthesize (default 1000)\n");
+    fprintf(stderr, "  -w segments    segments in each synthesized snapshot (default 100)\n");
+    fprintf(stderr, "  -i segments    segments added between synthesized snapshots (default 1)\n");
+    fprintf(stderr, "  -o dir         save the synthesized snapshots to dir\n");
+    fprintf(stderr, "  -r rounds      times the snapshots are replayed (default 10)\n");
+    fprintf(stderr, "  -m mode        full, update or all (default all)\n");
+    fprintf(stderr, "  -q             fewer snapshots and a single round\n");
+    fprintf(stderr, "  -j file        append the results to file as JSON lines\n");
+    fprintf(stderr, "generator options, see hlsgen -h:\n");
+    fprintf(stderr, "  -s seed -k segments -b segments -f -a segments -l segments -D segments -t characters -c segments\n");
+}
+
+int main(int argc, char **argv)
+{
+    generate_opts_t opts;
+    const char *dir = NULL;
+    const char *save_dir = NULL;
+    const char *mode = "all";
+    int nb_snapshots = 1000;
+    int window = 100;
+    int step = 1;
+    int rounds = 10;
+    int c;
+
+    hlsparse_global_init();
+    generate_opts_init(&opts);
+
+    while((c = getopt(argc, argv, "d:n:w:i:o:r:m:qj:s:k:b:fa:l:D:t:c:h")) != -1) {
+        switch(c) {
+            case 'd': dir = optarg; break;
+            case 'n': nb_snapshots = atoi(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            case 'i': step = atoi(optarg); break;
+            case 'o': save_dir = optarg; break;
+            case 'r': rounds = atoi(optarg); break;
+            case 'm': mode = optarg; break;
+            case 'q': replay_quick = 1; break;
+            case 'j':
+                replay_json = fopen(optarg, "a");
+                if(!replay_json) {
+                    fprintf(stderr, "unable to open %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 's': opts.seed = strtoull(optarg, NULL, 10); break;
+            case 'k': opts.key_rotation = atoi(optarg); break;
+            case 'b': opts.segments_per_file = atoi(optarg); break;
+            case 'f': opts.fmp4 = HLS_TRUE; break;
+            case 'a': opts.ad_interval = atoi(optarg); break;
+            case 'l': opts.ad_length = atoi(optarg); break;
+            case 'D': opts.discontinuity_interval = atoi(optarg); break;
+            case 't': opts.uri_token_size = atoi(optarg); break;
+            case 'c': opts.custom_tag_interval = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(replay_quick) {
+        nb_snapshots = nb_snapshots < 200 ? nb_snapshots : 200;
+        rounds = 1;
+    }
+    if(nb_snapshots <= 0 || window <= 0 || step <= 0 || rounds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    snapshot_t *snaps = NULL;
+    int nb_snaps = dir ? load_snapshots(dir, &snaps) :
+                         synthesize_snapshots(&opts, nb_snapshots, window, step, &snaps);
+    if(nb_snaps <= 0) {
+        fprintf(stderr, "no snapshots to replay\n");
+        return 1;
+    }
+
+    if(save_dir && save_snapshots(save_dir, snaps, nb_snaps) != 0) {
+        fprintf(stderr, "unable to save the snapshots to %s\n", save_dir);
+        return 1;
+    }
+
+    int segments = 0;
+    int i;
+    for(i = 0; i < nb_snaps; ++i) {
+        segments += snaps[i].nb_segments;
+    }
+    segments /= nb_snaps;
+
+    printf("%d snapshots, %d segments on average, %d rounds\n", nb_snaps, segments, rounds);
+    printf("%-14s %8s %10s %10s %10s %10s %12s %10s\n",
+           "step", "ops", "p50 us", "p99 us", "p99.9 us", "max us", "peak bytes", "allocs/op");
+
+    if(!strcmp(mode, "full") || !strcmp(mode, "all")) {
+        replay_full(snaps, nb_snaps, rounds, segments);
+    }
+    if(!strcmp(mode, "update") || !strcmp(mode, "all")) {
+        replay_update(snaps, nb_snaps, rounds, segments);
+    }
+
+    for(i = 0; i < nb_snaps; ++i) {
+        if(dir) {
+            free(snaps[i].src);
+        } else {
+            hls_free(snaps[i].src);
+        }
+    }
+    free(snaps);
+
+    if(replay_json) {
+        fclose(replay_json);
+    }
+    return 0;
+}
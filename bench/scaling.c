@@ -0,0 +1,402 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "generate.h"
+#include "../src/parse.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * scaling measures how parse and write throughput grows with threads.
+ *
+ * Every thread works on its own playlists so any loss of throughput as
+ * threads are added comes from state shared inside the library or the
+ * allocator. Each workload runs on 1, 2, 4... up to the number of cores with
+ * each of these allocators installed through hlsparse_global_init_mem:
+ *
+ *   libc     malloc and free
+ *   counted  malloc and free counting into shared atomics, like allocation
+ *            instrumentation often does
+ *   locked   malloc and free behind a single mutex, an allocator with one
+ *            shared heap
+ *   cached   per-thread free lists in front of malloc, an allocator which
+ *            shares nothing once warm
+ *
+ * e.g.
+ *
+ *   ./scaling -T 64 -n 10000
+ */
+
+#define SCALING_MAX_THREADS 256
+
+typedef void (*workload_fn_t)(void *ctx);
+
+typedef struct {
+    const char      *name;
+    workload_fn_t   setup;      // called once per thread before timing, may be NULL
+    workload_fn_t   run;
+    workload_fn_t   teardown;   // may be NULL
+} workload_t;
+
+typedef struct {
+    const char                  *name;
+    hlsparse_malloc_callback    m;
+    hlsparse_free_callback      f;
+} allocator_t;
+
+typedef struct {
+    const workload_t    *workload;
+    double              seconds;
+    uint64_t            ops;
+    media_playlist_t    playlist;
+} worker_t;
+
+static const char *scaling_src = NULL;
+static int scaling_size = 0;
+static FILE *scaling_json = NULL;
+
+static pthread_barrier_t scaling_barrier;
+static volatile int scaling_stop = 0;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * allocators
+ */
+
+static uint64_t counted_allocs = 0;
+static uint64_t counted_frees = 0;
+
+static void *counted_malloc(size_t size)
+{
+    __atomic_fetch_add(&counted_allocs, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+static void counted_free(void *ptr)
+{
+    __atomic_fetch_add(&counted_frees, 1, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+static pthread_mutex_t locked_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void *locked_malloc(size_t size)
+{
+    pthread_mutex_lock(&locked_mutex);
+    void *ptr = malloc(size);
+    pthread_mutex_unlock(&locked_mutex);
+    return ptr;
+}
+
+static void locked_free(void *ptr)
+{
+    pthread_mutex_lock(&locked_mutex);
+    free(ptr);
+    pthread_mutex_unlock(&locked_mutex);
+}
+
+// size classes of 16 bytes up to 512 bytes, larger blocks go to malloc
+#define CACHED_CLASSES  32
+#define CACHED_HEADER   16
+
+static _Thread_local void *cached_lists[CACHED_CLASSES];
+
+static void *cached_malloc(size_t size)
+{
+    size_t cls = (size + 15) / 16;
+    if(cls >= CACHED_CLASSES) {
+        cls = 0;
+    }
+    char *block = cls ? cached_lists[cls] : NULL;
+    if(block) {
+        cached_lists[cls] = *(void**)(block + CACHED_HEADER);
+    } else {
+        block = malloc(CACHED_HEADER + (cls ? cls * 16 : size));
+        if(!block) {
+            return NULL;
+        }
+    }
+    *(size_t*)block = cls;
+    return block + CACHED_HEADER;
+}
+
+static void cached_free(void *ptr)
+{
+    if(!ptr) {
+        return;
+    }
+    char *block = (char*)ptr - CACHED_HEADER;
+    size_t cls = *(size_t*)block;
+    if(cls) {
+        // blocks freed on another thread join that thread's lists
+        *(void**)ptr = cached_lists[cls];
+        cached_lists[cls] = block;
+    } else {
+        free(block);
+    }
+}
+
+static const allocator_t allocators[] = {
+    { "libc", (hlsparse_malloc_callback)malloc, (hlsparse_free_callback)free },
+    { "counted", counted_malloc, counted_free },
+    { "locked", locked_malloc, locked_free },
+    { "cached", cached_malloc, cached_free },
+};
+
+/*
+ * workloads
+ */
+
+static void parse_run(void *ctx)
+{
+    worker_t *w = ctx;
+    hlsparse_media_playlist_init(&w->playlist);
+    hlsparse_media_playlist(scaling_src, scaling_size, &w->playlist);
+    hlsparse_media_playlist_term(&w->playlist);
+}
+
+static void write_setup(void *ctx)
+{
+    worker_t *w = ctx;
+    hlsparse_media_playlist_init(&w->playlist);
+    hlsparse_media_playlist(scaling_src, scaling_size, &w->playlist);
+}
+
+static void write_run(void *ctx)
+{
+    worker_t *w = ctx;
+    char *out = NULL;
+    int size = 0;
+    hlswrite_media(&out, &size, &w->playlist);
+    hls_free(out);
+}
+
+static void write_teardown(void *ctx)
+{
+    worker_t *w = ctx;
+    hlsparse_media_playlist_term(&w->playlist);
+}
+
+static void reload_run(void *ctx)
+{
+    parse_run(ctx);
+    write_setup(ctx);
+    write_run(ctx);
+    write_teardown(ctx);
+}
+
+static const workload_t workloads[] = {
+    { "parse", NULL, parse_run, NULL },
+    { "write", write_setup, write_run, write_teardown },
+    { "reload", NULL, reload_run, NULL },
+};
+
+static void *worker(void *arg)
+{
+    worker_t *w = arg;
+
+    if(w->workload->setup) {
+        w->workload->setup(w);
+    }
+
+    pthread_barrier_wait(&scaling_barrier);
+
+    double start = now();
+    uint64_t ops = 0;
+    while(!__atomic_load_n(&scaling_stop, __ATOMIC_RELAXED)) {
+        w->workload->run(w);
+        ++ops;
+    }
+    w->seconds = now() - start;
+    w->ops = ops;
+
+    if(w->workload->teardown) {
+        w->workload->teardown(w);
+    }
+    return NULL;
+}
+
+/**
+ * Runs a workload on a number of threads for a fixed time.
+ *
+ * @returns the total operations per second.
+ */
+static double run_threads(const workload_t *workload, int nb_threads, double seconds)
+{
+    pthread_t threads[SCALING_MAX_THREADS];
+    worker_t workers[SCALING_MAX_THREADS];
+    int i;
+
+    scaling_stop = 0;
+    pthread_barrier_init(&scaling_barrier, NULL, nb_threads + 1);
+    for(i = 0; i < nb_threads; ++i) {
+        memset(&workers[i], 0, sizeof(worker_t));
+        workers[i].workload = workload;
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    pthread_barrier_wait(&scaling_barrier);
+    struct timespec ts = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&ts, NULL);
+    __atomic_store_n(&scaling_stop, 1, __ATOMIC_RELAXED);
+
+    double total = 0;
+    for(i = 0; i < nb_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        total += workers[i].ops / workers[i].seconds;
+    }
+    pthread_barrier_destroy(&scaling_barrier);
+
+    return total;
+}
+
+static void plot(double speedup, int max_threads)
+{
+    int width = (int)(speedup * 40 / max_threads + 0.5);
+    int i;
+    for(i = 0; i < width && i < 40; ++i) {
+        putchar('#');
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-q] [-T threads] [-n segments] [-t seconds] [-a allocator] [-w workload] [-j file]\n", name);
+    fprintf(stderr, "  -q              a single allocator and a shorter run\n");
+    fprintf(stderr, "  -T threads      largest number of threads (default the number of cores)\n");
+    fprintf(stderr, "  -n segments     segments in the playlist (default 1000)\n");
+    fprintf(stderr, "  -t seconds      time spent on every measurement (default 0.5)\n");
+    fprintf(stderr, "  -a allocator    libc, counted, locked or cached (default all)\n");
+    fprintf(stderr, "  -w workload     parse, write or reload (default all)\n");
+    fprintf(stderr, "  -j file         append the results to file as JSON lines\n");
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int nb_segments = 1000;
+    double seconds = 0.5;
+    const char *only_allocator = NULL;
+    const char *only_workload = NULL;
+    int quick = 0;
+    int c;
+
+    while((c = getopt(argc, argv, "qT:n:t:a:w:j:h")) != -1) {
+        switch(c) {
+            case 'q': quick = 1; break;
+            case 'T': max_threads = atoi(optarg); break;
+            case 'n': nb_segments = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'a': only_allocator = optarg; break;
+            case 'w': only_workload = optarg; break;
+            case 'j':
+                scaling_json = fopen(optarg, "a");
+                if(!scaling_json) {
+                    fprintf(stderr, "unable to open %s\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(quick) {
+        only_allocator = only_allocator ? only_allocator : "libc";
+        seconds = seconds < 0.2 ? seconds : 0.2;
+    }
+    if(max_threads < 1) {
+        max_threads = 1;
+    }
+    if(max_threads > SCALING_MAX_THREADS) {
+        max_threads = SCALING_MAX_THREADS;
+    }
+    if(nb_segments <= 0 || seconds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    hlsparse_global_init();
+
+    generate_opts_t opts;
+    generate_opts_init(&opts);
+    opts.nb_segments = nb_segments;
+    char *src = NULL;
+    if(generate_media_source(&opts, &src, &scaling_size) != HLS_OK) {
+        fprintf(stderr, "unable to generate the playlist\n");
+        return 1;
+    }
+    // the source is allocated before any allocator is swapped in
+    scaling_src = src;
+
+    printf("%d segments, %d bytes, up to %d threads\n", nb_segments, scaling_size, max_threads);
+    printf("%-8s %-8s %8s %14s %9s %10s\n", "workload", "alloc", "threads", "ops/s", "speedup", "efficiency");
+
+    int w, a;
+    for(w = 0; w < (int)(sizeof(workloads) / sizeof(workloads[0])); ++w) {
+        const workload_t *workload = &workloads[w];
+        if(only_workload && strcmp(only_workload, workload->name)) {
+            continue;
+        }
+
+        for(a = 0; a < (int)(sizeof(allocators) / sizeof(allocators[0])); ++a) {
+            const allocator_t *allocator = &allocators[a];
+            if(only_allocator && strcmp(only_allocator, allocator->name)) {
+                continue;
+            }
+
+            hlsparse_global_init_mem(allocator->m, allocator->f);
+
+            double single = 0;
+            int threads;
+            for(threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2) {
+                double ops = run_threads(workload, threads, seconds);
+                if(threads == 1) {
+                    single = ops;
+                }
+                double speedup = single > 0 ? ops / single : 0;
+
+                printf("%-8s %-8s %8d %14.1f %8.2fx %9.1f%% ", workload->name, allocator->name,
+                       threads, ops, speedup, 100.0 * speedup / threads);
+                plot(speedup, max_threads);
+                printf("\n");
+                fflush(stdout);
+
+                if(scaling_json) {
+                    fprintf(scaling_json, "{\"name\":\"scaling_%s_%s\",\"threads\":%d,\"segments\":%d,"
+                            "\"bytes\":%d,\"ops_per_s\":%.1f,\"mb_per_s\":%.3f,\"speedup\":%.3f,"
+                            "\"timestamp\":%lld}\n", workload->name, allocator->name, threads,
+                            nb_segments, scaling_size, ops, ops * scaling_size / 1e6, speedup,
+                            (long long)time(NULL));
+                }
+
+                if(threads == max_threads) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // blocks held in the per-thread caches of finished threads are not returned
+    hlsparse_global_init();
+    free(src);
+
+    if(scaling_json) {
+        fclose(scaling_json);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "bench.h"
+#include "generate.h"
+#include "../src/parse.h"
+#include <stdio.h>
+
+typedef struct {
+    media_playlist_t    playlist;
+    master_t            master;
+    char               *out;
+    int                 size;
+} write_ctx_t;
+
+static void bench_write_media(void *ctx)
+{
+    write_ctx_t *c = ctx;
+    hlswrite_media(&c->out, &c->size, &c->playlist);
+}
+
+static void bench_write_master(void *ctx)
+{
+    write_ctx_t *c = ctx;
+    hlswrite_master(&c->out, &c->size, &c->master);
+}
+
+static void bench_write_reset(void *ctx)
+{
+    write_ctx_t *c = ctx;
+    if(c->out) {
+        hls_free(c->out);
+        c->out = NULL;
+    }
+}
+
+void setup(void)
+{
+    const int segments[] = { 1000, 10000, 100000, 1000000 };
+    const int variants[] = { 10, 50, 100, 500 };
+    int nb_sizes = bench_quick ? 3 : 4;
+    write_ctx_t ctx = { .out = NULL, .size = 0 };
+    generate_opts_t opts;
+    int i;
+
+    generate_opts_init(&opts);
+
+    for(i = 0; i < nb_sizes; ++i) {
+        opts.nb_segments = segments[i];
+        hlsparse_media_playlist_init(&ctx.playlist);
+        if(generate_media_playlist(&opts, &ctx.playlist) != HLS_OK) {
+            fprintf(stderr, "unable to generate a %d segment playlist\n", segments[i]);
+            hlsparse_media_playlist_term(&ctx.playlist);
+            continue;
+        }
+
+        // the throughput is measured against the size of the written playlist
+        bench_write_media(&ctx);
+        bench_t b = { "write_media", "segment", segments[i], (size_t)ctx.size, bench_write_media, bench_write_reset, &ctx };
+        bench_write_reset(&ctx);
+        bench(&b);
+        hlsparse_media_playlist_term(&ctx.playlist);
+    }
+
+    for(i = 0; i < 4; ++i) {
+        opts.nb_variants = variants[i];
+        hlsparse_master_init(&ctx.master);
+        if(generate_master(&opts, &ctx.master) != HLS_OK) {
+            fprintf(stderr, "unable to generate a %d variant master playlist\n", variants[i]);
+            hlsparse_master_term(&ctx.master);
+            continue;
+        }
+
+        bench_write_master(&ctx);
+        bench_t b = { "write_master", "variant", variants[i], (size_t)ctx.size, bench_write_master, bench_write_reset, &ctx };
+        bench_write_reset(&ctx);
+        bench(&b);
+        hlsparse_master_term(&ctx.master);
+    }
+}
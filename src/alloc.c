@@ -0,0 +1,223 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Allocation statistics
+ *
+ * Every hls_malloc made by the library passes the name of the calling
+ * function. While statistics are enabled each live allocation is kept in an
+ * open addressing table from its pointer to its size and call site so that
+ * hls_free can account for the bytes it releases. Pointers which aren't in
+ * the table, e.g. allocated before the statistics were enabled, are ignored.
+ * The table itself is allocated with the C library rather than hls_malloc so
+ * it isn't part of the statistics.
+ */
+
+typedef struct {
+    const void  *ptr;
+    size_t      size;
+    int         site;
+} alloc_entry_t;
+
+static bool_t alloc_stats_enabled = HLS_FALSE;
+static hlsparse_alloc_stats_t alloc_stats;
+static alloc_entry_t *alloc_table = NULL;
+static size_t alloc_table_size = 0; // always a power of 2
+static size_t alloc_table_count = 0;
+
+static size_t alloc_slot(const void *ptr, size_t size)
+{
+    uint64_t h = ((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & (size - 1);
+}
+
+static void alloc_table_insert(alloc_entry_t *table, size_t size, const alloc_entry_t *entry)
+{
+    size_t i = alloc_slot(entry->ptr, size);
+    while(table[i].ptr) {
+        i = (i + 1) & (size - 1);
+    }
+    table[i] = *entry;
+}
+
+static bool_t alloc_table_grow(void)
+{
+    size_t size = alloc_table_size ? alloc_table_size * 2 : 1024;
+    alloc_entry_t *table = calloc(size, sizeof(alloc_entry_t));
+    if(!table) {
+        return HLS_FALSE;
+    }
+
+    size_t i;
+    for(i = 0; i < alloc_table_size; ++i) {
+        if(alloc_table[i].ptr) {
+            alloc_table_insert(table, size, &alloc_table[i]);
+        }
+    }
+
+    free(alloc_table);
+    alloc_table = table;
+    alloc_table_size = size;
+    return HLS_TRUE;
+}
+
+/**
+ * Finds the index of a call site in the statistics, adding it if it's new.
+ * Sites are compared by pointer as they're always the __func__ of the caller,
+ * any sites past HLSPARSE_ALLOC_SITES share the last entry.
+ */
+static int alloc_site(const char *site)
+{
+    int i;
+    for(i = 0; i < alloc_stats.nb_sites; ++i) {
+        if(alloc_stats.sites[i].site == site) {
+            return i;
+        }
+    }
+
+    if(alloc_stats.nb_sites == HLSPARSE_ALLOC_SITES) {
+        alloc_stats.sites[HLSPARSE_ALLOC_SITES - 1].site = "other";
+        return HLSPARSE_ALLOC_SITES - 1;
+    }
+
+    i = alloc_stats.nb_sites++;
+    alloc_stats.sites[i].site = site;
+    return i;
+}
+
+static void alloc_stats_add(const void *ptr, size_t size, const char *site)
+{
+    // keep the table at most half full
+    if((alloc_table_count + 1) * 2 > alloc_table_size && !alloc_table_grow()) {
+        return;
+    }
+
+    alloc_entry_t entry = { ptr, size, alloc_site(site) };
+    alloc_table_insert(alloc_table, alloc_table_size, &entry);
+    ++alloc_table_count;
+
+    hlsparse_alloc_site_t *s = &alloc_stats.sites[entry.site];
+    ++(s->nb_allocs);
+    s->bytes += size;
+    s->live_bytes += size;
+
+    ++(alloc_stats.nb_allocs);
+    ++(alloc_stats.nb_live);
+    alloc_stats.bytes += size;
+    alloc_stats.live_bytes += size;
+    if(alloc_stats.live_bytes > alloc_stats.peak_live_bytes) {
+        alloc_stats.peak_live_bytes = alloc_stats.live_bytes;
+    }
+}
+
+static void alloc_stats_remove(const void *ptr)
+{
+    if(!alloc_table) {
+        return;
+    }
+
+    size_t mask = alloc_table_size - 1;
+    size_t i = alloc_slot(ptr, alloc_table_size);
+    while(alloc_table[i].ptr != ptr) {
+        if(!alloc_table[i].ptr) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    hlsparse_alloc_site_t *s = &alloc_stats.sites[alloc_table[i].site];
+    ++(s->nb_frees);
+    s->live_bytes -= alloc_table[i].size;
+
+    ++(alloc_stats.nb_frees);
+    --(alloc_stats.nb_live);
+    alloc_stats.live_bytes -= alloc_table[i].size;
+    --alloc_table_count;
+
+    // shift the following entries back so that no lookup stops short
+    size_t j = i;
+    for(;;) {
+        alloc_table[i].ptr = NULL;
+        size_t home;
+        do {
+            j = (j + 1) & mask;
+            if(!alloc_table[j].ptr) {
+                return;
+            }
+            home = alloc_slot(alloc_table[j].ptr, alloc_table_size);
+        } while(i <= j ? (i < home && home <= j) : (i < home || home <= j));
+        alloc_table[i] = alloc_table[j];
+        i = j;
+    }
+}
+
+void *hls_malloc_site(size_t size, const char *site)
+{
+    void *ptr = (hls_malloc)(size);
+    if(alloc_stats_enabled && ptr) {
+        alloc_stats_add(ptr, size, site);
+    }
+    return ptr;
+}
+
+void hls_free_site(void *ptr)
+{
+    if(alloc_stats_enabled && ptr) {
+        alloc_stats_remove(ptr);
+    }
+    (hls_free)(ptr);
+}
+
+HLSCode hlsparse_alloc_stats_enable(bool_t enable)
+{
+    if(enable == alloc_stats_enabled) {
+        return HLS_OK;
+    }
+
+    memset(&alloc_stats, 0, sizeof(hlsparse_alloc_stats_t));
+    free(alloc_table);
+    alloc_table = NULL;
+    alloc_table_size = 0;
+    alloc_table_count = 0;
+
+    alloc_stats_enabled = enable ? HLS_TRUE : HLS_FALSE;
+    return HLS_OK;
+}
+
+HLSCode hlsparse_alloc_stats_reset(void)
+{
+    if(!alloc_stats_enabled) {
+        return HLS_ERROR;
+    }
+
+    // live allocations carry over, everything else starts from zero
+    alloc_stats.nb_allocs = 0;
+    alloc_stats.nb_frees = 0;
+    alloc_stats.bytes = 0;
+    alloc_stats.peak_live_bytes = alloc_stats.live_bytes;
+
+    int i;
+    for(i = 0; i < alloc_stats.nb_sites; ++i) {
+        alloc_stats.sites[i].nb_allocs = 0;
+        alloc_stats.sites[i].nb_frees = 0;
+        alloc_stats.sites[i].bytes = 0;
+    }
+
+    return HLS_OK;
+}
+
+HLSCode hlsparse_alloc_stats(hlsparse_alloc_stats_t *dest)
+{
+    if(!dest || !alloc_stats_enabled) {
+        return HLS_ERROR;
+    }
+
+    *dest = alloc_stats;
+    return HLS_OK;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/**
+ * Defines a function moving every node of the list \a src onto the end of the
+ * list \a head, whose last node is expected at \a tail when known.
+ * The first node of \a src is embedded in its owner so its content is moved
+ * into the preallocated \a node, which is freed when it isn't needed.
+ * Returns the new last node of \a head.
+ */
+#define DEFINE_LIST_SPLICE(name, type)                                      \
+static type *name(type *head, type *tail, type *src, type *src_tail, type *node) \
+{                                                                           \
+    type *last = tail ? tail : head;                                        \
+    while(last->next) {                                                     \
+        last = last->next;                                                  \
+    }                                                                       \
+    if(!src->data) {                                                        \
+        hls_free(node);                                                     \
+        return last;                                                        \
+    }                                                                       \
+    if(!last->data) {                                                       \
+        hls_free(node);                                                     \
+        node = last;                                                        \
+    } else {                                                                \
+        last->next = node;                                                  \
+    }                                                                       \
+    node->data = src->data;                                                 \
+    node->next = src->next;                                                 \
+    last = (src_tail && src_tail != src) ? src_tail : node;                 \
+    while(last->next) {                                                     \
+        last = last->next;                                                  \
+    }                                                                       \
+    src->data = NULL;                                                       \
+    src->next = NULL;                                                       \
+    return last;                                                            \
+}
+
+DEFINE_LIST_SPLICE(splice_segment_list, segment_list_t)
+DEFINE_LIST_SPLICE(splice_key_list, key_list_t)
+DEFINE_LIST_SPLICE(splice_map_list, map_list_t)
+DEFINE_LIST_SPLICE(splice_daterange_list, daterange_list_t)
+DEFINE_LIST_SPLICE(splice_string_list, string_list_t)
+
+/**
+ * Finds the key used by the last segment of a playlist.
+ *
+ * @returns the key, or NULL if the last segment isn't encrypted
+ */
+static const hls_key_t *last_segment_key(const media_playlist_t *playlist)
+{
+    if(!playlist->last_segment || playlist->last_segment->key_index < 0) {
+        return NULL;
+    }
+
+    int index = playlist->last_segment->key_index;
+    const key_list_t *key = &playlist->keys;
+    while(key && key->data && index > 0) {
+        key = key->next;
+        --index;
+    }
+    return key ? key->data : NULL;
+}
+
+HLSCode hlsparse_media_playlist_append(media_playlist_t *dest, media_playlist_t *src)
+{
+    if(!dest || !src || dest == src) {
+        return HLS_ERROR;
+    }
+
+    // allocate everything up front so that a failure leaves both playlists intact
+    segment_list_t *segment_node = hls_malloc(sizeof(segment_list_t));
+    key_list_t *key_node = hls_malloc(sizeof(key_list_t));
+    map_list_t *map_node = hls_malloc(sizeof(map_list_t));
+    daterange_list_t *daterange_node = hls_malloc(sizeof(daterange_list_t));
+    string_list_t *tag_node = hls_malloc(sizeof(string_list_t));
+
+    // segments of src which aren't encrypted would otherwise inherit the last
+    // key of dest, so they are given an explicit METHOD=NONE key
+    const hls_key_t *dest_key = last_segment_key(dest);
+    bool_t add_none_key = src->segments.data && src->segments.data->key_index < 0 &&
+                          dest_key && dest_key->method != KEY_METHOD_NONE;
+    hls_key_t *none_key = NULL;
+    key_list_t *none_key_node = NULL;
+    if(add_none_key) {
+        none_key = hls_malloc(sizeof(hls_key_t));
+        none_key_node = hls_malloc(sizeof(key_list_t));
+    }
+
+    if(!segment_node || !key_node || !map_node || !daterange_node || !tag_node ||
+       (add_none_key && (!none_key || !none_key_node))) {
+        void *nodes[] = { segment_node, key_node, map_node, daterange_node, tag_node, none_key, none_key_node };
+        int i;
+        for(i = 0; i < 7; ++i) {
+            if(nodes[i]) {
+                hls_free(nodes[i]);
+            }
+        }
+        return HLS_ERROR;
+    }
+
+    if(add_none_key) {
+        // dest already holds a key so the new node always follows its last one
+        key_list_t *last = dest->keys_tail ? dest->keys_tail : &dest->keys;
+        while(last->next) {
+            last = last->next;
+        }
+        hlsparse_key_init(none_key);
+        none_key->method = KEY_METHOD_NONE;
+        hlsparse_key_list_init(none_key_node);
+        none_key_node->data = none_key;
+        last->next = none_key_node;
+        dest->keys_tail = none_key_node;
+        ++(dest->nb_keys);
+    }
+
+    // remap the indexes and sequence numbers of src into the ranges of dest
+    int none_key_index = dest->nb_keys - 1;
+    segment_list_t *seg = &src->segments;
+    while(seg && seg->data) {
+        segment_t *segment = seg->data;
+        if(segment->key_index >= 0) {
+            segment->key_index += dest->nb_keys;
+        } else if(add_none_key) {
+            segment->key_index = none_key_index;
+        }
+        if(segment->map_index >= 0) {
+            segment->map_index += dest->nb_maps;
+        }
+        if(segment->daterange_index >= 0) {
+            segment->daterange_index += dest->nb_dateranges;
+        }
+        segment->sequence_num += dest->next_segment_media_sequence;
+        seg = seg->next;
+    }
+
+    // mark the join
+    if(dest->nb_segments > 0 && src->segments.data) {
+        src->segments.data->discontinuity = HLS_TRUE;
+    }
+
+    dest->segments_tail = splice_segment_list(&dest->segments, dest->segments_tail, &src->segments, src->segments_tail, segment_node);
+    dest->keys_tail = splice_key_list(&dest->keys, dest->keys_tail, &src->keys, src->keys_tail, key_node);
+    dest->maps_tail = splice_map_list(&dest->maps, dest->maps_tail, &src->maps, src->maps_tail, map_node);
+    dest->dateranges_tail = splice_daterange_list(&dest->dateranges, dest->dateranges_tail, &src->dateranges, src->dateranges_tail, daterange_node);
+    splice_string_list(&dest->custom_tags, NULL, &src->custom_tags, NULL, tag_node);
+
+    if(src->last_segment) {
+        dest->last_segment = src->last_segment;
+        dest->next_segment_pdt = src->next_segment_pdt;
+    }
+
+    dest->nb_segments += src->nb_segments;
+    dest->nb_keys += src->nb_keys;
+    dest->nb_maps += src->nb_maps;
+    dest->nb_dateranges += src->nb_dateranges;
+    dest->nb_custom_tags += src->nb_custom_tags;
+    dest->next_segment_media_sequence += src->next_segment_media_sequence;
+    dest->duration += src->duration;
+    dest->end_list = src->end_list;
+    dest->independent_segments = dest->independent_segments && src->independent_segments;
+    if(src->target_duration > dest->target_duration) {
+        dest->target_duration = src->target_duration;
+    }
+    if(src->version > dest->version) {
+        dest->version = src->version;
+    }
+
+    if(dest->window_size > 0 || dest->window_duration > 0) {
+        hlsparse_media_playlist_expire(dest);
+    }
+
+    if(dest->segment_hashes || dest->merkle_tree) {
+        hlsparse_media_playlist_hash_segments(dest);
+    }
+
+    // everything src owned now belongs to dest
+    src->nb_segments = src->nb_keys = src->nb_maps = src->nb_dateranges = 0;
+    src->last_segment = NULL;
+    src->segments_tail = NULL;
+    src->keys_tail = NULL;
+    src->maps_tail = NULL;
+    src->dateranges_tail = NULL;
+    hlsparse_media_playlist_term(src);
+
+    return HLS_OK;
+}
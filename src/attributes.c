@@ -0,0 +1,521 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Attribute schema
+ *
+ * The attributes of every tag with an attribute-list are declared here, the
+ * parser finds an attribute by the length of its name and a single compare and
+ * the writer writes the tables in order, so adding an attribute to a table is
+ * all it takes to both parse and write it.
+ */
+
+// an attribute of the struct named by ATTR_OWNER
+#define ATTR(name, type, flags, member, field) \
+    { name, sizeof(name) - 1, type, flags, offsetof(ATTR_OWNER, member), -1, field, NULL }
+#define ATTR_AUX(name, type, flags, member, aux, field, values) \
+    { name, sizeof(name) - 1, type, flags, offsetof(ATTR_OWNER, member), offsetof(ATTR_OWNER, aux), field, values }
+#define ATTR_ONE_OF(name, flags, member, field, values) \
+    { name, sizeof(name) - 1, ATTR_ENUM, flags, offsetof(ATTR_OWNER, member), -1, field, values }
+
+#define SCHEMA(attrs) { attrs, sizeof(attrs) / sizeof(attrs[0]) }
+
+static const attr_value_t hdcp_levels[] = {
+    { HDCP_LEVEL_NONE, NONE },
+    { HDCP_LEVEL_TYPE0, TYPE0 },
+    { HDCP_LEVEL_UNDEFINED, NULL }
+};
+
+static const attr_value_t media_types[] = {
+    { MEDIA_TYPE_AUDIO, AUDIO },
+    { MEDIA_TYPE_VIDEO, VIDEO },
+    { MEDIA_TYPE_SUBTITLES, SUBTITLES },
+    { MEDIA_TYPE_CLOSEDCAPTIONS, CLOSEDCAPTIONS },
+    { MEDIA_TYPE_INVALID, NULL }
+};
+
+static const attr_value_t instream_ids[] = {
+    { MEDIA_INSTREAMID_CC1, CC1 },
+    { MEDIA_INSTREAMID_CC2, CC2 },
+    { MEDIA_INSTREAMID_CC3, CC3 },
+    { MEDIA_INSTREAMID_CC4, CC4 },
+    { MEDIA_INSTREAMID_INVALID, NULL }
+};
+
+static const attr_value_t key_methods[] = {
+    { KEY_METHOD_NONE, NONE },
+    { KEY_METHOD_AES128, AES128 },
+    { KEY_METHOD_SAMPLEAES, SAMPLEAES },
+    { KEY_METHOD_SAMPLEAESCTR, SAMPLEAESCTR },
+    { KEY_METHOD_INVALID, NULL }
+};
+
+#define ATTR_OWNER stream_inf_t
+static const attr_t stream_inf_attrs[] = {
+    ATTR(BANDWIDTH, ATTR_BANDWIDTH, ATTR_REQUIRED, bandwidth, STREAM_INF_ATTR_BANDWIDTH),
+    ATTR(AVERAGEBANDWIDTH, ATTR_BANDWIDTH, 0, avg_bandwidth, STREAM_INF_ATTR_AVG_BANDWIDTH),
+    ATTR(CODECS, ATTR_STR, 0, codecs, STREAM_INF_ATTR_CODECS),
+    ATTR(RESOLUTION, ATTR_RESOLUTION, 0, resolution, STREAM_INF_ATTR_RESOLUTION),
+    ATTR(FRAMERATE, ATTR_FLOAT, 0, frame_rate, STREAM_INF_ATTR_FRAME_RATE),
+    ATTR_ONE_OF(HDCPLEVEL, 0, hdcp_level, STREAM_INF_ATTR_HDCP_LEVEL, hdcp_levels),
+    ATTR(AUDIO, ATTR_STR, 0, audio, STREAM_INF_ATTR_AUDIO),
+    ATTR(VIDEO, ATTR_STR, 0, video, STREAM_INF_ATTR_VIDEO),
+    ATTR(SUBTITLES, ATTR_STR, 0, subtitles, STREAM_INF_ATTR_SUBTITLES),
+    ATTR(CLOSEDCAPTIONS, ATTR_CLOSED_CAPTIONS, 0, closed_captions, STREAM_INF_ATTR_CLOSED_CAPTIONS),
+    ATTR(PROGRAMID, ATTR_INT, ATTR_READ_ONLY, program_id, STREAM_INF_ATTR_PROGRAM_ID),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER iframe_stream_inf_t
+static const attr_t iframe_stream_inf_attrs[] = {
+    ATTR(BANDWIDTH, ATTR_BANDWIDTH, ATTR_REQUIRED, bandwidth, 0),
+    ATTR(AVERAGEBANDWIDTH, ATTR_BANDWIDTH, 0, avg_bandwidth, 0),
+    ATTR(CODECS, ATTR_STR, 0, codecs, 0),
+    ATTR(RESOLUTION, ATTR_RESOLUTION, 0, resolution, 0),
+    ATTR_ONE_OF(HDCPLEVEL, 0, hdcp_level, 0, hdcp_levels),
+    ATTR(VIDEO, ATTR_STR, 0, video, 0),
+    ATTR(URI, ATTR_STR, ATTR_REQUIRED | ATTR_URI, uri, 0),
+    ATTR(PROGRAMID, ATTR_INT, ATTR_READ_ONLY, program_id, 0),
+    ATTR(FRAMERATE, ATTR_FLOAT, ATTR_READ_ONLY, frame_rate, 0),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER media_t
+static const attr_t media_attrs[] = {
+    ATTR_ONE_OF(TYPE, 0, type, MEDIA_ATTR_TYPE, media_types),
+    ATTR(URI, ATTR_STR, ATTR_URI, uri, MEDIA_ATTR_URI),
+    ATTR(GROUPID, ATTR_STR, ATTR_REQUIRED, group_id, MEDIA_ATTR_GROUP_ID),
+    ATTR(LANGUAGE, ATTR_STR, 0, language, MEDIA_ATTR_LANGUAGE),
+    ATTR(ASSOCLANGUAGE, ATTR_STR, 0, assoc_language, MEDIA_ATTR_ASSOC_LANGUAGE),
+    ATTR(NAME, ATTR_STR, ATTR_REQUIRED, name, MEDIA_ATTR_NAME),
+    ATTR(DEFAULT, ATTR_YES_NO, 0, is_default, MEDIA_ATTR_DEFAULT),
+    ATTR(AUTOSELECT, ATTR_YES_NO, 0, auto_select, MEDIA_ATTR_AUTOSELECT),
+    ATTR(FORCED, ATTR_YES_NO, 0, forced, MEDIA_ATTR_FORCED),
+    ATTR_AUX(INSTREAMID, ATTR_INSTREAM_ID, 0, instream_id, service_n, MEDIA_ATTR_INSTREAM_ID, instream_ids),
+    ATTR(CHARACTERISTICS, ATTR_STR, 0, characteristics, MEDIA_ATTR_CHARACTERISTICS),
+    ATTR(CHANNELS, ATTR_STR, 0, channels, MEDIA_ATTR_CHANNELS),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER hls_key_t
+static const attr_t key_attrs[] = {
+    ATTR_ONE_OF(METHOD, ATTR_REQUIRED, method, 0, key_methods),
+    ATTR(URI, ATTR_STR, ATTR_URI, uri, 0),
+    ATTR_AUX(KEY_IV, ATTR_DATA, ATTR_IV, iv, iv_size, 0, NULL),
+    ATTR(KEYFORMAT, ATTR_STR, 0, key_format, 0),
+    ATTR(KEYFORMATVERSIONS, ATTR_STR, 0, key_format_versions, 0),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER map_t
+static const attr_t map_attrs[] = {
+    ATTR(URI, ATTR_STR, ATTR_REQUIRED | ATTR_URI, uri, 0),
+    ATTR(BYTERANGE, ATTR_BYTE_RANGE, 0, byte_range, 0),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER session_data_t
+static const attr_t session_data_attrs[] = {
+    ATTR(DATAID, ATTR_STR, ATTR_REQUIRED, data_id, 0),
+    ATTR(VALUE, ATTR_STR, 0, value, 0),
+    ATTR(URI, ATTR_STR, ATTR_URI, uri, 0),
+    ATTR(LANGUAGE, ATTR_STR, 0, language, 0),
+};
+#undef ATTR_OWNER
+
+#define ATTR_OWNER daterange_t
+static const attr_t daterange_attrs[] = {
+    ATTR(ID, ATTR_STR, ATTR_REQUIRED, id, DATERANGE_ATTR_ID),
+    ATTR(CLASS, ATTR_STR, 0, klass, DATERANGE_ATTR_CLASS),
+    ATTR(STARTDATE, ATTR_DATE, ATTR_REQUIRED, start_date, DATERANGE_ATTR_START_DATE),
+    ATTR(ENDDATE, ATTR_DATE, 0, end_date, DATERANGE_ATTR_END_DATE),
+    ATTR(DURATION, ATTR_FLOAT, 0, duration, DATERANGE_ATTR_DURATION),
+    ATTR(PLANNEDDURATION, ATTR_FLOAT, 0, planned_duration, DATERANGE_ATTR_PLANNED_DURATION),
+    // matches any name starting "X-"
+    ATTR("X-", ATTR_CLIENT, 0, client_attributes, DATERANGE_ATTR_CLIENT),
+    ATTR_AUX(SCTE35CMD, ATTR_DATA, 0, scte35_cmd, scte35_cmd_size, DATERANGE_ATTR_SCTE35_CMD, NULL),
+    ATTR_AUX(SCTE35OUT, ATTR_DATA, 0, scte35_out, scte35_out_size, DATERANGE_ATTR_SCTE35_OUT, NULL),
+    ATTR_AUX(SCTE35IN, ATTR_DATA, 0, scte35_in, scte35_in_size, DATERANGE_ATTR_SCTE35_IN, NULL),
+    ATTR(ENDONNEXT, ATTR_YES_NO, 0, end_on_next, DATERANGE_ATTR_END_ON_NEXT),
+};
+#undef ATTR_OWNER
+
+const attr_schema_t stream_inf_schema = SCHEMA(stream_inf_attrs);
+const attr_schema_t iframe_stream_inf_schema = SCHEMA(iframe_stream_inf_attrs);
+const attr_schema_t media_schema = SCHEMA(media_attrs);
+const attr_schema_t key_schema = SCHEMA(key_attrs);
+const attr_schema_t map_schema = SCHEMA(map_attrs);
+const attr_schema_t session_data_schema = SCHEMA(session_data_attrs);
+const attr_schema_t daterange_schema = SCHEMA(daterange_attrs);
+
+static bool_t is_name_char(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+}
+
+static bool_t is_value_end(char c)
+{
+    return c == ',' || c == '\0' || c == '\r' || c == '\n';
+}
+
+/**
+ * Finds the attribute called \a name, the names are only compared once their
+ * lengths match.
+ */
+static const attr_t *find_attr(const attr_schema_t *schema, const char *name, size_t len)
+{
+    const attr_t *client = NULL;
+    const attr_t *attr = schema->attrs;
+    const attr_t *end = &schema->attrs[schema->nb_attrs];
+
+    for(; attr < end; ++attr) {
+        if(attr->type == ATTR_CLIENT) {
+            if(len >= attr->len && 0 == memcmp(name, attr->name, attr->len)) {
+                client = attr;
+            }
+        } else if(attr->len == len && 0 == memcmp(name, attr->name, len)) {
+            return attr;
+        }
+    }
+
+    return client;
+}
+
+/**
+ * Looks up an enumerated-string, up to the first character which can't be in
+ * one.
+ *
+ * @returns the number of characters parsed
+ */
+static int parse_attr_value(const char *src, const char *end, const attr_value_t *values, int *dest)
+{
+    const char *pt = src;
+    while(pt < end && !is_value_end(*pt) && *pt != '"') {
+        ++pt;
+    }
+
+    size_t len = pt - src;
+    const attr_value_t *value = values;
+    while(value->name && !(strlen(value->name) == len && 0 == memcmp(src, value->name, len))) {
+        ++value;
+    }
+
+    if(dest) {
+        *dest = value->value;
+    }
+    return pt - src;
+}
+
+/**
+ * Parses a YES or NO enumerated-string.
+ *
+ * @param src The source text, just past the '=' sign
+ * @param dest Set to HLS_TRUE or HLS_FALSE, left untouched for any other value,
+ * may be NULL to step over the value
+ * @returns the number of characters parsed
+ */
+static int parse_yes_no(const char *src, bool_t *dest)
+{
+    const char *pt = src;
+    if(EQUAL(pt, YES)) {
+        if(dest) {
+            *dest = HLS_TRUE;
+        }
+    } else if(EQUAL(pt, NO)) {
+        if(dest) {
+            *dest = HLS_FALSE;
+        }
+    }
+    return pt - src;
+}
+
+/**
+ * Parses a daterange's X- client attribute onto the end of \a list.
+ *
+ * @param name The attribute's name
+ * @param len The length of the name
+ * @param src The value, just past the '=' sign
+ * @param end The end of the source
+ * @param list The client attributes, NULL to step over the value
+ * @returns the number of characters of the value parsed
+ */
+static int parse_client_attr(const char *name, size_t len, const char *src, const char *end, param_list_t *list)
+{
+    const char *pt = src;
+    param_list_t *param = NULL;
+    param_list_t skipped;
+
+    if(!list) {
+        // step over the value without keeping it
+        param = &skipped;
+    } else if(list->value_type == PARAM_TYPE_NONE) {
+        // use the base client_attributes if there are no values stored.
+        param = list;
+    } else {
+        // allocate a new parameter and link it onto the end of the list
+        param = (param_list_t*) hls_malloc(sizeof(param_list_t));
+        hlsparse_param_list_init(param);
+        param_list_t *prev = list;
+        while(prev->next) {
+            prev = prev->next;
+        }
+        prev->next = param;
+    }
+
+    bool_t keep = param != &skipped;
+    if(keep) {
+        param->key = str_utils_ndup(name, len);
+    }
+
+    if(*pt == '"') {
+        param->value_type = PARAM_TYPE_STRING;
+        param->value_size = parse_attrib_str(pt, keep ? &param->value.data : NULL, end - pt);
+        pt += param->value_size;
+        param->value_size--; // parse always parses an extra end byte
+    } else if(*pt == '0' && (pt[1] == 'x' || pt[1] == 'X')) {
+        param->value_type = PARAM_TYPE_DATA;
+        param->value_size = parse_attrib_data(pt, keep ? &param->value.data : NULL, end - pt);
+        pt += param->value_size;
+        param->value_size = (param->value_size - 2) / 2; // minus '0x' / 2 bytes per character
+    } else {
+        param->value_type = PARAM_TYPE_FLOAT;
+        pt += parse_str_to_float(pt, keep ? &param->value.number : NULL, end - pt);
+        param->value_size = 0;
+    }
+
+    return pt - src;
+}
+
+/**
+ * Parses the value of \a attr at \a src into \a dest.
+ *
+ * @param attr The attribute
+ * @param name The attribute's name, kept by ATTR_CLIENT
+ * @param len The length of the name
+ * @param src The value, just past the '=' sign
+ * @param end The end of the value or of the source
+ * @param dest The struct holding the attribute
+ * @param fields The *_ATTR_* flags of the attributes to write, others are only
+ * stepped over
+ * @returns the number of characters of the value parsed
+ */
+static int parse_attr(const attr_t *attr, const char *name, size_t len, const char *src, const char *end, void *dest, int fields)
+{
+    const char *pt = src;
+    char *value = NULL;
+    if(!attr->field || (fields & attr->field)) {
+        value = (char*)dest + attr->offset;
+    }
+
+    switch(attr->type) {
+        case ATTR_INT:
+            pt += parse_str_to_int(pt, (int*)value, end - pt);
+            break;
+        case ATTR_FLOAT:
+        case ATTR_BANDWIDTH:
+            pt += parse_str_to_float(pt, (float*)value, end - pt);
+            break;
+        case ATTR_STR:
+            pt += parse_attrib_str(pt, (char**)value, end - pt);
+            break;
+        case ATTR_CLOSED_CAPTIONS:
+            if(TAG_IS(pt, end, NONE)) {
+                pt += sizeof(NONE) - 1;
+                if(value) {
+                    *(char**)value = str_utils_dup(NONE);
+                }
+            } else {
+                pt += parse_attrib_str(pt, (char**)value, end - pt);
+            }
+            break;
+        case ATTR_ENUM:
+            pt += parse_attr_value(pt, end, attr->values, (int*)value);
+            break;
+        case ATTR_YES_NO:
+            pt += parse_yes_no(pt, (bool_t*)value);
+            break;
+        case ATTR_RESOLUTION:
+            pt += parse_resolution(pt, end - pt, (resolution_t*)value);
+            break;
+        case ATTR_DATA: {
+            int data_len = parse_attrib_data(pt, (char**)value, end - pt);
+            pt += data_len;
+            if(value && attr->aux_offset >= 0) {
+                // minus '0x' / 2 characters per byte e.g. 'AA'
+                *(size_t*)((char*)dest + attr->aux_offset) = data_len > 2 ? (data_len - 2) / 2 : 0;
+            }
+        } break;
+        case ATTR_DATE:
+        case ATTR_BYTE_RANGE:
+            // the value may be a quoted-string
+            if(pt < end && *pt == '"') {
+                ++pt;
+            }
+            if(attr->type == ATTR_DATE) {
+                pt += parse_date(pt, (uint64_t*)value, end - pt);
+            } else {
+                pt += parse_byte_range(pt, end - pt, (byte_range_t*)value);
+            }
+            if(pt < end && *pt == '"') {
+                ++pt;
+            }
+            break;
+        case ATTR_INSTREAM_ID: {
+            if(pt < end && *pt == '"') {
+                ++pt;
+            }
+            int instream_id;
+            int service_n = 0;
+            if(TAG_IS(pt, end, SERVICE)) {
+                pt += sizeof(SERVICE) - 1;
+                instream_id = MEDIA_INSTREAMID_SERVICE;
+                pt += parse_str_to_int(pt, &service_n, end - pt);
+            } else {
+                pt += parse_attr_value(pt, end, attr->values, &instream_id);
+            }
+            if(value) {
+                *(int*)value = instream_id;
+                if(instream_id == MEDIA_INSTREAMID_SERVICE) {
+                    *(int*)((char*)dest + attr->aux_offset) = service_n;
+                }
+            }
+            if(pt < end && *pt == '"') {
+                ++pt;
+            }
+        } break;
+        case ATTR_CLIENT:
+            pt += parse_client_attr(name, len, pt, end, (param_list_t*)value);
+            break;
+    }
+
+    return pt - src;
+}
+
+/**
+ * Parses the attribute at \a src into \a dest, the struct described by
+ * \a schema. Anything which isn't a NAME=value pair, e.g. the tag's own name,
+ * is stepped over up to the next character which can't be in a name, as is
+ * the value of an attribute the schema doesn't have.
+ *
+ * @param schema The attributes of dest
+ * @param src The HLS source string
+ * @param size The size of the source string
+ * @param dest The destination object to write the value to
+ * @param fields The *_ATTR_* flags of the attributes to write, others are only
+ * stepped over
+ * @returns the number of characters parsed
+ */
+int parse_attribute(const attr_schema_t *schema, const char *src, size_t size, void *dest, int fields)
+{
+    if(!schema || !src || !size || !dest) {
+        return 0;
+    }
+
+    const char *pt = src;
+    const char *end = &src[size];
+
+    while(pt < end && is_name_char(*pt)) {
+        ++pt;
+    }
+
+    size_t len = pt - src;
+    if(len == 0 || pt >= end || *pt != '=') {
+        return len;
+    }
+
+    const attr_t *attr = find_attr(schema, src, len);
+    ++pt; // get past the '=' sign
+
+    if(!attr) {
+        // an attribute this tag doesn't have, quoted values may hold commas
+        if(pt < end && *pt == '"') {
+            ++pt;
+            while(pt < end && *pt != '"' && *pt != '\0' && *pt != '\r' && *pt != '\n') {
+                ++pt;
+            }
+            if(pt < end && *pt == '"') {
+                ++pt;
+            }
+        } else {
+            while(pt < end && !is_value_end(*pt)) {
+                ++pt;
+            }
+        }
+        return pt - src;
+    }
+
+    pt += parse_attr(attr, src, len, pt, end, dest, fields);
+    return pt - src;
+}
+
+typedef struct {
+    const attr_schema_t *schema;
+    void *dest;
+    int fields;
+} attr_dest_t;
+
+static void parse_token(const attr_token_t *token, void *user)
+{
+    const attr_dest_t *ctx = (const attr_dest_t*)user;
+    if(!ctx->dest) {
+        return;
+    }
+
+    // the first name starts with the tag's, e.g. "#EXT-X-KEY:METHOD"
+    const char *end = &token->name[token->name_size];
+    const char *name = end;
+    while(name > token->name && is_name_char(name[-1])) {
+        --name;
+    }
+
+    size_t len = end - name;
+    const attr_t *attr = len ? find_attr(ctx->schema, name, len) : NULL;
+    if(!attr) {
+        return;
+    }
+
+    const char *value = token->value;
+    size_t size = token->value_size;
+    if(attr->type == ATTR_STR && size > 2 && value[0] == '"' &&
+       memchr(&value[1], '"', size - 1) == &value[size - 1]) {
+        // the tokenizer has already found the quotes
+        if(!attr->field || (ctx->fields & attr->field)) {
+            *(char**)((char*)ctx->dest + attr->offset) = str_utils_ndup(&value[1], size - 2);
+        }
+        return;
+    }
+
+    parse_attr(attr, name, len, value, &value[size], ctx->dest, ctx->fields);
+}
+
+/**
+ * Parses the attribute-list on the line at \a src into \a dest, the struct
+ * described by \a schema. The list is split into attributes by
+ * tokenize_attributes, anything in front of the first attribute's name and
+ * attributes the schema doesn't have are stepped over.
+ *
+ * @param schema The attributes of dest
+ * @param src The HLS source string
+ * @param size The size of the source string
+ * @param dest The destination object to write the values to, may be NULL to
+ * only find the end of the line
+ * @param fields The *_ATTR_* flags of the attributes to write, others are only
+ * stepped over
+ * @returns the number of characters parsed
+ */
+int parse_attributes(const attr_schema_t *schema, const char *src, size_t size, void *dest, int fields)
+{
+    if(!schema || !src || !size) {
+        return 0;
+    }
+
+    attr_dest_t ctx = { schema, dest, fields };
+    return tokenize_attributes(src, size, parse_token, &ctx);
+}
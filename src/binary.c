@@ -0,0 +1,801 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parse.h"
+
+#define SNAPSHOT_MAGIC          "HLSSNAP"
+#define SNAPSHOT_VERSION        (2)
+#define SNAPSHOT_KIND_MEDIA     (1)
+#define SNAPSHOT_KIND_MASTER    (2)
+#define SNAPSHOT_ENDIAN         (0x01020304)
+#define SNAPSHOT_ALIGN          (16)
+#define SNAPSHOT_ROOT           ((sizeof(snapshot_header_t) + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1))
+
+/**
+ * Header found at the start of every snapshot file.
+ * The root object (media_playlist_t or master_t) always follows at SNAPSHOT_ROOT.
+ * Every pointer inside the image is stored as an offset from the start of the
+ * file (0 being NULL) and listed in the relocation table so that it can be
+ * turned back into an address once the file has been mapped.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t endian;
+    uint32_t ptr_size;
+    uint32_t root_size;
+    uint32_t segment_size;
+    uint64_t size;
+    uint64_t relocs;
+    uint64_t nb_relocs;
+    uint64_t strings;
+} snapshot_header_t;
+
+/**
+ * Growable buffer used while building a snapshot image.
+ * Objects and strings are written to separate buffers so the strings end up
+ * in a single table at the end of the image.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    char *strings;
+    size_t strings_size;
+    size_t strings_capacity;
+    uint64_t *relocs;           // slots pointing at objects
+    size_t nb_relocs;
+    size_t relocs_capacity;
+    uint64_t *str_relocs;       // slots pointing into the string table
+    size_t nb_str_relocs;
+    size_t str_relocs_capacity;
+    bool_t failed;
+} snapshot_t;
+
+static void *snap_grow(void *ptr, size_t used, size_t *capacity, size_t needed)
+{
+    if(needed <= *capacity) {
+        return ptr;
+    }
+
+    size_t cap = *capacity ? *capacity : 4096;
+    while(cap < needed) {
+        cap *= 2;
+    }
+
+    char *out = hls_malloc(cap);
+    if(out) {
+        if(ptr) {
+            memcpy(out, ptr, used);
+            hls_free(ptr);
+        }
+        *capacity = cap;
+    }
+    return out;
+}
+
+static void snap_term(snapshot_t *snap)
+{
+    char **params[] = {
+        &snap->data,
+        &snap->strings,
+        (char**)&snap->relocs,
+        (char**)&snap->str_relocs
+    };
+
+    parse_param_term(params, 4);
+}
+
+/**
+ * Reserves a zeroed, aligned object inside the image.
+ *
+ * @returns the offset of the object, or 0 on failure
+ */
+static size_t snap_alloc(snapshot_t *snap, size_t size)
+{
+    if(snap->failed) {
+        return 0;
+    }
+
+    size_t offset = (snap->size + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1);
+    char *data = snap_grow(snap->data, snap->size, &snap->capacity, offset + size);
+    if(!data) {
+        snap->failed = HLS_TRUE;
+        return 0;
+    }
+
+    snap->data = data;
+    memset(&snap->data[snap->size], 0, offset + size - snap->size);
+    snap->size = offset + size;
+    return offset;
+}
+
+static void snap_add_reloc(snapshot_t *snap, uint64_t **relocs, size_t *nb, size_t *capacity, size_t slot)
+{
+    uint64_t *out = snap_grow(*relocs, *nb * sizeof(uint64_t), capacity, (*nb + 1) * sizeof(uint64_t));
+    if(!out) {
+        snap->failed = HLS_TRUE;
+        return;
+    }
+
+    *relocs = out;
+    (*relocs)[(*nb)++] = slot;
+}
+
+/**
+ * Points the pointer slot at offset \a slot to the object at offset \a target.
+ */
+static void snap_ptr(snapshot_t *snap, size_t slot, size_t target)
+{
+    if(snap->failed || !target) {
+        return;
+    }
+
+    uintptr_t value = target;
+    memcpy(&snap->data[slot], &value, sizeof(value));
+    snap_add_reloc(snap, &snap->relocs, &snap->nb_relocs, &snap->relocs_capacity, slot);
+}
+
+/**
+ * Copies \a size bytes into the string table and points the slot at \a slot
+ * to them. A NUL terminator is always appended.
+ */
+static void snap_blob(snapshot_t *snap, size_t slot, const char *src, size_t size)
+{
+    if(snap->failed || !src) {
+        return;
+    }
+
+    size_t needed = snap->strings_size + size + 1;
+    char *strings = snap_grow(snap->strings, snap->strings_size, &snap->strings_capacity, needed);
+    if(!strings) {
+        snap->failed = HLS_TRUE;
+        return;
+    }
+
+    snap->strings = strings;
+    memcpy(&snap->strings[snap->strings_size], src, size);
+    snap->strings[snap->strings_size + size] = '\0';
+
+    // store the table relative offset for now, the table base is added once known
+    uintptr_t value = snap->strings_size;
+    memcpy(&snap->data[slot], &value, sizeof(value));
+    snap->strings_size = needed;
+
+    snap_add_reloc(snap, &snap->str_relocs, &snap->nb_str_relocs, &snap->str_relocs_capacity, slot);
+}
+
+static void snap_str(snapshot_t *snap, size_t slot, const char *str)
+{
+    if(str) {
+        snap_blob(snap, slot, str, strlen(str));
+    }
+}
+
+#define SLOT(base, type, field) ((base) + offsetof(type, field))
+#define AT(snap, type, offset) ((type*)&(snap)->data[offset])
+
+static void snap_string_list(snapshot_t *snap, size_t list, const string_list_t *src)
+{
+    size_t node = list;
+    while(src && src->data) {
+        snap_str(snap, SLOT(node, string_list_t, data), src->data);
+        src = src->next;
+        if(src && src->data) {
+            size_t next = snap_alloc(snap, sizeof(string_list_t));
+            snap_ptr(snap, SLOT(node, string_list_t, next), next);
+            node = next;
+        }
+    }
+}
+
+static void snap_param_list(snapshot_t *snap, size_t list, const param_list_t *src)
+{
+    size_t node = list;
+    while(src && src->value_type != PARAM_TYPE_NONE) {
+        if(snap->failed) {
+            return;
+        }
+        param_list_t *dest = AT(snap, param_list_t, node);
+        dest->value_type = src->value_type;
+        dest->value_size = src->value_size;
+        snap_str(snap, SLOT(node, param_list_t, key), src->key);
+        if(src->value_type == PARAM_TYPE_FLOAT) {
+            AT(snap, param_list_t, node)->value.number = src->value.number;
+        } else if(src->value_type == PARAM_TYPE_DATA) {
+            snap_blob(snap, SLOT(node, param_list_t, value.data), src->value.data, src->value_size);
+        } else {
+            snap_str(snap, SLOT(node, param_list_t, value.data), src->value.data);
+        }
+
+        src = src->next;
+        if(src && src->value_type != PARAM_TYPE_NONE) {
+            size_t next = snap_alloc(snap, sizeof(param_list_t));
+            snap_ptr(snap, SLOT(node, param_list_t, next), next);
+            node = next;
+        }
+    }
+}
+
+static size_t snap_key(snapshot_t *snap, const hls_key_t *src)
+{
+    size_t key = snap_alloc(snap, sizeof(hls_key_t));
+    if(!snap->failed) {
+        AT(snap, hls_key_t, key)->method = src->method;
+        AT(snap, hls_key_t, key)->iv_size = key_iv_size(src);
+        snap_str(snap, SLOT(key, hls_key_t, uri), src->uri);
+        snap_blob(snap, SLOT(key, hls_key_t, iv), src->iv, key_iv_size(src));
+        snap_str(snap, SLOT(key, hls_key_t, key_format), src->key_format);
+        snap_str(snap, SLOT(key, hls_key_t, key_format_versions), src->key_format_versions);
+    }
+    return key;
+}
+
+static void snap_key_list(snapshot_t *snap, size_t list, const key_list_t *src)
+{
+    size_t node = list;
+    while(src && src->data) {
+        snap_ptr(snap, SLOT(node, key_list_t, data), snap_key(snap, src->data));
+        src = src->next;
+        if(src && src->data) {
+            size_t next = snap_alloc(snap, sizeof(key_list_t));
+            snap_ptr(snap, SLOT(node, key_list_t, next), next);
+            node = next;
+        }
+    }
+}
+
+static void snap_map_list(snapshot_t *snap, size_t list, const map_list_t *src)
+{
+    size_t node = list;
+    while(src && src->data) {
+        size_t map = snap_alloc(snap, sizeof(map_t));
+        if(snap->failed) {
+            return;
+        }
+        AT(snap, map_t, map)->byte_range = src->data->byte_range;
+        snap_str(snap, SLOT(map, map_t, uri), src->data->uri);
+        snap_ptr(snap, SLOT(node, map_list_t, data), map);
+
+        src = src->next;
+        if(src && src->data) {
+            size_t next = snap_alloc(snap, sizeof(map_list_t));
+            snap_ptr(snap, SLOT(node, map_list_t, next), next);
+            node = next;
+        }
+    }
+}
+
+/*
+ * Lazily parsed tags are saved fully decoded. A loaded snapshot is read-only,
+ * so nothing may decode its attribute lists in place later. When \a src still
+ * has undecoded attributes they're all decoded into \a tmp, which is returned
+ * and has to be termed by the caller once it has been copied.
+ */
+static const daterange_t *snap_decoded_daterange(const daterange_t *src, daterange_t *tmp)
+{
+    hlsparse_daterange_init(tmp);
+    if(!src->attributes || src->decoded == DATERANGE_ATTR_ALL) {
+        return src;
+    }
+    parse_daterange(src->attributes, strlen(src->attributes), tmp);
+    tmp->pdt = src->pdt;
+    tmp->decoded = DATERANGE_ATTR_ALL;
+    return tmp;
+}
+
+static const media_t *snap_decoded_media(const media_t *src, media_t *tmp)
+{
+    hlsparse_media_init(tmp);
+    if(!src->attributes || src->decoded == MEDIA_ATTR_ALL) {
+        return src;
+    }
+    parse_media(src->attributes, strlen(src->attributes), tmp);
+    tmp->decoded = MEDIA_ATTR_ALL;
+    return tmp;
+}
+
+// the uri follows the tag, it is always taken from src
+static const stream_inf_t *snap_decoded_stream_inf(const stream_inf_t *src, stream_inf_t *tmp)
+{
+    hlsparse_stream_inf_init(tmp);
+    if(!src->attributes || src->decoded == STREAM_INF_ATTR_ALL) {
+        return src;
+    }
+    parse_stream_inf(src->attributes, strlen(src->attributes), tmp);
+    tmp->decoded = STREAM_INF_ATTR_ALL;
+    return tmp;
+}
+
+static void snap_daterange_list(snapshot_t *snap, size_t list, const daterange_list_t *src)
+{
+    size_t node = list;
+    while(src && src->data) {
+        daterange_t tmp;
+        const daterange_t *dr = snap_decoded_daterange(src->data, &tmp);
+        size_t daterange = snap_alloc(snap, sizeof(daterange_t));
+        if(snap->failed) {
+            hlsparse_daterange_term(&tmp);
+            return;
+        }
+        daterange_t *dest = AT(snap, daterange_t, daterange);
+        dest->pdt = dr->pdt;
+        dest->start_date = dr->start_date;
+        dest->end_date = dr->end_date;
+        dest->duration = dr->duration;
+        dest->planned_duration = dr->planned_duration;
+        dest->scte35_cmd_size = dr->scte35_cmd_size;
+        dest->scte35_out_size = dr->scte35_out_size;
+        dest->scte35_in_size = dr->scte35_in_size;
+        dest->end_on_next = dr->end_on_next;
+        dest->decoded = dr->decoded;
+        snap_str(snap, SLOT(daterange, daterange_t, id), dr->id);
+        snap_str(snap, SLOT(daterange, daterange_t, klass), dr->klass);
+        snap_str(snap, SLOT(daterange, daterange_t, attributes), dr->attributes);
+        snap_blob(snap, SLOT(daterange, daterange_t, scte35_cmd), dr->scte35_cmd, dr->scte35_cmd_size);
+        snap_blob(snap, SLOT(daterange, daterange_t, scte35_out), dr->scte35_out, dr->scte35_out_size);
+        snap_blob(snap, SLOT(daterange, daterange_t, scte35_in), dr->scte35_in, dr->scte35_in_size);
+        snap_param_list(snap, SLOT(daterange, daterange_t, client_attributes), &dr->client_attributes);
+        snap_ptr(snap, SLOT(node, daterange_list_t, data), daterange);
+        hlsparse_daterange_term(&tmp);
+
+        src = src->next;
+        if(src && src->data) {
+            size_t next = snap_alloc(snap, sizeof(daterange_list_t));
+            snap_ptr(snap, SLOT(node, daterange_list_t, next), next);
+            node = next;
+        }
+    }
+}
+
+static void snap_segment_list(snapshot_t *snap, size_t root, const media_playlist_t *playlist)
+{
+    int count = 0;
+    const segment_list_t *src = &playlist->segments;
+    while(src && src->data) {
+        ++count;
+        src = src->next;
+    }
+
+    if(count == 0) {
+        return;
+    }
+
+    // segment records and list nodes are stored contiguously, the first list
+    // node is the one embedded in the playlist itself
+    size_t segments = snap_alloc(snap, sizeof(segment_t) * count);
+    size_t nodes = count > 1 ? snap_alloc(snap, sizeof(segment_list_t) * (count - 1)) : 0;
+    size_t node = SLOT(root, media_playlist_t, segments);
+
+    src = &playlist->segments;
+    for(int i = 0; i < count && !snap->failed; ++i) {
+        const segment_t *seg = src->data;
+        size_t segment = segments + sizeof(segment_t) * i;
+        segment_t *dest = AT(snap, segment_t, segment);
+
+        dest->sequence_num = seg->sequence_num;
+        dest->key_index = seg->key_index;
+        dest->map_index = seg->map_index;
+        dest->daterange_index = seg->daterange_index;
+        dest->duration = seg->duration;
+        dest->discontinuity = seg->discontinuity;
+        dest->pdt_discontinuity = seg->pdt_discontinuity;
+        dest->pdt = seg->pdt;
+        dest->pdt_end = seg->pdt_end;
+        dest->byte_range = seg->byte_range;
+        dest->hash = seg->hash;
+        snap_str(snap, SLOT(segment, segment_t, title), seg->title);
+        snap_str(snap, SLOT(segment, segment_t, uri), seg->uri);
+        snap_string_list(snap, SLOT(segment, segment_t, custom_tags), &seg->custom_tags);
+
+        snap_ptr(snap, SLOT(node, segment_list_t, data), segment);
+        if(seg == playlist->last_segment) {
+            snap_ptr(snap, SLOT(root, media_playlist_t, last_segment), segment);
+        }
+
+        if(i + 1 < count) {
+            size_t next = nodes + sizeof(segment_list_t) * i;
+            snap_ptr(snap, SLOT(node, segment_list_t, next), next);
+            node = next;
+        }
+        src = src->next;
+    }
+}
+
+static void snap_merkle_tree(snapshot_t *snap, size_t root, const media_playlist_t *playlist)
+{
+    if(!playlist->merkle_tree || playlist->nb_merkle_leaves <= 0) {
+        return;
+    }
+
+    // count the nodes of every level up to the root
+    size_t nb_nodes = 0;
+    int level_size = playlist->nb_merkle_leaves;
+    while(level_size > 1) {
+        nb_nodes += level_size;
+        level_size = (level_size + 1) / 2;
+    }
+    ++nb_nodes;
+
+    size_t tree = snap_alloc(snap, sizeof(uint64_t) * nb_nodes);
+    if(!snap->failed) {
+        memcpy(&snap->data[tree], playlist->merkle_tree, sizeof(uint64_t) * nb_nodes);
+        snap_ptr(snap, SLOT(root, media_playlist_t, merkle_tree), tree);
+    }
+}
+
+static size_t snap_begin(snapshot_t *snap, uint32_t kind, size_t root_size)
+{
+    memset(snap, 0, sizeof(snapshot_t));
+
+    size_t header = snap_alloc(snap, sizeof(snapshot_header_t));
+    size_t root = snap_alloc(snap, root_size);
+    if(snap->failed || header != 0 || root != SNAPSHOT_ROOT) {
+        snap->failed = HLS_TRUE;
+        return 0;
+    }
+
+    snapshot_header_t *hdr = AT(snap, snapshot_header_t, header);
+    memcpy(hdr->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    hdr->version = SNAPSHOT_VERSION;
+    hdr->kind = kind;
+    hdr->endian = SNAPSHOT_ENDIAN;
+    hdr->ptr_size = sizeof(void*);
+    hdr->root_size = root_size;
+    hdr->segment_size = sizeof(segment_t);
+    return root;
+}
+
+/**
+ * Appends the string and relocation tables to the image and writes it to \a path.
+ */
+static HLSCode snap_finish(snapshot_t *snap, const char *path)
+{
+    HLSCode res = HLS_ERROR;
+
+    // place the string table and patch every slot pointing into it
+    size_t strings = snap_alloc(snap, snap->strings_size);
+    if(!snap->failed) {
+        if(snap->strings_size) {
+            memcpy(&snap->data[strings], snap->strings, snap->strings_size);
+        }
+        for(size_t i = 0; i < snap->nb_str_relocs; ++i) {
+            uintptr_t value;
+            memcpy(&value, &snap->data[snap->str_relocs[i]], sizeof(value));
+            value += strings;
+            memcpy(&snap->data[snap->str_relocs[i]], &value, sizeof(value));
+            snap_add_reloc(snap, &snap->relocs, &snap->nb_relocs, &snap->relocs_capacity, snap->str_relocs[i]);
+        }
+    }
+
+    size_t relocs = snap_alloc(snap, snap->nb_relocs * sizeof(uint64_t));
+    if(!snap->failed) {
+        if(snap->nb_relocs) {
+            memcpy(&snap->data[relocs], snap->relocs, snap->nb_relocs * sizeof(uint64_t));
+        }
+
+        snapshot_header_t *hdr = AT(snap, snapshot_header_t, 0);
+        hdr->size = snap->size;
+        hdr->relocs = relocs;
+        hdr->nb_relocs = snap->nb_relocs;
+        hdr->strings = strings;
+
+        FILE *file = fopen(path, "wb");
+        if(file) {
+            if(fwrite(snap->data, 1, snap->size, file) == snap->size) {
+                res = HLS_OK;
+            }
+            if(fclose(file) != 0) {
+                res = HLS_ERROR;
+            }
+        }
+    }
+
+    snap_term(snap);
+    return res;
+}
+
+/**
+ * Maps a snapshot file and relocates every pointer slot in place.
+ *
+ * @returns the address of the root object, or NULL on failure
+ */
+static void *snap_load(const char *path, uint32_t kind, size_t root_size)
+{
+    if(!path) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < SNAPSHOT_ROOT + root_size) {
+        close(fd);
+        return NULL;
+    }
+
+    // a private mapping lets the relocation write into the pages without
+    // touching the file, untouched pages stay shared with the page cache
+    size_t size = st.st_size;
+    char *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return NULL;
+    }
+
+    const snapshot_header_t *hdr = (const snapshot_header_t*)base;
+    if(memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+       hdr->version != SNAPSHOT_VERSION ||
+       hdr->kind != kind ||
+       hdr->endian != SNAPSHOT_ENDIAN ||
+       hdr->ptr_size != sizeof(void*) ||
+       hdr->root_size != root_size ||
+       hdr->segment_size != sizeof(segment_t) ||
+       hdr->size != size ||
+       hdr->relocs > size ||
+       hdr->nb_relocs > (size - hdr->relocs) / sizeof(uint64_t)) {
+        munmap(base, size);
+        return NULL;
+    }
+
+    const uint64_t *relocs = (const uint64_t*)&base[hdr->relocs];
+    for(uint64_t i = 0; i < hdr->nb_relocs; ++i) {
+        uint64_t slot = relocs[i];
+        uintptr_t value;
+        if(slot < SNAPSHOT_ROOT || slot > size - sizeof(value) || slot % sizeof(value)) {
+            munmap(base, size);
+            return NULL;
+        }
+        memcpy(&value, &base[slot], sizeof(value));
+        if(value >= size) {
+            munmap(base, size);
+            return NULL;
+        }
+        char *ptr = value ? &base[value] : NULL;
+        memcpy(&base[slot], &ptr, sizeof(ptr));
+    }
+
+    return &base[SNAPSHOT_ROOT];
+}
+
+static HLSCode snap_unload(void *root, uint32_t kind)
+{
+    if(!root) {
+        return HLS_ERROR;
+    }
+
+    char *base = (char*)root - SNAPSHOT_ROOT;
+    const snapshot_header_t *hdr = (const snapshot_header_t*)base;
+    if(memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || hdr->kind != kind) {
+        return HLS_ERROR;
+    }
+
+    return munmap(base, hdr->size) == 0 ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_media_playlist_save_binary(const char *path, const media_playlist_t *playlist)
+{
+    if(!path || !playlist) {
+        return HLS_ERROR;
+    }
+
+    snapshot_t snap;
+    size_t root = snap_begin(&snap, SNAPSHOT_KIND_MEDIA, sizeof(media_playlist_t));
+
+    if(!snap.failed) {
+        // copy all the plain values, the pointers are cleared and rebuilt below
+        media_playlist_t *dest = AT(&snap, media_playlist_t, root);
+        memcpy(dest, playlist, sizeof(media_playlist_t));
+        dest->uri = NULL;
+        dest->last_segment = NULL;
+        hlsparse_segment_list_init(&dest->segments);
+        hlsparse_key_list_init(&dest->keys);
+        hlsparse_map_list_init(&dest->maps);
+        hlsparse_daterange_list_init(&dest->dateranges);
+        hlsparse_string_list_init(&dest->custom_tags);
+        dest->merkle_tree = NULL;
+        dest->free_segments = NULL;
+        dest->free_segment_nodes = NULL;
+        dest->segments_tail = NULL;
+        dest->keys_tail = NULL;
+        dest->maps_tail = NULL;
+        dest->dateranges_tail = NULL;
+
+        snap_str(&snap, SLOT(root, media_playlist_t, uri), playlist->uri);
+        snap_merkle_tree(&snap, root, playlist);
+        snap_segment_list(&snap, root, playlist);
+        snap_key_list(&snap, SLOT(root, media_playlist_t, keys), &playlist->keys);
+        snap_map_list(&snap, SLOT(root, media_playlist_t, maps), &playlist->maps);
+        snap_daterange_list(&snap, SLOT(root, media_playlist_t, dateranges), &playlist->dateranges);
+        snap_string_list(&snap, SLOT(root, media_playlist_t, custom_tags), &playlist->custom_tags);
+    }
+
+    return snap_finish(&snap, path);
+}
+
+HLSCode hlsparse_media_playlist_load_binary(const char *path, media_playlist_t **dest)
+{
+    if(!dest) {
+        return HLS_ERROR;
+    }
+
+    *dest = snap_load(path, SNAPSHOT_KIND_MEDIA, sizeof(media_playlist_t));
+    return *dest ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_media_playlist_unload_binary(media_playlist_t *playlist)
+{
+    return snap_unload(playlist, SNAPSHOT_KIND_MEDIA);
+}
+
+HLSCode hlsparse_master_save_binary(const char *path, const master_t *master)
+{
+    if(!path || !master) {
+        return HLS_ERROR;
+    }
+
+    snapshot_t snap;
+    size_t root = snap_begin(&snap, SNAPSHOT_KIND_MASTER, sizeof(master_t));
+
+    if(!snap.failed) {
+        master_t *dest = AT(&snap, master_t, root);
+        memcpy(dest, master, sizeof(master_t));
+        dest->uri = NULL;
+        hlsparse_session_data_list_init(&dest->session_data);
+        hlsparse_media_list_init(&dest->media);
+        hlsparse_stream_inf_list_init(&dest->stream_infs);
+        hlsparse_iframe_stream_inf_list_init(&dest->iframe_stream_infs);
+        hlsparse_string_list_init(&dest->custom_tags);
+        hlsparse_key_list_init(&dest->session_keys);
+
+        snap_str(&snap, SLOT(root, master_t, uri), master->uri);
+
+        size_t node = SLOT(root, master_t, session_data);
+        const session_data_list_t *sess = &master->session_data;
+        while(sess && sess->data && !snap.failed) {
+            size_t data = snap_alloc(&snap, sizeof(session_data_t));
+            snap_str(&snap, SLOT(data, session_data_t, data_id), sess->data->data_id);
+            snap_str(&snap, SLOT(data, session_data_t, value), sess->data->value);
+            snap_str(&snap, SLOT(data, session_data_t, uri), sess->data->uri);
+            snap_str(&snap, SLOT(data, session_data_t, language), sess->data->language);
+            snap_ptr(&snap, SLOT(node, session_data_list_t, data), data);
+            sess = sess->next;
+            if(sess && sess->data) {
+                size_t next = snap_alloc(&snap, sizeof(session_data_list_t));
+                snap_ptr(&snap, SLOT(node, session_data_list_t, next), next);
+                node = next;
+            }
+        }
+
+        node = SLOT(root, master_t, media);
+        const media_list_t *media = &master->media;
+        while(media && media->data && !snap.failed) {
+            media_t tmp;
+            const media_t *src = snap_decoded_media(media->data, &tmp);
+            size_t data = snap_alloc(&snap, sizeof(media_t));
+            if(snap.failed) {
+                hlsparse_media_term(&tmp);
+                break;
+            }
+            media_t *m = AT(&snap, media_t, data);
+            m->type = src->type;
+            m->instream_id = src->instream_id;
+            m->service_n = src->service_n;
+            m->forced = src->forced;
+            m->is_default = src->is_default;
+            m->auto_select = src->auto_select;
+            m->decoded = src->decoded;
+            snap_str(&snap, SLOT(data, media_t, name), src->name);
+            snap_str(&snap, SLOT(data, media_t, group_id), src->group_id);
+            snap_str(&snap, SLOT(data, media_t, language), src->language);
+            snap_str(&snap, SLOT(data, media_t, assoc_language), src->assoc_language);
+            snap_str(&snap, SLOT(data, media_t, uri), src->uri);
+            snap_str(&snap, SLOT(data, media_t, characteristics), src->characteristics);
+            snap_str(&snap, SLOT(data, media_t, channels), src->channels);
+            snap_str(&snap, SLOT(data, media_t, attributes), src->attributes);
+            snap_ptr(&snap, SLOT(node, media_list_t, data), data);
+            hlsparse_media_term(&tmp);
+            media = media->next;
+            if(media && media->data) {
+                size_t next = snap_alloc(&snap, sizeof(media_list_t));
+                snap_ptr(&snap, SLOT(node, media_list_t, next), next);
+                node = next;
+            }
+        }
+
+        node = SLOT(root, master_t, stream_infs);
+        const stream_inf_list_t *inf = &master->stream_infs;
+        while(inf && inf->data && !snap.failed) {
+            stream_inf_t tmp;
+            const stream_inf_t *src = snap_decoded_stream_inf(inf->data, &tmp);
+            size_t data = snap_alloc(&snap, sizeof(stream_inf_t));
+            if(snap.failed) {
+                hlsparse_stream_inf_term(&tmp);
+                break;
+            }
+            stream_inf_t *s = AT(&snap, stream_inf_t, data);
+            s->program_id = src->program_id;
+            s->hdcp_level = src->hdcp_level;
+            s->bandwidth = src->bandwidth;
+            s->avg_bandwidth = src->avg_bandwidth;
+            s->frame_rate = src->frame_rate;
+            s->resolution = src->resolution;
+            s->decoded = src->decoded;
+            snap_str(&snap, SLOT(data, stream_inf_t, codecs), src->codecs);
+            snap_str(&snap, SLOT(data, stream_inf_t, video), src->video);
+            snap_str(&snap, SLOT(data, stream_inf_t, audio), src->audio);
+            snap_str(&snap, SLOT(data, stream_inf_t, uri), inf->data->uri);
+            snap_str(&snap, SLOT(data, stream_inf_t, subtitles), src->subtitles);
+            snap_str(&snap, SLOT(data, stream_inf_t, closed_captions), src->closed_captions);
+            snap_str(&snap, SLOT(data, stream_inf_t, attributes), src->attributes);
+            snap_ptr(&snap, SLOT(node, stream_inf_list_t, data), data);
+            hlsparse_stream_inf_term(&tmp);
+            inf = inf->next;
+            if(inf && inf->data) {
+                size_t next = snap_alloc(&snap, sizeof(stream_inf_list_t));
+                snap_ptr(&snap, SLOT(node, stream_inf_list_t, next), next);
+                node = next;
+            }
+        }
+
+        node = SLOT(root, master_t, iframe_stream_infs);
+        const iframe_stream_inf_list_t *iframe = &master->iframe_stream_infs;
+        while(iframe && iframe->data && !snap.failed) {
+            size_t data = snap_alloc(&snap, sizeof(iframe_stream_inf_t));
+            if(snap.failed) {
+                break;
+            }
+            iframe_stream_inf_t *s = AT(&snap, iframe_stream_inf_t, data);
+            s->program_id = iframe->data->program_id;
+            s->hdcp_level = iframe->data->hdcp_level;
+            s->bandwidth = iframe->data->bandwidth;
+            s->avg_bandwidth = iframe->data->avg_bandwidth;
+            s->frame_rate = iframe->data->frame_rate;
+            s->resolution = iframe->data->resolution;
+            snap_str(&snap, SLOT(data, iframe_stream_inf_t, codecs), iframe->data->codecs);
+            snap_str(&snap, SLOT(data, iframe_stream_inf_t, video), iframe->data->video);
+            snap_str(&snap, SLOT(data, iframe_stream_inf_t, uri), iframe->data->uri);
+            snap_ptr(&snap, SLOT(node, iframe_stream_inf_list_t, data), data);
+            iframe = iframe->next;
+            if(iframe && iframe->data) {
+                size_t next = snap_alloc(&snap, sizeof(iframe_stream_inf_list_t));
+                snap_ptr(&snap, SLOT(node, iframe_stream_inf_list_t, next), next);
+                node = next;
+            }
+        }
+
+        snap_string_list(&snap, SLOT(root, master_t, custom_tags), &master->custom_tags);
+        snap_key_list(&snap, SLOT(root, master_t, session_keys), &master->session_keys);
+    }
+
+    return snap_finish(&snap, path);
+}
+
+HLSCode hlsparse_master_load_binary(const char *path, master_t **dest)
+{
+    if(!dest) {
+        return HLS_ERROR;
+    }
+
+    *dest = snap_load(path, SNAPSHOT_KIND_MASTER, sizeof(master_t));
+    return *dest ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_master_unload_binary(master_t *master)
+{
+    return snap_unload(master, SNAPSHOT_KIND_MASTER);
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "parse.h"
+
+#define CACHE_KIND_MEDIA    (1)
+#define CACHE_KIND_MASTER   (2)
+#define CACHE_URI_SEED      (0x6873u)
+
+#define STR_SIZE(s) ((s) ? strlen(s) + 1 : 0)
+
+/**
+ * Estimates the number of bytes held by a parsed media playlist.
+ *
+ * @param playlist The playlist to measure
+ */
+size_t media_playlist_footprint(const media_playlist_t *playlist)
+{
+    size_t size = STR_SIZE(playlist->uri) + sizeof(uint64_t) * playlist->nb_merkle_leaves * 2;
+
+    const segment_list_t *seg = &playlist->segments;
+    while(seg && seg->data) {
+        size += sizeof(segment_t) + STR_SIZE(seg->data->uri) + STR_SIZE(seg->data->title);
+        const string_list_t *tag = &seg->data->custom_tags;
+        while(tag && tag->data) {
+            size += STR_SIZE(tag->data) + (tag != &seg->data->custom_tags ? sizeof(string_list_t) : 0);
+            tag = tag->next;
+        }
+        size += seg != &playlist->segments ? sizeof(segment_list_t) : 0;
+        seg = seg->next;
+    }
+
+    const key_list_t *key = &playlist->keys;
+    while(key && key->data) {
+        size += sizeof(hls_key_t) + sizeof(key_list_t) + STR_SIZE(key->data->uri) +
+                key_iv_size(key->data) + STR_SIZE(key->data->key_format) +
+                STR_SIZE(key->data->key_format_versions);
+        key = key->next;
+    }
+
+    const map_list_t *map = &playlist->maps;
+    while(map && map->data) {
+        size += sizeof(map_t) + sizeof(map_list_t) + STR_SIZE(map->data->uri);
+        map = map->next;
+    }
+
+    const daterange_list_t *daterange = &playlist->dateranges;
+    while(daterange && daterange->data) {
+        const daterange_t *dr = daterange->data;
+        size += sizeof(daterange_t) + sizeof(daterange_list_t) + STR_SIZE(dr->id) +
+                STR_SIZE(dr->klass) + dr->scte35_cmd_size + dr->scte35_out_size + dr->scte35_in_size +
+                STR_SIZE(dr->attributes);
+        const param_list_t *param = &dr->client_attributes;
+        while(param && param->value_type != PARAM_TYPE_NONE) {
+            size += sizeof(param_list_t) + STR_SIZE(param->key) + param->value_size;
+            param = param->next;
+        }
+        daterange = daterange->next;
+    }
+
+    const string_list_t *tag = &playlist->custom_tags;
+    while(tag && tag->data) {
+        size += STR_SIZE(tag->data) + sizeof(string_list_t);
+        tag = tag->next;
+    }
+
+    return size;
+}
+
+/**
+ * Estimates the number of bytes held by a parsed master playlist.
+ *
+ * @param master The master playlist to measure
+ */
+size_t master_footprint(const master_t *master)
+{
+    size_t size = STR_SIZE(master->uri);
+
+    const media_list_t *media = &master->media;
+    while(media && media->data) {
+        const media_t *m = media->data;
+        size += sizeof(media_t) + sizeof(media_list_t) + STR_SIZE(m->name) +
+                STR_SIZE(m->group_id) + STR_SIZE(m->language) + STR_SIZE(m->assoc_language) +
+                STR_SIZE(m->uri) + STR_SIZE(m->characteristics) + STR_SIZE(m->channels) +
+                STR_SIZE(m->attributes);
+        media = media->next;
+    }
+
+    const stream_inf_list_t *inf = &master->stream_infs;
+    while(inf && inf->data) {
+        const stream_inf_t *s = inf->data;
+        size += sizeof(stream_inf_t) + sizeof(stream_inf_list_t) + STR_SIZE(s->codecs) +
+                STR_SIZE(s->video) + STR_SIZE(s->audio) + STR_SIZE(s->uri) +
+                STR_SIZE(s->subtitles) + STR_SIZE(s->closed_captions) + STR_SIZE(s->attributes);
+        inf = inf->next;
+    }
+
+    const iframe_stream_inf_list_t *iframe = &master->iframe_stream_infs;
+    while(iframe && iframe->data) {
+        const iframe_stream_inf_t *s = iframe->data;
+        size += sizeof(iframe_stream_inf_t) + sizeof(iframe_stream_inf_list_t) +
+                STR_SIZE(s->codecs) + STR_SIZE(s->video) + STR_SIZE(s->uri);
+        iframe = iframe->next;
+    }
+
+    const session_data_list_t *sess = &master->session_data;
+    while(sess && sess->data) {
+        const session_data_t *s = sess->data;
+        size += sizeof(session_data_t) + sizeof(session_data_list_t) + STR_SIZE(s->data_id) +
+                STR_SIZE(s->value) + STR_SIZE(s->uri) + STR_SIZE(s->language);
+        sess = sess->next;
+    }
+
+    const key_list_t *key = &master->session_keys;
+    while(key && key->data) {
+        size += sizeof(hls_key_t) + sizeof(key_list_t) + STR_SIZE(key->data->uri) +
+                key_iv_size(key->data) + STR_SIZE(key->data->key_format) +
+                STR_SIZE(key->data->key_format_versions);
+        key = key->next;
+    }
+
+    const string_list_t *tag = &master->custom_tags;
+    while(tag && tag->data) {
+        size += STR_SIZE(tag->data) + sizeof(string_list_t);
+        tag = tag->next;
+    }
+
+    return size;
+}
+
+static size_t cache_bucket(const parse_cache_t *cache, uint64_t uri_hash)
+{
+    return (size_t)(uri_hash & (uint64_t)(cache->nb_buckets - 1));
+}
+
+static void cache_lru_unlink(parse_cache_t *cache, parse_cache_entry_t *entry)
+{
+    if(entry->prev) {
+        entry->prev->next = entry->next;
+    } else if(cache->head == entry) {
+        cache->head = entry->next;
+    }
+    if(entry->next) {
+        entry->next->prev = entry->prev;
+    } else if(cache->tail == entry) {
+        cache->tail = entry->prev;
+    }
+    entry->prev = entry->next = NULL;
+}
+
+static void cache_lru_push(parse_cache_t *cache, parse_cache_entry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if(cache->head) {
+        cache->head->prev = entry;
+    }
+    cache->head = entry;
+    if(!cache->tail) {
+        cache->tail = entry;
+    }
+}
+
+static void cache_bucket_unlink(parse_cache_t *cache, parse_cache_entry_t *entry)
+{
+    parse_cache_entry_t **link = &cache->buckets[cache_bucket(cache, entry->uri_hash)];
+    while(*link) {
+        if(*link == entry) {
+            *link = entry->bucket_next;
+            break;
+        }
+        link = &(*link)->bucket_next;
+    }
+    entry->bucket_next = NULL;
+}
+
+static void cache_entry_free(parse_cache_entry_t *entry)
+{
+    if(entry->kind == CACHE_KIND_MEDIA) {
+        hlsparse_media_playlist_term(&entry->playlist.media);
+    } else {
+        hlsparse_master_term(&entry->playlist.master);
+    }
+
+    char **params[] = { &entry->uri };
+    parse_param_term(params, 1);
+    hls_free(entry);
+}
+
+/**
+ * Takes an entry out of the cache. Entries which are still borrowed are kept
+ * alive on the orphan list until their last release.
+ */
+static void cache_remove(parse_cache_t *cache, parse_cache_entry_t *entry)
+{
+    cache_bucket_unlink(cache, entry);
+    cache_lru_unlink(cache, entry);
+    cache->bytes -= entry->footprint;
+    --(cache->nb_entries);
+
+    if(entry->refs > 0) {
+        entry->orphan = HLS_TRUE;
+        entry->next = cache->orphans;
+        if(cache->orphans) {
+            cache->orphans->prev = entry;
+        }
+        cache->orphans = entry;
+    } else {
+        cache_entry_free(entry);
+    }
+}
+
+static void cache_evict(parse_cache_t *cache)
+{
+    parse_cache_entry_t *entry = cache->tail;
+    while(entry && (cache->nb_entries > cache->max_entries ||
+                    (cache->max_bytes > 0 && cache->bytes > cache->max_bytes))) {
+        parse_cache_entry_t *prev = entry->prev;
+        // borrowed entries and the most recent entry are never evicted
+        if(entry != cache->head && entry->refs == 0) {
+            cache_remove(cache, entry);
+            ++(cache->evictions);
+        }
+        entry = prev;
+    }
+}
+
+static parse_cache_entry_t *cache_find(parse_cache_t *cache, const char *uri, uint64_t uri_hash, int kind)
+{
+    parse_cache_entry_t *entry = cache->buckets[cache_bucket(cache, uri_hash)];
+    while(entry) {
+        if(entry->uri_hash == uri_hash && entry->kind == kind && strcmp(entry->uri, uri) == 0) {
+            return entry;
+        }
+        entry = entry->bucket_next;
+    }
+    return NULL;
+}
+
+/**
+ * Looks up \a src in the cache, parsing it into a new entry on a miss.
+ */
+static parse_cache_entry_t *cache_get(parse_cache_t *cache, const char *uri, const char *src, size_t size, int kind)
+{
+    uint64_t uri_hash = hls_hash64(uri, strlen(uri), CACHE_URI_SEED);
+    uint64_t hash = hls_hash64(src, size, 0);
+
+    parse_cache_entry_t *entry = cache_find(cache, uri, uri_hash, kind);
+    if(entry) {
+        if(entry->hash == hash && entry->size == size) {
+            ++(cache->hits);
+            cache_lru_unlink(cache, entry);
+            cache_lru_push(cache, entry);
+            ++(entry->refs);
+            return entry;
+        }
+        // the playlist has changed, drop the stale version
+        cache_remove(cache, entry);
+    }
+
+    ++(cache->misses);
+
+    entry = hls_malloc(sizeof(parse_cache_entry_t));
+    if(!entry) {
+        return NULL;
+    }
+    memset(entry, 0, sizeof(parse_cache_entry_t));
+    entry->kind = kind;
+    entry->uri = str_utils_dup(uri);
+    entry->uri_hash = uri_hash;
+    entry->hash = hash;
+    entry->size = size;
+
+    // the uri is the base used to resolve relative paths inside the playlist
+    if(kind == CACHE_KIND_MEDIA) {
+        hlsparse_media_playlist_init(&entry->playlist.media);
+        entry->playlist.media.uri = str_utils_dup(uri);
+        hlsparse_media_playlist(src, size, &entry->playlist.media);
+        entry->footprint = media_playlist_footprint(&entry->playlist.media);
+    } else {
+        hlsparse_master_init(&entry->playlist.master);
+        entry->playlist.master.uri = str_utils_dup(uri);
+        hlsparse_master(src, size, &entry->playlist.master);
+        entry->footprint = master_footprint(&entry->playlist.master);
+    }
+    entry->footprint += sizeof(parse_cache_entry_t) + STR_SIZE(uri);
+
+    size_t bucket = cache_bucket(cache, uri_hash);
+    entry->bucket_next = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    cache_lru_push(cache, entry);
+    cache->bytes += entry->footprint;
+    ++(cache->nb_entries);
+    entry->refs = 1;
+
+    cache_evict(cache);
+    return entry;
+}
+
+static HLSCode cache_release(parse_cache_t *cache, parse_cache_entry_t *entry)
+{
+    if(entry->refs <= 0) {
+        return HLS_ERROR;
+    }
+
+    --(entry->refs);
+    if(entry->refs == 0) {
+        if(entry->orphan) {
+            if(entry->prev) {
+                entry->prev->next = entry->next;
+            } else {
+                cache->orphans = entry->next;
+            }
+            if(entry->next) {
+                entry->next->prev = entry->prev;
+            }
+            cache_entry_free(entry);
+        } else {
+            // entries over budget are only kept while they are borrowed
+            cache_evict(cache);
+        }
+    }
+    return HLS_OK;
+}
+
+HLSCode hlsparse_cache_init(parse_cache_t *cache, int max_entries, size_t max_bytes)
+{
+    if(!cache || max_entries <= 0) {
+        return HLS_ERROR;
+    }
+
+    memset(cache, 0, sizeof(parse_cache_t));
+    cache->max_entries = max_entries;
+    cache->max_bytes = max_bytes;
+
+    // keep the bucket array a power of two at least twice the entry count
+    cache->nb_buckets = 16;
+    while(cache->nb_buckets < max_entries * 2) {
+        cache->nb_buckets *= 2;
+    }
+
+    cache->buckets = hls_malloc(sizeof(parse_cache_entry_t*) * cache->nb_buckets);
+    if(!cache->buckets) {
+        return HLS_ERROR;
+    }
+    memset(cache->buckets, 0, sizeof(parse_cache_entry_t*) * cache->nb_buckets);
+    return HLS_OK;
+}
+
+HLSCode hlsparse_cache_term(parse_cache_t *cache)
+{
+    if(!cache) {
+        return HLS_ERROR;
+    }
+
+    while(cache->head) {
+        parse_cache_entry_t *entry = cache->head;
+        cache->head = entry->next;
+        cache_entry_free(entry);
+    }
+    while(cache->orphans) {
+        parse_cache_entry_t *entry = cache->orphans;
+        cache->orphans = entry->next;
+        cache_entry_free(entry);
+    }
+
+    if(cache->buckets) {
+        hls_free(cache->buckets);
+    }
+    memset(cache, 0, sizeof(parse_cache_t));
+    return HLS_OK;
+}
+
+HLSCode hlsparse_cache_media_playlist(parse_cache_t *cache, const char *uri, const char *src, size_t size, media_playlist_t **dest)
+{
+    if(!cache || !cache->buckets || !uri || !src || !dest) {
+        return HLS_ERROR;
+    }
+
+    parse_cache_entry_t *entry = cache_get(cache, uri, src, size, CACHE_KIND_MEDIA);
+    *dest = entry ? &entry->playlist.media : NULL;
+    return entry ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_cache_master(parse_cache_t *cache, const char *uri, const char *src, size_t size, master_t **dest)
+{
+    if(!cache || !cache->buckets || !uri || !src || !dest) {
+        return HLS_ERROR;
+    }
+
+    parse_cache_entry_t *entry = cache_get(cache, uri, src, size, CACHE_KIND_MASTER);
+    *dest = entry ? &entry->playlist.master : NULL;
+    return entry ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_cache_media_playlist_release(parse_cache_t *cache, media_playlist_t *playlist)
+{
+    if(!cache || !playlist) {
+        return HLS_ERROR;
+    }
+
+    parse_cache_entry_t *entry = (parse_cache_entry_t*)((char*)playlist - offsetof(parse_cache_entry_t, playlist.media));
+    return cache_release(cache, entry);
+}
+
+HLSCode hlsparse_cache_master_release(parse_cache_t *cache, master_t *master)
+{
+    if(!cache || !master) {
+        return HLS_ERROR;
+    }
+
+    parse_cache_entry_t *entry = (parse_cache_entry_t*)((char*)master - offsetof(parse_cache_entry_t, playlist.master));
+    return cache_release(cache, entry);
+}
@@ -0,0 +1,457 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+typedef uint64_t (*diff_hash_callback)(const void *);
+typedef bool_t (*diff_equal_callback)(const void *, const void *);
+
+/**
+ * Slot of the open addressed table used to match keys, maps and dateranges
+ * between two playlists.
+ */
+typedef struct {
+    uint64_t hash;
+    const void *item;
+    bool_t matched;
+} diff_slot_t;
+
+static uint64_t hash_str(uint64_t h, const char *str)
+{
+    return hls_hash64(str, str ? strlen(str) : 0, h);
+}
+
+static bool_t str_equal(const char *a, const char *b)
+{
+    if(!a || !b) {
+        return a == b;
+    }
+    return strcmp(a, b) == 0;
+}
+
+static bool_t data_equal(const char *a, size_t a_size, const char *b, size_t b_size)
+{
+    if(a_size != b_size || (!a) != (!b)) {
+        return HLS_FALSE;
+    }
+    return !a || memcmp(a, b, a_size) == 0;
+}
+
+static uint64_t key_hash(const void *item)
+{
+    const hls_key_t *key = (const hls_key_t*)item;
+    uint64_t h = hls_hash64(&key->method, sizeof(key->method), 0);
+    h = hash_str(h, key->uri);
+    h = hls_hash64(key->iv, key_iv_size(key), h);
+    h = hash_str(h, key->key_format);
+    return hash_str(h, key->key_format_versions);
+}
+
+static bool_t key_equal(const void *a_item, const void *b_item)
+{
+    const hls_key_t *a = (const hls_key_t*)a_item;
+    const hls_key_t *b = (const hls_key_t*)b_item;
+    if(!a || !b) {
+        return a == b;
+    }
+    return a->method == b->method &&
+           str_equal(a->uri, b->uri) &&
+           data_equal(a->iv, key_iv_size(a), b->iv, key_iv_size(b)) &&
+           str_equal(a->key_format, b->key_format) &&
+           str_equal(a->key_format_versions, b->key_format_versions);
+}
+
+static uint64_t map_hash(const void *item)
+{
+    const map_t *map = (const map_t*)item;
+    uint64_t h = hash_str(0, map->uri);
+    return hls_hash64(&map->byte_range, sizeof(byte_range_t), h);
+}
+
+static bool_t map_equal(const void *a_item, const void *b_item)
+{
+    const map_t *a = (const map_t*)a_item;
+    const map_t *b = (const map_t*)b_item;
+    if(!a || !b) {
+        return a == b;
+    }
+    return str_equal(a->uri, b->uri) &&
+           a->byte_range.n == b->byte_range.n &&
+           a->byte_range.o == b->byte_range.o;
+}
+
+static uint64_t daterange_hash(const void *item)
+{
+    const daterange_t *daterange = (const daterange_t*)item;
+    uint64_t h = hash_str(0, daterange->id);
+    h = hash_str(h, daterange->klass);
+    h = hls_hash64(&daterange->start_date, sizeof(timestamp_t), h);
+    return hls_hash64(&daterange->end_date, sizeof(timestamp_t), h);
+}
+
+static bool_t param_list_equal(const param_list_t *a, const param_list_t *b)
+{
+    while(a && b && a->value_type != PARAM_TYPE_NONE && b->value_type != PARAM_TYPE_NONE) {
+        if(!str_equal(a->key, b->key) || a->value_type != b->value_type) {
+            return HLS_FALSE;
+        }
+        if(a->value_type == PARAM_TYPE_FLOAT) {
+            if(a->value.number != b->value.number) {
+                return HLS_FALSE;
+            }
+        } else if(!data_equal(a->value.data, a->value_size, b->value.data, b->value_size)) {
+            return HLS_FALSE;
+        }
+        a = a->next;
+        b = b->next;
+    }
+    // both lists must end at the same time
+    return (!a || a->value_type == PARAM_TYPE_NONE) == (!b || b->value_type == PARAM_TYPE_NONE);
+}
+
+static bool_t daterange_equal(const void *a_item, const void *b_item)
+{
+    const daterange_t *a = (const daterange_t*)a_item;
+    const daterange_t *b = (const daterange_t*)b_item;
+    return str_equal(a->id, b->id) &&
+           str_equal(a->klass, b->klass) &&
+           a->start_date == b->start_date &&
+           a->end_date == b->end_date &&
+           a->duration == b->duration &&
+           a->planned_duration == b->planned_duration &&
+           a->end_on_next == b->end_on_next &&
+           data_equal(a->scte35_cmd, a->scte35_cmd_size, b->scte35_cmd, b->scte35_cmd_size) &&
+           data_equal(a->scte35_out, a->scte35_out_size, b->scte35_out, b->scte35_out_size) &&
+           data_equal(a->scte35_in, a->scte35_in_size, b->scte35_in, b->scte35_in_size) &&
+           param_list_equal(&a->client_attributes, &b->client_attributes);
+}
+
+/**
+ * Matches two arrays of items by content and counts the items found only in
+ * one of them. Runs in linear time using an open addressed hash table.
+ *
+ * @returns HLS_OK on success, HLS_ERROR if the table couldn't be allocated
+ */
+static HLSCode diff_items(const void **old_items, int nb_old, const void **new_items, int nb_new,
+                          diff_hash_callback hash, diff_equal_callback equal,
+                          int *added, int *removed)
+{
+    *added = *removed = 0;
+    if(nb_old == 0 || nb_new == 0) {
+        *added = nb_new;
+        *removed = nb_old;
+        return HLS_OK;
+    }
+
+    size_t nb_slots = 16;
+    while(nb_slots < (size_t)nb_old * 2) {
+        nb_slots *= 2;
+    }
+
+    diff_slot_t *slots = hls_malloc(sizeof(diff_slot_t) * nb_slots);
+    if(!slots) {
+        return HLS_ERROR;
+    }
+    memset(slots, 0, sizeof(diff_slot_t) * nb_slots);
+
+    int i;
+    for(i = 0; i < nb_old; ++i) {
+        uint64_t h = hash(old_items[i]);
+        size_t slot = (size_t)h & (nb_slots - 1);
+        while(slots[slot].item) {
+            slot = (slot + 1) & (nb_slots - 1);
+        }
+        slots[slot].hash = h;
+        slots[slot].item = old_items[i];
+    }
+
+    int matched = 0;
+    for(i = 0; i < nb_new; ++i) {
+        uint64_t h = hash(new_items[i]);
+        size_t slot = (size_t)h & (nb_slots - 1);
+        bool_t found = HLS_FALSE;
+        while(slots[slot].item) {
+            if(!slots[slot].matched && slots[slot].hash == h && equal(slots[slot].item, new_items[i])) {
+                slots[slot].matched = HLS_TRUE;
+                found = HLS_TRUE;
+                break;
+            }
+            slot = (slot + 1) & (nb_slots - 1);
+        }
+        if(found) {
+            ++matched;
+        } else {
+            ++(*added);
+        }
+    }
+
+    *removed = nb_old - matched;
+    hls_free(slots);
+    return HLS_OK;
+}
+
+/**
+ * Decodes a copy of a lazily parsed daterange, the playlists being compared
+ * are const and may be loaded snapshots so they are never decoded in place.
+ *
+ * @returns the copy, or NULL when the daterange is already fully decoded or the
+ * copy couldn't be allocated
+ */
+static daterange_t *diff_decode_daterange(const daterange_t *daterange, HLSCode *res)
+{
+    if(!daterange->attributes || daterange->decoded == DATERANGE_ATTR_ALL) {
+        return NULL;
+    }
+
+    daterange_t *copy = hls_malloc(sizeof(daterange_t));
+    if(!copy) {
+        *res = HLS_ERROR;
+        return NULL;
+    }
+    hlsparse_daterange_init(copy);
+    parse_daterange(daterange->attributes, strlen(daterange->attributes), copy);
+    return copy;
+}
+
+/**
+ * Copies the data pointers of a playlist's key, map and daterange lists into
+ * arrays so that segments can look them up by index. Lazily parsed dateranges
+ * are decoded into copies kept in \a decoded, which the caller frees.
+ */
+static HLSCode diff_collect(const media_playlist_t *playlist, const void ***keys, const void ***maps,
+                            const void ***dateranges, daterange_t ***decoded)
+{
+    *keys = hls_malloc(sizeof(void*) * (playlist->nb_keys + 1));
+    *maps = hls_malloc(sizeof(void*) * (playlist->nb_maps + 1));
+    *dateranges = hls_malloc(sizeof(void*) * (playlist->nb_dateranges + 1));
+    *decoded = hls_malloc(sizeof(daterange_t*) * (playlist->nb_dateranges + 1));
+    if(*decoded) {
+        memset(*decoded, 0, sizeof(daterange_t*) * (playlist->nb_dateranges + 1));
+    }
+    if(!*keys || !*maps || !*dateranges || !*decoded) {
+        return HLS_ERROR;
+    }
+
+    int i = 0;
+    const key_list_t *key = &playlist->keys;
+    while(key && key->data && i < playlist->nb_keys) {
+        (*keys)[i++] = key->data;
+        key = key->next;
+    }
+
+    i = 0;
+    const map_list_t *map = &playlist->maps;
+    while(map && map->data && i < playlist->nb_maps) {
+        (*maps)[i++] = map->data;
+        map = map->next;
+    }
+
+    i = 0;
+    HLSCode res = HLS_OK;
+    const daterange_list_t *daterange = &playlist->dateranges;
+    while(daterange && daterange->data && i < playlist->nb_dateranges) {
+        (*decoded)[i] = diff_decode_daterange(daterange->data, &res);
+        (*dateranges)[i] = (*decoded)[i] ? (*decoded)[i] : daterange->data;
+        ++i;
+        daterange = daterange->next;
+    }
+
+    return res;
+}
+
+static void diff_free_decoded(daterange_t **decoded, int nb_dateranges)
+{
+    int i;
+    if(decoded) {
+        for(i = 0; i < nb_dateranges; ++i) {
+            if(decoded[i]) {
+                hlsparse_daterange_term(decoded[i]);
+                hls_free(decoded[i]);
+            }
+        }
+        hls_free(decoded);
+    }
+}
+
+static const void *diff_lookup(const void **items, int nb_items, int index)
+{
+    return (index >= 0 && index < nb_items) ? items[index] : NULL;
+}
+
+static bool_t segment_equal(const segment_t *a, const void **a_keys, const void **a_maps, const media_playlist_t *a_playlist,
+                            const segment_t *b, const void **b_keys, const void **b_maps, const media_playlist_t *b_playlist)
+{
+    return str_equal(a->uri, b->uri) &&
+           str_equal(a->title, b->title) &&
+           a->duration == b->duration &&
+           a->discontinuity == b->discontinuity &&
+           a->byte_range.n == b->byte_range.n &&
+           a->byte_range.o == b->byte_range.o &&
+           key_equal(diff_lookup(a_keys, a_playlist->nb_keys, a->key_index),
+                     diff_lookup(b_keys, b_playlist->nb_keys, b->key_index)) &&
+           map_equal(diff_lookup(a_maps, a_playlist->nb_maps, a->map_index),
+                     diff_lookup(b_maps, b_playlist->nb_maps, b->map_index));
+}
+
+HLSCode hlsparse_media_playlist_diff_init(media_playlist_diff_t *diff)
+{
+    if(!diff) {
+        return HLS_ERROR;
+    }
+
+    memset(diff, 0, sizeof(media_playlist_diff_t));
+    return HLS_OK;
+}
+
+HLSCode hlsparse_media_playlist_diff_term(media_playlist_diff_t *diff)
+{
+    if(!diff) {
+        return HLS_ERROR;
+    }
+
+    if(diff->changed) {
+        hls_free(diff->changed);
+    }
+    memset(diff, 0, sizeof(media_playlist_diff_t));
+    return HLS_OK;
+}
+
+HLSCode hlsparse_media_playlist_diff(const media_playlist_t *old_playlist, const media_playlist_t *new_playlist, media_playlist_diff_t *diff)
+{
+    if(!old_playlist || !new_playlist || !diff) {
+        return HLS_ERROR;
+    }
+
+    hlsparse_media_playlist_diff_term(diff);
+
+    const media_playlist_t *a = old_playlist;
+    const media_playlist_t *b = new_playlist;
+
+    // header changes
+    if(a->version != b->version) {
+        diff->changes |= PLAYLIST_DIFF_VERSION;
+    }
+    if(a->target_duration != b->target_duration) {
+        diff->changes |= PLAYLIST_DIFF_TARGET_DURATION;
+    }
+    if(a->playlist_type != b->playlist_type) {
+        diff->changes |= PLAYLIST_DIFF_PLAYLIST_TYPE;
+    }
+    if(a->end_list != b->end_list) {
+        diff->changes |= PLAYLIST_DIFF_END_LIST;
+    }
+    if(a->media_sequence != b->media_sequence) {
+        diff->changes |= PLAYLIST_DIFF_MEDIA_SEQUENCE;
+    }
+    if(a->discontinuity_sequence != b->discontinuity_sequence) {
+        diff->changes |= PLAYLIST_DIFF_DISCONTINUITY_SEQ;
+    }
+    if(a->iframes_only != b->iframes_only) {
+        diff->changes |= PLAYLIST_DIFF_IFRAMES_ONLY;
+    }
+    if(a->independent_segments != b->independent_segments) {
+        diff->changes |= PLAYLIST_DIFF_INDEPENDENT_SEGMENTS;
+    }
+    if(a->start.time_offset != b->start.time_offset || a->start.precise != b->start.precise) {
+        diff->changes |= PLAYLIST_DIFF_START;
+    }
+
+    const void **a_keys = NULL, **a_maps = NULL, **a_dateranges = NULL;
+    const void **b_keys = NULL, **b_maps = NULL, **b_dateranges = NULL;
+    daterange_t **a_decoded = NULL, **b_decoded = NULL;
+    HLSCode res = diff_collect(a, &a_keys, &a_maps, &a_dateranges, &a_decoded);
+    if(res == HLS_OK) {
+        res = diff_collect(b, &b_keys, &b_maps, &b_dateranges, &b_decoded);
+    }
+
+    if(res == HLS_OK) {
+        res |= diff_items(a_keys, a->nb_keys, b_keys, b->nb_keys, key_hash, key_equal,
+                          &diff->nb_keys_added, &diff->nb_keys_removed);
+        res |= diff_items(a_maps, a->nb_maps, b_maps, b->nb_maps, map_hash, map_equal,
+                          &diff->nb_maps_added, &diff->nb_maps_removed);
+        res |= diff_items(a_dateranges, a->nb_dateranges, b_dateranges, b->nb_dateranges,
+                          daterange_hash, daterange_equal,
+                          &diff->nb_dateranges_added, &diff->nb_dateranges_removed);
+    }
+
+    if(res == HLS_OK) {
+        int nb_overlap = a->nb_segments < b->nb_segments ? a->nb_segments : b->nb_segments;
+        diff->changed = hls_malloc(sizeof(int) * (nb_overlap + 1));
+        res = diff->changed ? HLS_OK : HLS_ERROR;
+    }
+
+    if(res == HLS_OK) {
+        // both segment lists are ordered by sequence number, walk them side by side
+        const segment_list_t *a_seg = a->segments.data ? &a->segments : NULL;
+        segment_list_t *b_seg = b->segments.data ? (segment_list_t*)&b->segments : NULL;
+
+        // sequence_num counts from the first segment parsed, which may since have expired
+        int a_base = a->media_sequence - (a_seg ? a_seg->data->sequence_num : 0);
+        int b_base = b->media_sequence - (b_seg ? b_seg->data->sequence_num : 0);
+
+        while(a_seg && a_seg->data && b_seg && b_seg->data) {
+            int a_num = a_base + a_seg->data->sequence_num;
+            int b_num = b_base + b_seg->data->sequence_num;
+            if(a_num < b_num) {
+                ++(diff->nb_expired);
+                a_seg = a_seg->next;
+            } else if(b_num < a_num) {
+                ++(diff->nb_prepended);
+                b_seg = b_seg->next;
+            } else {
+                if(segment_equal(a_seg->data, a_keys, a_maps, a, b_seg->data, b_keys, b_maps, b)) {
+                    ++(diff->nb_unchanged);
+                } else {
+                    diff->changed[diff->nb_changed++] = b_num;
+                }
+                a_seg = a_seg->next;
+                b_seg = b_seg->next;
+            }
+        }
+
+        while(a_seg && a_seg->data) {
+            ++(diff->nb_truncated);
+            a_seg = a_seg->next;
+        }
+
+        if(b_seg && b_seg->data) {
+            diff->appended = b_seg;
+        }
+        while(b_seg && b_seg->data) {
+            ++(diff->nb_appended);
+            b_seg = b_seg->next;
+        }
+
+        if(diff->nb_expired || diff->nb_prepended || diff->nb_appended || diff->nb_truncated || diff->nb_changed) {
+            diff->changes |= PLAYLIST_DIFF_SEGMENTS;
+        }
+        if(diff->nb_keys_added || diff->nb_keys_removed) {
+            diff->changes |= PLAYLIST_DIFF_KEYS;
+        }
+        if(diff->nb_maps_added || diff->nb_maps_removed) {
+            diff->changes |= PLAYLIST_DIFF_MAPS;
+        }
+        if(diff->nb_dateranges_added || diff->nb_dateranges_removed) {
+            diff->changes |= PLAYLIST_DIFF_DATERANGES;
+        }
+    }
+
+    const void **arrays[] = { a_keys, a_maps, a_dateranges, b_keys, b_maps, b_dateranges };
+    int i;
+    for(i = 0; i < 6; ++i) {
+        if(arrays[i]) {
+            hls_free((void*)arrays[i]);
+        }
+    }
+    diff_free_decoded(a_decoded, a->nb_dateranges);
+    diff_free_decoded(b_decoded, b->nb_dateranges);
+
+    if(res != HLS_OK) {
+        hlsparse_media_playlist_diff_term(diff);
+    }
+    return res;
+}
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+// XXH64 primes
+#define PRIME64_1   0x9E3779B185EBCA87ULL
+#define PRIME64_2   0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3   0x165667B19E3779F9ULL
+#define PRIME64_4   0x85EBCA77C2B2AE63ULL
+#define PRIME64_5   0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = ROTL64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t merge64(uint64_t acc, uint64_t val)
+{
+    acc ^= round64(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+/**
+ * Hashes \a size bytes of \a data using the XXH64 algorithm.
+ *
+ * @param data The data to hash
+ * @param size The number of bytes in data
+ * @param seed The seed value of the hash
+ * @returns The 64 bit hash value
+ */
+uint64_t hls_hash64(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    const uint8_t *end = p + size;
+    uint64_t h;
+
+    if(!data) {
+        size = 0;
+        p = end = (const uint8_t*)"";
+    }
+
+    if(size >= 32) {
+        const uint8_t *limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while(p <= limit);
+
+        h = ROTL64(v1, 1) + ROTL64(v2, 7) + ROTL64(v3, 12) + ROTL64(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t)size;
+
+    while(p + 8 <= end) {
+        h ^= round64(0, read64(p));
+        h = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+
+    if(p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+
+    while(p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = ROTL64(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+#define SEGMENT_HASH_SEED   (0x736567u)
+#define MERKLE_HASH_SEED    (0x6d6b6cu)
+
+// hashes a value as 8 little endian bytes so fingerprints match across hosts
+static uint64_t hash_u64(uint64_t h, uint64_t value)
+{
+    uint8_t bytes[8];
+    int i;
+    for(i = 0; i < 8; ++i) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+    return hls_hash64(bytes, 8, h);
+}
+
+static uint64_t hash_str(uint64_t h, const char *str)
+{
+    // include the length so that a NULL string differs from an empty one
+    h = hash_u64(h, str ? strlen(str) + 1 : 0);
+    return hls_hash64(str, str ? strlen(str) : 0, h);
+}
+
+static uint64_t hash_float(uint64_t h, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_u64(h, bits);
+}
+
+static uint64_t segment_hash(const segment_t *segment, const hls_key_t *key)
+{
+    uint64_t h = hash_str(SEGMENT_HASH_SEED, segment->uri);
+    h = hash_float(h, segment->duration);
+    h = hash_u64(h, (uint32_t)segment->byte_range.n);
+    h = hash_u64(h, (uint32_t)segment->byte_range.o);
+    h = hash_u64(h, segment->discontinuity ? 1 : 0);
+    if(key) {
+        h = hash_u64(h, (uint32_t)key->method);
+        h = hash_str(h, key->uri);
+        h = hls_hash64(key->iv, key_iv_size(key), h);
+    } else {
+        h = hash_u64(h, 0);
+    }
+    return h;
+}
+
+static uint64_t merkle_parent(uint64_t left, uint64_t right)
+{
+    return hash_u64(hash_u64(MERKLE_HASH_SEED, left), right);
+}
+
+// number of nodes in a level of a tree with nb_leaves leaves
+static int merkle_level_size(int nb_leaves, int level)
+{
+    return (int)(((int64_t)nb_leaves + ((int64_t)1 << level) - 1) >> level);
+}
+
+static int merkle_top_level(int nb_leaves)
+{
+    int level = 0;
+    while(merkle_level_size(nb_leaves, level) > 1) {
+        ++level;
+    }
+    return level;
+}
+
+/**
+ * Looks up a node of a hash tree. Levels above the root hold the root alone,
+ * as a node without a sibling is carried up unchanged.
+ *
+ * @returns HLS_TRUE if the node exists
+ */
+static bool_t merkle_node(const uint64_t *tree, int nb_leaves, int level, int index, uint64_t *hash)
+{
+    if(!tree || nb_leaves <= 0 || level < 0 || index < 0) {
+        return HLS_FALSE;
+    }
+
+    int top = merkle_top_level(nb_leaves);
+    if(level > top) {
+        level = top;
+        if(index != 0) {
+            return HLS_FALSE;
+        }
+    }
+
+    if(index >= merkle_level_size(nb_leaves, level)) {
+        return HLS_FALSE;
+    }
+
+    size_t offset = 0;
+    int i;
+    for(i = 0; i < level; ++i) {
+        offset += merkle_level_size(nb_leaves, i);
+    }
+
+    *hash = tree[offset + index];
+    return HLS_TRUE;
+}
+
+/**
+ * Returns the index of the first leaf under a node which differs between two
+ * trees, or -1 if the subtrees are identical.
+ */
+static int merkle_first_diff(const media_playlist_t *a, const media_playlist_t *b, int level, int index)
+{
+    uint64_t a_hash = 0, b_hash = 0;
+    bool_t a_exists = merkle_node(a->merkle_tree, a->nb_merkle_leaves, level, index, &a_hash);
+    bool_t b_exists = merkle_node(b->merkle_tree, b->nb_merkle_leaves, level, index, &b_hash);
+
+    if(!a_exists && !b_exists) {
+        return -1;
+    }
+    if(a_exists && b_exists && a_hash == b_hash) {
+        return -1;
+    }
+    if(level == 0) {
+        return index;
+    }
+
+    int res = merkle_first_diff(a, b, level - 1, index * 2);
+    if(res < 0) {
+        res = merkle_first_diff(a, b, level - 1, index * 2 + 1);
+    }
+    return res;
+}
+
+HLSCode hlsparse_media_playlist_hash_segments(media_playlist_t *playlist)
+{
+    if(!playlist) {
+        return HLS_ERROR;
+    }
+
+    if(playlist->merkle_tree) {
+        hls_free(playlist->merkle_tree);
+    }
+    playlist->merkle_tree = NULL;
+    playlist->merkle_root = 0;
+    playlist->nb_merkle_leaves = 0;
+
+    int nb_leaves = 0;
+    const segment_list_t *seg = &playlist->segments;
+    while(seg && seg->data) {
+        ++nb_leaves;
+        seg = seg->next;
+    }
+
+    if(nb_leaves == 0) {
+        return HLS_OK;
+    }
+
+    // segments reference their key by index
+    const hls_key_t **keys = hls_malloc(sizeof(hls_key_t*) * (playlist->nb_keys + 1));
+    if(!keys) {
+        return HLS_ERROR;
+    }
+    int nb_keys = 0;
+    const key_list_t *key = &playlist->keys;
+    while(key && key->data && nb_keys < playlist->nb_keys) {
+        keys[nb_keys++] = key->data;
+        key = key->next;
+    }
+
+    int top = merkle_top_level(nb_leaves);
+    size_t size = 0;
+    int level;
+    for(level = 0; level <= top; ++level) {
+        size += merkle_level_size(nb_leaves, level);
+    }
+
+    uint64_t *tree = hls_malloc(sizeof(uint64_t) * size);
+    if(!tree) {
+        hls_free(keys);
+        return HLS_ERROR;
+    }
+
+    int i = 0;
+    seg = &playlist->segments;
+    while(seg && seg->data) {
+        int key_index = seg->data->key_index;
+        const hls_key_t *seg_key = (key_index >= 0 && key_index < nb_keys) ? keys[key_index] : NULL;
+        seg->data->hash = segment_hash(seg->data, seg_key);
+        tree[i++] = seg->data->hash;
+        seg = seg->next;
+    }
+    hls_free(keys);
+
+    const uint64_t *children = tree;
+    uint64_t *parents = tree + nb_leaves;
+    for(level = 1; level <= top; ++level) {
+        int nb_children = merkle_level_size(nb_leaves, level - 1);
+        int nb_parents = merkle_level_size(nb_leaves, level);
+        for(i = 0; i < nb_parents; ++i) {
+            if(i * 2 + 1 < nb_children) {
+                parents[i] = merkle_parent(children[i * 2], children[i * 2 + 1]);
+            } else {
+                parents[i] = children[i * 2];
+            }
+        }
+        children = parents;
+        parents += nb_parents;
+    }
+
+    playlist->merkle_tree = tree;
+    playlist->merkle_root = tree[size - 1];
+    playlist->nb_merkle_leaves = nb_leaves;
+    return HLS_OK;
+}
+
+HLSCode hlsparse_media_playlist_merkle_node(const media_playlist_t *playlist, int level, int index, uint64_t *hash)
+{
+    if(!playlist || !hash) {
+        return HLS_ERROR;
+    }
+
+    return merkle_node(playlist->merkle_tree, playlist->nb_merkle_leaves, level, index, hash) ? HLS_OK : HLS_ERROR;
+}
+
+HLSCode hlsparse_media_playlist_first_divergence(const media_playlist_t *a, const media_playlist_t *b, int *sequence)
+{
+    if(!a || !b || !sequence) {
+        return HLS_ERROR;
+    }
+
+    // a playlist without segments has no tree to compare
+    if((a->nb_segments > 0 && !a->merkle_tree) || (b->nb_segments > 0 && !b->merkle_tree)) {
+        return HLS_ERROR;
+    }
+
+    if(a->media_sequence != b->media_sequence) {
+        // the first segment of one playlist doesn't exist in the other
+        *sequence = a->media_sequence < b->media_sequence ? a->media_sequence : b->media_sequence;
+        return HLS_OK;
+    }
+
+    int a_top = merkle_top_level(a->nb_merkle_leaves);
+    int b_top = merkle_top_level(b->nb_merkle_leaves);
+    int index = merkle_first_diff(a, b, a_top > b_top ? a_top : b_top, 0);
+
+    *sequence = index < 0 ? -1 : a->media_sequence + index;
+    return HLS_OK;
+}
@@ -1,4 +1,5 @@
 #include "parse.h"
+#include "probes.h"
 #include <memory.h>
 #include <stdio.h>
 
@@ -13,7 +14,7 @@ HLSCode hlsparse_global_init(void)
     return HLS_OK;
 }
 
-HLSCode hlsparse_init_mem(hlsparse_malloc_callback m, hlsparse_free_callback f)
+HLSCode hlsparse_global_init_mem(hlsparse_malloc_callback m, hlsparse_free_callback f)
 {
     if(!m || !f) {
         return HLS_ERROR;
@@ -24,6 +25,13 @@ HLSCode hlsparse_init_mem(hlsparse_malloc_callback m, hlsparse_free_callback f)
     return HLS_OK;
 }
 
+void hlsparse_free(void *ptr)
+{
+    if(ptr) {
+        hls_free(ptr);
+    }
+}
+
 HLSCode hlsparse_master_init(master_t *dest)
 {
     if(!dest) {
@@ -60,6 +68,7 @@ HLSCode hlsparse_master_term(master_t *dest)
     hlsparse_media_list_term(&dest->media);
     hlsparse_stream_inf_list_term(&dest->stream_infs);
     hlsparse_iframe_stream_inf_list_term(&dest->iframe_stream_infs);
+    parse_key_list_term(&dest->session_keys);
 
     return HLS_OK;
 }
@@ -70,14 +79,27 @@ HLSCode hlsparse_media_playlist_term(media_playlist_t *dest)
         return HLS_ERROR;
     }
     char **params[] = {
-        &dest->uri
+        &dest->uri,
+        (char**)&dest->merkle_tree
     };
 
-    parse_param_term(params, 1);
+    parse_param_term(params, 2);
     hlsparse_string_list_term(&dest->custom_tags);
     hlsparse_segment_list_term(&dest->segments);
+    parse_key_list_term(&dest->keys);
     parse_map_list_term(&dest->maps);
     hlsparse_daterange_list_term(&dest->dateranges);
+    hlsparse_segment_list_term(dest->free_segments);
+    hlsparse_segment_list_term(dest->free_segment_nodes);
+    char **free_lists[] = {
+        (char**)&dest->free_segments,
+        (char**)&dest->free_segment_nodes
+    };
+    parse_param_term(free_lists, 2);
+    dest->segments_tail = NULL;
+    dest->keys_tail = NULL;
+    dest->maps_tail = NULL;
+    dest->dateranges_tail = NULL;
     
     return HLS_OK;
 }
@@ -86,6 +108,9 @@ int hlsparse_master(const char *src, size_t size, master_t *dest)
 {
     int res = 0;
 
+    HLS_PROBE2(parse_master_start, src, size);
+    uint64_t start = hls_metrics_enabled ? metrics_now() : 0;
+
     // make sure we have some data
     if (src && *src != '\0' && src < &src[size]) {
         // go through each line parsing the tags
@@ -104,6 +129,10 @@ int hlsparse_master(const char *src, size_t size, master_t *dest)
         res = pt - src;
     }
 
+    if(start) {
+        metrics_parse(HLS_TRUE, res, start);
+    }
+    HLS_PROBE2(parse_master_done, res, dest ? dest->nb_stream_infs : 0);
     return res;
 }
 
@@ -111,9 +140,15 @@ int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest
 {
     int res = 0;
 
+    HLS_PROBE2(parse_media_start, src, size);
+    uint64_t start = hls_metrics_enabled ? metrics_now() : 0;
+
     if(dest) {
-        // reset the duration
-        dest->duration = 0;
+        // reset the duration, segments parsed earlier are kept when the
+        // playlist is being updated
+        if(dest->nb_segments == 0) {
+            dest->duration = 0;
+        }
         // reset the segment byte range
         dest->next_segment_byterange.n = dest->next_segment_byterange.o = 0;
     }
@@ -122,6 +157,13 @@ int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest
     if(src && (src[0] != '\0') && size > 0) {
         // go through each line parsing the tags
         const char* pt = &src[0];
+
+        // a tail parse starts at the tags of the first segment it builds
+        int nb_segments = dest ? dest->nb_segments : 0;
+        pt += parse_media_playlist_tail(src, size, dest);
+        timestamp_t tail_pdt = dest ? dest->next_segment_pdt : 0;
+        bool_t tail = pt != src;
+
         while(*pt != '\0' && pt < &src[size]) {
             if(*pt == '#') {
                 ++pt;
@@ -136,6 +178,12 @@ int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest
             }
         }
 
+        // the first segment is compared with the last skipped one
+        segment_t *first = tail ? dest->segments.data : NULL;
+        if(first && nb_segments == 0 && first->pdt != tail_pdt) {
+            first->pdt_discontinuity = HLS_TRUE;
+        }
+
         res = pt - src;
     }
 
@@ -145,23 +193,23 @@ int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest
     if(tag_media && tag_media->data)
     {
         // create a new segment
-        segment_t *segment = hls_malloc(sizeof(segment_t));
-        hlsparse_segment_init(segment);
+        segment_t *segment = media_playlist_alloc_segment(dest);
 
         // add the new segment to the playlist
-        segment_list_t *next = &dest->segments;
+        segment_list_t *next = dest->segments_tail ? dest->segments_tail : &dest->segments;
         while(next) {
             if(!next->data) {
                 next->data = segment;
                 break;
             } else if(!next->next) {
-                next->next = hls_malloc(sizeof(segment_list_t));
-                hlsparse_segment_list_init(next->next);
+                next->next = media_playlist_alloc_segment_node(dest);
                 next->next->data = segment;
+                next = next->next;
                 break;
             }
             next = next->next;
         };
+        dest->segments_tail = next;
 
         dest->last_segment = segment;
         ++(dest->nb_segments);
@@ -183,5 +231,17 @@ int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest
         dest->next_segment_discontinuity = HLS_FALSE;
     }
 
+    if(dest->window_size > 0 || dest->window_duration > 0) {
+        hlsparse_media_playlist_expire(dest);
+    }
+
+    if(dest->segment_hashes) {
+        hlsparse_media_playlist_hash_segments(dest);
+    }
+
+    if(start) {
+        metrics_parse(HLS_FALSE, res, start);
+    }
+    HLS_PROBE2(parse_media_done, res, dest->nb_segments);
     return res;
 }
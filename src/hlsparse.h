@@ -23,6 +23,7 @@
 #define KEY_METHOD_AES128           2
 #define KEY_METHOD_SAMPLEAES        3
 #define KEY_METHOD_INVALID          4
+#define KEY_METHOD_SAMPLEAESCTR     5
 
 #define MEDIA_TYPE_NONE             0
 #define MEDIA_TYPE_VIDEO            1
@@ -52,6 +53,120 @@
 #define HDCP_LEVEL_NONE             1
 #define HDCP_LEVEL_TYPE0            2
 
+// media_playlist_diff_t change flags
+#define PLAYLIST_DIFF_VERSION               (1 << 0)
+#define PLAYLIST_DIFF_TARGET_DURATION       (1 << 1)
+#define PLAYLIST_DIFF_PLAYLIST_TYPE         (1 << 2)
+#define PLAYLIST_DIFF_END_LIST              (1 << 3)
+#define PLAYLIST_DIFF_MEDIA_SEQUENCE        (1 << 4)
+#define PLAYLIST_DIFF_DISCONTINUITY_SEQ     (1 << 5)
+#define PLAYLIST_DIFF_IFRAMES_ONLY          (1 << 6)
+#define PLAYLIST_DIFF_INDEPENDENT_SEGMENTS  (1 << 7)
+#define PLAYLIST_DIFF_START                 (1 << 8)
+#define PLAYLIST_DIFF_SEGMENTS              (1 << 9)
+#define PLAYLIST_DIFF_KEYS                  (1 << 10)
+#define PLAYLIST_DIFF_MAPS                  (1 << 11)
+#define PLAYLIST_DIFF_DATERANGES            (1 << 12)
+
+// attributes decoded on demand from lazily parsed tags
+#define STREAM_INF_ATTR_PROGRAM_ID          (1 << 0)
+#define STREAM_INF_ATTR_BANDWIDTH           (1 << 1)
+#define STREAM_INF_ATTR_AVG_BANDWIDTH       (1 << 2)
+#define STREAM_INF_ATTR_CODECS              (1 << 3)
+#define STREAM_INF_ATTR_RESOLUTION          (1 << 4)
+#define STREAM_INF_ATTR_AUDIO               (1 << 5)
+#define STREAM_INF_ATTR_VIDEO               (1 << 6)
+#define STREAM_INF_ATTR_SUBTITLES           (1 << 7)
+#define STREAM_INF_ATTR_CLOSED_CAPTIONS     (1 << 8)
+#define STREAM_INF_ATTR_FRAME_RATE          (1 << 9)
+#define STREAM_INF_ATTR_HDCP_LEVEL          (1 << 10)
+#define STREAM_INF_ATTR_ALL                 ((1 << 11) - 1)
+
+#define MEDIA_ATTR_TYPE                     (1 << 0)
+#define MEDIA_ATTR_GROUP_ID                 (1 << 1)
+#define MEDIA_ATTR_NAME                     (1 << 2)
+#define MEDIA_ATTR_AUTOSELECT               (1 << 3)
+#define MEDIA_ATTR_FORCED                   (1 << 4)
+#define MEDIA_ATTR_DEFAULT                  (1 << 5)
+#define MEDIA_ATTR_LANGUAGE                 (1 << 6)
+#define MEDIA_ATTR_ASSOC_LANGUAGE           (1 << 7)
+#define MEDIA_ATTR_URI                      (1 << 8)
+#define MEDIA_ATTR_INSTREAM_ID              (1 << 9)
+#define MEDIA_ATTR_CHARACTERISTICS          (1 << 10)
+#define MEDIA_ATTR_CHANNELS                 (1 << 11)
+#define MEDIA_ATTR_ALL                      ((1 << 12) - 1)
+
+#define DATERANGE_ATTR_ID                   (1 << 0)
+#define DATERANGE_ATTR_CLASS                (1 << 1)
+#define DATERANGE_ATTR_START_DATE           (1 << 2)
+#define DATERANGE_ATTR_END_DATE             (1 << 3)
+#define DATERANGE_ATTR_DURATION             (1 << 4)
+#define DATERANGE_ATTR_PLANNED_DURATION     (1 << 5)
+#define DATERANGE_ATTR_SCTE35_CMD           (1 << 6)
+#define DATERANGE_ATTR_SCTE35_OUT           (1 << 7)
+#define DATERANGE_ATTR_SCTE35_IN            (1 << 8)
+#define DATERANGE_ATTR_END_ON_NEXT          (1 << 9)
+#define DATERANGE_ATTR_CLIENT               (1 << 10)  // the X- client attributes
+#define DATERANGE_ATTR_ALL                  ((1 << 11) - 1)
+
+// data a playlist can be told to step over while parsing, see skip_fields
+#define PARSE_FIELD_TITLES                  (1 << 0)   // EXTINF titles
+#define PARSE_FIELD_CUSTOM_TAGS             (1 << 1)
+#define PARSE_FIELD_DATERANGES              (1 << 2)
+#define PARSE_FIELD_SCTE35                  (1 << 3)   // the SCTE35 attributes of parsed dateranges
+#define PARSE_FIELD_KEYS                    (1 << 4)
+#define PARSE_FIELD_MAPS                    (1 << 5)
+#define PARSE_FIELD_SESSION_DATA            (1 << 6)
+#define PARSE_FIELD_SESSION_KEYS            (1 << 7)
+#define PARSE_FIELD_MEDIA                   (1 << 8)   // EXT-X-MEDIA renditions
+#define PARSE_FIELD_IFRAME_STREAM_INFS      (1 << 9)
+#define PARSE_FIELD_RESOLVED_URIS           (1 << 10)  // URIs are kept as written instead of combined with the playlist uri
+
+// conformance rules checked by hlsparse_validate
+#define VIOLATION_EXTM3U                    (1 << 0)   // the playlist doesn't start with EXTM3U
+#define VIOLATION_MIXED_TAGS                (1 << 1)   // master and media playlist tags in one playlist
+#define VIOLATION_TARGET_DURATION           (1 << 2)   // media playlist without EXT-X-TARGETDURATION
+#define VIOLATION_EXTINF_DURATION           (1 << 3)   // segment longer than the target duration
+#define VIOLATION_URI                       (1 << 4)   // EXTINF or EXT-X-STREAM-INF without a uri, or a uri without either
+#define VIOLATION_MEDIA_SEQUENCE            (1 << 5)   // EXT-X-MEDIA-SEQUENCE repeated or after the first segment
+#define VIOLATION_PDT_ORDER                 (1 << 6)   // program date time going backwards without a discontinuity
+#define VIOLATION_BYTE_RANGE                (1 << 7)   // byte range without an offset not following a sub-range of the same uri
+#define VIOLATION_KEY                       (1 << 8)   // key method, uri or IV inconsistent
+#define VIOLATION_MAP                       (1 << 9)   // map without a uri
+#define VIOLATION_DATERANGE                 (1 << 10)  // daterange attributes breaking the EXT-X-DATERANGE rules
+#define VIOLATION_DATERANGE_PDT             (1 << 11)  // dateranges in a playlist without a program date time
+#define VIOLATION_STREAM_INF                (1 << 12)  // variant stream without a bandwidth or uri
+#define VIOLATION_MEDIA                     (1 << 13)  // rendition without a type, group id or name
+#define VIOLATION_GROUP                     (1 << 14)  // variant stream referencing a rendition group which doesn't exist
+#define VIOLATION_COUNT                     15
+
+// tags counted by hlsparse_metrics
+#define METRICS_TAG_EXTM3U                  0
+#define METRICS_TAG_EXTXVERSION             1
+#define METRICS_TAG_EXTINF                  2
+#define METRICS_TAG_EXTXBYTERANGE           3
+#define METRICS_TAG_EXTXDISCONTINUITY       4
+#define METRICS_TAG_EXTXKEY                 5
+#define METRICS_TAG_EXTXMAP                 6
+#define METRICS_TAG_EXTXDATERANGE           7
+#define METRICS_TAG_EXTXPROGRAMDATETIME     8
+#define METRICS_TAG_EXTXTARGETDURATION      9
+#define METRICS_TAG_EXTXMEDIASEQUENCE       10
+#define METRICS_TAG_EXTXDISCONTINUITYSEQ    11
+#define METRICS_TAG_EXTXENDLIST             12
+#define METRICS_TAG_EXTXPLAYLISTTYPE        13
+#define METRICS_TAG_EXTXIFRAMESONLY         14
+#define METRICS_TAG_EXTXALLOWCACHE          15
+#define METRICS_TAG_EXTXINDEPENDENTSEGMENTS 16
+#define METRICS_TAG_EXTXSTART               17
+#define METRICS_TAG_EXTXMEDIA               18
+#define METRICS_TAG_EXTXSTREAMINF           19
+#define METRICS_TAG_EXTXIFRAMESTREAMINF     20
+#define METRICS_TAG_EXTXSESSIONDATA         21
+#define METRICS_TAG_EXTXSESSIONKEY          22
+#define METRICS_TAG_CUSTOM                  23
+#define METRICS_TAG_COUNT                   24
+
 // HLS tags
 #define EXTM3U                      "EXTM3U"
 #define EXTXVERSION                 "EXT-X-VERSION"
@@ -135,6 +250,7 @@
 #define NONE                        "NONE"
 #define AES128                      "AES-128"
 #define SAMPLEAES                   "SAMPLE-AES"
+#define SAMPLEAESCTR                "SAMPLE-AES-CTR"
 
 #ifdef __cplusplus
 extern "C" {
@@ -193,6 +309,7 @@ typedef struct {
     int method;
     char *uri;
     char *iv;
+    size_t iv_size;         // bytes in iv, 0 for a 128 bit IV set by the caller
     char *key_format;
     char *key_format_versions;
 } hls_key_t;
@@ -222,6 +339,8 @@ typedef struct {
     char *subtitles;
     char *closed_captions;
     resolution_t resolution;
+    char *attributes;   // attribute list not yet decoded, see hlsparse_stream_inf_decode
+    int decoded;        // STREAM_INF_ATTR_* flags of the attributes decoded from 'attributes'
 } stream_inf_t;
 
 typedef struct {
@@ -245,6 +364,8 @@ typedef struct {
     size_t scte35_out_size;
     size_t scte35_in_size;
     bool_t end_on_next;
+    char *attributes;   // attribute list not yet decoded, see hlsparse_daterange_decode
+    int decoded;        // DATERANGE_ATTR_* flags of the attributes decoded from 'attributes'
 } daterange_t;
 
 typedef struct {
@@ -261,6 +382,8 @@ typedef struct {
     char *uri;
     char *characteristics;
     char *channels;
+    char *attributes;   // attribute list not yet decoded, see hlsparse_media_decode
+    int decoded;        // MEDIA_ATTR_* flags of the attributes decoded from 'attributes'
 } media_t;
 
 typedef struct {
@@ -277,6 +400,7 @@ typedef struct {
     timestamp_t pdt_end;
     byte_range_t byte_range;
     string_list_t custom_tags;  // tags associated to this segment the parser didn't recognize
+    uint64_t hash;              // fingerprint of the segment, see media_playlist_t.segment_hashes
 } segment_t;
 
 typedef struct {
@@ -373,6 +497,8 @@ typedef struct {
     string_list_t               custom_tags;
     key_list_t                  session_keys;
     int                         nb_session_keys;
+    bool_t                      lazy_attributes;    // set before parsing to decode stream inf and media attributes on demand
+    int                         skip_fields;        // set before parsing to PARSE_FIELD_* flags of the data which isn't needed
 } master_t;
 
 /**
@@ -408,8 +534,245 @@ typedef struct {
     daterange_list_t            dateranges;
     string_list_t               custom_tags;
     segment_t                   *last_segment;                  
+    segment_list_t              *segments_tail;     // last list nodes, kept for constant time appends
+    key_list_t                  *keys_tail;
+    map_list_t                  *maps_tail;
+    daterange_list_t            *dateranges_tail;
+    int                         window_size;        // set to keep at most this many segments, 0 for no limit
+    float                       window_duration;    // set to keep at most this many seconds of segments, 0 for no limit
+    segment_list_t              *free_segments;     // expired segment records kept for reuse
+    segment_list_t              *free_segment_nodes;
+    bool_t                      segment_hashes;     // set before parsing to fingerprint the segments
+    uint64_t                    merkle_root;        // hash over the segment fingerprints
+    uint64_t                    *merkle_tree;       // hash tree nodes, level by level from the leaves
+    int                         nb_merkle_leaves;
+    bool_t                      lazy_attributes;    // set before parsing to decode daterange attributes on demand
+    int                         skip_fields;        // set before parsing to PARSE_FIELD_* flags of the data which isn't needed
+    int                         tail_segments;      // set before parsing to only build the last this many segments, 0 for all
 } media_playlist_t;
 
+/**
+ * Parsed playlist held by a parse_cache_t.
+ */
+typedef struct parse_cache_entry {
+    int                         kind;
+    int                         refs;           // number of outstanding borrows
+    bool_t                      orphan;         // replaced or evicted while borrowed
+    char                        *uri;
+    uint64_t                    uri_hash;
+    uint64_t                    hash;           // hash of the source text
+    size_t                      size;           // length of the source text
+    size_t                      footprint;      // estimated bytes held by the entry
+    struct parse_cache_entry    *prev;          // LRU order, most recent first
+    struct parse_cache_entry    *next;
+    struct parse_cache_entry    *bucket_next;
+    union {
+        media_playlist_t        media;
+        master_t                master;
+    } playlist;
+} parse_cache_entry_t;
+
+/**
+ * Cache of parsed playlists keyed by URI and a hash of the playlist text.
+ * A cache is not thread safe, share it between threads with external locking.
+ */
+typedef struct {
+    int                         max_entries;
+    size_t                      max_bytes;      // 0 for no memory bound
+    int                         nb_entries;
+    size_t                      bytes;          // estimated bytes held by the entries
+    uint64_t                    hits;
+    uint64_t                    misses;
+    uint64_t                    evictions;
+    int                         nb_buckets;
+    parse_cache_entry_t         **buckets;
+    parse_cache_entry_t         *head;          // most recently used
+    parse_cache_entry_t         *tail;          // least recently used
+    parse_cache_entry_t         *orphans;       // removed entries still borrowed
+} parse_cache_t;
+
+/**
+ * The numbers describing a playlist, read by hlsparse_media_playlist_summary
+ * without building the playlist.
+ */
+typedef struct {
+    bool_t                      m3u;
+    bool_t                      master;             // the source lists variant streams rather than segments
+    int                         version;
+    float                       target_duration;
+    int                         media_sequence;
+    int                         discontinuity_sequence;
+    int                         playlist_type;      // PLAYLIST_TYPE_*
+    bool_t                      end_list;
+    int                         nb_segments;
+    int                         nb_stream_infs;
+    float                       duration;           // sum of the segment durations
+    timestamp_t                 last_pdt;           // program date time of the last segment, 0 without EXT-X-PROGRAM-DATE-TIME
+} playlist_summary_t;
+
+/**
+ * The key a segment read by a segment_reader_t is encrypted with.
+ * The strings point into the playlist source and aren't NUL terminated.
+ */
+typedef struct {
+    int                         method;             // KEY_METHOD_*, KEY_METHOD_UNDEFINED without a key
+    const char                  *uri;
+    size_t                      uri_size;
+    const char                  *iv;                // as written, e.g. "0x..."
+    size_t                      iv_size;
+    int                         index;              // the key_index hlsparse_media_playlist would give the segment
+} key_view_t;
+
+/**
+ * The media initialization section of a segment read by a segment_reader_t.
+ */
+typedef struct {
+    const char                  *uri;
+    size_t                      uri_size;
+    byte_range_t                byte_range;
+    int                         index;              // the map_index hlsparse_media_playlist would give the segment
+} map_view_t;
+
+/**
+ * A segment read by hlsparse_segment_reader_next. The strings point into the
+ * playlist source and aren't NUL terminated, uris are as written.
+ */
+typedef struct {
+    int                         sequence_num;
+    float                       duration;
+    const char                  *title;
+    size_t                      title_size;
+    const char                  *uri;
+    size_t                      uri_size;
+    bool_t                      discontinuity;
+    bool_t                      pdt_discontinuity;
+    timestamp_t                 pdt;
+    timestamp_t                 pdt_end;
+    byte_range_t                byte_range;
+    key_view_t                  key;
+    map_view_t                  map;
+} segment_view_t;
+
+/**
+ * Reads the segments of a media playlist one at a time without building the
+ * playlist. The playlist tags are kept as they're read.
+ */
+typedef struct {
+    const char                  *src;
+    const char                  *pt;                // where the next segment is read from
+    const char                  *end;
+    int                         version;
+    float                       target_duration;
+    int                         media_sequence;
+    int                         discontinuity_sequence;
+    bool_t                      end_list;
+    int                         nb_segments;
+    timestamp_t                 next_segment_pdt;
+    timestamp_t                 last_segment_pdt_end;
+    key_view_t                  key;
+    map_view_t                  map;
+} segment_reader_t;
+
+/**
+ * A broken conformance rule, found by hlsparse_validate.
+ */
+typedef struct {
+    int                         rule;               // VIOLATION_*
+    size_t                      offset;             // byte offset of the line breaking the rule
+} violation_t;
+
+typedef void (*hlsparse_violation_callback)(const violation_t *violation, void *user);
+
+/**
+ * The options and result of validating a playlist with hlsparse_validate.
+ */
+typedef struct {
+    hlsparse_violation_callback callback;           // set before validating, called for every violation
+    void                        *user;              // passed to the callback
+    int                         nb_threads;         // set before validating to split large media playlists over threads
+    bool_t                      master;
+    int                         nb_violations;
+    int                         violations;         // VIOLATION_* flags of every rule broken
+} playlist_validation_t;
+
+/**
+ * Structural differences between two versions of a media playlist.
+ * Segments are aligned on their media sequence number, counted from the
+ * media_sequence of each playlist.
+ * The segment list pointers reference the compared playlists and are only
+ * valid as long as those playlists are.
+ */
+typedef struct {
+    int                         changes;            // PLAYLIST_DIFF_* flags
+    int                         nb_expired;         // segments removed from the head of the old playlist
+    int                         nb_prepended;       // segments before the head of the old playlist (stale playlist)
+    int                         nb_appended;        // segments added to the tail of the new playlist
+    int                         nb_truncated;       // segments at the tail of the old playlist missing from the new one
+    int                         nb_changed;         // segments in both playlists which differ
+    int                         nb_unchanged;       // segments in both playlists which are identical
+    int                         *changed;           // absolute sequence numbers of the changed segments
+    segment_list_t              *appended;          // first appended segment of the new playlist
+    int                         nb_keys_added;
+    int                         nb_keys_removed;
+    int                         nb_maps_added;
+    int                         nb_maps_removed;
+    int                         nb_dateranges_added;
+    int                         nb_dateranges_removed;
+} media_playlist_diff_t;
+
+#define HLSPARSE_ALLOC_SITES    (64)
+
+/**
+ * Allocations made from a single function of the library.
+ * 'site' is the name of the function, sites past HLSPARSE_ALLOC_SITES are
+ * combined into a final entry named "other".
+ */
+typedef struct {
+    const char                  *site;
+    uint64_t                    nb_allocs;
+    uint64_t                    nb_frees;
+    uint64_t                    bytes;          // total bytes allocated
+    size_t                      live_bytes;     // bytes allocated and not yet freed
+} hlsparse_alloc_site_t;
+
+/**
+ * Allocation statistics collected while hlsparse_alloc_stats_enable is on.
+ * Counters cover the allocations made since statistics were enabled or last
+ * reset, live counts cover every allocation made while enabled.
+ */
+typedef struct {
+    uint64_t                    nb_allocs;
+    uint64_t                    nb_frees;
+    uint64_t                    bytes;
+    size_t                      live_bytes;
+    size_t                      peak_live_bytes;
+    uint64_t                    nb_live;
+    int                         nb_sites;
+    hlsparse_alloc_site_t       sites[HLSPARSE_ALLOC_SITES];
+} hlsparse_alloc_stats_t;
+
+#define HLSPARSE_METRICS_BUCKETS    (32)
+
+/**
+ * Counters collected while hlsparse_metrics_enable is on.
+ * Counters only increase, export them as monotonic counters or subtract two
+ * snapshots to get the activity of an interval.
+ * Latencies are in log2 buckets of nanoseconds, bucket n counts calls taking
+ * less than 2^n ns and at least 2^(n-1) ns, the last bucket counts every
+ * call taking longer.
+ */
+typedef struct {
+    uint64_t                    nb_master_parsed;
+    uint64_t                    nb_media_parsed;
+    uint64_t                    bytes_parsed;
+    uint64_t                    nb_master_written;
+    uint64_t                    nb_media_written;
+    uint64_t                    bytes_written;
+    uint64_t                    tags[METRICS_TAG_COUNT];    // indexed by METRICS_TAG_*
+    uint64_t                    parse_latency[HLSPARSE_METRICS_BUCKETS];
+    uint64_t                    write_latency[HLSPARSE_METRICS_BUCKETS];
+} hlsparse_metrics_t;
+
 ///////////////////////////////////////
 /// Parsing and Writing Functions
 ///////////////////////////////////////
@@ -475,6 +838,8 @@ HLSCode hlsparse_media_playlist_term(media_playlist_t *dest);
 
 /**
  * parses an HLS string of data into a media_playlist_t struct
+ * Tags named by the skip_fields of \a dest are stepped over without being
+ * allocated or decoded.
  *
  * @param src The raw string of data that represents an HLS master playlist
  * @param size The length of src
@@ -485,6 +850,12 @@ int hlsparse_master(const char *src, size_t size, master_t *dest);
 
 /**
  * parses an HLS string of data into a media_playlist_t struct
+ * Tags named by the skip_fields of \a dest are stepped over without being
+ * allocated or decoded. Skipped keys, maps and dateranges aren't counted so
+ * the indexes held by segments stay consistent with what was kept.
+ * With tail_segments set only the last segments are built, the ones before
+ * them are stepped over and leave \a dest as if they had been parsed and then
+ * removed by hlsparse_media_playlist_expire.
  *
  * @param src The raw string of data that represents an HLS media playlist
  * @param size The length of src
@@ -493,6 +864,19 @@ int hlsparse_master(const char *src, size_t size, master_t *dest);
  */
 int hlsparse_media_playlist(const char *src, size_t size, media_playlist_t *dest);
 
+/**
+ * Reads the header values, segment count, duration and last program date time
+ * of a playlist in a single pass over src without allocating anything or
+ * building any segments. Master playlists are detected and their variant
+ * streams counted.
+ *
+ * @param src The raw string of data that represents an HLS playlist
+ * @param size The length of src
+ * @param dest The summary to fill
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_summary(const char *src, size_t size, playlist_summary_t *dest);
+
 /**
  * writes an HLS master playlist from a master_t structure.
  * 
@@ -513,6 +897,449 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master);
  */
 HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist);
 
+/**
+ * Frees a string written by hlswrite_master or hlswrite_media with the memory
+ * callbacks the library was initialized with.
+ *
+ * @param ptr The string to free, NULL is ignored.
+ */
+void hlsparse_free(void *ptr);
+
+///////////////////////////////////////
+/// Playlist Editing Functions
+///////////////////////////////////////
+
+/**
+ * Appends the segments, keys, maps and dateranges of \a src to \a dest.
+ * The lists of src are spliced onto dest without copying them, the segments
+ * of src are given the next sequence numbers of dest and their key, map and
+ * daterange indexes are moved past the ones of dest. The first appended
+ * segment is marked as a discontinuity, and unencrypted segments following
+ * an encrypted dest get a METHOD=NONE key.
+ * Ownership of everything held by src is taken over by dest and src is
+ * terminated, it must be initialized again before it is reused.
+ *
+ * @param dest The playlist to append to.
+ * @param src The playlist to append, terminated on success.
+ * @returns HLS_OK on success, on failure both playlists are left untouched.
+ */
+HLSCode hlsparse_media_playlist_append(media_playlist_t *dest, media_playlist_t *src);
+
+/**
+ * Removes the oldest segments of a live playlist until it fits within its
+ * window_size and window_duration, always keeping the latest segment.
+ * The media_sequence and discontinuity_sequence are moved forward with every
+ * removed segment, keys, maps and dateranges no longer used by any segment
+ * are freed, and the removed segment records are reused by later parses.
+ * This is done by the parser and by hlsparse_media_playlist_append when a
+ * window is set on the playlist.
+ *
+ * @param playlist The media playlist to trim.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_expire(media_playlist_t *playlist);
+
+///////////////////////////////////////
+/// Segment Hash Functions
+///////////////////////////////////////
+
+/**
+ * Computes the fingerprint of every segment and the hash tree over them.
+ * A fingerprint covers the uri, duration, byte range, discontinuity and key
+ * of a segment. Each parent node hashes its two children, a node without a
+ * sibling is carried up unchanged, and the last node is the merkle_root.
+ * This is done by the parser when segment_hashes is set on the playlist, and
+ * must be called again after the segments have been changed.
+ *
+ * @param playlist The media playlist to hash.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_hash_segments(media_playlist_t *playlist);
+
+/**
+ * Gets a node of the segment hash tree. Level 0 holds the segment fingerprints,
+ * the root is index 0 of the highest level. This allows remote copies of a
+ * playlist to be compared one level at a time.
+ *
+ * @param playlist The hashed media playlist.
+ * @param level The level of the node.
+ * @param index The index of the node within the level.
+ * @param hash Assigned the hash of the node.
+ * @returns HLS_OK on success, HLS_ERROR if the node doesn't exist.
+ */
+HLSCode hlsparse_media_playlist_merkle_node(const media_playlist_t *playlist, int level, int index, uint64_t *hash);
+
+/**
+ * Finds the first media sequence number at which two hashed playlists differ,
+ * descending the hash trees in O(log n).
+ *
+ * @param a The first hashed media playlist.
+ * @param b The second hashed media playlist.
+ * @param sequence Assigned the first differing media sequence number, or -1
+ * when the playlists hold the same segments.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_first_divergence(const media_playlist_t *a, const media_playlist_t *b, int *sequence);
+
+///////////////////////////////////////
+/// Parse Cache Functions
+///////////////////////////////////////
+
+/**
+ * Initializes a parse_cache_t object.
+ * The least recently used entries are evicted once the cache holds more than
+ * max_entries playlists or more than max_bytes of parsed data.
+ *
+ * @param cache The cache to initialize.
+ * @param max_entries The maximum number of cached playlists.
+ * @param max_bytes The maximum estimated memory held by the cache, 0 for no limit.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_init(parse_cache_t *cache, int max_entries, size_t max_bytes);
+
+/**
+ * Cleans up a parse_cache_t object freeing every cached playlist, including
+ * the ones which haven't been released.
+ *
+ * @param cache The cache to destroy.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_term(parse_cache_t *cache);
+
+/**
+ * Returns the parsed media playlist for \a src, only parsing the text when it
+ * differs from the last version seen for \a uri.
+ * The uri is also used as the base for resolving relative paths.
+ * The returned playlist is shared and must not be modified, it stays valid until
+ * released with hlsparse_cache_media_playlist_release.
+ *
+ * @param cache The cache to use.
+ * @param uri The uri of the playlist.
+ * @param src The raw playlist text.
+ * @param size The length of src.
+ * @param dest Assigned the cached playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_media_playlist(parse_cache_t *cache, const char *uri, const char *src, size_t size, media_playlist_t **dest);
+
+/**
+ * Returns the parsed master playlist for \a src, only parsing the text when it
+ * differs from the last version seen for \a uri.
+ * The returned master is shared and must not be modified, it stays valid until
+ * released with hlsparse_cache_master_release.
+ *
+ * @param cache The cache to use.
+ * @param uri The uri of the playlist.
+ * @param src The raw playlist text.
+ * @param size The length of src.
+ * @param dest Assigned the cached master playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_master(parse_cache_t *cache, const char *uri, const char *src, size_t size, master_t **dest);
+
+/**
+ * Releases a playlist returned by hlsparse_cache_media_playlist.
+ *
+ * @param cache The cache the playlist was returned from.
+ * @param playlist The playlist to release.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_media_playlist_release(parse_cache_t *cache, media_playlist_t *playlist);
+
+/**
+ * Releases a master playlist returned by hlsparse_cache_master.
+ *
+ * @param cache The cache the master playlist was returned from.
+ * @param master The master playlist to release.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_cache_master_release(parse_cache_t *cache, master_t *master);
+
+///////////////////////////////////////
+/// Playlist Diff Functions
+///////////////////////////////////////
+
+/**
+ * Initializes a media_playlist_diff_t object.
+ *
+ * @param diff The diff to initialize.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_diff_init(media_playlist_diff_t *diff);
+
+/**
+ * Cleans up a media_playlist_diff_t object.
+ *
+ * @param diff The diff to clean up.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_diff_term(media_playlist_diff_t *diff);
+
+/**
+ * Compares two versions of a media playlist.
+ * Segments are matched by sequence number in a single pass over both playlists
+ * and compared by uri, duration, title, byte range, discontinuity and the
+ * content of their key and map. Program date times aren't compared as they
+ * are derived from the segment durations when the playlist has none. Keys, maps and dateranges are
+ * compared by content, regardless of their position in the playlist.
+ * Any previous result held by \a diff is replaced.
+ *
+ * @param old_playlist The previous version of the playlist.
+ * @param new_playlist The current version of the playlist.
+ * @param diff The initialized diff to write the result to.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_diff(const media_playlist_t *old_playlist, const media_playlist_t *new_playlist, media_playlist_diff_t *diff);
+
+///////////////////////////////////////
+/// Validation Functions
+///////////////////////////////////////
+
+/**
+ * Initializes a playlist_validation_t object.
+ *
+ * @param validation The validation to initialize.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_validation_init(playlist_validation_t *validation);
+
+/**
+ * Checks a master or media playlist against the VIOLATION_* conformance rules
+ * in a single pass over src, without building the playlist or allocating
+ * anything. Every violation is passed to the callback of \a validation with
+ * the byte offset of the line breaking the rule.
+ * With nb_threads set, media playlists of a few hundred KB or more are split
+ * between that many threads. The callback is then called from those threads,
+ * one at a time but not in the order of the offsets.
+ * Any previous result held by \a validation is replaced.
+ *
+ * @param src The raw string of data that represents an HLS playlist
+ * @param size The length of src
+ * @param validation The initialized validation holding the options and result.
+ * @returns HLS_OK when the playlist was validated, whether or not it broke any rules.
+ */
+HLSCode hlsparse_validate(const char *src, size_t size, playlist_validation_t *validation);
+
+/**
+ * @param rule One of the VIOLATION_* flags.
+ * @returns The name of the rule, or NULL if rule isn't one.
+ */
+const char *hlsparse_violation_name(int rule);
+
+///////////////////////////////////////
+/// Segment Reader Functions
+///////////////////////////////////////
+
+/**
+ * Initializes a segment_reader_t to read the segments of src.
+ * src isn't copied and has to outlive the reader and the segments it reads.
+ *
+ * @param reader The reader to initialize.
+ * @param src The raw string of data that represents an HLS media playlist
+ * @param size The length of src
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_segment_reader_init(segment_reader_t *reader, const char *src, size_t size);
+
+/**
+ * Reads the next segment of a media playlist, only reading as far into the
+ * source as the segment's uri. The values match the segment_t
+ * hlsparse_media_playlist would build, except for its custom tags and the
+ * segment it adds for custom tags after the last segment, which aren't read.
+ * Nothing is allocated.
+ *
+ * @param reader The initialized reader.
+ * @param dest The segment to fill.
+ * @returns The number of bytes read, 0 once there are no more segments.
+ */
+int hlsparse_segment_reader_next(segment_reader_t *reader, segment_view_t *dest);
+
+///////////////////////////////////////
+/// Binary Snapshot Functions
+///////////////////////////////////////
+
+/**
+ * Saves a parsed media playlist as a relocatable binary snapshot.
+ * The snapshot holds the segment records contiguously followed by a single string
+ * table, and can be loaded again without re-parsing the playlist text.
+ * Snapshots are only portable between builds with the same structure layout.
+ *
+ * @param path The file to write the snapshot to.
+ * @param playlist The media playlist to save.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_save_binary(const char *path, const media_playlist_t *playlist);
+
+/**
+ * Loads a media playlist snapshot written by hlsparse_media_playlist_save_binary.
+ * The file is mapped into memory and used in place, no objects are allocated.
+ * The loaded playlist must be treated as read-only and released with
+ * hlsparse_media_playlist_unload_binary, never with hlsparse_media_playlist_term.
+ *
+ * @param path The snapshot file to load.
+ * @param dest Assigned the address of the loaded playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_load_binary(const char *path, media_playlist_t **dest);
+
+/**
+ * Releases a media playlist loaded with hlsparse_media_playlist_load_binary.
+ *
+ * @param playlist The loaded playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_unload_binary(media_playlist_t *playlist);
+
+/**
+ * Saves a parsed master playlist as a relocatable binary snapshot.
+ *
+ * @param path The file to write the snapshot to.
+ * @param master The master playlist to save.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_master_save_binary(const char *path, const master_t *master);
+
+/**
+ * Loads a master playlist snapshot written by hlsparse_master_save_binary.
+ * The loaded master must be treated as read-only and released with
+ * hlsparse_master_unload_binary, never with hlsparse_master_term.
+ *
+ * @param path The snapshot file to load.
+ * @param dest Assigned the address of the loaded master playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_master_load_binary(const char *path, master_t **dest);
+
+/**
+ * Releases a master playlist loaded with hlsparse_master_load_binary.
+ *
+ * @param master The loaded master playlist.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_master_unload_binary(master_t *master);
+
+///////////////////////////////////////
+/// Lazy Attribute Functions
+///////////////////////////////////////
+
+/**
+ * Decodes attributes of a stream inf parsed with lazy_attributes set on its
+ * master playlist. Lazy parsing keeps the raw attribute list of each
+ * EXT-X-STREAM-INF and leaves its fields zeroed, apart from the uri, until
+ * they're decoded. Each attribute is only decoded once, asking for decoded
+ * attributes again costs nothing, and the attribute list is freed once every
+ * attribute has been decoded.
+ * Stream infs which weren't parsed lazily are always fully decoded, and so is
+ * everything in a binary snapshot since undecoded attributes are decoded when
+ * the snapshot is saved.
+ *
+ * @param stream_inf The stream inf to decode.
+ * @param fields STREAM_INF_ATTR_* flags of the attributes to decode.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_stream_inf_decode(stream_inf_t *stream_inf, int fields);
+
+/**
+ * Decodes attributes of an EXT-X-MEDIA tag parsed with lazy_attributes set on
+ * its master playlist, see hlsparse_stream_inf_decode.
+ *
+ * @param media The media to decode.
+ * @param fields MEDIA_ATTR_* flags of the attributes to decode.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_decode(media_t *media, int fields);
+
+/**
+ * Decodes attributes of an EXT-X-DATERANGE tag parsed with lazy_attributes set
+ * on its media playlist, see hlsparse_stream_inf_decode.
+ *
+ * @param daterange The daterange to decode.
+ * @param fields DATERANGE_ATTR_* flags of the attributes to decode.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_daterange_decode(daterange_t *daterange, int fields);
+
+/**
+ * Decodes every attribute left undecoded in a master playlist.
+ * This is done by hlswrite_master.
+ *
+ * @param master The master playlist to decode.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_master_decode(master_t *master);
+
+/**
+ * Decodes every attribute left undecoded in a media playlist.
+ * This is done by hlswrite_media, hlsparse_media_playlist_diff decodes copies
+ * of the dateranges it compares and leaves the playlists as they are.
+ *
+ * @param playlist The media playlist to decode.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_media_playlist_decode(media_playlist_t *playlist);
+
+///////////////////////////////////////
+/// Allocation Statistics
+///////////////////////////////////////
+
+/**
+ * Starts or stops recording the allocations made by the library.
+ * Recording has a cost on every allocation and is off by default.
+ * Stopping discards the statistics collected so far.
+ * Statistics are global and are not thread safe.
+ *
+ * @param enable HLS_TRUE to start recording, HLS_FALSE to stop.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_alloc_stats_enable(bool_t enable);
+
+/**
+ * Zeroes the allocation and free counters so that the statistics of a single
+ * parse, write or term call can be read. Live allocations are kept and the
+ * peak is reset to the current live bytes.
+ *
+ * @returns HLS_OK on success, HLS_ERROR when recording isn't enabled.
+ */
+HLSCode hlsparse_alloc_stats_reset(void);
+
+/**
+ * Copies the current allocation statistics.
+ *
+ * @param dest The statistics to fill.
+ * @returns HLS_OK on success, HLS_ERROR when recording isn't enabled.
+ */
+HLSCode hlsparse_alloc_stats(hlsparse_alloc_stats_t *dest);
+
+///////////////////////////////////////
+/// Metrics
+///////////////////////////////////////
+
+/**
+ * Starts or stops counting the playlists, bytes and tags parsed and written
+ * along with their latencies. Counting is off by default.
+ * Each thread counts separately without locks, totals are merged when read.
+ *
+ * @param enable HLS_TRUE to start counting, HLS_FALSE to stop.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_metrics_enable(bool_t enable);
+
+/**
+ * Sums the counters of every thread, including threads which have exited.
+ * May be called from any thread while others are parsing.
+ *
+ * @param dest The metrics to fill.
+ * @returns HLS_OK on success.
+ */
+HLSCode hlsparse_metrics(hlsparse_metrics_t *dest);
+
+/**
+ * @param tag One of the METRICS_TAG_* values.
+ * @returns The name of the tag, "custom" for tags the parser doesn't know,
+ * or NULL when tag is out of range.
+ */
+const char *hlsparse_metrics_tag_name(int tag);
+
 ///////////////////////////////////////////////////////////////
 /// Struct initialization and termination util Functions
 ///////////////////////////////////////////////////////////////
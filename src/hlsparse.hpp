@@ -0,0 +1,389 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+#ifndef _HLSPARSE_HPP
+#define _HLSPARSE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "hlsparse.h"
+
+/*
+ * C++ wrapper
+ *
+ * Header only, C++20. hls::MediaPlaylist and hls::Master own a parsed playlist
+ * and call the _init and _term functions for it, they can be moved but not
+ * copied. Nothing is copied out of the playlists, strings are returned as
+ * std::string_view, byte data as std::span and the linked lists are iterated
+ * in place, all of them valid for as long as the playlist they come from.
+ * hlsparse_global_init must still be called before using them.
+ */
+
+namespace hls {
+
+/**
+ * @returns a view of a string held by a playlist, empty for NULL.
+ */
+inline std::string_view view(const char *str)
+{
+    return str ? std::string_view(str) : std::string_view();
+}
+
+/**
+ * @returns the bytes of a string held by a playlist which may contain zeros,
+ * such as the SCTE-35 commands of a daterange.
+ */
+inline std::span<const uint8_t> bytes(const char *data, size_t size)
+{
+    return data ? std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(data), size) : std::span<const uint8_t>();
+}
+
+namespace detail {
+
+// the item held by a list node, and whether the node holds one at all as the
+// first node of an empty list is embedded in its owner with no data
+
+template<typename Node>
+inline bool valid(Node *node)
+{
+    if constexpr(std::is_same_v<std::remove_const_t<Node>, param_list_t>) {
+        return node && node->key;
+    } else {
+        return node && node->data;
+    }
+}
+
+template<typename Node>
+inline auto &item(Node *node)
+{
+    if constexpr(std::is_const_v<Node>) {
+        return std::as_const(*node->data);
+    } else {
+        return *node->data;
+    }
+}
+
+inline std::string_view item(const string_list_t *node)
+{
+    return view(node->data);
+}
+
+inline const param_list_t &item(const param_list_t *node)
+{
+    return *node;
+}
+
+} // namespace detail
+
+/**
+ * A range over one of the linked lists of a playlist, e.g. segment_list_t,
+ * iterated without copying its items. string_list_t items are string views.
+ */
+template<typename Node>
+class List {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using reference = decltype(detail::item(std::declval<Node *>()));
+        using value_type = std::remove_cvref_t<reference>;
+        using pointer = std::add_pointer_t<reference>;
+
+        iterator() = default;
+        explicit iterator(Node *node) : node_(detail::valid(node) ? node : nullptr) {}
+
+        reference operator*() const { return detail::item(node_); }
+        pointer operator->() const { return &detail::item(node_); }
+
+        iterator &operator++()
+        {
+            node_ = detail::valid(node_->next) ? node_->next : nullptr;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator it = *this;
+            ++(*this);
+            return it;
+        }
+
+        bool operator==(const iterator &other) const = default;
+
+    private:
+        Node *node_ = nullptr;
+    };
+
+    explicit List(Node *head) : head_(head) {}
+
+    iterator begin() const { return iterator(head_); }
+    iterator end() const { return iterator(); }
+    bool empty() const { return begin() == end(); }
+
+    /**
+     * @returns the number of items, counted by walking the list.
+     */
+    size_t size() const { return std::distance(begin(), end()); }
+
+private:
+    Node *head_;
+};
+
+/**
+ * Owner of a media_playlist_t.
+ */
+class MediaPlaylist {
+public:
+    MediaPlaylist() { hlsparse_media_playlist_init(&playlist_); }
+    ~MediaPlaylist() { hlsparse_media_playlist_term(&playlist_); }
+
+    MediaPlaylist(const MediaPlaylist &) = delete;
+    MediaPlaylist &operator=(const MediaPlaylist &) = delete;
+
+    MediaPlaylist(MediaPlaylist &&other) noexcept { take(other); }
+
+    MediaPlaylist &operator=(MediaPlaylist &&other) noexcept
+    {
+        if(this != &other) {
+            hlsparse_media_playlist_term(&playlist_);
+            take(other);
+        }
+        return *this;
+    }
+
+    /**
+     * Parses src into the playlist, the options set on it beforehand apply.
+     *
+     * @returns the number of bytes read.
+     */
+    int parse(std::string_view src) { return hlsparse_media_playlist(src.data(), src.size(), &playlist_); }
+
+    /**
+     * Parses src into a new playlist with default options.
+     */
+    static MediaPlaylist from(std::string_view src)
+    {
+        MediaPlaylist playlist;
+        playlist.parse(src);
+        return playlist;
+    }
+
+    /**
+     * Frees everything parsed so the playlist can be parsed into again. The
+     * options stay as they were set.
+     */
+    void reset()
+    {
+        media_playlist_t options = playlist_;
+        hlsparse_media_playlist_term(&playlist_);
+        hlsparse_media_playlist_init(&playlist_);
+        playlist_.window_size = options.window_size;
+        playlist_.window_duration = options.window_duration;
+        playlist_.segment_hashes = options.segment_hashes;
+        playlist_.lazy_attributes = options.lazy_attributes;
+        playlist_.skip_fields = options.skip_fields;
+        playlist_.tail_segments = options.tail_segments;
+    }
+
+    /**
+     * Writes the playlist into out, reusing the memory it already holds.
+     */
+    HLSCode write(std::string &out)
+    {
+        char *dest = nullptr;
+        int size = 0;
+        HLSCode res = hlswrite_media(&dest, &size, &playlist_);
+        if(res == HLS_OK) {
+            out.assign(dest, size);
+        }
+        hlsparse_free(dest);
+        return res;
+    }
+
+    std::string write()
+    {
+        std::string out;
+        write(out);
+        return out;
+    }
+
+    media_playlist_t *get() { return &playlist_; }
+    const media_playlist_t *get() const { return &playlist_; }
+    media_playlist_t *operator->() { return &playlist_; }
+    const media_playlist_t *operator->() const { return &playlist_; }
+
+    std::string_view uri() const { return view(playlist_.uri); }
+
+    List<segment_list_t> segments() { return List<segment_list_t>(&playlist_.segments); }
+    List<const segment_list_t> segments() const { return List<const segment_list_t>(&playlist_.segments); }
+    List<key_list_t> keys() { return List<key_list_t>(&playlist_.keys); }
+    List<const key_list_t> keys() const { return List<const key_list_t>(&playlist_.keys); }
+    List<map_list_t> maps() { return List<map_list_t>(&playlist_.maps); }
+    List<const map_list_t> maps() const { return List<const map_list_t>(&playlist_.maps); }
+    List<daterange_list_t> dateranges() { return List<daterange_list_t>(&playlist_.dateranges); }
+    List<const daterange_list_t> dateranges() const { return List<const daterange_list_t>(&playlist_.dateranges); }
+    List<const string_list_t> custom_tags() const { return List<const string_list_t>(&playlist_.custom_tags); }
+
+private:
+    // the tails may point at the list nodes embedded in the playlist itself
+    template<typename Node>
+    static Node *rebase(Node *tail, Node *head, Node *other_head)
+    {
+        return tail == other_head ? head : tail;
+    }
+
+    void take(MediaPlaylist &other)
+    {
+        playlist_ = other.playlist_;
+        playlist_.segments_tail = rebase(playlist_.segments_tail, &playlist_.segments, &other.playlist_.segments);
+        playlist_.keys_tail = rebase(playlist_.keys_tail, &playlist_.keys, &other.playlist_.keys);
+        playlist_.maps_tail = rebase(playlist_.maps_tail, &playlist_.maps, &other.playlist_.maps);
+        playlist_.dateranges_tail = rebase(playlist_.dateranges_tail, &playlist_.dateranges, &other.playlist_.dateranges);
+        hlsparse_media_playlist_init(&other.playlist_);
+    }
+
+    media_playlist_t playlist_;
+};
+
+/**
+ * Owner of a master_t.
+ */
+class Master {
+public:
+    Master() { hlsparse_master_init(&master_); }
+    ~Master() { hlsparse_master_term(&master_); }
+
+    Master(const Master &) = delete;
+    Master &operator=(const Master &) = delete;
+
+    Master(Master &&other) noexcept : master_(other.master_) { hlsparse_master_init(&other.master_); }
+
+    Master &operator=(Master &&other) noexcept
+    {
+        if(this != &other) {
+            hlsparse_master_term(&master_);
+            master_ = other.master_;
+            hlsparse_master_init(&other.master_);
+        }
+        return *this;
+    }
+
+    /**
+     * Parses src into the master, the options set on it beforehand apply.
+     *
+     * @returns the number of bytes read.
+     */
+    int parse(std::string_view src) { return hlsparse_master(src.data(), src.size(), &master_); }
+
+    /**
+     * Parses src into a new master with default options.
+     */
+    static Master from(std::string_view src)
+    {
+        Master master;
+        master.parse(src);
+        return master;
+    }
+
+    /**
+     * Frees everything parsed so the master can be parsed into again. The
+     * options stay as they were set.
+     */
+    void reset()
+    {
+        master_t options = master_;
+        hlsparse_master_term(&master_);
+        hlsparse_master_init(&master_);
+        master_.lazy_attributes = options.lazy_attributes;
+        master_.skip_fields = options.skip_fields;
+    }
+
+    /**
+     * Writes the master into out, reusing the memory it already holds.
+     */
+    HLSCode write(std::string &out)
+    {
+        char *dest = nullptr;
+        int size = 0;
+        HLSCode res = hlswrite_master(&dest, &size, &master_);
+        if(res == HLS_OK) {
+            out.assign(dest, size);
+        }
+        hlsparse_free(dest);
+        return res;
+    }
+
+    std::string write()
+    {
+        std::string out;
+        write(out);
+        return out;
+    }
+
+    master_t *get() { return &master_; }
+    const master_t *get() const { return &master_; }
+    master_t *operator->() { return &master_; }
+    const master_t *operator->() const { return &master_; }
+
+    std::string_view uri() const { return view(master_.uri); }
+
+    List<stream_inf_list_t> stream_infs() { return List<stream_inf_list_t>(&master_.stream_infs); }
+    List<const stream_inf_list_t> stream_infs() const { return List<const stream_inf_list_t>(&master_.stream_infs); }
+    List<iframe_stream_inf_list_t> iframe_stream_infs() { return List<iframe_stream_inf_list_t>(&master_.iframe_stream_infs); }
+    List<const iframe_stream_inf_list_t> iframe_stream_infs() const { return List<const iframe_stream_inf_list_t>(&master_.iframe_stream_infs); }
+    List<media_list_t> media() { return List<media_list_t>(&master_.media); }
+    List<const media_list_t> media() const { return List<const media_list_t>(&master_.media); }
+    List<session_data_list_t> session_data() { return List<session_data_list_t>(&master_.session_data); }
+    List<const session_data_list_t> session_data() const { return List<const session_data_list_t>(&master_.session_data); }
+    List<key_list_t> session_keys() { return List<key_list_t>(&master_.session_keys); }
+    List<const key_list_t> session_keys() const { return List<const key_list_t>(&master_.session_keys); }
+    List<const string_list_t> custom_tags() const { return List<const string_list_t>(&master_.custom_tags); }
+
+private:
+    master_t master_;
+};
+
+/**
+ * @returns the custom tags of a segment.
+ */
+inline List<const string_list_t> custom_tags(const segment_t &segment)
+{
+    return List<const string_list_t>(&segment.custom_tags);
+}
+
+/**
+ * @returns the X- attributes of a daterange.
+ */
+inline List<const param_list_t> client_attributes(const daterange_t &daterange)
+{
+    return List<const param_list_t>(&daterange.client_attributes);
+}
+
+inline std::span<const uint8_t> scte35_cmd(const daterange_t &daterange)
+{
+    return bytes(daterange.scte35_cmd, daterange.scte35_cmd_size);
+}
+
+inline std::span<const uint8_t> scte35_out(const daterange_t &daterange)
+{
+    return bytes(daterange.scte35_out, daterange.scte35_out_size);
+}
+
+inline std::span<const uint8_t> scte35_in(const daterange_t &daterange)
+{
+    return bytes(daterange.scte35_in, daterange.scte35_in_size);
+}
+
+} // namespace hls
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+#ifndef _HLSPARSE_GENERATOR_HPP
+#define _HLSPARSE_GENERATOR_HPP
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "hlsparse.h"
+
+/*
+ * Segment generator
+ *
+ * Header only, C++20. hls::segments is a coroutine over the segment reader
+ * which yields the segments of a media playlist one at a time as the source is
+ * read, no segment_t or list is built. The views point into the source, which
+ * has to outlive them.
+ */
+
+namespace hls {
+
+/**
+ * A lazily evaluated sequence of values, resumed each time the next value is
+ * asked for. The yielded values are valid until the generator is advanced.
+ */
+template<typename T>
+class Generator {
+public:
+    struct promise_type {
+        const T *value = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        std::suspend_always yield_value(const T &yielded) noexcept
+        {
+            value = std::addressof(yielded);
+            return {};
+        }
+
+        // values are only produced with co_yield
+        template<typename U>
+        std::suspend_never await_transform(U &&) = delete;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = const T &;
+        using pointer = const T *;
+
+        iterator() = default;
+        explicit iterator(handle_type handle) : handle_(handle) {}
+
+        reference operator*() const { return *handle_.promise().value; }
+        pointer operator->() const { return handle_.promise().value; }
+
+        iterator &operator++()
+        {
+            resume(handle_);
+            return *this;
+        }
+
+        void operator++(int) { ++(*this); }
+
+        bool operator==(std::default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+    private:
+        handle_type handle_;
+    };
+
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+
+    Generator(Generator &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Generator &operator=(Generator &&other) noexcept
+    {
+        if(this != &other) {
+            if(handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Generator()
+    {
+        if(handle_) {
+            handle_.destroy();
+        }
+    }
+
+    /**
+     * Runs the coroutine up to its first value, begin can only be called once.
+     */
+    iterator begin()
+    {
+        if(handle_) {
+            resume(handle_);
+        }
+        return iterator(handle_);
+    }
+
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+    explicit Generator(handle_type handle) : handle_(handle) {}
+
+    static void resume(handle_type handle)
+    {
+        handle.resume();
+        if(handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+
+    handle_type handle_;
+};
+
+/**
+ * A segment yielded by hls::segments, see segment_view_t.
+ */
+struct SegmentView {
+    struct Key {
+        int method;
+        std::string_view uri;
+        std::string_view iv;
+        int index;
+    };
+
+    struct Map {
+        std::string_view uri;
+        byte_range_t byte_range;
+        int index;
+    };
+
+    int sequence_num;
+    float duration;
+    std::string_view title;
+    std::string_view uri;
+    bool discontinuity;
+    bool pdt_discontinuity;
+    timestamp_t pdt;
+    timestamp_t pdt_end;
+    byte_range_t byte_range;
+    Key key;
+    Map map;
+
+    explicit SegmentView(const segment_view_t &view) :
+        sequence_num(view.sequence_num),
+        duration(view.duration),
+        title(view.title, view.title_size),
+        uri(view.uri, view.uri_size),
+        discontinuity(view.discontinuity),
+        pdt_discontinuity(view.pdt_discontinuity),
+        pdt(view.pdt),
+        pdt_end(view.pdt_end),
+        byte_range(view.byte_range),
+        key{ view.key.method, std::string_view(view.key.uri, view.key.uri_size),
+             std::string_view(view.key.iv, view.key.iv_size), view.key.index },
+        map{ std::string_view(view.map.uri, view.map.uri_size), view.map.byte_range, view.map.index }
+    {
+    }
+};
+
+/**
+ * Yields the segments read by \a reader. The reader keeps the playlist tags
+ * read so far, e.g. the media sequence, and where the next segment starts.
+ */
+inline Generator<SegmentView> segments(segment_reader_t &reader)
+{
+    segment_view_t view;
+    while(hlsparse_segment_reader_next(&reader, &view) > 0) {
+        co_yield SegmentView(view);
+    }
+}
+
+/**
+ * Yields the segments of the media playlist in \a src.
+ */
+inline Generator<SegmentView> segments(std::string_view src)
+{
+    segment_reader_t reader;
+    hlsparse_segment_reader_init(&reader, src.data(), src.size());
+    segment_view_t view;
+    while(hlsparse_segment_reader_next(&reader, &view) > 0) {
+        co_yield SegmentView(view);
+    }
+}
+
+} // namespace hls
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Lazy attributes
+ *
+ * With lazy_attributes set the parser copies the attribute list of each
+ * EXT-X-STREAM-INF, EXT-X-MEDIA and EXT-X-DATERANGE tag in a single allocation
+ * instead of decoding it. Attributes are decoded from the copy on request by
+ * running the tag parser with only the missing attributes selected, it steps
+ * over the others the same way so the decoded values always match an eager
+ * parse.
+ */
+
+int parse_stream_inf_lazy(const char *src, size_t size, stream_inf_t *dest)
+{
+    dest->decoded = 0;
+    return parse_line_to_str(src, &dest->attributes, size);
+}
+
+int parse_media_lazy(const char *src, size_t size, media_t *dest)
+{
+    dest->decoded = 0;
+    return parse_line_to_str(src, &dest->attributes, size);
+}
+
+int parse_daterange_lazy(const char *src, size_t size, daterange_t *dest)
+{
+    dest->decoded = 0;
+    return parse_line_to_str(src, &dest->attributes, size);
+}
+
+HLSCode hlsparse_stream_inf_decode(stream_inf_t *stream_inf, int fields)
+{
+    if(!stream_inf) {
+        return HLS_ERROR;
+    }
+
+    int missing = fields & STREAM_INF_ATTR_ALL & ~stream_inf->decoded;
+    if(stream_inf->attributes && missing) {
+        parse_stream_inf_fields(stream_inf->attributes, strlen(stream_inf->attributes), stream_inf, missing);
+        stream_inf->decoded |= missing;
+        if(stream_inf->decoded == STREAM_INF_ATTR_ALL) {
+            hls_free(stream_inf->attributes);
+            stream_inf->attributes = NULL;
+        }
+    }
+
+    return HLS_OK;
+}
+
+HLSCode hlsparse_media_decode(media_t *media, int fields)
+{
+    if(!media) {
+        return HLS_ERROR;
+    }
+
+    int missing = fields & MEDIA_ATTR_ALL & ~media->decoded;
+    if(media->attributes && missing) {
+        parse_media_fields(media->attributes, strlen(media->attributes), media, missing);
+        media->decoded |= missing;
+        if(media->decoded == MEDIA_ATTR_ALL) {
+            hls_free(media->attributes);
+            media->attributes = NULL;
+        }
+    }
+
+    return HLS_OK;
+}
+
+HLSCode hlsparse_daterange_decode(daterange_t *daterange, int fields)
+{
+    if(!daterange) {
+        return HLS_ERROR;
+    }
+
+    int missing = fields & DATERANGE_ATTR_ALL & ~daterange->decoded;
+    if(daterange->attributes && missing) {
+        parse_daterange_fields(daterange->attributes, strlen(daterange->attributes), daterange, missing);
+        daterange->decoded |= missing;
+        if(daterange->decoded == DATERANGE_ATTR_ALL) {
+            hls_free(daterange->attributes);
+            daterange->attributes = NULL;
+        }
+    }
+
+    return HLS_OK;
+}
+
+HLSCode hlsparse_master_decode(master_t *master)
+{
+    if(!master) {
+        return HLS_ERROR;
+    }
+
+    stream_inf_list_t *inf = &master->stream_infs;
+    while(inf && inf->data) {
+        hlsparse_stream_inf_decode(inf->data, STREAM_INF_ATTR_ALL);
+        inf = inf->next;
+    }
+
+    media_list_t *media = &master->media;
+    while(media && media->data) {
+        hlsparse_media_decode(media->data, MEDIA_ATTR_ALL);
+        media = media->next;
+    }
+
+    return HLS_OK;
+}
+
+HLSCode hlsparse_media_playlist_decode(media_playlist_t *playlist)
+{
+    if(!playlist) {
+        return HLS_ERROR;
+    }
+
+    daterange_list_t *daterange = &playlist->dateranges;
+    while(daterange && daterange->data) {
+        hlsparse_daterange_decode(daterange->data, DATERANGE_ATTR_ALL);
+        daterange = daterange->next;
+    }
+
+    return HLS_OK;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "parse.h"
+
+/*
+ * Metrics
+ *
+ * Each thread counts into its own block so the parser never contends on a
+ * shared counter. A block is added to a global list the first time its
+ * thread records something and hlsparse_metrics sums every block on the
+ * list. Only the owning thread writes to a block, so counters are bumped
+ * with plain relaxed stores and read with relaxed loads, a snapshot may be
+ * mid-update across counters but never sees a torn value.
+ * When a thread exits its counters are added to a retired block and its own
+ * block is freed, so totals never go backwards and threads which come and go
+ * don't leak. The list and the retired block are guarded by a lock which is
+ * only taken once per thread and when the metrics are read. Blocks are
+ * allocated with the C library rather than hls_malloc as they can be freed
+ * by a thread exiting after the library's memory functions were changed.
+ */
+
+typedef struct metrics_block {
+    hlsparse_metrics_t      metrics;
+    struct metrics_block    *next;
+} metrics_block_t;
+
+bool_t hls_metrics_enabled = HLS_FALSE;
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static metrics_block_t *metrics_blocks = NULL;      // live blocks, guarded by metrics_lock
+static hlsparse_metrics_t metrics_retired;          // exited threads, guarded by metrics_lock
+static pthread_once_t metrics_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t metrics_key;
+static bool_t metrics_key_valid = HLS_FALSE;
+static _Thread_local metrics_block_t *metrics_local = NULL;
+
+static const char *metrics_tag_names[METRICS_TAG_COUNT] = {
+    EXTM3U,
+    EXTXVERSION,
+    EXTINF,
+    EXTXBYTERANGE,
+    EXTXDISCONTINUITY,
+    EXTXKEY,
+    EXTXMAP,
+    EXTXDATERANGE,
+    EXTXPROGRAMDATETIME,
+    EXTXTARGETDURATION,
+    EXTXMEDIASEQUENCE,
+    EXTXDISCONTINUITYSEQ,
+    EXTXENDLIST,
+    EXTXPLAYLISTTYPE,
+    EXTXIFRAMESONLY,
+    EXTXALLOWCACHE,
+    EXTXINDEPENDENTSEGMENTS,
+    EXTXSTART,
+    EXTXMEDIA,
+    EXTXSTREAMINF,
+    EXTXIFRAMESTREAMINF,
+    EXTXSESSIONDATA,
+    EXTXSESSIONKEY,
+    "custom"
+};
+
+static inline void metrics_add(uint64_t *counter, uint64_t n)
+{
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+// adds the counters of one block to another, every field is a uint64_t so
+// the blocks can be summed as arrays
+static void metrics_sum(hlsparse_metrics_t *dest, const hlsparse_metrics_t *src)
+{
+    const int count = sizeof(hlsparse_metrics_t) / sizeof(uint64_t);
+    uint64_t *sum = (uint64_t*)dest;
+    const uint64_t *counters = (const uint64_t*)src;
+    int i;
+    for(i = 0; i < count; ++i) {
+        sum[i] += __atomic_load_n(&counters[i], __ATOMIC_RELAXED);
+    }
+}
+
+// called as a thread exits with the block it counted into
+static void metrics_retire(void *arg)
+{
+    metrics_block_t *block = arg;
+
+    pthread_mutex_lock(&metrics_lock);
+    metrics_sum(&metrics_retired, &block->metrics);
+    metrics_block_t **next = &metrics_blocks;
+    while(*next && *next != block) {
+        next = &(*next)->next;
+    }
+    if(*next) {
+        *next = block->next;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+
+    metrics_local = NULL;
+    free(block);
+}
+
+static void metrics_key_create(void)
+{
+    metrics_key_valid = pthread_key_create(&metrics_key, metrics_retire) == 0;
+}
+
+static hlsparse_metrics_t *metrics_thread(void)
+{
+    metrics_block_t *block = metrics_local;
+    if(block) {
+        return &block->metrics;
+    }
+
+    block = calloc(1, sizeof(metrics_block_t));
+    if(!block) {
+        return NULL;
+    }
+
+    // without a key the block can't be retired and simply outlives its thread
+    pthread_once(&metrics_key_once, metrics_key_create);
+    if(metrics_key_valid) {
+        pthread_setspecific(metrics_key, block);
+    }
+
+    pthread_mutex_lock(&metrics_lock);
+    block->next = metrics_blocks;
+    metrics_blocks = block;
+    pthread_mutex_unlock(&metrics_lock);
+
+    metrics_local = block;
+    return &block->metrics;
+}
+
+int metrics_nb_blocks(void)
+{
+    int nb = 0;
+    pthread_mutex_lock(&metrics_lock);
+    const metrics_block_t *block = metrics_blocks;
+    while(block) {
+        ++nb;
+        block = block->next;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+    return nb;
+}
+
+static int metrics_bucket(uint64_t ns)
+{
+    int bucket = ns ? 64 - __builtin_clzll(ns) : 0;
+    return bucket < HLSPARSE_METRICS_BUCKETS ? bucket : HLSPARSE_METRICS_BUCKETS - 1;
+}
+
+uint64_t metrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_parse(bool_t master, size_t bytes, uint64_t start)
+{
+    hlsparse_metrics_t *m = metrics_thread();
+    if(!m) {
+        return;
+    }
+
+    if(master) {
+        metrics_add(&m->nb_master_parsed, 1);
+    } else {
+        metrics_add(&m->nb_media_parsed, 1);
+    }
+    metrics_add(&m->bytes_parsed, bytes);
+    metrics_add(&m->parse_latency[metrics_bucket(metrics_now() - start)], 1);
+}
+
+void metrics_write(bool_t master, size_t bytes, uint64_t start)
+{
+    hlsparse_metrics_t *m = metrics_thread();
+    if(!m) {
+        return;
+    }
+
+    if(master) {
+        metrics_add(&m->nb_master_written, 1);
+    } else {
+        metrics_add(&m->nb_media_written, 1);
+    }
+    metrics_add(&m->bytes_written, bytes);
+    metrics_add(&m->write_latency[metrics_bucket(metrics_now() - start)], 1);
+}
+
+void metrics_tag(int tag)
+{
+    hlsparse_metrics_t *m = metrics_thread();
+    if(m) {
+        metrics_add(&m->tags[tag], 1);
+    }
+}
+
+HLSCode hlsparse_metrics_enable(bool_t enable)
+{
+    __atomic_store_n(&hls_metrics_enabled, enable ? HLS_TRUE : HLS_FALSE, __ATOMIC_RELAXED);
+    return HLS_OK;
+}
+
+HLSCode hlsparse_metrics(hlsparse_metrics_t *dest)
+{
+    if(!dest) {
+        return HLS_ERROR;
+    }
+
+    memset(dest, 0, sizeof(hlsparse_metrics_t));
+
+    pthread_mutex_lock(&metrics_lock);
+    metrics_sum(dest, &metrics_retired);
+    const metrics_block_t *block = metrics_blocks;
+    while(block) {
+        metrics_sum(dest, &block->metrics);
+        block = block->next;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+
+    return HLS_OK;
+}
+
+const char *hlsparse_metrics_tag_name(int tag)
+{
+    if(tag < 0 || tag >= METRICS_TAG_COUNT) {
+        return NULL;
+    }
+    return metrics_tag_names[tag];
+}
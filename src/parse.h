@@ -13,6 +13,10 @@
 // of the tag if successful
 #define EQUAL(a,b)  (0 == strncmp((a), (b), sizeof(b) - 1) && (a += sizeof(b) - 1))
 
+// compares a char* with a string literal HLS tag without reading past end or
+// moving the ptr
+#define TAG_IS(pt, end, tag) ((size_t)((end) - (pt)) >= sizeof(tag) - 1 && 0 == strncmp((pt), (tag), sizeof(tag) - 1))
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,6 +25,20 @@ extern "C" {
 extern hlsparse_malloc_callback hls_malloc;
 extern hlsparse_free_callback hls_free;
 
+// Allocations are tagged with the calling function for hlsparse_alloc_stats
+void *hls_malloc_site(size_t size, const char *site);
+void hls_free_site(void *ptr);
+#define hls_malloc(size)    hls_malloc_site((size), __func__)
+#define hls_free(ptr)       hls_free_site(ptr)
+
+// Metrics
+extern bool_t hls_metrics_enabled;
+uint64_t metrics_now(void);
+void metrics_parse(bool_t master, size_t bytes, uint64_t start);
+void metrics_write(bool_t master, size_t bytes, uint64_t start);
+void metrics_tag(int tag);
+int metrics_nb_blocks(void);
+
 // Utils
 char *str_utils_dup(const char *str);
 char *str_utils_ndup(const char *str, size_t size);
@@ -29,11 +47,18 @@ char *str_utils_nappend(char *str, const char *append, size_t size);
 char *str_utils_join(const char *str, const char *join);
 char *str_utils_njoin(const char *str, const char *join, size_t size);
 char *path_combine(char **dest, const char *base, const char *path);
+uint64_t hls_hash64(const void *data, size_t size, uint64_t seed);
+size_t media_playlist_footprint(const media_playlist_t *playlist);
+size_t master_footprint(const master_t *master);
+segment_t *media_playlist_alloc_segment(media_playlist_t *playlist);
+segment_list_t *media_playlist_alloc_segment_node(media_playlist_t *playlist);
 
 // Tag parsing
 int parse_line_to_str(const char *src, char **dest, size_t size);
 int parse_str_to_int(const char *src, int *dest, size_t size);
 int parse_str_to_float(const char *str, float *dest, size_t size);
+int parse_str_to_ticks(const char *src, int64_t *dest, int decimals, size_t size);
+int parse_str_to_duration(const char *src, double *dest, int64_t *ms, size_t size);
 int parse_date(const char *src, uint64_t *dest, size_t size);
 int parse_attrib_str(const char *src, char **dest, size_t size);
 int parse_attrib_data(const char *src, char **dest, size_t size);
@@ -43,8 +68,10 @@ int parse_str_to_float(const char *str, float *dest, size_t size);
 int parse_date(const char *src, uint64_t *dest, size_t size);
 int parse_attrib_str(const char *src, char **dest, size_t size);
 int parse_attrib_data(const char *src, char **dest, size_t size);
+const char *parse_attrib_find(const char *src, const char *end, const char *name, size_t *size);
 int parse_master_tag(const char *src, size_t size, master_t *dest); 
 int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *dest);
+int parse_media_playlist_tail(const char *src, size_t size, media_playlist_t *dest);
 void hlsparse_byte_range_init(byte_range_t *byte_range);
 void hlsparse_ext_inf_init(ext_inf_t *ext_inf);
 void hlsparse_resolution_init(resolution_t *resolution);
@@ -72,6 +99,7 @@ void hlsparse_ext_inf_term(ext_inf_t *ext_inf);
 void hlsparse_iframe_stream_inf_term(iframe_stream_inf_t *stream_inf);
 void hlsparse_stream_inf_term(stream_inf_t *stream_inf);
 void hlsparse_key_term(hls_key_t *key);
+size_t key_iv_size(const hls_key_t *key);
 void hlsparse_map_term(map_t *map);
 void hlsparse_daterange_term(daterange_t *daterange);
 void hlsparse_media_term(media_t *media);
@@ -91,22 +119,102 @@ int parse_byte_range(const char *src, size_t size, byte_range_t *dest);
 int parse_iframe_stream_inf(const char *src, size_t size, iframe_stream_inf_t *dest);
 int parse_iframe_stream_inf_tag(const char *src, size_t size, iframe_stream_inf_t *dest);
 int parse_stream_inf(const char *src, size_t size, stream_inf_t *dest);
-int parse_stream_inf_tag(const char *src, size_t size, stream_inf_t *dest);
+int parse_stream_inf_fields(const char *src, size_t size, stream_inf_t *dest, int fields);
+int parse_stream_inf_tag(const char *src, size_t size, stream_inf_t *dest, int fields);
 int parse_resolution(const char *src, size_t size, resolution_t *dest);
 int parse_key(const char *src, size_t size, hls_key_t *key);
 int parse_key_tag(const char *src, size_t size, hls_key_t *key);
 int parse_map(const char *src, size_t size, map_t *map);
-int parse_daterange_tag(const char *src, size_t size, daterange_t *daterange);
+int parse_daterange_tag(const char *src, size_t size, daterange_t *daterange, int fields);
 int parse_daterange(const char *src, size_t size, daterange_t *daterange);
+int parse_daterange_fields(const char *src, size_t size, daterange_t *daterange, int fields);
 int parse_map_tag(const char *src, size_t size, map_t *map);
 int parse_media(const char *src, size_t size, media_t *media);
-int parse_media_tag(const char *src, size_t size, media_t *media);
+int parse_media_fields(const char *src, size_t size, media_t *media, int fields);
+int parse_media_tag(const char *src, size_t size, media_t *media, int fields);
 int parse_segment(const char *src, size_t size, segment_t *segment);
-int parse_segment_tag(const char *src, size_t size, segment_t *segment);
+int parse_segment_fields(const char *src, size_t size, segment_t *segment, int skip_fields);
+int parse_segment_tag(const char *src, size_t size, segment_t *segment, int skip_fields);
 int parse_segment_uri(const char *src, size_t size, media_playlist_t *dest);
 int parse_session_data(const char *src, size_t size, session_data_t *session_data);
 int parse_session_data_tag(const char *src, size_t size,session_data_t *session_data);
 int parse_start(const char *src, size_t size, start_t *start);
+int parse_stream_inf_lazy(const char *src, size_t size, stream_inf_t *dest);
+int parse_media_lazy(const char *src, size_t size, media_t *dest);
+int parse_daterange_lazy(const char *src, size_t size, daterange_t *dest);
+
+// Attribute schema
+// Each tag with an attribute-list is described once by a table of attr_t, in
+// the order the attributes are written, the parser and the writer both work
+// from the table.
+#define ATTR_INT                0   // decimal-integer
+#define ATTR_FLOAT              1   // decimal-floating-point, written with 3 decimals
+#define ATTR_BANDWIDTH          2   // decimal-integer held in a float
+#define ATTR_STR                3   // quoted-string
+#define ATTR_ENUM               4   // enumerated-string, one of attr_t.values
+#define ATTR_YES_NO             5   // YES or NO, only YES is written
+#define ATTR_RESOLUTION         6   // decimal-resolution
+#define ATTR_DATA               7   // hexadecimal-sequence
+#define ATTR_DATE               8   // ISO-8601 date, quoted or not
+#define ATTR_BYTE_RANGE         9   // quoted "n@o"
+#define ATTR_INSTREAM_ID        10  // quoted CC1-CC4 or SERVICEn
+#define ATTR_CLOSED_CAPTIONS    11  // quoted-string or NONE
+#define ATTR_CLIENT             12  // the X- attributes, kept in a param_list_t
+
+#define ATTR_REQUIRED           (1 << 0)    // written even when it has no value, an ATTR_ENUM
+                                            // without a name fails the write
+#define ATTR_URI                (1 << 1)    // written relative to the playlist's uri
+#define ATTR_READ_ONLY          (1 << 2)    // parsed but never written
+#define ATTR_IV                 (1 << 3)    // an ATTR_DATA IV, see key_iv_size
+
+typedef struct {
+    int value;
+    const char *name;
+} attr_value_t;
+
+typedef struct {
+    const char *name;
+    uint8_t len;
+    uint8_t type;           // ATTR_*
+    uint8_t flags;          // ATTR_REQUIRED, ATTR_URI, ATTR_READ_ONLY and ATTR_IV
+    uint16_t offset;        // of the value in the tag's struct
+    int16_t aux_offset;     // of an ATTR_DATA's size_t length or of an
+                            // ATTR_INSTREAM_ID's service number
+    int field;              // the *_ATTR_* flag parsing the value, 0 when always parsed
+    const attr_value_t *values; // ATTR_ENUM and ATTR_INSTREAM_ID names, ended by
+                                // the value given to any other name
+} attr_t;
+
+typedef struct {
+    const attr_t *attrs;
+    int nb_attrs;
+} attr_schema_t;
+
+extern const attr_schema_t stream_inf_schema;
+extern const attr_schema_t iframe_stream_inf_schema;
+extern const attr_schema_t media_schema;
+extern const attr_schema_t key_schema;
+extern const attr_schema_t map_schema;
+extern const attr_schema_t session_data_schema;
+extern const attr_schema_t daterange_schema;
+
+int parse_attribute(const attr_schema_t *schema, const char *src, size_t size, void *dest, int fields);
+int parse_attributes(const attr_schema_t *schema, const char *src, size_t size, void *dest, int fields);
+
+// Attribute tokenizer
+// An attribute-list is split into NAME=value spans in a single pass over the
+// line, the value runs up to the next comma outside of a quoted-string and
+// keeps its quotes.
+typedef struct {
+    const char *name;
+    size_t name_size;
+    const char *value;
+    size_t value_size;
+} attr_token_t;
+
+typedef void (*attr_token_callback)(const attr_token_t *token, void *user);
+
+int tokenize_attributes(const char *src, size_t size, attr_token_callback callback, void *user);
 
 #ifdef __cplusplus
 }
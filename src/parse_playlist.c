@@ -5,6 +5,7 @@
  */
 
 #include "parse.h"
+#include "probes.h"
 #include <memory.h>
 
 /**
@@ -22,44 +23,61 @@ int parse_master_tag(const char *src, size_t size, master_t *dest)
     }
 
     const char *pt = src;
+    int tag = METRICS_TAG_CUSTOM;
 
     if (EQUAL(pt, EXTM3U)) {
+        tag = METRICS_TAG_EXTM3U;
 
         dest->m3u = HLS_TRUE;
     } else if (EQUAL(pt, EXTXMEDIA)) {
+        tag = METRICS_TAG_EXTXMEDIA;
+        if(dest->skip_fields & PARSE_FIELD_MEDIA) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            media_t *media = hls_malloc(sizeof(media_t));
+            hlsparse_media_init(media);
 
-        media_t *media = hls_malloc(sizeof(media_t));
-        hlsparse_media_init(media);
-
-        pt += parse_media(pt, size - (pt - src), media);
+            if(dest->lazy_attributes) {
+                pt += parse_media_lazy(pt, size - (pt - src), media);
+            } else {
+                pt += parse_media(pt, size - (pt - src), media);
+            }
 
-        media_list_t *next = &dest->media;
+            media_list_t *next = &dest->media;
 
-        while(next) {
-            if(!next->data) {
-                next->data = media;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(media_list_t));
-                hlsparse_media_list_init(next->next);
-                next->next->data = media;
-                break;
-            }
-            next = next->next;
-        };
+            while(next) {
+                if(!next->data) {
+                    next->data = media;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(media_list_t));
+                    hlsparse_media_list_init(next->next);
+                    next->next->data = media;
+                    break;
+                }
+                next = next->next;
+            };
+        }
 
     } else if (EQUAL(pt, EXTXVERSION)) {
+        tag = METRICS_TAG_EXTXVERSION;
         ++pt; // get past the ':'
         pt += parse_str_to_int(pt, &dest->version, size - (pt - src));
     } else if (EQUAL(pt, EXTXINDEPENDENTSEGMENTS )) {
+        tag = METRICS_TAG_EXTXINDEPENDENTSEGMENTS;
 
         dest->independent_segments = HLS_TRUE;
     } else if (EQUAL(pt, EXTXSTREAMINF)) {
+        tag = METRICS_TAG_EXTXSTREAMINF;
 
         stream_inf_t *stream_inf = hls_malloc(sizeof(stream_inf_t));
         hlsparse_stream_inf_init(stream_inf);
 
-        pt += parse_stream_inf(pt, size - (pt - src), stream_inf);
+        if(dest->lazy_attributes) {
+            pt += parse_stream_inf_lazy(pt, size - (pt - src), stream_inf);
+        } else {
+            pt += parse_stream_inf(pt, size - (pt - src), stream_inf);
+        }
 
         // the line directly after a stream-inf must be the the uri
         // go to the end of the line
@@ -73,8 +91,12 @@ int parse_master_tag(const char *src, size_t size, master_t *dest)
         // get the uri
         char* path = NULL;
         pt += parse_line_to_str(pt, &path, size - (pt - src));
-        path_combine(&stream_inf->uri, dest->uri, path);
-        if (path) hls_free(path);
+        if(dest->skip_fields & PARSE_FIELD_RESOLVED_URIS) {
+            stream_inf->uri = path;
+        } else {
+            path_combine(&stream_inf->uri, dest->uri, path);
+            if (path) hls_free(path);
+        }
 
         stream_inf_list_t *next = &dest->stream_infs;
 
@@ -94,89 +116,105 @@ int parse_master_tag(const char *src, size_t size, master_t *dest)
         dest->nb_stream_infs++;
 
     } else if (EQUAL(pt, EXTXIFRAMESTREAMINF)) {
+        tag = METRICS_TAG_EXTXIFRAMESTREAMINF;
+        if(dest->skip_fields & PARSE_FIELD_IFRAME_STREAM_INFS) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            iframe_stream_inf_t *stream_inf = hls_malloc(sizeof(iframe_stream_inf_t));
+            hlsparse_iframe_stream_inf_init(stream_inf);
+            pt += parse_iframe_stream_inf(pt, size - (pt - src), stream_inf);
 
-        iframe_stream_inf_t *stream_inf = hls_malloc(sizeof(iframe_stream_inf_t));
-        hlsparse_iframe_stream_inf_init(stream_inf);
-        pt += parse_iframe_stream_inf(pt, size - (pt - src), stream_inf);
-
-        char *path = stream_inf->uri;
-        path_combine(&stream_inf->uri, dest->uri, path);
+            if(!(dest->skip_fields & PARSE_FIELD_RESOLVED_URIS)) {
+                char *path = stream_inf->uri;
+                path_combine(&stream_inf->uri, dest->uri, path);
+            }
 
-        iframe_stream_inf_list_t *next = &dest->iframe_stream_infs;
+            iframe_stream_inf_list_t *next = &dest->iframe_stream_infs;
 
-        while(next) {
-            if(!next->data) {
-                next->data = stream_inf;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(iframe_stream_inf_list_t));
-                hlsparse_iframe_stream_inf_list_init(next->next);
-                next->next->data = stream_inf;
-                break;
-            }
-            next = next->next;
-        };
+            while(next) {
+                if(!next->data) {
+                    next->data = stream_inf;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(iframe_stream_inf_list_t));
+                    hlsparse_iframe_stream_inf_list_init(next->next);
+                    next->next->data = stream_inf;
+                    break;
+                }
+                next = next->next;
+            };
 
-        dest->nb_iframe_stream_infs++;
+            dest->nb_iframe_stream_infs++;
+        }
 
     } else if (EQUAL(pt, EXTXSESSIONDATA)) {
+        tag = METRICS_TAG_EXTXSESSIONDATA;
+        if(dest->skip_fields & PARSE_FIELD_SESSION_DATA) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            session_data_t *session_data = hls_malloc(sizeof(session_data_t));
+            hlsparse_session_data_init(session_data);
+            ;
+            pt += parse_session_data(pt, size - (pt - src), session_data);
 
-        session_data_t *session_data = hls_malloc(sizeof(session_data_t));
-        hlsparse_session_data_init(session_data);
-        ;
-        pt += parse_session_data(pt, size - (pt - src), session_data);
-
-        session_data_list_t *next = &dest->session_data;
+            session_data_list_t *next = &dest->session_data;
 
-        while(next) {
-            if(!next->data) {
-                next->data = session_data;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(session_data_list_t));
-                hlsparse_session_data_list_init(next->next);
-                next->next->data = session_data;
-                break;
-            }
-            next = next->next;
-        };
+            while(next) {
+                if(!next->data) {
+                    next->data = session_data;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(session_data_list_t));
+                    hlsparse_session_data_list_init(next->next);
+                    next->next->data = session_data;
+                    break;
+                }
+                next = next->next;
+            };
+        }
 
     } else if(EQUAL(pt, EXTXSTART)) {
+        tag = METRICS_TAG_EXTXSTART;
 
         ++pt;
         pt += parse_start(pt, size - (pt - src), &dest->start);
     } else if(EQUAL(pt, EXTXSESSIONKEY)) {
+        tag = METRICS_TAG_EXTXSESSIONKEY;
+        if(dest->skip_fields & PARSE_FIELD_SESSION_KEYS) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            ++pt;
+            hls_key_t* key = hls_malloc(sizeof(hls_key_t));
+            hlsparse_key_init(key);
+            pt += parse_key(pt, size - (pt - src), key);
 
-        ++pt;
-        hls_key_t* key = hls_malloc(sizeof(hls_key_t));
-        hlsparse_key_init(key);
-        pt += parse_key(pt, size - (pt - src), key);
+            if(key->method != KEY_METHOD_NONE && key->method != KEY_METHOD_INVALID &&
+               !(dest->skip_fields & PARSE_FIELD_RESOLVED_URIS)) {
+                path_combine(&key->uri, dest->uri, key->uri);
+            }
 
-        if(key->method != KEY_METHOD_NONE && key->method != KEY_METHOD_INVALID) {
-            path_combine(&key->uri, dest->uri, key->uri);
-        }
+            key_list_t *next = &dest->session_keys;
 
-        key_list_t *next = &dest->session_keys;
+            while(next) {
+                if(!next->data) {
+                    next->data = key;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(key_list_t));
+                    hlsparse_key_list_init(next->next);
+                    next->next->data = key;
+                    break;
+                }
+                next = next->next;
+            };
 
-        while(next) {
-            if(!next->data) {
-                next->data = key;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(hls_key_t));
-                hlsparse_key_list_init(next->next);
-                next->next->data = key;
-                break;
-            }
-            next = next->next;
-        };
-        
-        ++(dest->nb_session_keys);        
+            ++(dest->nb_session_keys);
+        }
     } else {
 
         // custom src
         char *custom_tag = NULL;
-        pt += parse_line_to_str(pt, &custom_tag, size - (pt - src));
+        pt += parse_line_to_str(pt, dest->skip_fields & PARSE_FIELD_CUSTOM_TAGS ? NULL : &custom_tag, size - (pt - src));
         if (custom_tag && *custom_tag != '\0') {
 
             string_list_t *next = &dest->custom_tags;
@@ -197,7 +235,12 @@ int parse_master_tag(const char *src, size_t size, master_t *dest)
     }
 
     // return how far we have moved along in the src
-    return pt - src;
+    int res = pt - src;
+    if(hls_metrics_enabled) {
+        metrics_tag(tag);
+    }
+    HLS_PROBE2(master_tag, tag, res);
+    return res;
 }
 
 /**
@@ -215,22 +258,29 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
     }
 
     const char *pt = src;
+    int tag = METRICS_TAG_CUSTOM;
 
     if(EQUAL(pt, EXTM3U)) {
+        tag = METRICS_TAG_EXTM3U;
         dest->m3u = HLS_TRUE;
     } else if(EQUAL(pt, EXTXVERSION)) {
+        tag = METRICS_TAG_EXTXVERSION;
         ++pt; // get past the '=' sign
         pt += parse_str_to_int(pt, &dest->version, size - (pt - src));
     } else if(EQUAL(pt, EXTXTARGETDURATION)) {
+        tag = METRICS_TAG_EXTXTARGETDURATION;
         ++pt; // get past the '=' sign
         pt += parse_str_to_float(pt, &dest->target_duration, size - (pt - src));
     } else if(EQUAL(pt, EXTXINDEPENDENTSEGMENTS)) {
+        tag = METRICS_TAG_EXTXINDEPENDENTSEGMENTS;
         ++pt; // get past the '=' sign
         dest->independent_segments = HLS_TRUE;
     } else if(EQUAL(pt, EXTXMEDIASEQUENCE)) {
+        tag = METRICS_TAG_EXTXMEDIASEQUENCE;
         ++pt; // get past the '=' sign
         pt += parse_str_to_int(pt, &dest->media_sequence, size - (pt - src));
     } else if(EQUAL(pt, EXTXPLAYLISTTYPE)) {
+        tag = METRICS_TAG_EXTXPLAYLISTTYPE;
         ++pt; // get past the '=' sign
         if(EQUAL(pt, VOD)) {
             dest->playlist_type = PLAYLIST_TYPE_VOD;
@@ -240,25 +290,34 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
             dest->playlist_type = PLAYLIST_TYPE_INVALID;
         }
     } else if(EQUAL(pt, EXTXENDLIST)) {
+        tag = METRICS_TAG_EXTXENDLIST;
         dest->end_list = HLS_TRUE;
     } else if(EQUAL(pt, EXTXPROGRAMDATETIME)) {
+        tag = METRICS_TAG_EXTXPROGRAMDATETIME;
         ++pt; // get past the '=' sign
         pt += parse_date(pt, &dest->next_segment_pdt, size - (pt - src));
     } else if(EQUAL(pt, EXTXALLOWCACHE)) {
+        tag = METRICS_TAG_EXTXALLOWCACHE;
         dest->allow_cache = HLS_TRUE;
     } else if(EQUAL(pt, EXTXDISCONTINUITYSEQ)) {
+        tag = METRICS_TAG_EXTXDISCONTINUITYSEQ;
         ++pt; // get past the ':' 
         pt += parse_str_to_int(pt, &dest->discontinuity_sequence, size - (pt - src));
     } else if(EQUAL(pt, EXTXDISCONTINUITY)) {
+        tag = METRICS_TAG_EXTXDISCONTINUITY;
         dest->next_segment_discontinuity = HLS_TRUE;
     } else if(EQUAL(pt, EXTXIFRAMESONLY)) {
+        tag = METRICS_TAG_EXTXIFRAMESONLY;
         dest->iframes_only = HLS_TRUE;
     } else if(EQUAL(pt, EXTXINDEPENDENTSEGMENTS)) {
+        tag = METRICS_TAG_EXTXINDEPENDENTSEGMENTS;
         dest->independent_segments = HLS_TRUE;
     } else if(EQUAL(pt, EXTXSTART)) {
+        tag = METRICS_TAG_EXTXSTART;
         ++pt;
         pt += parse_start(pt, size - (pt - src), &dest->start);
     } else if (EQUAL(pt, EXTXBYTERANGE)) {
+        tag = METRICS_TAG_EXTXBYTERANGE;
         if (*pt == ':') {
             ++pt;
             pt += parse_str_to_int(pt,
@@ -272,19 +331,17 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
             }
         }
     } else if(EQUAL(pt, EXTINF)) {
+        tag = METRICS_TAG_EXTINF;
         ++pt;
-        segment_t *segment = hls_malloc(sizeof(segment_t));
-        hlsparse_segment_init(segment);
+        segment_t *segment = media_playlist_alloc_segment(dest);
 
-        pt += parse_segment(pt, size - (pt - src), segment);
+        // parsing the duration sets pdt_end to pdt plus the exact milliseconds
+        segment->pdt = dest->next_segment_pdt;
+        pt += parse_segment_fields(pt, size - (pt - src), segment, dest->skip_fields);
 
         segment->sequence_num = dest->next_segment_media_sequence;
         ++(dest->next_segment_media_sequence);
 
-        segment->pdt = dest->next_segment_pdt;
-        segment->pdt_end = dest->next_segment_pdt +
-                           (timestamp_t)(segment->duration * 1000.f);
-
         // increase the segment PDT so that the next segment gets a valid value
         dest->next_segment_pdt = segment->pdt_end;
 
@@ -298,21 +355,22 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
             }
         }
 
-        // add the segment to the playlist
-        segment_list_t *next = &dest->segments;
+        // add the segment to the playlist, starting from the last known node
+        segment_list_t *next = dest->segments_tail ? dest->segments_tail : &dest->segments;
 
         while(next) {
             if(!next->data) {
                 next->data = segment;
                 break;
             } else if(!next->next) {
-                next->next = hls_malloc(sizeof(segment_list_t));
-                hlsparse_segment_list_init(next->next);
+                next->next = media_playlist_alloc_segment_node(dest);
                 next->next->data = segment;
+                next = next->next;
                 break;
             }
             next = next->next;
         };
+        dest->segments_tail = next;
 
         dest->last_segment = segment;
         ++(dest->nb_segments);
@@ -321,85 +379,116 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
         dest->duration += segment->duration;
 
     } else if(EQUAL(pt, EXTXKEY)) {
-        ++pt;
-        hls_key_t* key = hls_malloc(sizeof(hls_key_t));
-        hlsparse_key_init(key);
-        pt += parse_key(pt, size - (pt - src), key);
+        tag = METRICS_TAG_EXTXKEY;
+        if(dest->skip_fields & PARSE_FIELD_KEYS) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            ++pt;
+            hls_key_t* key = hls_malloc(sizeof(hls_key_t));
+            hlsparse_key_init(key);
+            pt += parse_key(pt, size - (pt - src), key);
 
-        if(key->method != KEY_METHOD_NONE && key->method != KEY_METHOD_INVALID) {
-            path_combine(&key->uri, dest->uri, key->uri);
-        }
+            if(key->method != KEY_METHOD_NONE && key->method != KEY_METHOD_INVALID &&
+               !(dest->skip_fields & PARSE_FIELD_RESOLVED_URIS)) {
+                path_combine(&key->uri, dest->uri, key->uri);
+            }
 
-        // set the media sequnce that the key originated
-        key_list_t *next = &dest->keys;
+            // set the media sequnce that the key originated
+            key_list_t *next = dest->keys_tail ? dest->keys_tail : &dest->keys;
 
-        while(next) {
-            if(!next->data) {
-                next->data = key;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(hls_key_t));
-                hlsparse_key_list_init(next->next);
-                next->next->data = key;
-                break;
-            }
-            next = next->next;
-        };
-        
-        ++(dest->nb_keys);        
+            while(next) {
+                if(!next->data) {
+                    next->data = key;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(key_list_t));
+                    hlsparse_key_list_init(next->next);
+                    next->next->data = key;
+                    next = next->next;
+                    break;
+                }
+                next = next->next;
+            };
+            dest->keys_tail = next;
+
+            ++(dest->nb_keys);
+        }
 
     } else if(EQUAL(pt, EXTXMAP)) {
-        ++pt;
-        map_t *map = hls_malloc(sizeof(map_t));;
-        hlsparse_map_init(map);
-        pt += parse_map(pt, size - (pt - src), map);
-        map_list_t *next = &dest->maps;
+        tag = METRICS_TAG_EXTXMAP;
+        if(dest->skip_fields & PARSE_FIELD_MAPS) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            ++pt;
+            map_t *map = hls_malloc(sizeof(map_t));;
+            hlsparse_map_init(map);
+            pt += parse_map(pt, size - (pt - src), map);
+            map_list_t *next = dest->maps_tail ? dest->maps_tail : &dest->maps;
 
-        while(next) {
-            if(!next->data) {
-                next->data = map;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(map_t));
-                hlsparse_map_list_init(next->next);
-                next->next->data = map;
-                break;
-            }
-            next = next->next;
-        };
+            while(next) {
+                if(!next->data) {
+                    next->data = map;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(map_list_t));
+                    hlsparse_map_list_init(next->next);
+                    next->next->data = map;
+                    next = next->next;
+                    break;
+                }
+                next = next->next;
+            };
+            dest->maps_tail = next;
 
-        ++(dest->nb_maps);
+            ++(dest->nb_maps);
+        }
 
     } else if(EQUAL(pt, EXTXDATERANGE)) {
-        ++pt;
-        daterange_t *daterange = hls_malloc(sizeof(daterange_t));;
-        hlsparse_daterange_init(daterange);
-        pt += parse_daterange(pt, size - (pt - src), daterange);
-        daterange->pdt = dest->next_segment_pdt;
+        tag = METRICS_TAG_EXTXDATERANGE;
+        if(dest->skip_fields & PARSE_FIELD_DATERANGES) {
+            pt += parse_line_to_str(pt, NULL, size - (pt - src));
+        } else {
+            ++pt;
+            daterange_t *daterange = hls_malloc(sizeof(daterange_t));;
+            hlsparse_daterange_init(daterange);
+            if(dest->lazy_attributes) {
+                pt += parse_daterange_lazy(pt, size - (pt - src), daterange);
+            } else if(dest->skip_fields & PARSE_FIELD_SCTE35) {
+                pt += parse_daterange_fields(pt, size - (pt - src), daterange,
+                                             DATERANGE_ATTR_ALL & ~(DATERANGE_ATTR_SCTE35_CMD |
+                                                                    DATERANGE_ATTR_SCTE35_OUT |
+                                                                    DATERANGE_ATTR_SCTE35_IN));
+            } else {
+                pt += parse_daterange(pt, size - (pt - src), daterange);
+            }
+            daterange->pdt = dest->next_segment_pdt;
 
-        daterange_list_t *next = &dest->dateranges;
+            daterange_list_t *next = dest->dateranges_tail ? dest->dateranges_tail : &dest->dateranges;
 
-        while(next) {
+            while(next) {
 
-            if(!next->data) {
-                next->data = daterange;
-                break;
-            } else if(!next->next) {
-                next->next = hls_malloc(sizeof(daterange_t));
-                hlsparse_daterange_list_init(next->next);
-                next->next->data = daterange;
-                break;
-            }
-            next = next->next;
-        };
+                if(!next->data) {
+                    next->data = daterange;
+                    break;
+                } else if(!next->next) {
+                    next->next = hls_malloc(sizeof(daterange_list_t));
+                    hlsparse_daterange_list_init(next->next);
+                    next->next->data = daterange;
+                    next = next->next;
+                    break;
+                }
+                next = next->next;
+            };
+            dest->dateranges_tail = next;
 
-        ++(dest->nb_dateranges);
+            ++(dest->nb_dateranges);
+        }
 
     } else {
         // custom src
         char *custom_tag = NULL;
 
-        pt += parse_line_to_str(pt, &custom_tag, size - (pt - src));
+        pt += parse_line_to_str(pt, dest->skip_fields & PARSE_FIELD_CUSTOM_TAGS ? NULL : &custom_tag, size - (pt - src));
         
         if (custom_tag && *custom_tag != '\0') {
 
@@ -423,5 +512,10 @@ int parse_media_playlist_tag(const char *src, size_t size, media_playlist_t *des
     }
 
     // return how far we have moved along in the src
-    return pt - src;
+    int res = pt - src;
+    if(hls_metrics_enabled) {
+        metrics_tag(tag);
+    }
+    HLS_PROBE3(media_tag, tag, res, dest->nb_segments);
+    return res;
 }
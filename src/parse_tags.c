@@ -346,10 +346,12 @@ void hlsparse_stream_inf_term(stream_inf_t *stream_inf)
             &stream_inf->subtitles,
             &stream_inf->closed_captions,
             &stream_inf->video,
-            &stream_inf->uri
+            &stream_inf->uri,
+            &stream_inf->attributes
         };
 
-        parse_param_term(params, 7);
+        stream_inf->decoded = 0;
+        parse_param_term(params, 8);
     }
 }
 
@@ -375,6 +377,21 @@ void hlsparse_key_term(hls_key_t *dest)
     }
 }
 
+/**
+ * Returns the size of a key's IV in bytes, 0 without an IV.
+ * Keys built by callers from before iv_size was added leave it 0, their IV is
+ * taken to be the 128 bits EXT-X-KEY requires.
+ *
+ * @param key The key.
+ */
+size_t key_iv_size(const hls_key_t *key)
+{
+    if(!key->iv) {
+        return 0;
+    }
+    return key->iv_size ? key->iv_size : 16;
+}
+
 /**
  * Helper function for terminating a map_t.
  * This will free any properties on the object resetting the values, but won't
@@ -411,13 +428,15 @@ void hlsparse_daterange_term(daterange_t *dest)
             &dest->scte35_cmd,
             &dest->scte35_out,
             &dest->scte35_in,
+            &dest->attributes,
         };
 
         dest->scte35_cmd_size = 0;
         dest->scte35_out_size = 0;
         dest->scte35_in_size = 0;
+        dest->decoded = 0;
 
-        parse_param_term(params, 5);
+        parse_param_term(params, 6);
         hlsparse_param_list_term(&dest->client_attributes);
     }
 }
@@ -441,9 +460,11 @@ void hlsparse_media_term(media_t *dest)
             &dest->uri,
             &dest->characteristics,
             &dest->channels,
+            &dest->attributes,
         };
 
-        parse_param_term(params, 7);
+        dest->decoded = 0;
+        parse_param_term(params, 8);
     }
 }
 
@@ -491,6 +512,38 @@ void hlsparse_session_data_term(session_data_t *dest)
     }
 }
 
+/**
+ * Terminates and frees the item of each node of the list at \a dest with
+ * \a term_item, and frees every node after the first. The list is walked
+ * rather than recursed so that long lists, e.g. the segments of a long
+ * playlist, can't exhaust the stack.
+ */
+#define LIST_TERM(list_type, dest, term_item) \
+    if(dest) { \
+        list_type *ptr = (dest)->next; \
+        if((dest)->data) { \
+            term_item((dest)->data); \
+            hls_free((dest)->data); \
+            (dest)->data = NULL; \
+        } \
+        (dest)->next = NULL; \
+        while(ptr) { \
+            list_type *next = ptr->next; \
+            if(ptr->data) { \
+                term_item(ptr->data); \
+                hls_free(ptr->data); \
+            } \
+            hls_free(ptr); \
+            ptr = next; \
+        } \
+    }
+
+// the strings of a string_list_t hold nothing to terminate
+static inline void string_term(char *str)
+{
+    (void)str;
+}
+
 /**
  * Helper function for terminating a segmentlist_t.
  * This will free any properties on the object resetting the values, but won't
@@ -501,20 +554,7 @@ void hlsparse_session_data_term(session_data_t *dest)
  */
 void hlsparse_segment_list_term(segment_list_t *dest)
 {
-
-    if(dest) {
-        if(dest->data) {
-            hlsparse_segment_term(dest->data);
-            hls_free(dest->data);
-            dest->data = NULL;
-        }
-
-        if(dest->next) {
-            hlsparse_segment_list_term(dest->next);
-            hls_free(dest->next);
-            dest->next = NULL;
-        }
-    }
+    LIST_TERM(segment_list_t, dest, hlsparse_segment_term);
 }
 
 /**
@@ -527,19 +567,7 @@ void hlsparse_segment_list_term(segment_list_t *dest)
  */
 void hlsparse_session_data_list_term(session_data_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_session_data_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        session_data_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_session_data_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(session_data_list_t, dest, hlsparse_session_data_term);
 }
 
 /**
@@ -552,19 +580,7 @@ void hlsparse_session_data_list_term(session_data_list_t *dest)
  */
 void parse_key_list_term(key_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_key_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        key_list_t *ptr = dest->next;
-
-        if(ptr) {
-            parse_key_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(key_list_t, dest, hlsparse_key_term);
 }
 
 /**
@@ -577,19 +593,7 @@ void parse_key_list_term(key_list_t *dest)
  */
 void hlsparse_media_list_term(media_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_media_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        media_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_media_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(media_list_t, dest, hlsparse_media_term);
 }
 
 /**
@@ -602,19 +606,7 @@ void hlsparse_media_list_term(media_list_t *dest)
  */
 void parse_map_list_term(map_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_map_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        map_list_t *ptr = dest->next;
-
-        if(ptr) {
-            parse_map_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(map_list_t, dest, hlsparse_map_term);
 }
 
 /**
@@ -627,19 +619,7 @@ void parse_map_list_term(map_list_t *dest)
  */
 void hlsparse_daterange_list_term(daterange_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_daterange_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        daterange_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_daterange_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(daterange_list_t, dest, hlsparse_daterange_term);
 }
 
 /**
@@ -652,20 +632,7 @@ void hlsparse_daterange_list_term(daterange_list_t *dest)
  */
 void hlsparse_iframe_stream_inf_list_term(iframe_stream_inf_list_t *dest)
 {
-
-    if(dest) {
-        if(dest->data) {
-            hlsparse_iframe_stream_inf_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        iframe_stream_inf_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_iframe_stream_inf_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(iframe_stream_inf_list_t, dest, hlsparse_iframe_stream_inf_term);
 }
 
 /**
@@ -678,19 +645,7 @@ void hlsparse_iframe_stream_inf_list_term(iframe_stream_inf_list_t *dest)
  */
 void hlsparse_stream_inf_list_term(stream_inf_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hlsparse_stream_inf_term(dest->data);
-            hls_free(dest->data);
-        }
-
-        stream_inf_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_stream_inf_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(stream_inf_list_t, dest, hlsparse_stream_inf_term);
 }
 
 /**
@@ -703,18 +658,7 @@ void hlsparse_stream_inf_list_term(stream_inf_list_t *dest)
  */
 void hlsparse_string_list_term(string_list_t *dest)
 {
-    if(dest) {
-        if(dest->data) {
-            hls_free(dest->data);
-        }
-
-        string_list_t *ptr = dest->next;
-
-        if(ptr) {
-            hlsparse_string_list_term(ptr);
-            hls_free(ptr);
-        }
-    }
+    LIST_TERM(string_list_t, dest, string_term);
 }
 
 /**
@@ -781,8 +725,8 @@ int parse_byte_range(
 
     if(src && src[0] != '\0' && dest) {
         int *value = dest ? &dest->n : NULL;
-        pt += parse_str_to_int(pt, value, size);
-        if(*pt == '@') {
+        pt += parse_str_to_int(pt, value, size - (pt - src));
+        if(pt < &src[size] && *pt == '@') {
             ++pt;
             value = dest ? &dest->o : NULL;
             pt += parse_str_to_int(pt, value, size - (pt - src));
@@ -805,33 +749,7 @@ int parse_iframe_stream_inf(
     size_t size,
     iframe_stream_inf_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && src[0] != '\0') {
-        // go through each line parsing the tags
-        const char *pt = src;
-        int dif;
-
-        while(!(*pt == '\0' || *pt == '\r' || *pt == '\n')) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_iframe_stream_inf_tag(
-                          pt,
-                          size - (pt - src),
-                          dest);
-
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the two data points
-        res = pt - src;
-    }
-
-    return res;
+    return parse_attributes(&iframe_stream_inf_schema, src, size, dest, 0);
 }
 
 /**
@@ -846,43 +764,7 @@ int parse_iframe_stream_inf_tag(
     size_t size,
     iframe_stream_inf_t *dest)
 {
-    const char *pt = src;
-
-    if(EQUAL(pt, PROGRAMID)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_int(pt, &dest->program_id, size - (pt - src));
-    } else if(EQUAL(pt, BANDWIDTH)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->bandwidth, size - (pt - src));
-    } else if(EQUAL(pt, AVERAGEBANDWIDTH)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->avg_bandwidth, size - (pt - src));
-    } else if(EQUAL(pt, CODECS)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->codecs, size - (pt - src));
-    } else if(EQUAL(pt, RESOLUTION)) {
-        ++pt; // get past the '=' sign
-        pt += parse_resolution(
-                  pt, size - (pt - src), &dest->resolution);
-    } else if(EQUAL(pt, VIDEO)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->video, size - (pt - src));
-    } else if(EQUAL(pt, URI)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->uri, size - (pt - src));
-    } else if(EQUAL(pt, FRAMERATE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->frame_rate, size - (pt - src));
-    } else if(EQUAL(pt, HDCPLEVEL)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, TYPE0)) {
-            dest->hdcp_level = HDCP_LEVEL_TYPE0;
-        } else if(EQUAL(pt, NONE)) {
-            dest->hdcp_level = HDCP_LEVEL_NONE;
-        }
-    }
-    // return the length of characters we have parsed
-    return pt - src;
+    return parse_attribute(&iframe_stream_inf_schema, src, size, dest, 0);
 }
 
 /**
@@ -902,7 +784,7 @@ int parse_resolution(const char *src, size_t size, resolution_t *dest)
     int width = 0, height = 0;
     pt += parse_str_to_int(pt, &width, size - (pt - src));
 
-    if(*pt == 'x') {
+    if(pt < &src[size] && *pt == 'x') {
         ++pt;
         pt += parse_str_to_int(pt, &height, size - (pt - src));
     }
@@ -924,34 +806,11 @@ int parse_resolution(const char *src, size_t size, resolution_t *dest)
  */
 int parse_key(const char *src, size_t size, hls_key_t *dest)
 {
-    int res = 0;
-
     if(!src || !size || !dest) {
         return 0;
     }
 
-    // make sure we have some data
-    if(src && src[0] != '\0') {
-        // go through each line parsing the tags
-        const char *pt = src;
-        const char *end = &src[size];
-
-        int dif;
-        while(!(*pt == '\0' || *pt == '\r' || *pt == '\n' || pt >= end)) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_key_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
-
-    return res;
+    return parse_attributes(&key_schema, src, size, dest, 0);
 }
 
 /**
@@ -963,35 +822,7 @@ int parse_key(const char *src, size_t size, hls_key_t *dest)
  */
 int parse_key_tag(const char *src, size_t size, hls_key_t *dest)
 {
-    const char *pt = src;
-
-    if(EQUAL(pt, METHOD)) {
-        // get past the '='
-        ++pt;
-        if(EQUAL(pt, "NONE")) {
-            dest->method = KEY_METHOD_NONE;
-        } else if(EQUAL(pt, "AES-128")) {
-            dest->method = KEY_METHOD_AES128;
-        } else if(EQUAL(pt, "SAMPLE-AES")) {
-            dest->method = KEY_METHOD_SAMPLEAES;
-        } else {
-            dest->method = KEY_METHOD_INVALID;
-        }
-    } else if(EQUAL(pt, URI)) {
-        ++pt;
-        pt += parse_attrib_str(pt, &dest->uri, size - (pt - src));
-    } else if(EQUAL(pt, KEY_IV)) {
-        ++pt;
-        pt += parse_attrib_data(pt, &dest->iv, size - (pt - src));
-    } else if(EQUAL(pt, KEYFORMATVERSIONS)) {
-        ++pt;
-        pt += parse_attrib_str(pt, &dest->key_format_versions, size - (pt - src));
-    } else if(EQUAL(pt, KEYFORMAT)) {
-        ++pt;
-        pt += parse_attrib_str(pt, &dest->key_format, size - (pt - src));
-    }
-
-    return pt - src;
+    return parse_attribute(&key_schema, src, size, dest, 0);
 }
 
 /**
@@ -1003,32 +834,7 @@ int parse_key_tag(const char *src, size_t size, hls_key_t *dest)
  */
 int parse_map(const char *src, size_t size, map_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && src[0] != '\0' && size > 0) {
-        // go through each line parsing the tags
-        const char *pt = &src[0];
-
-        int dif;
-        while(!(*pt == '\0' ||
-                *pt == '\r' ||
-                *pt == '\n' ||
-                pt >= &src[size])) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_map_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
-
-    return res;
+    return parse_attributes(&map_schema, src, size, dest, 0);
 }
 
 /**
@@ -1040,22 +846,7 @@ int parse_map(const char *src, size_t size, map_t *dest)
  */
 int parse_map_tag(const char *src, size_t size, map_t *dest)
 {
-    if(!src || !size || !dest) {
-        return 0;
-    }
-
-    const char *pt = src;
-
-    if(EQUAL(pt, URI)) {
-        ++pt;
-        parse_attrib_str(pt, &dest->uri, size - (pt - src));
-    } else if(EQUAL(pt, BYTERANGE)) {
-        // get past the ="
-        pt += 2;
-        pt += parse_byte_range(pt, size - (pt - src), &dest->byte_range);
-    }
-
-    return pt - src;
+    return parse_attribute(&map_schema, src, size, dest, 0);
 }
 
 /**
@@ -1067,32 +858,21 @@ int parse_map_tag(const char *src, size_t size, map_t *dest)
  */
 int parse_daterange(const char *src, size_t size, daterange_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && src[0] != '\0' && size > 0) {
-        // go through each line parsing the tags
-        const char *pt = &src[0];
-
-        int dif;
-        while(!(*pt == '\0' ||
-                *pt == '\r' ||
-                *pt == '\n' ||
-                pt >= &src[size])) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_daterange_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
+    return parse_daterange_fields(src, size, dest, DATERANGE_ATTR_ALL);
+}
 
-    return res;
+/**
+ * Parses only the attributes of an HLS daterange tag selected by \a fields,
+ * the others are stepped over exactly as parse_daterange would.
+ *
+ * @param src The srouce of the HLS src
+ * @param size The length of the src string
+ * @param dest The destination object to write the properties to
+ * @param fields DATERANGE_ATTR_* flags of the attributes to parse
+ */
+int parse_daterange_fields(const char *src, size_t size, daterange_t *dest, int fields)
+{
+    return parse_attributes(&daterange_schema, src, size, dest, fields);
 }
 
 /**
@@ -1101,104 +881,11 @@ int parse_daterange(const char *src, size_t size, daterange_t *dest)
  * @param src The HLS source string
  * @param size The size of the source string
  * @param dest The destination object to write the value to
+ * @param fields DATERANGE_ATTR_* flags of the attributes to write, others are only stepped over
  */
-int parse_daterange_tag(const char *src, size_t size, daterange_t *dest)
+int parse_daterange_tag(const char *src, size_t size, daterange_t *dest, int fields)
 {
-    if(!src || !size || !dest) {
-        return 0;
-    }
-
-    const char *pt = src;
-
-    if(EQUAL(pt, ID)) {
-        ++pt;
-        pt += parse_attrib_str(pt, &dest->id, size - (pt - src));
-    } else if(EQUAL(pt, CLASS)) {
-        ++pt;
-        pt += parse_attrib_str(pt, &dest->klass, size - (pt - src));
-    } else if(EQUAL(pt, STARTDATE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_date(pt, &dest->start_date, size - (pt - src));
-    } else if(EQUAL(pt, ENDDATE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_date(pt, &dest->end_date, size - (pt - src));
-    } else if(EQUAL(pt, DURATION)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->duration, size - (pt - src));
-    } else if(EQUAL(pt, PLANNEDDURATION)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->planned_duration, size - (pt - src));
-    } else if(EQUAL(pt, SCTE35CMD)) {
-        ++pt; // get past the '=' sign
-        dest->scte35_cmd_size = parse_attrib_data(pt, &dest->scte35_cmd, size - (pt - src));
-        pt += dest->scte35_cmd_size;
-        dest->scte35_cmd_size = (dest->scte35_cmd_size - 2) / 2; // minus '0x' / 2 characters per byte e.g. 'AA'
-    } else if(EQUAL(pt, SCTE35OUT)) {
-        ++pt; // get past the '=' sign
-        dest->scte35_out_size = parse_attrib_data(pt, &dest->scte35_out, size - (pt - src));
-        pt += dest->scte35_out_size;
-        dest->scte35_out_size = (dest->scte35_out_size - 2) / 2; // minus '0x' / 2 characters per byte e.g. 'AA'
-    } else if(EQUAL(pt, SCTE35IN)) {
-        ++pt; // get past the '=' sign
-        dest->scte35_in_size = parse_attrib_data(pt, &dest->scte35_in, size - (pt - src));
-        pt += dest->scte35_in_size;
-        dest->scte35_in_size = (dest->scte35_in_size - 2) / 2; // minus '0x' / 2 characters per byte e.g. 'AA'
-    } else if(EQUAL(pt, ENDONNEXT)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, YES)) {
-            dest->end_on_next = HLS_TRUE;
-        } else if(EQUAL(pt, NO)) {
-            dest->end_on_next = HLS_FALSE;
-        }
-    } else if(pt[0] == 'X' && pt[1] == '-') {
-        // custom client parameter
-        // find the '=' sign so we know where the key ends
-        const char *tmp = pt+1;
-        while(*tmp != '=' && *tmp != '\n' && tmp != '\0' ) {
-            ++tmp;
-        }
-        // get the key string
-        if(tmp - pt > 1) {
-            param_list_t *param = NULL;
-            // use the base client_attributes if there are no values stored.
-            if(dest->client_attributes.value_type == PARAM_TYPE_NONE) {
-                param = &dest->client_attributes;
-            }else{
-                // allocate a new parameter.
-                param = (param_list_t*) hls_malloc(sizeof(param_list_t));
-                hlsparse_param_list_init(param);
-                // find the last value in the link list, we'll attach the new one
-                // to this one's "next" property.
-                param_list_t *prev = &dest->client_attributes;
-                while(prev->next) {
-                    prev = prev->next;
-                }
-                // link the param onto the list.
-                prev->next = param;
-            }
-            // duplicate the string to create the new key
-            param->key = str_utils_ndup(pt, tmp-pt);
-            // find the new value string
-            pt = tmp + 1; // get past the '='
-            if(*pt == '"') {
-                param->value_type = PARAM_TYPE_STRING;
-                param->value_size = parse_attrib_str(pt, &param->value.data, size - (pt - src));
-                pt += param->value_size;
-                param->value_size--; // parse always parses an extra end byte
-            }else if(*pt == '0' && (pt[1] == 'x' || pt[1] == 'X')) {
-                param->value_type = PARAM_TYPE_DATA;
-                param->value_size = parse_attrib_data(pt, &param->value.data, size - (pt - src));
-                pt += param->value_size;
-                param->value_size = (param->value_size - 2) / 2; // minus '0x' / 2 bytes per character
-            }else{
-                param->value_type = PARAM_TYPE_FLOAT;
-                pt += parse_str_to_float(pt, &param->value.number, size - (pt - src));
-                param->value_size = 0;
-            }
-        }
-    }
-
-    return pt - src;
+    return parse_attribute(&daterange_schema, src, size, dest, fields);
 }
 
 /**
@@ -1207,91 +894,11 @@ int parse_daterange_tag(const char *src, size_t size, daterange_t *dest)
  * @param src The HLS source string
  * @param size The size of the source string
  * @param dest The destination object to write the value to
+ * @param fields MEDIA_ATTR_* flags of the attributes to write, others are only stepped over
  */
-int parse_media_tag(const char *src, size_t size, media_t *dest)
+int parse_media_tag(const char *src, size_t size, media_t *dest, int fields)
 {
-    if(!src || !size || !dest) {
-        return 0;
-    }
-
-    const char *pt = src;
-
-    if(EQUAL(pt, TYPE)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, VIDEO)) {
-            dest->type = MEDIA_TYPE_VIDEO;
-        } else if(EQUAL(pt, AUDIO)) {
-            dest->type = MEDIA_TYPE_AUDIO;
-        } else if(EQUAL(pt, SUBTITLES)) {
-            dest->type = MEDIA_TYPE_SUBTITLES;
-        } else if(EQUAL(pt, CLOSEDCAPTIONS)) {
-            dest->type = MEDIA_TYPE_CLOSEDCAPTIONS;
-        } else {
-            dest->type = MEDIA_TYPE_INVALID;
-        }
-    } else if(EQUAL(pt, GROUPID)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->group_id, size - (pt - src));
-    } else if(EQUAL(pt, NAME)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->name, size - (pt - src));
-    } else if(EQUAL(pt, AUTOSELECT)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, YES)) {
-            dest->auto_select = HLS_TRUE;
-        } else if(EQUAL(pt, NO)) {
-            dest->auto_select = HLS_FALSE;
-        }
-    } else if(EQUAL(pt, FORCED)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, YES)) {
-            dest->forced = HLS_TRUE;
-        } else if(EQUAL(pt, NO)) {
-            dest->forced = HLS_FALSE;
-        }
-    } else if(EQUAL(pt, DEFAULT)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, YES)) {
-            dest->is_default = HLS_TRUE;
-        } else if(EQUAL(pt, NO)) {
-            dest->is_default = HLS_FALSE;
-        }
-    } else if(EQUAL(pt, LANGUAGE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->language, size - (pt - src));
-    } else if(EQUAL(pt, ASSOCLANGUAGE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->assoc_language, size - (pt - src));
-    } else if(EQUAL(pt, URI)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->uri, size - (pt - src));
-    } else if(EQUAL(pt, INSTREAMID)) {
-        pt += 2; // get past the '=' and the '"'
-        if(EQUAL(pt, CC1)) {
-            dest->instream_id = MEDIA_INSTREAMID_CC1;
-        } else if(EQUAL(pt, CC2)) {
-            dest->instream_id = MEDIA_INSTREAMID_CC2;
-        } else if(EQUAL(pt, CC3)) {
-            dest->instream_id = MEDIA_INSTREAMID_CC3;
-        } else if(EQUAL(pt, CC4)) {
-            dest->instream_id = MEDIA_INSTREAMID_CC4;
-        } else if(EQUAL(pt, SERVICE)) {
-            dest->instream_id = MEDIA_INSTREAMID_SERVICE;
-            pt += parse_str_to_int(pt, &dest->service_n, size - (pt - src));
-        } else {
-            dest->instream_id = MEDIA_INSTREAMID_INVALID;
-        }
-    } else if(EQUAL(pt, CHARACTERISTICS)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->characteristics, size - (pt - src));
-    } else if(EQUAL(pt, CHANNELS)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->channels, size - (pt - src));
-    } else {
-        // custom tags?
-    }
-
-    return pt - src;
+    return parse_attribute(&media_schema, src, size, dest, fields);
 }
 
 /**
@@ -1303,28 +910,21 @@ int parse_media_tag(const char *src, size_t size, media_t *dest)
  */
 int parse_media(const char *src, size_t size, media_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && (src[0] != '\0')) {
-        // go through each line parsing the tags
-        const char *pt = &src[0];
-        int dif;
-        while(!(*pt == '\0' || *pt == '\r' || *pt == '\n' || pt >= &src[size])) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_media_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
+    return parse_media_fields(src, size, dest, MEDIA_ATTR_ALL);
+}
 
-    return res;
+/**
+ * Parses only the attributes of an HLS media tag selected by \a fields,
+ * the others are stepped over exactly as parse_media would.
+ *
+ * @param src The srouce of the HLS src
+ * @param size The length of the src string
+ * @param dest The destination object to write the properties to
+ * @param fields MEDIA_ATTR_* flags of the attributes to parse
+ */
+int parse_media_fields(const char *src, size_t size, media_t *dest, int fields)
+{
+    return parse_attributes(&media_schema, src, size, dest, fields);
 }
 
 /**
@@ -1334,6 +934,20 @@ int parse_media(const char *src, size_t size, media_t *dest)
  * @param size The length of src
  */
 int parse_segment(const char *src, size_t size, segment_t *dest)
+{
+    return parse_segment_fields(src, size, dest, 0);
+}
+
+/**
+ * Parses an HLS EXTINF tag stepping over the data named by \a skip_fields.
+ *
+ * @param src The raw EXTINF data to parse.
+ * @param size The length of src
+ * @param dest The segment to write the duration and title into, its pdt_end is
+ * set from its pdt and the duration in whole milliseconds
+ * @param skip_fields PARSE_FIELD_* flags of the data to step over
+ */
+int parse_segment_fields(const char *src, size_t size, segment_t *dest, int skip_fields)
 {
     int res = 0;
 
@@ -1348,7 +962,7 @@ int parse_segment(const char *src, size_t size, segment_t *dest)
             if(*pt == ',' || *pt == '=' || *pt == '\r' || *pt == '#') {
                 ++pt;
             } else {
-                dif = parse_segment_tag(pt, size - (pt - src), dest);
+                dif = parse_segment_tag(pt, size - (pt - src), dest, skip_fields);
                 pt += dif > 0 ? dif : 1;
             }
         }
@@ -1379,7 +993,7 @@ int parse_segment_uri(const char *src, size_t size, media_playlist_t *dest)
         // return the difference between the 2 data points
         res = pt - src;
 
-        if(segment->uri) {
+        if(segment->uri && !(dest->skip_fields & PARSE_FIELD_RESOLVED_URIS)) {
             path_combine(&segment->uri, dest->uri, segment->uri);
         }
 
@@ -1410,8 +1024,9 @@ int parse_segment_uri(const char *src, size_t size, media_playlist_t *dest)
  * @param src The HLS source string
  * @param size The size of the source string
  * @param dest The destination object to write the value to
+ * @param skip_fields PARSE_FIELD_* flags of the data to step over
  */
-int parse_segment_tag(const char *src, size_t size, segment_t *dest)
+int parse_segment_tag(const char *src, size_t size, segment_t *dest, int skip_fields)
 {
     const char *pt = src;
 
@@ -1424,11 +1039,15 @@ int parse_segment_tag(const char *src, size_t size, segment_t *dest)
         ++pt;
     }
 
-    pt += parse_str_to_float(pt, &dest->duration, size - (pt - src));
+    double duration = 0.;
+    int64_t ms = 0;
+    pt += parse_str_to_duration(pt, &duration, &ms, size - (pt - src));
+    dest->duration = (float)duration;
+    dest->pdt_end = dest->pdt + ms;
 
     if(*pt == ',') {
         ++pt;
-        pt += parse_line_to_str(pt, &dest->title, size - (pt - src));
+        pt += parse_line_to_str(pt, skip_fields & PARSE_FIELD_TITLES ? NULL : &dest->title, size - (pt - src));
     }
 
     return pt - src;
@@ -1443,28 +1062,7 @@ int parse_segment_tag(const char *src, size_t size, segment_t *dest)
  */
 int parse_session_data(const char*src, size_t size, session_data_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && src[0] != '\0' && size > 0) {
-        // go through each line parsing the tags
-        const char *pt = &src[0];
-        int dif;
-        while(!(*pt == '\0' || *pt == '\r' || *pt == '\n' || pt >= &src[size])) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_session_data_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
-
-    return res;
+    return parse_attributes(&session_data_schema, src, size, dest, 0);
 }
 
 /**
@@ -1476,29 +1074,7 @@ int parse_session_data(const char*src, size_t size, session_data_t *dest)
  */
 int parse_session_data_tag(const char *src, size_t size, session_data_t *dest)
 {
-    if(!src || !size || !dest) {
-        return 0;
-    }
-
-    const char *pt = src;
-
-    if(EQUAL(pt, DATAID)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->data_id, size - (pt - src));
-    } else if(EQUAL(pt, VALUE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->value, size - (pt - src));
-    } else if(EQUAL(pt, URI)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->uri, size - (pt - src));
-    } else if(EQUAL(pt, LANGUAGE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->language, size - (pt - src));
-    } else {
-        // custom tags?
-    }
-
-    return pt - src;
+    return parse_attribute(&session_data_schema, src, size, dest, 0);
 }
 
 /**
@@ -1554,29 +1130,21 @@ int parse_start(const char *src, size_t size, start_t* dest)
  */
 int parse_stream_inf(const char *src, size_t size, stream_inf_t *dest)
 {
-    int res = 0;
-
-    // make sure we have some data
-    if(src && src[0] != '\0') {
-        // go through each line parsing the tags
-        const char *pt = src;
-
-        int dif;
-        while(!(*pt == '\0' || *pt == '\r' || *pt == '\n' || pt >= &src[size])) {
-            // skip comma characters in between the attributes
-            if(*pt == ',' || *pt == '=' || *pt == ':') {
-                ++pt;
-            } else {
-                dif = parse_stream_inf_tag(pt, size - (pt - src), dest);
-                pt += dif > 0 ? dif : 1;
-            }
-        }
-
-        // return the difference between the 2 data points
-        res = pt - src;
-    }
+    return parse_stream_inf_fields(src, size, dest, STREAM_INF_ATTR_ALL);
+}
 
-    return res;
+/**
+ * Parses only the attributes of an HLS stream inf tag selected by \a fields,
+ * the others are stepped over exactly as parse_stream_inf would.
+ *
+ * @param src The HLS source string
+ * @param size The size of the source string
+ * @param dest The destination object to write the value to
+ * @param fields STREAM_INF_ATTR_* flags of the attributes to parse
+ */
+int parse_stream_inf_fields(const char *src, size_t size, stream_inf_t *dest, int fields)
+{
+    return parse_attributes(&stream_inf_schema, src, size, dest, fields);
 }
 
 /**
@@ -1585,58 +1153,9 @@ int parse_stream_inf(const char *src, size_t size, stream_inf_t *dest)
  * @param src The HLS source string
  * @param size The size of the source string
  * @param dest The destination object to write the value to
+ * @param fields STREAM_INF_ATTR_* flags of the attributes to write, others are only stepped over
  */
-int parse_stream_inf_tag(const char *src, size_t size, stream_inf_t *dest)
+int parse_stream_inf_tag(const char *src, size_t size, stream_inf_t *dest, int fields)
 {
-    if(!src || !size || !dest) {
-        return 0;
-    }
-
-    const char *pt = src;
-
-    if(EQUAL(pt, PROGRAMID)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_int(pt, &dest->program_id, size - (pt - src));
-    } else if(EQUAL(pt, BANDWIDTH)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->bandwidth, size - (pt - src));
-    } else if(EQUAL(pt, AVERAGEBANDWIDTH)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->avg_bandwidth, size - (pt - src));
-    } else if(EQUAL(pt, CODECS)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->codecs, size - (pt - src));
-    } else if(EQUAL(pt, RESOLUTION)) {
-        ++pt; // get past the '=' sign
-        pt += parse_resolution(pt, size - (pt - src), &dest->resolution);
-    } else if(EQUAL(pt, AUDIO)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->audio, size - (pt - src));
-    } else if(EQUAL(pt, VIDEO)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->video, size - (pt - src));
-    } else if(EQUAL(pt, SUBTITLES)) {
-        ++pt; // get past the '=' sign
-        pt += parse_attrib_str(pt, &dest->subtitles, size - (pt - src));
-    } else if(EQUAL(pt, CLOSEDCAPTIONS)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, NONE)) {
-            dest->closed_captions = str_utils_dup(NONE);
-        }else{
-            pt += parse_attrib_str(pt, &dest->closed_captions, size - (pt - src));
-        }
-    } else if(EQUAL(pt, FRAMERATE)) {
-        ++pt; // get past the '=' sign
-        pt += parse_str_to_float(pt, &dest->frame_rate, size - (pt - src));
-    } else if(EQUAL(pt, HDCPLEVEL)) {
-        ++pt; // get past the '=' sign
-        if(EQUAL(pt, TYPE0)) {
-            dest->hdcp_level = HDCP_LEVEL_TYPE0;
-        } else if(EQUAL(pt, NONE)) {
-            dest->hdcp_level = HDCP_LEVEL_NONE;
-        }
-    }
-
-    // return the length of characters we have parsed
-    return pt - src;
+    return parse_attribute(&stream_inf_schema, src, size, dest, fields);
 }
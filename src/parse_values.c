@@ -43,6 +43,232 @@ int parse_line_to_str(const char *src, char **dest, size_t size)
     return dest_size;
 }
 
+/*
+ * Decimal kernels
+ *
+ * The numbers are kept as an exact decimal, an integer mantissa and a power
+ * of ten, until they're rounded once into the destination's type. The first 8
+ * digits are read one at a time, which is quickest for the short numbers most
+ * playlists hold, the rest of a longer number, e.g. a byte range offset, is
+ * read as 64 bit words of 8 digits, each combined into its value in 3
+ * multiplies with SWAR (SIMD within a register).
+ */
+
+#define SWAR_ONES       0x0101010101010101ULL
+#define MAX_DIGITS      19  // the most digits which always fit in a uint64_t
+
+#define IS_DIGIT(c)     ((c) >= '0' && (c) <= '9')
+
+static const uint64_t pow10_u64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// the powers of ten a double holds exactly
+static const double pow10_f64[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+typedef struct {
+    uint64_t mantissa;
+    int exponent;       // the value is mantissa * 10^exponent
+    bool_t negative;
+} decimal_t;
+
+// the 8 characters at src with the first in the low byte
+static inline uint64_t load8(const char *src)
+{
+    uint64_t v;
+    memcpy(&v, src, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// whether all 8 characters in v are '0' to '9'
+static inline bool_t swar_is_eight_digits(uint64_t v)
+{
+    return ((v & (SWAR_ONES * 0xF0)) | (((v + SWAR_ONES * 0x06) & (SWAR_ONES * 0xF0)) >> 4)) == SWAR_ONES * 0x33;
+}
+
+// the value of the 8 digits in v
+static inline uint64_t swar_eight_digits(uint64_t v)
+{
+    v -= SWAR_ONES * '0';
+    v = (v * 10) + (v >> 8);
+    return (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+            (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+}
+
+/**
+ * Adds the digits at \a src onto the end of \a value, which wraps around
+ * past 19 digits. Short numbers are quickest a digit at a time, once a number
+ * is 8 digits long the rest of it is read 8 digits at a time.
+ *
+ * @returns the number of digits read
+ */
+static inline int parse_digits(const char *src, const char *end, uint64_t *value)
+{
+    const char *pt = src;
+    const char *stop = end - src > 8 ? &src[8] : end;
+    uint64_t v = *value;
+
+    while(pt < stop && IS_DIGIT(*pt)) {
+        v = v * 10 + (*pt - '0');
+        ++pt;
+    }
+
+    if(pt == &src[8]) {
+        while(end - pt >= 8) {
+            uint64_t word = load8(pt);
+            if(!swar_is_eight_digits(word)) {
+                break;
+            }
+            v = v * 100000000ULL + swar_eight_digits(word);
+            pt += 8;
+        }
+        while(pt < end && IS_DIGIT(*pt)) {
+            v = v * 10 + (*pt - '0');
+            ++pt;
+        }
+    }
+
+    *value = v;
+    return pt - src;
+}
+
+/**
+ * Adds the digits at \a src onto the end of \a dec keeping only the first
+ * MAX_DIGITS significant ones, the others are counted in \a dropped.
+ *
+ * @param digits The significant digits in the mantissa
+ * @returns the number of digits read
+ */
+static int parse_long_digits(const char *src, const char *end, decimal_t *dec, int *digits, int *dropped)
+{
+    const char *pt = src;
+    while(pt < end && IS_DIGIT(*pt)) {
+        if(*digits < MAX_DIGITS) {
+            dec->mantissa = dec->mantissa * 10 + (*pt - '0');
+            *digits += dec->mantissa != 0;
+        } else {
+            ++*dropped;
+        }
+        ++pt;
+    }
+    return pt - src;
+}
+
+/**
+ * Parses a decimal number with more digits than fit in the mantissa, see
+ * parse_decimal.
+ */
+static int parse_long_decimal(const char *src, size_t size, decimal_t *dec)
+{
+    const char *pt = src;
+    const char *end = &src[size];
+    int digits = 0;
+    int dropped = 0;
+
+    dec->mantissa = 0;
+    dec->negative = *pt == '-';
+    if(dec->negative) {
+        ++pt;
+    }
+
+    // the integer digits past the kept ones still count towards the value
+    pt += parse_long_digits(pt, end, dec, &digits, &dropped);
+    dec->exponent = dropped;
+
+    if(pt < end && *pt == '.') {
+        ++pt;
+        dropped = 0;
+        int len = parse_long_digits(pt, end, dec, &digits, &dropped);
+        dec->exponent -= len - dropped;
+        pt += len;
+    }
+
+    return pt - src;
+}
+
+/**
+ * Parses an optionally signed decimal number, e.g. "-12.500", into an exact
+ * mantissa and power of ten.
+ *
+ * @returns the number of characters parsed
+ */
+static inline int parse_decimal(const char *src, size_t size, decimal_t *dec)
+{
+    const char *pt = src;
+    const char *end = &src[size];
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool_t negative = *pt == '-';
+
+    if(negative) {
+        ++pt;
+    }
+
+    int nb_digits = parse_digits(pt, end, &mantissa);
+    pt += nb_digits;
+
+    if(pt < end && *pt == '.') {
+        ++pt;
+        int len = parse_digits(pt, end, &mantissa);
+        exponent = -len;
+        nb_digits += len;
+        pt += len;
+    }
+
+    if(nb_digits > MAX_DIGITS) {
+        // the mantissa has wrapped around
+        return parse_long_decimal(src, size, dec);
+    }
+
+    dec->mantissa = mantissa;
+    dec->exponent = exponent;
+    dec->negative = negative;
+    return pt - src;
+}
+
+/**
+ * Rounds \a dec to the nearest double. The conversion is exact when the
+ * mantissa fits in the double's 53 bits and the power of ten is one a double
+ * holds exactly, which covers the values in a playlist, longer mantissas go
+ * through a long double, where it has a 64 bit mantissa, so are only rounded
+ * twice.
+ */
+static inline double decimal_to_double(const decimal_t *dec)
+{
+    int exponent = dec->exponent;
+    double value;
+
+    if(dec->mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        // signed converts in one instruction
+        value = (double)(int64_t)dec->mantissa;
+        value = exponent < 0 ? value / pow10_f64[-exponent] : value * pow10_f64[exponent];
+    } else {
+        long double wide = (long double)dec->mantissa;
+        while(exponent > 22) {
+            wide *= 1e22L;
+            exponent -= 22;
+        }
+        while(exponent < -22) {
+            wide /= 1e22L;
+            exponent += 22;
+        }
+        wide = exponent < 0 ? wide / (long double)pow10_f64[-exponent] : wide * (long double)pow10_f64[exponent];
+        value = (double)wide;
+    }
+
+    return dec->negative ? -value : value;
+}
+
 /**
  * Parses the number represented as a string from \a src and writes it
  * into the \a dest pointer
@@ -54,28 +280,24 @@ int parse_line_to_str(const char *src, char **dest, size_t size)
 int parse_str_to_int(const char *src, int *dest, size_t size)
 {
     const char* pt = src;
-    int value = 0;
-    int sign = 1;
+    uint64_t value = 0;
 
     if(!src || size == 0) {
         return 0;
     }
 
     // parse the minus sign
-    if(*pt == '-') {
-        sign = -1;
+    bool_t negative = *pt == '-';
+    if(negative) {
         ++pt;
     }
 
     // parse the number
-    while(*pt >= '0' && *pt <= '9' && pt < &src[size]) {
-        value = (value * 10) + (*pt - '0');
-        ++pt;
-    }
+    pt += parse_digits(pt, &src[size], &value);
 
     // set the value
     if(dest) {
-        *dest = value * sign;
+        *dest = (int)(negative ? 0 - value : value);
     }
     // return how how forward we moved in the string
     return pt - src;
@@ -91,45 +313,93 @@ int parse_str_to_int(const char *src, int *dest, size_t size)
  */
 int parse_str_to_float(const char *src, float *dest, size_t size)
 {
-    const char *pt = src;
-    float value = 0.f;
-    float fraction = 0.f;
-    float sign = 1.f;
+    decimal_t dec;
 
     if(!src || size == 0) {
         return 0;
     }
 
-    // parse the minus sign
-    if(*pt == '-') {
-        sign = -1.f;
-        ++pt;
-    }
+    int len = parse_decimal(src, size, &dec);
 
-    // parse the floating point number before the decimal point
-    while(*pt >= '0' && *pt <= '9' && pt < &src[size]) {
-        value = (value * 10) + (*pt - '0');
-        ++pt;
+    // set the value
+    if(dest) {
+        *dest = (float)decimal_to_double(&dec);
     }
+    // return how how forward we moved in the string
+    return len;
+}
 
-    // parse the decimal point
-    if(pt < &src[size] && *pt == '.') {
-        ++pt;
-        float divis = 1.f;
-        while(*pt >= '0' && *pt <= '9' && pt < &src[size]) {
-            fraction = (fraction * 10.f) + (float)(*pt - '0');
-            divis *= 10.f;
-            ++pt;
+/**
+ * Rounds the exact decimal \a dec to a whole number of ticks of 10^-decimals,
+ * half away from zero.
+ */
+static inline int64_t decimal_to_ticks(const decimal_t *dec, int decimals)
+{
+    int exponent = dec->exponent + decimals;
+    uint64_t ticks = 0;
+    if(exponent >= 0) {
+        ticks = exponent < MAX_DIGITS ? dec->mantissa * pow10_u64[exponent] : 0;
+    } else if(-exponent <= MAX_DIGITS) {
+        uint64_t scale = pow10_u64[-exponent];
+        ticks = dec->mantissa / scale;
+        if(dec->mantissa % scale >= scale - scale / 2) {
+            ++ticks;
         }
-        fraction = fraction / divis;
     }
+    return dec->negative ? -(int64_t)ticks : (int64_t)ticks;
+}
 
-    // set the value
+/**
+ * Parses the decimal number at \a src as a whole number of ticks of
+ * 10^-decimals, e.g. seconds as milliseconds with 3 decimals, rounding half
+ * away from zero without going through a floating-point type.
+ *
+ * @param src The text source to read
+ * @param dest The destination to write the number of ticks into
+ * @param decimals The number of decimal places in a tick, 0 to 9
+ * @param size The length of the text source
+ */
+int parse_str_to_ticks(const char *src, int64_t *dest, int decimals, size_t size)
+{
+    decimal_t dec;
+
+    if(!src || size == 0) {
+        return 0;
+    }
+
+    int len = parse_decimal(src, size, &dec);
     if(dest) {
-        *dest = sign * (value + fraction);
+        *dest = decimal_to_ticks(&dec, decimals);
     }
-    // return how how forward we moved in the string
-    return pt - src;
+    return len;
+}
+
+/**
+ * Parses a duration in seconds, e.g. an EXTINF's, from \a src into both its
+ * seconds as a double and its milliseconds, each rounded once from the exact
+ * decimal so the program date times derived from it don't drift.
+ *
+ * @param src The text source to read
+ * @param dest The destination to write the seconds into, may be NULL
+ * @param ms The destination to write the milliseconds into, may be NULL
+ * @param size The length of the text source
+ */
+int parse_str_to_duration(const char *src, double *dest, int64_t *ms, size_t size)
+{
+    decimal_t dec;
+
+    if(!src || size == 0) {
+        return 0;
+    }
+
+    int len = parse_decimal(src, size, &dec);
+    if(dest) {
+        *dest = decimal_to_double(&dec);
+    }
+    if(ms) {
+        *ms = decimal_to_ticks(&dec, 3);
+    }
+    return len;
 }
 
 /**
@@ -164,7 +434,7 @@ int parse_date(const char *src, uint64_t *dest, size_t size)
     const char* end = &src[size];
 
     int year = 0, month = 0, day = 0, hours = 0, mins = 0, tzd = 0;
-    float secs = 0.f;
+    int64_t ms = 0;
     int is_utc = 0;
 
     // Parse the year
@@ -215,7 +485,7 @@ int parse_date(const char *src, uint64_t *dest, size_t size)
             if(len == 2) {
                 if(*pt == ':' && pt < end) {
                     ++pt;
-                    len = parse_str_to_float(pt, &secs, size - (pt - src));
+                    len = parse_str_to_ticks(pt, &ms, 3, size - (pt - src));
                     pt += len;
                 }
             } else {
@@ -307,7 +577,7 @@ int parse_date(const char *src, uint64_t *dest, size_t size)
         break;
     }
 
-    uint64_t time = ((((((total_days * 24ULL) + (hours)) * 60ULL) + mins) * 60ULL) * 1000ULL) + (uint64_t)(secs * 1000.f);
+    uint64_t time = ((((((total_days * 24ULL) + (hours)) * 60ULL) + mins) * 60ULL) * 1000ULL) + ms;
     time -= (tzd * 60000ULL); // convert time zone minutes into ms
     time -= 62167219200000; // Minus ms since Midnight 1/1/1970
 
@@ -361,9 +631,6 @@ int parse_attrib_str(const char *src, char **dest, size_t size)
 int parse_attrib_data(const char *src, char **dest, size_t size)
 {
     const char *pt = src;
-    uint8_t buffer[16];
-    int buf_size = 16;
-    int idx = 0;
 
     if(!src || !size) {
         return 0;
@@ -372,57 +639,100 @@ int parse_attrib_data(const char *src, char **dest, size_t size)
     // the data HAS to start with '0x' or '0X'
     if (*pt == '0' && (pt[1] == 'x' || pt[1] == 'X')) {
         pt += 2;
+        const char *start = pt;
         const char *end = &src[size];
-        uint8_t value = 0;
-
-        // every 2 bytes calculate the next value
-        for (int i = 0; pt < end; ++i) {
-            uint8_t tmp_value = 0;
-            if (*pt >= '0' && *pt <= '9') {
-                tmp_value = *pt - '0';
-            } else if (*pt >= 'a' && *pt <= 'f') {
-                tmp_value = (*pt - 'a') + 10;
-            } else if (*pt >= 'A' && *pt <= 'F') {
-                tmp_value = (*pt - 'A') + 10;
-            } else {
-                // there is a problem, we could just be at the end
-                // of the data, break out!
-                break;
-            }
+
+        // find the end of the data first so it can be allocated in one go,
+        // the data is binary and may contain zeros so it can't be appended
+        // to as a string
+        while(pt < end && ((*pt >= '0' && *pt <= '9') ||
+                           (*pt >= 'a' && *pt <= 'f') ||
+                           (*pt >= 'A' && *pt <= 'F'))) {
             ++pt;
+        }
 
-            // every 2nd character finishes the byte
-            if (i % 2 == 0) {
-                value = tmp_value;
-            } else {
-                value = (value * 16) + tmp_value;
-                // add the next value to the buffer
-                buffer[idx] = value;
-                ++idx;
-                // if we've exhausted the buffer, add it to the output
-                if (idx == buf_size) {
-                    if(!(*dest)) {
-                        *dest = str_utils_ndup((char *)buffer, idx);
-                    } else {
-                        *dest = str_utils_nappend(*dest, (char *)buffer, idx);
+        // every 2 characters make a byte, a trailing odd character is ignored
+        size_t nb_bytes = (pt - start) / 2;
+        if (dest && nb_bytes > 0) {
+            char *data = hls_malloc(nb_bytes + 1);
+            if(data) {
+                size_t i;
+                for(i = 0; i < nb_bytes; ++i) {
+                    uint8_t value = 0;
+                    int j;
+                    for(j = 0; j < 2; ++j) {
+                        char c = start[i * 2 + j];
+                        uint8_t tmp_value = c <= '9' ? c - '0' : (c >= 'a' ? c - 'a' : c - 'A') + 10;
+                        value = (value * 16) + tmp_value;
                     }
-                    // reset the buffer index
-                    idx = 0;
+                    data[i] = (char)value;
+                }
+                data[nb_bytes] = '\0';
+                if(*dest) {
+                    hls_free(*dest);
                 }
+                *dest = data;
             }
         }
     }
 
-    // add any remaining data to the string
-    if (dest && idx > 0) {
-        if(!(*dest)) {
-            *dest = str_utils_ndup((char*)buffer, idx);
+    // return the length of parsed values
+    return pt - src;
+}
+
+/**
+ * Finds the value of an attribute in the attribute list [src, end) without
+ * allocating. Quoted values are returned without their quotes.
+ *
+ * @param src The attribute list, just past the ':' of its tag
+ * @param end The end of the attribute list
+ * @param name The name of the attribute
+ * @param size Set to the length of the value
+ * @returns the value, or NULL if the list doesn't hold the attribute
+ */
+const char *parse_attrib_find(const char *src, const char *end, const char *name, size_t *size)
+{
+    const char *pt = src;
+    size_t name_len = strlen(name);
+
+    while(pt < end) {
+        const char *key = pt;
+        while(pt < end && *pt != '=' && *pt != ',') {
+            ++pt;
+        }
+        size_t key_len = pt - key;
+        if(pt >= end || *pt == ',') {
+            ++pt;
+            continue;
+        }
+
+        ++pt; // get past the '='
+        const char *value = pt;
+        if(pt < end && *pt == '"') {
+            value = ++pt;
+            while(pt < end && *pt != '"') {
+                ++pt;
+            }
+            *size = pt - value;
+            if(pt < end) {
+                ++pt;
+            }
         } else {
-            *dest = str_utils_nappend(*dest, (char *)buffer, idx);
+            while(pt < end && *pt != ',') {
+                ++pt;
+            }
+            *size = pt - value;
+        }
+
+        if(key_len == name_len && 0 == strncmp(key, name, name_len)) {
+            return value;
+        }
+
+        while(pt < end && *pt != ',') {
+            ++pt;
         }
+        ++pt;
     }
 
-    // return the length of parsed values
-    return pt - src;
+    return NULL;
 }
-
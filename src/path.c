@@ -15,6 +15,8 @@
  *\param dest The output string where the combined path is set.
  *\param base The Base URI.
  *\param path The path to combine onto base.
+ * A string already held by dest is freed when it is replaced, so path may be
+ * the current value of *dest.
  * Within a representation with a well defined base URI of
  *
  *     http://a/b/c/d;p?q
@@ -87,8 +89,8 @@ char *path_combine(char **dest, const char *base, const char *path)
                 ++p_base;
             }
 
-            if(path_protocol) {
-                // if a protocol exists, return the path
+            if(path_protocol || (!last_sep && path[0] != '?' && path[0] != '#')) {
+                // if a protocol exists, or base has no directory, return the path
                 out_dest = str_utils_dup(path);
             } else if(path[0] == '.') {
                 // parse all the combinations where the path begins with a dot
@@ -158,6 +160,9 @@ char *path_combine(char **dest, const char *base, const char *path)
     }
 
     if(dest) {
+        if(*dest && *dest != out_dest) {
+            hls_free(*dest);
+        }
         *dest = out_dest;
     }
 
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#ifndef _HLSPARSE_PROBES_H
+#define _HLSPARSE_PROBES_H
+
+/*
+ * USDT static tracepoints
+ *
+ * Built with USDT=1 the library carries the probes below under the
+ * 'hlsparse' provider, e.g.
+ *
+ *   bpftrace -e 'usdt:./app:hlsparse:media_tag { @[arg0] = count(); }'
+ *
+ * An inactive probe is a single nop and its arguments are values the
+ * surrounding code has already computed, so the probes can be left in
+ * production builds. Without USDT=1 the probes compile to nothing.
+ *
+ *   parse_master_start(src, size)
+ *   parse_master_done(bytes_parsed, nb_stream_infs)
+ *   parse_media_start(src, size)
+ *   parse_media_done(bytes_parsed, nb_segments)
+ *   master_tag(tag, bytes_parsed)                  tag is a METRICS_TAG_* value
+ *   media_tag(tag, bytes_parsed, nb_segments)      tag is a METRICS_TAG_* value
+ *   write_master_start(master, nb_stream_infs)
+ *   write_master_done(size)
+ *   write_media_start(playlist, nb_segments)
+ *   write_media_done(size, nb_segments)
+ */
+
+#ifdef HLSPARSE_USDT
+
+#include <sys/sdt.h>
+
+#define HLS_PROBE1(name, a)         DTRACE_PROBE1(hlsparse, name, a)
+#define HLS_PROBE2(name, a, b)      DTRACE_PROBE2(hlsparse, name, a, b)
+#define HLS_PROBE3(name, a, b, c)   DTRACE_PROBE3(hlsparse, name, a, b, c)
+
+#else
+
+#define HLS_PROBE1(name, a)
+#define HLS_PROBE2(name, a, b)
+#define HLS_PROBE3(name, a, b, c)
+
+#endif
+
+#endif // _HLSPARSE_PROBES_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Segment reader
+ *
+ * Each call reads the lines of one segment, from just past the uri of the
+ * segment before it to its own uri, so a caller can act on the first
+ * segments of a playlist before the rest of it has been read. The key and map
+ * tags are scanned for the attributes a segment needs and kept as views into
+ * the source, the values which carry from one segment to the next, such as
+ * the program date time, are kept by the reader.
+ */
+
+static const char *next_line(const char *line, const char *end)
+{
+    const char *eol = memchr(line, '\n', end - line);
+    return eol ? eol + 1 : end;
+}
+
+/**
+ * Finds the end of a line's content, before any "\r\n".
+ */
+static const char *line_end(const char *line, const char *end)
+{
+    const char *eol = memchr(line, '\n', end - line);
+    eol = eol ? eol : end;
+    if(eol > line && eol[-1] == '\r') {
+        --eol;
+    }
+    return eol;
+}
+
+/**
+ * Finds the value of a tag, past the ':' which follows its name.
+ */
+static const char *tag_value(const char *tag, size_t len, const char *eol)
+{
+    const char *pt = tag + len;
+    return (pt < eol && *pt == ':') ? pt + 1 : pt;
+}
+
+#define TAG_VALUE(pt, eol, tag) tag_value((pt), sizeof(tag) - 1, (eol))
+
+static void read_byte_range(const char *src, const char *end, byte_range_t *dest)
+{
+    const char *pt = src;
+    dest->n = dest->o = 0;
+    pt += parse_str_to_int(pt, &dest->n, end - pt);
+    if(pt < end && *pt == '@') {
+        ++pt;
+        parse_str_to_int(pt, &dest->o, end - pt);
+    }
+}
+
+static void read_key(const char *attrs, const char *eol, key_view_t *key)
+{
+    size_t size = 0;
+    const char *method = parse_attrib_find(attrs, eol, METHOD, &size);
+
+    key->method = method ? KEY_METHOD_INVALID : KEY_METHOD_UNDEFINED;
+    if(method && size == sizeof(NONE) - 1 && 0 == strncmp(method, NONE, size)) {
+        key->method = KEY_METHOD_NONE;
+    } else if(method && size == sizeof(AES128) - 1 && 0 == strncmp(method, AES128, size)) {
+        key->method = KEY_METHOD_AES128;
+    } else if(method && size == sizeof(SAMPLEAES) - 1 && 0 == strncmp(method, SAMPLEAES, size)) {
+        key->method = KEY_METHOD_SAMPLEAES;
+    } else if(method && size == sizeof(SAMPLEAESCTR) - 1 && 0 == strncmp(method, SAMPLEAESCTR, size)) {
+        key->method = KEY_METHOD_SAMPLEAESCTR;
+    }
+
+    key->uri = parse_attrib_find(attrs, eol, URI, &key->uri_size);
+    key->uri_size = key->uri ? key->uri_size : 0;
+    key->iv = parse_attrib_find(attrs, eol, KEY_IV, &key->iv_size);
+    key->iv_size = key->iv ? key->iv_size : 0;
+    ++(key->index);
+}
+
+static void read_map(const char *attrs, const char *eol, map_view_t *map)
+{
+    size_t size = 0;
+    const char *byte_range = parse_attrib_find(attrs, eol, BYTERANGE, &size);
+
+    map->uri = parse_attrib_find(attrs, eol, URI, &map->uri_size);
+    map->uri_size = map->uri ? map->uri_size : 0;
+    map->byte_range.n = map->byte_range.o = 0;
+    if(byte_range) {
+        read_byte_range(byte_range, byte_range + size, &map->byte_range);
+    }
+    ++(map->index);
+}
+
+HLSCode hlsparse_segment_reader_init(segment_reader_t *reader, const char *src, size_t size)
+{
+    if(!reader || !src) {
+        return HLS_ERROR;
+    }
+
+    memset(reader, 0, sizeof(segment_reader_t));
+    reader->src = reader->pt = src;
+    reader->end = memchr(src, '\0', size);
+    reader->end = reader->end ? reader->end : &src[size];
+    reader->key.index = reader->map.index = -1;
+    return HLS_OK;
+}
+
+int hlsparse_segment_reader_next(segment_reader_t *reader, segment_view_t *dest)
+{
+    if(!reader || !dest || !reader->pt) {
+        return 0;
+    }
+
+    const char *begin = reader->pt;
+    const char *end = reader->end;
+    const char *line = begin;
+    const char *extinf = NULL;
+    bool_t discontinuity = HLS_FALSE;
+    byte_range_t byte_range = { 0, 0 };
+
+    while(line < end) {
+        const char *eol = line_end(line, end);
+        const char *next = next_line(line, end);
+
+        if(*line == '#') {
+            const char *tag = line + 1;
+            if(TAG_IS(tag, eol, EXTINF)) {
+                if(extinf) {
+                    // the segment before had no uri, read this one next time
+                    break;
+                }
+                const char *pt = TAG_VALUE(tag, eol, EXTINF);
+                double duration = 0.;
+                int64_t ms = 0;
+                memset(dest, 0, sizeof(segment_view_t));
+                pt += parse_str_to_duration(pt, &duration, &ms, eol - pt);
+                dest->duration = (float)duration;
+                if(pt < eol && *pt == ',') {
+                    dest->title = ++pt;
+                    dest->title_size = eol - pt;
+                }
+                dest->sequence_num = reader->nb_segments;
+                dest->pdt = reader->next_segment_pdt;
+                dest->pdt_end = dest->pdt + ms;
+                reader->next_segment_pdt = dest->pdt_end;
+                extinf = line;
+            } else if(TAG_IS(tag, eol, EXTXPROGRAMDATETIME)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXPROGRAMDATETIME);
+                parse_date(pt, &reader->next_segment_pdt, eol - pt);
+            } else if(TAG_IS(tag, eol, EXTXBYTERANGE)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXBYTERANGE);
+                read_byte_range(pt, eol, &byte_range);
+            } else if(TAG_IS(tag, eol, EXTXKEY)) {
+                read_key(TAG_VALUE(tag, eol, EXTXKEY), eol, &reader->key);
+            } else if(TAG_IS(tag, eol, EXTXMAP)) {
+                read_map(TAG_VALUE(tag, eol, EXTXMAP), eol, &reader->map);
+            } else if(TAG_IS(tag, eol, EXTXDISCONTINUITYSEQ)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXDISCONTINUITYSEQ);
+                parse_str_to_int(pt, &reader->discontinuity_sequence, eol - pt);
+            } else if(TAG_IS(tag, eol, EXTXDISCONTINUITY)) {
+                discontinuity = HLS_TRUE;
+            } else if(TAG_IS(tag, eol, EXTXMEDIASEQUENCE)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXMEDIASEQUENCE);
+                parse_str_to_int(pt, &reader->media_sequence, eol - pt);
+            } else if(TAG_IS(tag, eol, EXTXTARGETDURATION)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXTARGETDURATION);
+                parse_str_to_float(pt, &reader->target_duration, eol - pt);
+            } else if(TAG_IS(tag, eol, EXTXVERSION)) {
+                const char *pt = TAG_VALUE(tag, eol, EXTXVERSION);
+                parse_str_to_int(pt, &reader->version, eol - pt);
+            } else if(TAG_IS(tag, eol, EXTXENDLIST)) {
+                reader->end_list = HLS_TRUE;
+            }
+        } else if(extinf && eol > line) {
+            dest->uri = line;
+            dest->uri_size = eol - line;
+            line = next;
+            break;
+        }
+
+        line = next;
+    }
+
+    reader->pt = line;
+
+    if(!extinf) {
+        return 0;
+    }
+
+    dest->discontinuity = discontinuity;
+    dest->byte_range = byte_range;
+    dest->key = reader->key;
+    dest->map = reader->map;
+    dest->pdt_discontinuity = reader->nb_segments > 0 && dest->pdt != reader->last_segment_pdt_end;
+    reader->last_segment_pdt_end = dest->pdt_end;
+    ++(reader->nb_segments);
+
+    return line - begin;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/**
+ * Finds the value of a tag, past the ':' which follows its name.
+ */
+static const char *tag_value(const char *tag, size_t len, const char *next)
+{
+    const char *pt = tag + len;
+    return (pt < next && *pt == ':') ? pt + 1 : pt;
+}
+
+#define TAG_VALUE(pt, next, tag) tag_value((pt), sizeof(tag) - 1, (next))
+
+HLSCode hlsparse_media_playlist_summary(const char *src, size_t size, playlist_summary_t *dest)
+{
+    if(!src || !dest) {
+        return HLS_ERROR;
+    }
+
+    memset(dest, 0, sizeof(playlist_summary_t));
+
+    const char *end = memchr(src, '\0', size);
+    end = end ? end : &src[size];
+
+    // only the program date time the last segment is counted from is parsed,
+    // the segments after it move it on the same way the parser does
+    const char *pdt = NULL;
+    const char *last_pdt = NULL;
+    timestamp_t pdt_offset = 0;
+    timestamp_t last_offset = 0;
+
+    const char *line = src;
+    while(line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        const char *next = eol ? eol + 1 : end;
+
+        if(*line == '#') {
+            const char *pt = line + 1;
+            if(TAG_IS(pt, next, EXTINF)) {
+                double duration = 0.;
+                int64_t ms = 0;
+                pt = TAG_VALUE(pt, next, EXTINF);
+                parse_str_to_duration(pt, &duration, &ms, next - pt);
+                ++(dest->nb_segments);
+                // summed as the parser sums segment_t.duration
+                dest->duration += (float)duration;
+                last_pdt = pdt;
+                last_offset = pdt_offset;
+                pdt_offset += ms;
+            } else if(TAG_IS(pt, next, EXTXPROGRAMDATETIME)) {
+                pdt = TAG_VALUE(pt, next, EXTXPROGRAMDATETIME);
+                pdt_offset = 0;
+            } else if(TAG_IS(pt, next, EXTXTARGETDURATION)) {
+                pt = TAG_VALUE(pt, next, EXTXTARGETDURATION);
+                parse_str_to_float(pt, &dest->target_duration, next - pt);
+            } else if(TAG_IS(pt, next, EXTXMEDIASEQUENCE)) {
+                pt = TAG_VALUE(pt, next, EXTXMEDIASEQUENCE);
+                parse_str_to_int(pt, &dest->media_sequence, next - pt);
+            } else if(TAG_IS(pt, next, EXTXDISCONTINUITYSEQ)) {
+                pt = TAG_VALUE(pt, next, EXTXDISCONTINUITYSEQ);
+                parse_str_to_int(pt, &dest->discontinuity_sequence, next - pt);
+            } else if(TAG_IS(pt, next, EXTXVERSION)) {
+                pt = TAG_VALUE(pt, next, EXTXVERSION);
+                parse_str_to_int(pt, &dest->version, next - pt);
+            } else if(TAG_IS(pt, next, EXTXPLAYLISTTYPE)) {
+                pt = TAG_VALUE(pt, next, EXTXPLAYLISTTYPE);
+                if(TAG_IS(pt, next, VOD)) {
+                    dest->playlist_type = PLAYLIST_TYPE_VOD;
+                } else if(TAG_IS(pt, next, EVENT)) {
+                    dest->playlist_type = PLAYLIST_TYPE_EVENT;
+                }
+            } else if(TAG_IS(pt, next, EXTXENDLIST)) {
+                dest->end_list = HLS_TRUE;
+            } else if(TAG_IS(pt, next, EXTXSTREAMINF)) {
+                dest->master = HLS_TRUE;
+                ++(dest->nb_stream_infs);
+            } else if(TAG_IS(pt, next, EXTXIFRAMESTREAMINF)) {
+                dest->master = HLS_TRUE;
+            } else if(TAG_IS(pt, next, EXTM3U)) {
+                dest->m3u = HLS_TRUE;
+            }
+        }
+
+        line = next;
+    }
+
+    if(last_pdt) {
+        parse_date(last_pdt, &dest->last_pdt, end - last_pdt);
+        dest->last_pdt += last_offset;
+    }
+
+    return HLS_OK;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Tail parsing
+ *
+ * With tail_segments set the parser only builds the last segments of a media
+ * playlist. The first segment to build is found by scanning backwards from the
+ * end of the source. The lines before it are read without building anything,
+ * only the playlist tags are parsed along with the last key, map and daterange
+ * the skipped segments leave behind, while the sequence numbers, program date
+ * time and media and discontinuity sequences are moved past the skipped
+ * segments the same way hlsparse_media_playlist_expire would.
+ */
+
+// tags which describe the playlist rather than the segment which follows them
+static const char *playlist_tags[] = {
+    EXTM3U, EXTXVERSION, EXTXTARGETDURATION, EXTXMEDIASEQUENCE, EXTXDISCONTINUITYSEQ,
+    EXTXPLAYLISTTYPE, EXTXENDLIST, EXTXIFRAMESONLY, EXTXINDEPENDENTSEGMENTS, EXTXSTART,
+    EXTXALLOWCACHE
+};
+
+/**
+ * Finds the start of the line before \a line.
+ *
+ * @returns the start of the previous line, or NULL if \a line is the first
+ */
+static const char *prev_line(const char *src, const char *line)
+{
+    if(line <= src) {
+        return NULL;
+    }
+
+    const char *pt = line - 1;
+    while(pt > src && pt[-1] != '\n') {
+        --pt;
+    }
+    return pt;
+}
+
+/**
+ * Finds the start of the line after \a line, or \a end if it's the last.
+ */
+static const char *next_line(const char *line, const char *end)
+{
+    const char *eol = memchr(line, '\n', end - line);
+    return eol ? eol + 1 : end;
+}
+
+static bool_t is_playlist_tag(const char *tag, const char *end)
+{
+    int i;
+    for(i = 0; i < (int)(sizeof(playlist_tags) / sizeof(playlist_tags[0])); ++i) {
+        size_t len = strlen(playlist_tags[i]);
+        if((size_t)(end - tag) >= len && 0 == strncmp(tag, playlist_tags[i], len)) {
+            return HLS_TRUE;
+        }
+    }
+    return HLS_FALSE;
+}
+
+/**
+ * Finds where the tags of the first of the last \a count segments begin, which
+ * is the line after the uri of the segment before it.
+ *
+ * @returns the start of the tail, or NULL if the playlist has no more than
+ * \a count segments
+ */
+static const char *find_tail(const char *src, const char *end, int count)
+{
+    const char *line = end;
+    const char *first = NULL;
+    int found = 0;
+
+    while(found < count && (line = prev_line(src, line))) {
+        if(TAG_IS(line, end, "#" EXTINF)) {
+            first = line;
+            ++found;
+        }
+    }
+
+    if(found < count) {
+        return NULL;
+    }
+
+    // step back over the tags of the segment to the uri before them
+    line = first;
+    while((line = prev_line(src, line))) {
+        if(*line != '#' && *line != '\n' && *line != '\r') {
+            return next_line(line, end);
+        }
+    }
+
+    return NULL;
+}
+
+int parse_media_playlist_tail(const char *src, size_t size, media_playlist_t *dest)
+{
+    if(!src || !dest || dest->tail_segments <= 0 || size == 0) {
+        return 0;
+    }
+
+    const char *end = memchr(src, '\0', size);
+    end = end ? end : &src[size];
+
+    const char *tail = find_tail(src, end, dest->tail_segments);
+    if(!tail) {
+        return 0;
+    }
+
+    const char *key = NULL, *map = NULL, *daterange = NULL;
+    const char *pdt = NULL, *daterange_pdt = NULL;
+    int nb_skipped = 0;
+    int nb_discontinuities = 0;
+
+    // read the tags before the tail without building the segments they describe
+    const char *line = src;
+    while(line < tail) {
+        if(*line == '#') {
+            const char *tag = line + 1;
+            if(TAG_IS(tag, tail, EXTINF)) {
+                ++nb_skipped;
+            } else if(TAG_IS(tag, tail, EXTXPROGRAMDATETIME)) {
+                pdt = tag;
+            } else if(TAG_IS(tag, tail, EXTXKEY)) {
+                key = tag;
+            } else if(TAG_IS(tag, tail, EXTXMAP)) {
+                map = tag;
+            } else if(TAG_IS(tag, tail, EXTXDATERANGE)) {
+                daterange = tag;
+                daterange_pdt = pdt;
+            } else if(is_playlist_tag(tag, tail)) {
+                parse_media_playlist_tag(tag, end - tag, dest);
+            } else if(TAG_IS(tag, tail, EXTXDISCONTINUITY)) {
+                ++nb_discontinuities;
+            }
+        }
+        line = next_line(line, tail);
+    }
+
+    // the tags of the first kept segment replace the ones before it
+    line = tail;
+    while(line < end && !TAG_IS(line, end, "#" EXTINF)) {
+        if(TAG_IS(line, end, "#" EXTXKEY)) {
+            key = NULL;
+        } else if(TAG_IS(line, end, "#" EXTXMAP)) {
+            map = NULL;
+        } else if(TAG_IS(line, end, "#" EXTXDATERANGE)) {
+            daterange = NULL;
+        }
+        line = next_line(line, end);
+    }
+
+    if(key) {
+        parse_media_playlist_tag(key, end - key, dest);
+    }
+    if(map) {
+        parse_media_playlist_tag(map, end - map, dest);
+    }
+
+    // replay the segment durations from the last program date time the kept
+    // daterange and the tail depend on
+    line = daterange ? daterange_pdt : pdt;
+    line = line ? line - 1 : src;
+    while(line < tail) {
+        if(*line == '#') {
+            const char *tag = line + 1;
+            if(TAG_IS(tag, tail, EXTINF)) {
+                int64_t ms = 0;
+                parse_str_to_ticks(tag + sizeof(EXTINF), &ms, 3, tail - tag - sizeof(EXTINF));
+                dest->next_segment_pdt += ms;
+            } else if(tag == daterange || TAG_IS(tag, tail, EXTXPROGRAMDATETIME)) {
+                parse_media_playlist_tag(tag, end - tag, dest);
+            }
+        }
+        line = next_line(line, tail);
+    }
+
+    dest->next_segment_media_sequence += nb_skipped;
+    dest->media_sequence += nb_skipped;
+    dest->discontinuity_sequence += nb_discontinuities;
+
+    return tail - src;
+}
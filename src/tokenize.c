@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Attribute-list tokenizer
+ *
+ * The line is classified 64 bytes at a time into bit masks of its quotes,
+ * commas, equals signs and line ends, one bit per byte. The quoted regions
+ * are found from the quote mask with a prefix xor, so the commas and equals
+ * signs in quoted-strings drop out before the structural characters are
+ * walked, one bit at a time, to find where each attribute's name and value
+ * start and end.
+ */
+
+#define BLOCK_SIZE  64
+
+typedef struct {
+    uint64_t quote;
+    uint64_t comma;
+    uint64_t equal;
+    uint64_t eol;   // '\0', '\r' and '\n'
+} block_masks_t;
+
+#if defined(__AVX2__)
+
+static inline uint64_t match32(__m256i v, char c)
+{
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
+
+static void classify(const char *block, block_masks_t *m)
+{
+    __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+
+    m->quote = match32(lo, '"') | match32(hi, '"') << 32;
+    m->comma = match32(lo, ',') | match32(hi, ',') << 32;
+    m->equal = match32(lo, '=') | match32(hi, '=') << 32;
+    m->eol = (match32(lo, '\0') | match32(lo, '\r') | match32(lo, '\n')) |
+             (match32(hi, '\0') | match32(hi, '\r') | match32(hi, '\n')) << 32;
+}
+
+#elif defined(__SSE2__)
+
+static inline uint64_t match16(__m128i v, char c)
+{
+    return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+static void classify(const char *block, block_masks_t *m)
+{
+    int i;
+    memset(m, 0, sizeof(*m));
+    for(i = 0; i < BLOCK_SIZE; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + i));
+        m->quote |= match16(v, '"') << i;
+        m->comma |= match16(v, ',') << i;
+        m->equal |= match16(v, '=') << i;
+        m->eol |= (match16(v, '\0') | match16(v, '\r') | match16(v, '\n')) << i;
+    }
+}
+
+#else
+
+static void classify(const char *block, block_masks_t *m)
+{
+    int i;
+    memset(m, 0, sizeof(*m));
+    for(i = 0; i < BLOCK_SIZE; ++i) {
+        uint64_t bit = 1ULL << i;
+        switch(block[i]) {
+            case '"': m->quote |= bit; break;
+            case ',': m->comma |= bit; break;
+            case '=': m->equal |= bit; break;
+            case '\0':
+            case '\r':
+            case '\n': m->eol |= bit; break;
+        }
+    }
+}
+
+#endif
+
+/**
+ * Sets every bit from each set bit up to, but not including, the next one, so
+ * the quote mask becomes the opening quotes and the quoted-strings after them.
+ */
+static inline uint64_t prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static inline void emit(const char *start, const char *equal, const char *end,
+                        attr_token_callback callback, void *user)
+{
+    // anything without an '=', e.g. a trailing comma, isn't an attribute
+    if(equal) {
+        attr_token_t token = { start, equal - start, equal + 1, end - equal - 1 };
+        callback(&token, user);
+    }
+}
+
+/**
+ * Splits the attribute-list on the line at \a src into NAME=value pairs, the
+ * commas and equals signs inside quoted-strings are part of the value. The
+ * name is everything before the first '=' of the attribute, so the first one
+ * starts with whatever is in front of the attribute-list, e.g. the tag's name.
+ *
+ * @param src The attribute-list
+ * @param size The size of src, the list ends at the first line end before it
+ * @param callback Called with each attribute in order
+ * @param user Passed through to callback
+ * @returns the length of the line
+ */
+int tokenize_attributes(const char *src, size_t size, attr_token_callback callback, void *user)
+{
+    if(!src || !size || !callback) {
+        return 0;
+    }
+
+    const char *pt = src;
+    const char *end = &src[size];
+    const char *start = src;        // of the current attribute
+    const char *equal = NULL;       // the current attribute's first '='
+    uint64_t in_quote = 0;          // all ones while a quoted-string runs on into the next block
+    char tail[BLOCK_SIZE];
+
+    while(pt < end) {
+        const char *block = pt;
+        size_t remaining = end - pt;
+        if(remaining < BLOCK_SIZE) {
+            // the zeros after the source are line ends
+            memcpy(tail, pt, remaining);
+            memset(&tail[remaining], 0, BLOCK_SIZE - remaining);
+            block = tail;
+        }
+
+        block_masks_t m;
+        classify(block, &m);
+
+        uint64_t quoted = prefix_xor(m.quote) ^ in_quote;
+        in_quote = (uint64_t)((int64_t)quoted >> 63);
+
+        // nothing from the line end on is part of the list
+        uint64_t line = m.eol ? (m.eol & -m.eol) - 1 : ~0ULL;
+        uint64_t structural = (m.comma | m.equal) & ~quoted & line;
+
+        while(structural) {
+            int i = __builtin_ctzll(structural);
+            if(m.comma & (1ULL << i)) {
+                emit(start, equal, &pt[i], callback, user);
+                start = &pt[i + 1];
+                equal = NULL;
+            } else if(!equal) {
+                equal = &pt[i];
+            }
+            structural &= structural - 1;
+        }
+
+        if(m.eol) {
+            pt += __builtin_ctzll(m.eol);
+            break;
+        }
+        pt += BLOCK_SIZE;
+    }
+
+    emit(start, equal, pt, callback, user);
+    return pt - src;
+}
@@ -0,0 +1,651 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include "parse.h"
+
+/*
+ * Validation
+ *
+ * The playlist is read one line at a time, checking each tag with the value
+ * parsers and a scanner for attribute lists which only points into the source,
+ * so nothing is allocated whatever the size of the playlist. The little state
+ * kept between lines, such as the last segment's uri and program date time,
+ * points into the source as well.
+ *
+ * Large media playlists are split into parts which end after a segment's uri
+ * and are validated on separate threads. Each part starts without knowing the
+ * state left by the parts before it, so the first program date time and the
+ * first byte range without an offset of a part are kept aside and checked
+ * once every part is done, carrying the state from one part to the next.
+ */
+
+#define VALIDATE_MAX_THREADS    64
+#define VALIDATE_MIN_PART       (256 * 1024)    // smallest part of a playlist given to a thread
+
+static const char *violation_names[VIOLATION_COUNT] = {
+    "extm3u", "mixed-tags", "target-duration", "extinf-duration", "uri",
+    "media-sequence", "pdt-order", "byte-range", "key", "map", "daterange",
+    "daterange-pdt", "stream-inf", "media", "group"
+};
+
+typedef struct {
+    const char          *uri;           // points into the source
+    size_t              uri_len;
+    bool_t              byte_range;     // the segment is a sub-range of uri
+} segment_ref_t;
+
+typedef struct {
+    playlist_validation_t   *validation;
+    const char              *src;
+    pthread_mutex_t         lock;
+} validate_ctx_t;
+
+typedef struct {
+    validate_ctx_t          *ctx;
+    const char              *begin;
+    const char              *end;
+    bool_t                  first;          // the part starts at the beginning of the playlist
+    float                   target_duration;
+    bool_t                  has_target_duration;
+    bool_t                  has_media_sequence;
+
+    int                     nb_segments;
+    const char              *extinf;        // EXTINF waiting for its uri
+    const char              *byte_range;    // EXT-X-BYTERANGE without an offset for the next segment
+    bool_t                  sub_range;      // the next segment is a sub-range
+    bool_t                  discontinuity;  // the next segment follows a discontinuity
+    segment_ref_t           last;           // the last segment of the part
+
+    // program date times are counted from the start of the part until the
+    // part has one of its own
+    bool_t                  pdt_known;
+    timestamp_t             pdt;            // program date time of the next segment
+    timestamp_t             last_pdt;       // program date time of the last segment
+    bool_t                  last_pdt_known;
+    bool_t                  has_pdt;
+    const char              *daterange;     // first EXT-X-DATERANGE
+
+    // checks which need the state left by the previous part
+    const char              *pending_pdt;
+    timestamp_t             pending_pdt_value;
+    timestamp_t             pending_pdt_last;       // start of the segment before it, counted from the start of the part
+    bool_t                  pending_pdt_last_in_part;
+    const char              *pending_byte_range;
+    segment_ref_t           pending_segment;
+} validate_part_t;
+
+static void report(validate_ctx_t *ctx, int rule, const char *line)
+{
+    violation_t violation = { rule, (size_t)(line - ctx->src) };
+
+    pthread_mutex_lock(&ctx->lock);
+    ++(ctx->validation->nb_violations);
+    ctx->validation->violations |= rule;
+    if(ctx->validation->callback) {
+        ctx->validation->callback(&violation, ctx->validation->user);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+/**
+ * Finds the end of a line's content, before any "\r\n".
+ */
+static const char *line_end(const char *line, const char *end)
+{
+    const char *eol = memchr(line, '\n', end - line);
+    eol = eol ? eol : end;
+    if(eol > line && eol[-1] == '\r') {
+        --eol;
+    }
+    return eol;
+}
+
+static const char *next_line(const char *line, const char *end)
+{
+    const char *eol = memchr(line, '\n', end - line);
+    return eol ? eol + 1 : end;
+}
+
+static bool_t is_uri_line(const char *line, const char *end)
+{
+    return line < end && *line != '#' && line_end(line, end) > line;
+}
+
+static bool_t value_is(const char *value, size_t len, const char *str)
+{
+    return value && len == strlen(str) && 0 == strncmp(value, str, len);
+}
+
+/**
+ * Finds the attribute list of a tag, past the ':' which follows its name.
+ */
+static const char *tag_attrs(const char *tag, size_t len, const char *end)
+{
+    const char *pt = tag + len;
+    return (pt < end && *pt == ':') ? pt + 1 : pt;
+}
+
+#define TAG_ATTRS(pt, end, tag) tag_attrs((pt), sizeof(tag) - 1, (end))
+
+/**
+ * An IV is a hexadecimal-sequence of 128 bits, "0x" and 32 hex digits.
+ */
+static bool_t valid_iv(const char *iv, size_t len)
+{
+    size_t i;
+    if(len != 34 || iv[0] != '0' || (iv[1] != 'x' && iv[1] != 'X')) {
+        return HLS_FALSE;
+    }
+    for(i = 2; i < len; ++i) {
+        char c = iv[i];
+        if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+            return HLS_FALSE;
+        }
+    }
+    return HLS_TRUE;
+}
+
+static bool_t valid_key(const char *attrs, const char *end)
+{
+    size_t method_len = 0, uri_len = 0, iv_len = 0;
+    const char *method = parse_attrib_find(attrs, end, "METHOD", &method_len);
+    const char *uri = parse_attrib_find(attrs, end, "URI", &uri_len);
+    const char *iv = parse_attrib_find(attrs, end, "IV", &iv_len);
+
+    if(value_is(method, method_len, "NONE")) {
+        return !uri && !iv;
+    }
+    if(!value_is(method, method_len, "AES-128") && !value_is(method, method_len, "SAMPLE-AES") &&
+       !value_is(method, method_len, "SAMPLE-AES-CTR")) {
+        return HLS_FALSE;
+    }
+    if(!uri) {
+        return HLS_FALSE;
+    }
+    return !iv || valid_iv(iv, iv_len);
+}
+
+static bool_t valid_daterange(const char *attrs, const char *end)
+{
+    size_t len = 0;
+    timestamp_t start = 0, end_date = 0;
+    double duration = 0.;
+    float planned_duration = 0.f;
+    int64_t duration_ms = 0;
+
+    if(!parse_attrib_find(attrs, end, "ID", &len) || len == 0) {
+        return HLS_FALSE;
+    }
+
+    const char *value = parse_attrib_find(attrs, end, "START-DATE", &len);
+    if(!value || parse_date(value, &start, len) == 0) {
+        return HLS_FALSE;
+    }
+
+    const char *end_value = parse_attrib_find(attrs, end, "END-DATE", &len);
+    if(end_value && (parse_date(end_value, &end_date, len) == 0 || end_date < start)) {
+        return HLS_FALSE;
+    }
+
+    const char *duration_value = parse_attrib_find(attrs, end, "DURATION", &len);
+    if(duration_value && (parse_str_to_duration(duration_value, &duration, &duration_ms, len) == 0 || duration < 0.)) {
+        return HLS_FALSE;
+    }
+
+    value = parse_attrib_find(attrs, end, "PLANNED-DURATION", &len);
+    if(value && (parse_str_to_float(value, &planned_duration, len) == 0 || planned_duration < 0.f)) {
+        return HLS_FALSE;
+    }
+
+    // the end date and duration have to describe the same range
+    if(end_value && duration_value) {
+        timestamp_t expected = start + duration_ms;
+        if(end_date + 1 < expected || end_date > expected + 1) {
+            return HLS_FALSE;
+        }
+    }
+
+    value = parse_attrib_find(attrs, end, "END-ON-NEXT", &len);
+    if(value) {
+        if(!value_is(value, len, "YES") || !parse_attrib_find(attrs, end, "CLASS", &len) ||
+           end_value || duration_value) {
+            return HLS_FALSE;
+        }
+    }
+
+    return HLS_TRUE;
+}
+
+static void validate_pdt(validate_part_t *part, const char *line, const char *value, const char *end)
+{
+    timestamp_t pdt = 0;
+    part->has_pdt = HLS_TRUE;
+    parse_date(value, &pdt, end - value);
+
+    // the time line may start over after a discontinuity
+    if(!part->discontinuity) {
+        if(part->pdt_known) {
+            if(part->last_pdt_known && pdt < part->last_pdt) {
+                report(part->ctx, VIOLATION_PDT_ORDER, line);
+            }
+        } else if(!part->first) {
+            part->pending_pdt = line;
+            part->pending_pdt_value = pdt;
+            part->pending_pdt_last = part->last_pdt;
+            part->pending_pdt_last_in_part = part->nb_segments > 0;
+        }
+    }
+
+    part->pdt = pdt;
+    part->pdt_known = HLS_TRUE;
+}
+
+static void validate_segment_uri(validate_part_t *part, const char *line, const char *end)
+{
+    segment_ref_t segment = { line, (size_t)(line_end(line, end) - line), part->sub_range };
+
+    if(part->byte_range) {
+        if(part->nb_segments == 0 && !part->first) {
+            part->pending_byte_range = part->byte_range;
+            part->pending_segment = segment;
+        } else if(part->nb_segments == 0 || !part->last.byte_range || part->last.uri_len != segment.uri_len ||
+                  strncmp(part->last.uri, segment.uri, segment.uri_len)) {
+            report(part->ctx, VIOLATION_BYTE_RANGE, part->byte_range);
+        }
+    }
+
+    part->last = segment;
+    ++(part->nb_segments);
+    part->extinf = NULL;
+    part->byte_range = NULL;
+    part->sub_range = HLS_FALSE;
+    part->discontinuity = HLS_FALSE;
+}
+
+static void validate_media_line(validate_part_t *part, const char *line)
+{
+    const char *end = part->end;
+
+    if(*line != '#') {
+        if(!is_uri_line(line, end)) {
+            return;
+        }
+        if(!part->extinf) {
+            report(part->ctx, VIOLATION_URI, line);
+        }
+        validate_segment_uri(part, line, end);
+        return;
+    }
+
+    const char *tag = line + 1;
+    const char *eol = line_end(line, end);
+
+    if(TAG_IS(tag, eol, EXTINF)) {
+        double duration = 0.;
+        int64_t ms = 0;
+        const char *value = TAG_ATTRS(tag, eol, EXTINF);
+        parse_str_to_duration(value, &duration, &ms, eol - value);
+        if(part->extinf) {
+            report(part->ctx, VIOLATION_URI, part->extinf);
+        }
+        part->extinf = line;
+        // durations are rounded to the nearest second before comparing
+        if(part->has_target_duration && (int)(duration + 0.5) > (int)part->target_duration) {
+            report(part->ctx, VIOLATION_EXTINF_DURATION, line);
+        }
+        part->last_pdt = part->pdt;
+        part->last_pdt_known = part->pdt_known;
+        part->pdt += ms;
+    } else if(TAG_IS(tag, eol, EXTXPROGRAMDATETIME)) {
+        validate_pdt(part, line, TAG_ATTRS(tag, eol, EXTXPROGRAMDATETIME), eol);
+    } else if(TAG_IS(tag, eol, EXTXBYTERANGE)) {
+        const char *value = TAG_ATTRS(tag, eol, EXTXBYTERANGE);
+        part->sub_range = HLS_TRUE;
+        part->byte_range = memchr(value, '@', eol - value) ? NULL : line;
+    } else if(TAG_IS(tag, eol, EXTXKEY)) {
+        if(!valid_key(TAG_ATTRS(tag, eol, EXTXKEY), eol)) {
+            report(part->ctx, VIOLATION_KEY, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTXMAP)) {
+        size_t len = 0;
+        if(!parse_attrib_find(TAG_ATTRS(tag, eol, EXTXMAP), eol, "URI", &len) || len == 0) {
+            report(part->ctx, VIOLATION_MAP, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTXDATERANGE)) {
+        if(!part->daterange) {
+            part->daterange = line;
+        }
+        if(!valid_daterange(TAG_ATTRS(tag, eol, EXTXDATERANGE), eol)) {
+            report(part->ctx, VIOLATION_DATERANGE, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTXDISCONTINUITYSEQ)) {
+        // a playlist tag, nothing to check
+    } else if(TAG_IS(tag, eol, EXTXDISCONTINUITY)) {
+        part->discontinuity = HLS_TRUE;
+    } else if(TAG_IS(tag, eol, EXTXMEDIASEQUENCE)) {
+        if(part->has_media_sequence || part->nb_segments > 0 || part->extinf || !part->first) {
+            report(part->ctx, VIOLATION_MEDIA_SEQUENCE, line);
+        }
+        part->has_media_sequence = HLS_TRUE;
+    } else if(TAG_IS(tag, eol, EXTXTARGETDURATION)) {
+        const char *value = TAG_ATTRS(tag, eol, EXTXTARGETDURATION);
+        parse_str_to_float(value, &part->target_duration, eol - value);
+        part->has_target_duration = HLS_TRUE;
+    } else if(TAG_IS(tag, eol, EXTXSTREAMINF) || TAG_IS(tag, eol, EXTXIFRAMESTREAMINF) ||
+              TAG_IS(tag, eol, EXTXSESSIONDATA) || TAG_IS(tag, eol, EXTXSESSIONKEY) ||
+              TAG_IS(tag, eol, EXTXMEDIA ":")) {
+        report(part->ctx, VIOLATION_MIXED_TAGS, line);
+    }
+}
+
+/**
+ * Checks that an EXT-X-MEDIA of the given type declares a group.
+ */
+static bool_t find_group(const char *src, const char *end, const char *type, const char *group, size_t group_len)
+{
+    const char *line = src;
+    while(line < end) {
+        const char *eol = line_end(line, end);
+        if(TAG_IS(line, eol, "#" EXTXMEDIA ":")) {
+            const char *attrs = line + sizeof(EXTXMEDIA) + 1;
+            size_t len = 0;
+            const char *value = parse_attrib_find(attrs, eol, "TYPE", &len);
+            if(value_is(value, len, type)) {
+                value = parse_attrib_find(attrs, eol, "GROUP-ID", &len);
+                if(value && len == group_len && 0 == strncmp(value, group, len)) {
+                    return HLS_TRUE;
+                }
+            }
+        }
+        line = next_line(line, end);
+    }
+    return HLS_FALSE;
+}
+
+static void validate_master_line(validate_part_t *part, const char *line)
+{
+    static const char *groups[] = { "AUDIO", "VIDEO", "SUBTITLES", "CLOSED-CAPTIONS" };
+    const char *end = part->end;
+
+    if(*line != '#') {
+        if(is_uri_line(line, end) && !part->extinf) {
+            report(part->ctx, VIOLATION_URI, line);
+        }
+        part->extinf = NULL;
+        return;
+    }
+
+    // only the line after an EXT-X-STREAM-INF can be its uri
+    part->extinf = NULL;
+
+    const char *tag = line + 1;
+    const char *eol = line_end(line, end);
+    size_t len = 0;
+
+    if(TAG_IS(tag, eol, EXTXSTREAMINF)) {
+        const char *attrs = TAG_ATTRS(tag, eol, EXTXSTREAMINF);
+        if(!parse_attrib_find(attrs, eol, "BANDWIDTH", &len)) {
+            report(part->ctx, VIOLATION_STREAM_INF, line);
+        }
+
+        int i;
+        for(i = 0; i < 4; ++i) {
+            const char *group = parse_attrib_find(attrs, eol, groups[i], &len);
+            // CLOSED-CAPTIONS=NONE isn't quoted and references nothing
+            if(group && !(group[-1] != '"' && value_is(group, len, "NONE")) &&
+               !find_group(part->ctx->src, end, groups[i], group, len)) {
+                report(part->ctx, VIOLATION_GROUP, line);
+            }
+        }
+
+        // the uri has to be on the next line
+        const char *next = next_line(line, end);
+        if(!is_uri_line(next, end)) {
+            report(part->ctx, VIOLATION_URI, line);
+        }
+        part->extinf = line;
+    } else if(TAG_IS(tag, eol, EXTXIFRAMESTREAMINF)) {
+        const char *attrs = TAG_ATTRS(tag, eol, EXTXIFRAMESTREAMINF);
+        if(!parse_attrib_find(attrs, eol, "BANDWIDTH", &len) || !parse_attrib_find(attrs, eol, "URI", &len)) {
+            report(part->ctx, VIOLATION_STREAM_INF, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTXMEDIA ":")) {
+        const char *attrs = TAG_ATTRS(tag, eol, EXTXMEDIA);
+        const char *type = parse_attrib_find(attrs, eol, "TYPE", &len);
+        size_t type_len = len;
+        bool_t cc = value_is(type, type_len, "CLOSED-CAPTIONS");
+        if(!(value_is(type, type_len, "AUDIO") || value_is(type, type_len, "VIDEO") ||
+             value_is(type, type_len, "SUBTITLES") || cc) ||
+           !parse_attrib_find(attrs, eol, "GROUP-ID", &len) || !parse_attrib_find(attrs, eol, "NAME", &len) ||
+           (cc && (!parse_attrib_find(attrs, eol, "INSTREAM-ID", &len) || parse_attrib_find(attrs, eol, "URI", &len)))) {
+            report(part->ctx, VIOLATION_MEDIA, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTXSESSIONKEY)) {
+        if(!valid_key(TAG_ATTRS(tag, eol, EXTXSESSIONKEY), eol)) {
+            report(part->ctx, VIOLATION_KEY, line);
+        }
+    } else if(TAG_IS(tag, eol, EXTINF) || TAG_IS(tag, eol, EXTXTARGETDURATION) ||
+              TAG_IS(tag, eol, EXTXMEDIASEQUENCE) || TAG_IS(tag, eol, EXTXKEY) ||
+              TAG_IS(tag, eol, EXTXMAP) || TAG_IS(tag, eol, EXTXBYTERANGE) ||
+              TAG_IS(tag, eol, EXTXDISCONTINUITY) || TAG_IS(tag, eol, EXTXPROGRAMDATETIME) ||
+              TAG_IS(tag, eol, EXTXDATERANGE) || TAG_IS(tag, eol, EXTXENDLIST) ||
+              TAG_IS(tag, eol, EXTXPLAYLISTTYPE)) {
+        report(part->ctx, VIOLATION_MIXED_TAGS, line);
+    }
+}
+
+static void *validate_part(void *arg)
+{
+    validate_part_t *part = arg;
+    bool_t master = part->ctx->validation->master;
+
+    const char *line = part->begin;
+    while(line < part->end) {
+        if(master) {
+            validate_master_line(part, line);
+        } else {
+            validate_media_line(part, line);
+        }
+        line = next_line(line, part->end);
+    }
+
+    if(!master && part->extinf) {
+        report(part->ctx, VIOLATION_URI, part->extinf);
+    }
+
+    return NULL;
+}
+
+/**
+ * Finds where the next part of a media playlist can start at or after \a pt,
+ * which is the line after a segment's uri.
+ */
+static const char *split_point(const char *pt, const char *end)
+{
+    const char *line = next_line(pt, end);
+    while(line < end) {
+        if(is_uri_line(line, end)) {
+            return next_line(line, end);
+        }
+        line = next_line(line, end);
+    }
+    return end;
+}
+
+/**
+ * Checks what the parts couldn't check on their own by carrying the state
+ * left by each part into the next one.
+ */
+static void validate_join(validate_part_t *parts, int nb_parts)
+{
+    bool_t pdt_known = parts[0].pdt_known;
+    timestamp_t pdt = parts[0].pdt;
+    bool_t last_pdt_known = parts[0].nb_segments > 0 && parts[0].last_pdt_known;
+    timestamp_t last_pdt = parts[0].last_pdt;
+    segment_ref_t last = parts[0].last;
+    bool_t has_last = parts[0].nb_segments > 0;
+    int i;
+
+    for(i = 1; i < nb_parts; ++i) {
+        validate_part_t *part = &parts[i];
+
+        if(part->pending_pdt) {
+            bool_t known = part->pending_pdt_last_in_part ? pdt_known : last_pdt_known;
+            timestamp_t before = part->pending_pdt_last_in_part ? pdt + part->pending_pdt_last : last_pdt;
+            if(known && part->pending_pdt_value < before) {
+                report(part->ctx, VIOLATION_PDT_ORDER, part->pending_pdt);
+            }
+        }
+
+        if(part->pending_byte_range) {
+            if(!has_last || !last.byte_range || last.uri_len != part->pending_segment.uri_len ||
+               strncmp(last.uri, part->pending_segment.uri, last.uri_len)) {
+                report(part->ctx, VIOLATION_BYTE_RANGE, part->pending_byte_range);
+            }
+        }
+
+        if(part->nb_segments > 0) {
+            last = part->last;
+            has_last = HLS_TRUE;
+            if(part->last_pdt_known) {
+                last_pdt = part->last_pdt;
+                last_pdt_known = HLS_TRUE;
+            } else {
+                last_pdt = pdt + part->last_pdt;
+                last_pdt_known = pdt_known;
+            }
+        }
+
+        if(part->pdt_known) {
+            pdt = part->pdt;
+            pdt_known = HLS_TRUE;
+        } else {
+            pdt += part->pdt;
+        }
+    }
+}
+
+HLSCode hlsparse_validation_init(playlist_validation_t *validation)
+{
+    if(!validation) {
+        return HLS_ERROR;
+    }
+
+    memset(validation, 0, sizeof(playlist_validation_t));
+    return HLS_OK;
+}
+
+HLSCode hlsparse_validate(const char *src, size_t size, playlist_validation_t *validation)
+{
+    if(!src || !validation) {
+        return HLS_ERROR;
+    }
+
+    validation->nb_violations = 0;
+    validation->violations = 0;
+    validation->master = HLS_FALSE;
+
+    validate_ctx_t ctx;
+    ctx.validation = validation;
+    ctx.src = src;
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    const char *end = memchr(src, '\0', size);
+    end = end ? end : &src[size];
+
+    if(!TAG_IS(src, end, "#" EXTM3U)) {
+        report(&ctx, VIOLATION_EXTM3U, src);
+    }
+
+    // the header says what kind of playlist this is and how long its
+    // segments may be before any part is validated
+    validate_part_t header;
+    memset(&header, 0, sizeof(validate_part_t));
+    const char *line = src;
+    while(line < end && !TAG_IS(line, end, "#" EXTINF) && !is_uri_line(line, end)) {
+        const char *eol = line_end(line, end);
+        if(TAG_IS(line, eol, "#" EXTXSTREAMINF) || TAG_IS(line, eol, "#" EXTXIFRAMESTREAMINF) ||
+           TAG_IS(line, eol, "#" EXTXMEDIA ":")) {
+            validation->master = HLS_TRUE;
+            break;
+        } else if(TAG_IS(line, eol, "#" EXTXTARGETDURATION)) {
+            const char *value = TAG_ATTRS(line + 1, eol, EXTXTARGETDURATION);
+            parse_str_to_float(value, &header.target_duration, eol - value);
+            header.has_target_duration = HLS_TRUE;
+        }
+        line = next_line(line, end);
+    }
+
+    validate_part_t parts[VALIDATE_MAX_THREADS];
+    int nb_parts = 1;
+    if(!validation->master && validation->nb_threads > 1) {
+        size_t max_parts = (end - src) / VALIDATE_MIN_PART;
+        nb_parts = validation->nb_threads < VALIDATE_MAX_THREADS ? validation->nb_threads : VALIDATE_MAX_THREADS;
+        nb_parts = (size_t)nb_parts < max_parts ? nb_parts : (int)max_parts;
+        nb_parts = nb_parts > 1 ? nb_parts : 1;
+    }
+
+    const char *begin = src;
+    int i;
+    for(i = 0; i < nb_parts; ++i) {
+        memcpy(&parts[i], &header, sizeof(validate_part_t));
+        parts[i].ctx = &ctx;
+        parts[i].first = i == 0;
+        parts[i].begin = begin;
+        parts[i].end = i == nb_parts - 1 ? end : split_point(src + (end - src) * (i + 1) / nb_parts, end);
+        parts[i].end = parts[i].end > begin ? parts[i].end : begin;
+        begin = parts[i].end;
+    }
+
+    pthread_t threads[VALIDATE_MAX_THREADS];
+    bool_t started[VALIDATE_MAX_THREADS];
+    for(i = 1; i < nb_parts; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, validate_part, &parts[i]) == 0;
+    }
+    validate_part(&parts[0]);
+    for(i = 1; i < nb_parts; ++i) {
+        if(started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            validate_part(&parts[i]);
+        }
+    }
+
+    validate_join(parts, nb_parts);
+
+    if(!validation->master) {
+        bool_t has_target_duration = HLS_FALSE;
+        bool_t has_pdt = HLS_FALSE;
+        const char *daterange = NULL;
+        for(i = 0; i < nb_parts; ++i) {
+            has_target_duration = has_target_duration || parts[i].has_target_duration;
+            has_pdt = has_pdt || parts[i].has_pdt;
+            daterange = daterange ? daterange : parts[i].daterange;
+        }
+        if(!has_target_duration) {
+            report(&ctx, VIOLATION_TARGET_DURATION, src);
+        }
+        if(daterange && !has_pdt) {
+            report(&ctx, VIOLATION_DATERANGE_PDT, daterange);
+        }
+    }
+
+    pthread_mutex_destroy(&ctx.lock);
+    return HLS_OK;
+}
+
+const char *hlsparse_violation_name(int rule)
+{
+    int i;
+    for(i = 0; i < VIOLATION_COUNT; ++i) {
+        if(rule == (1 << i)) {
+            return violation_names[i];
+        }
+    }
+    return NULL;
+}
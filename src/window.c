@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include <string.h>
+#include "parse.h"
+
+/**
+ * Gets a segment record for the playlist, reusing an expired one when possible.
+ * The list node which held the recycled segment is kept for the next call to
+ * media_playlist_alloc_segment_node.
+ *
+ * @param playlist The playlist the segment is for
+ * @returns an initialized segment, or NULL if none could be allocated
+ */
+segment_t *media_playlist_alloc_segment(media_playlist_t *playlist)
+{
+    segment_t *segment = NULL;
+    segment_list_t *node = playlist->free_segments;
+
+    if(node) {
+        playlist->free_segments = node->next;
+        segment = node->data;
+        node->data = NULL;
+        node->next = playlist->free_segment_nodes;
+        playlist->free_segment_nodes = node;
+    } else {
+        segment = hls_malloc(sizeof(segment_t));
+    }
+
+    hlsparse_segment_init(segment);
+    return segment;
+}
+
+/**
+ * Gets a segment list node for the playlist, reusing an expired one when possible.
+ *
+ * @param playlist The playlist the node is for
+ * @returns an initialized node, or NULL if none could be allocated
+ */
+segment_list_t *media_playlist_alloc_segment_node(media_playlist_t *playlist)
+{
+    segment_list_t *node = playlist->free_segment_nodes;
+
+    if(node) {
+        playlist->free_segment_nodes = node->next;
+    } else {
+        node = hls_malloc(sizeof(segment_list_t));
+    }
+
+    hlsparse_segment_list_init(node);
+    return node;
+}
+
+/**
+ * Removes the first segment of a playlist, keeping its record and list node
+ * for reuse. The first list node is embedded in the playlist so the second
+ * node's content is moved into it.
+ */
+static void expire_head(media_playlist_t *playlist)
+{
+    segment_list_t *head = &playlist->segments;
+    segment_t *segment = head->data;
+    segment_list_t *node = head->next;
+
+    // removing a discontinuity from the playlist moves the discontinuity sequence
+    ++(playlist->media_sequence);
+    if(segment->discontinuity) {
+        ++(playlist->discontinuity_sequence);
+    }
+    playlist->duration -= segment->duration;
+    --(playlist->nb_segments);
+
+    head->data = node->data;
+    head->next = node->next;
+    if(playlist->segments_tail == node) {
+        playlist->segments_tail = head;
+    }
+
+    hlsparse_segment_term(segment);
+    hlsparse_segment_init(segment);
+    node->data = segment;
+    node->next = playlist->free_segments;
+    playlist->free_segments = node;
+}
+
+/**
+ * Defines a function removing the first \a count entries of a list whose
+ * first node is embedded in its owner.
+ */
+#define DEFINE_LIST_EXPIRE(name, list_type, term)                           \
+static void name(list_type *head, list_type **tail, int count)              \
+{                                                                           \
+    while(count-- > 0 && head->data) {                                      \
+        list_type *node = head->next;                                       \
+        term(head->data);                                                   \
+        hls_free(head->data);                                               \
+        head->data = node ? node->data : NULL;                              \
+        head->next = node ? node->next : NULL;                              \
+        if(node) {                                                          \
+            if(*tail == node) {                                             \
+                *tail = head;                                               \
+            }                                                               \
+            hls_free(node);                                                 \
+        }                                                                   \
+    }                                                                       \
+}
+
+DEFINE_LIST_EXPIRE(expire_keys, key_list_t, hlsparse_key_term)
+DEFINE_LIST_EXPIRE(expire_maps, map_list_t, hlsparse_map_term)
+DEFINE_LIST_EXPIRE(expire_dateranges, daterange_list_t, hlsparse_daterange_term)
+
+/**
+ * Drops the keys, maps and dateranges which come before the first segment's
+ * and moves the indexes of the remaining segments down accordingly.
+ * This is only done when the first segment has moved past at least one of
+ * them, which happens once per key rotation rather than once per segment.
+ */
+static void expire_unreferenced(media_playlist_t *playlist)
+{
+    const segment_t *first = playlist->segments.data;
+    int keys = first->key_index > 0 ? first->key_index : 0;
+    int maps = first->map_index > 0 ? first->map_index : 0;
+    int dateranges = first->daterange_index > 0 ? first->daterange_index : 0;
+
+    if(keys == 0 && maps == 0 && dateranges == 0) {
+        return;
+    }
+
+    expire_keys(&playlist->keys, &playlist->keys_tail, keys);
+    expire_maps(&playlist->maps, &playlist->maps_tail, maps);
+    expire_dateranges(&playlist->dateranges, &playlist->dateranges_tail, dateranges);
+    playlist->nb_keys -= keys;
+    playlist->nb_maps -= maps;
+    playlist->nb_dateranges -= dateranges;
+
+    segment_list_t *seg = &playlist->segments;
+    while(seg && seg->data) {
+        seg->data->key_index -= keys;
+        seg->data->map_index -= maps;
+        seg->data->daterange_index -= dateranges;
+        seg = seg->next;
+    }
+}
+
+HLSCode hlsparse_media_playlist_expire(media_playlist_t *playlist)
+{
+    if(!playlist) {
+        return HLS_ERROR;
+    }
+
+    int nb_expired = 0;
+
+    // the last segment is always kept
+    while(playlist->segments.data && playlist->segments.next) {
+        bool_t over_size = playlist->window_size > 0 && playlist->nb_segments > playlist->window_size;
+        bool_t over_duration = playlist->window_duration > 0 &&
+                               playlist->duration - playlist->segments.data->duration >= playlist->window_duration;
+        if(!over_size && !over_duration) {
+            break;
+        }
+        expire_head(playlist);
+        ++nb_expired;
+    }
+
+    if(nb_expired > 0) {
+        expire_unreferenced(playlist);
+        if(playlist->merkle_tree) {
+            hlsparse_media_playlist_hash_segments(playlist);
+        }
+    }
+
+    return HLS_OK;
+}
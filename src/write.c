@@ -6,10 +6,12 @@
 
 #include <stdio.h>
 #include <memory.h>
+#include <string.h>
 #include <time.h>
 #include "hlsparse.h"
 #include "write.h"
 #include "parse.h"
+#include "probes.h"
 
 #define PAGE_SIZE   (4096) // 4KB Page size
 
@@ -23,41 +25,212 @@
     latest = pgprintf(latest, "#%s:%d\n", tag_name, value);
 #define ADD_TAG_ENUM(tag_name, value) \
     latest = pgprintf(latest, "#%s:%s\n", tag_name, value);
-#define START_TAG_ENUM(tag_name, param_name, value) \
-    latest = pgprintf(latest, "#%s:%s=%s", tag_name, param_name, value);
-#define START_TAG_STR(tag_name, param_name, value) \
-    latest = pgprintf(latest, "#%s:%s=\"%s\"", tag_name, param_name, value);
-#define START_TAG_INT(tag_name, param_name, value) \
-    latest = pgprintf(latest, "#%s:%s=%d", tag_name, param_name, value);
-#define END_TAG() \
-    latest = pgprintf(latest, "\n");
-#define ADD_PARAM_STR(param_name, value) \
-    latest = pgprintf(latest, ",%s=\"%s\"", param_name, value);
-#define ADD_PARAM_INT(param_name, value) \
-    latest = pgprintf(latest, ",%s=%d", param_name, value);
-#define ADD_PARAM_INT_OPTL(param_name, value) \
-    if(value > 0) { latest = pgprintf(latest, ",%s=%d", param_name, value); }
-#define ADD_PARAM_FLOAT_OPTL(param_name, value) \
-    if(value > 0.f) { latest = pgprintf(latest, ",%s=%.3f", param_name, value); }
-#define ADD_PARAM_STR_OPTL(param_name, value) \
-    if(value) { latest = pgprintf(latest, ",%s=\"%s\"", param_name, value); }
-#define ADD_PARAM_HEX_OPTL(param_name, value, count) \
-    if(value) { latest = pgprintf(latest, ",%s=0x", param_name); int l=0; while(l<count) { latest = pgprintf(latest, "%02X", (uint8_t)value[l]); ++l; } }
-#define ADD_PARAM_BOOL_YES_ONLY(param_name, value) \
-    if(value == HLS_TRUE) { latest = pgprintf(latest, ",%s=%s", param_name, YES); }
-#define ADD_PARAM_RES_OPTL(param_name, value) \
-    latest = pgprintf(latest, ",%s=%dx%d", param_name, value.width, value.height);
 #define ADD_URI(value) \
     latest = pgprintf(latest, "%s\n", value);
+#define ADD_ATTRIBUTES(tag_name, schema, value, base) \
+    if(!(latest = write_attributes(latest, tag_name, schema, value, base))) { free_page_root(root); return HLS_ERROR; }
 
 void timestamp_to_iso_date(timestamp_t timestamp, char *date_str, size_t size)
 {
     int milli = (int)(timestamp % 1000LL);
     time_t time = timestamp / 1000LL;
-    struct tm *gmt = gmtime(&time);
-    char tmp[30];
-    strftime(tmp, 30, "%FT%T", gmt);
-    snprintf(date_str, size, "%s.%03dZ", tmp, milli);
+    // gmtime_r rather than gmtime's shared buffer so threads can write at once,
+    // formatted by hand as strftime consults the locale
+    struct tm gmt;
+    gmtime_r(&time, &gmt);
+    snprintf(date_str, size, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             gmt.tm_year + 1900, gmt.tm_mon + 1, gmt.tm_mday,
+             gmt.tm_hour, gmt.tm_min, gmt.tm_sec, milli);
+}
+
+static page_t *write_str(page_t *latest, const char *str)
+{
+    return write_to_page(latest, str, strlen(str));
+}
+
+static page_t *write_hex(page_t *latest, const char *data, size_t size)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char buf[2];
+    size_t i;
+    latest = write_to_page(latest, "0x", 2);
+    for(i = 0; i < size; ++i) {
+        buf[0] = digits[(uint8_t)data[i] >> 4];
+        buf[1] = digits[(uint8_t)data[i] & 0xF];
+        latest = write_to_page(latest, buf, 2);
+    }
+    return latest;
+}
+
+/**
+ * Starts an attribute, the first follows the tag's ':' and the others a ','
+ */
+static page_t *write_attr_name(page_t *latest, char *sep, const char *name, size_t len)
+{
+    latest = write_to_page(latest, sep, 1);
+    latest = write_to_page(latest, name, len);
+    latest = write_to_page(latest, "=", 1);
+    *sep = ',';
+    return latest;
+}
+
+static const char *attr_value_name(const attr_value_t *values, int value)
+{
+    while(values->name && values->value != value) {
+        ++values;
+    }
+    return values->name;
+}
+
+/**
+ * Writes a tag with an attribute-list, the attributes are written in the order
+ * of \a schema and those which aren't ATTR_REQUIRED only when they have a value.
+ *
+ * @param latest The page to write to
+ * @param tag The tag's name
+ * @param schema The attributes of src
+ * @param src The object to write the attributes of, e.g. a media_t
+ * @param base The playlist's uri which ATTR_URI attributes are written relative to, may be NULL
+ * @returns the page written to last, NULL when a required ATTR_ENUM has no name to write
+ */
+static page_t *write_attributes(page_t *latest, const char *tag, const attr_schema_t *schema, const void *src, const char *base)
+{
+    char sep = ':';
+    int i;
+
+    latest = write_to_page(latest, "#", 1);
+    latest = write_str(latest, tag);
+
+    for(i = 0; i < schema->nb_attrs; ++i) {
+        const attr_t *attr = &schema->attrs[i];
+        const char *value = (const char*)src + attr->offset;
+        bool_t required = (attr->flags & ATTR_REQUIRED) != 0;
+
+        if(attr->flags & ATTR_READ_ONLY) {
+            continue;
+        }
+
+        switch(attr->type) {
+            case ATTR_INT:
+            case ATTR_BANDWIDTH: {
+                int number = attr->type == ATTR_INT ? *(const int*)value : (int)*(const float*)value;
+                if(required || number > 0) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "%d", number);
+                }
+            } break;
+            case ATTR_FLOAT: {
+                float number = *(const float*)value;
+                if(required || number > 0.f) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "%.3f", number);
+                }
+            } break;
+            case ATTR_STR:
+            case ATTR_CLOSED_CAPTIONS: {
+                const char *str = *(const char* const*)value;
+                if(str && base && (attr->flags & ATTR_URI)) {
+                    str = find_relative_path(str, base);
+                }
+                if(required || str) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    if(attr->type == ATTR_CLOSED_CAPTIONS && str && 0 == strcmp(str, NONE)) {
+                        // NONE is an enumerated-string, not a group
+                        latest = write_str(latest, NONE);
+                    } else {
+                        latest = write_to_page(latest, "\"", 1);
+                        latest = write_str(latest, str ? str : "");
+                        latest = write_to_page(latest, "\"", 1);
+                    }
+                }
+            } break;
+            case ATTR_ENUM: {
+                const char *name = attr_value_name(attr->values, *(const int*)value);
+                if(name) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = write_str(latest, name);
+                } else if(required) {
+                    return NULL;
+                }
+            } break;
+            case ATTR_YES_NO:
+                if(*(const bool_t*)value == HLS_TRUE) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = write_str(latest, YES);
+                }
+                break;
+            case ATTR_RESOLUTION: {
+                const resolution_t *resolution = (const resolution_t*)value;
+                if(required || resolution->width > 0 || resolution->height > 0) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "%dx%d", resolution->width, resolution->height);
+                }
+            } break;
+            case ATTR_DATA: {
+                const char *data = *(const char* const*)value;
+                if(data) {
+                    size_t size = *(const size_t*)((const char*)src + attr->aux_offset);
+                    if(!size && (attr->flags & ATTR_IV)) {
+                        size = key_iv_size((const hls_key_t*)src);
+                    }
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = write_hex(latest, data, size);
+                }
+            } break;
+            case ATTR_DATE: {
+                timestamp_t date = *(const timestamp_t*)value;
+                if(required || date > 0) {
+                    char buf[30];
+                    timestamp_to_iso_date(date, buf, 30);
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "\"%s\"", buf);
+                }
+            } break;
+            case ATTR_BYTE_RANGE: {
+                const byte_range_t *range = (const byte_range_t*)value;
+                if(range->n > 0) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "\"%d@%d\"", range->n, range->o);
+                }
+            } break;
+            case ATTR_INSTREAM_ID: {
+                int instream_id = *(const int*)value;
+                const char *name = attr_value_name(attr->values, instream_id);
+                if(instream_id == MEDIA_INSTREAMID_SERVICE) {
+                    int service_n = *(const int*)((const char*)src + attr->aux_offset);
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "\"%s%d\"", SERVICE, service_n);
+                } else if(name) {
+                    latest = write_attr_name(latest, &sep, attr->name, attr->len);
+                    latest = pgprintf(latest, "\"%s\"", name);
+                }
+            } break;
+            case ATTR_CLIENT: {
+                const param_list_t *param = (const param_list_t*)value;
+                while(param && param->key) {
+                    switch(param->value_type) {
+                        case PARAM_TYPE_STRING:
+                            latest = write_attr_name(latest, &sep, param->key, strlen(param->key));
+                            latest = pgprintf(latest, "\"%s\"", param->value.data);
+                            break;
+                        case PARAM_TYPE_DATA:
+                            if(param->value.data) {
+                                latest = write_attr_name(latest, &sep, param->key, strlen(param->key));
+                                latest = write_hex(latest, param->value.data, param->value_size);
+                            }
+                            break;
+                        case PARAM_TYPE_FLOAT:
+                            latest = write_attr_name(latest, &sep, param->key, strlen(param->key));
+                            latest = pgprintf(latest, "%.3f", param->value.number);
+                            break;
+                    }
+                    param = param->next;
+                }
+            } break;
+        }
+    }
+
+    return write_to_page(latest, "\n", 1);
 }
 
 const char* find_relative_path(const char *path, const char *base)
@@ -84,6 +257,14 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master)
         return HLS_ERROR;
     }
 
+    HLS_PROBE2(write_master_start, master, master->nb_stream_infs);
+    uint64_t start = hls_metrics_enabled ? metrics_now() : 0;
+
+    // every attribute is written so lazily parsed ones are decoded first
+    if(master->lazy_attributes) {
+        hlsparse_master_decode(master);
+    }
+
     page_t *root = create_page(NULL);
     page_t *latest = root;
     
@@ -96,42 +277,7 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master)
 
     media_list_t *media = &master->media;
     while(media && media->data) {
-        switch(media->data->type) {
-            case MEDIA_TYPE_AUDIO: START_TAG_ENUM(EXTXMEDIA, TYPE, AUDIO); break;
-            case MEDIA_TYPE_VIDEO: START_TAG_ENUM(EXTXMEDIA, TYPE, VIDEO); break;
-            case MEDIA_TYPE_SUBTITLES: START_TAG_ENUM(EXTXMEDIA, TYPE, SUBTITLES); break;
-            case MEDIA_TYPE_CLOSEDCAPTIONS: START_TAG_ENUM(EXTXMEDIA, TYPE, CLOSEDCAPTIONS); break;
-        }
-
-        if(master->uri) {
-            const char *uri = find_relative_path(media->data->uri, master->uri);
-            ADD_PARAM_STR_OPTL(URI, uri);
-        }else{
-            ADD_PARAM_STR_OPTL(URI, media->data->uri);
-        }
-        ADD_PARAM_STR(GROUPID, media->data->group_id);
-        ADD_PARAM_STR_OPTL(LANGUAGE, media->data->language);
-        ADD_PARAM_STR_OPTL(ASSOCLANGUAGE, media->data->language);
-        ADD_PARAM_STR_OPTL(ASSOCLANGUAGE, media->data->assoc_language);
-        ADD_PARAM_STR(NAME, media->data->name);
-        ADD_PARAM_BOOL_YES_ONLY(DEFAULT, media->data->is_default);
-        ADD_PARAM_BOOL_YES_ONLY(AUTOSELECT, media->data->auto_select);
-        ADD_PARAM_BOOL_YES_ONLY(FORCED, media->data->forced);
-
-        switch(media->data->instream_id) {
-            case MEDIA_INSTREAMID_CC1: ADD_PARAM_STR(INSTREAMID, CC1); break;
-            case MEDIA_INSTREAMID_CC2: ADD_PARAM_STR(INSTREAMID, CC2); break;
-            case MEDIA_INSTREAMID_CC3: ADD_PARAM_STR(INSTREAMID, CC3); break;
-            case MEDIA_INSTREAMID_CC4: ADD_PARAM_STR(INSTREAMID, CC4); break;
-            case MEDIA_INSTREAMID_SERVICE: {
-                latest = pgprintf(latest, ",%s=\"%s%d\"", INSTREAMID, SERVICE, media->data->service_n);
-                } break;
-        }
-
-        ADD_PARAM_STR_OPTL(CHARACTERISTICS, media->data->characteristics);
-        ADD_PARAM_STR_OPTL(CHANNELS, media->data->channels);
-        END_TAG();
-        
+        ADD_ATTRIBUTES(EXTXMEDIA, &media_schema, media->data, master->uri);
         media = media->next;
     }
 
@@ -139,20 +285,7 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master)
     stream_inf_list_t *stream_inf_list = &master->stream_infs;
     while(stream_inf_list && stream_inf_list->data) {
         stream_inf_t *inf = stream_inf_list->data;
-        START_TAG_INT(EXTXSTREAMINF, BANDWIDTH, (int)inf->bandwidth);
-        ADD_PARAM_INT_OPTL(AVERAGEBANDWIDTH, (int)inf->avg_bandwidth);
-        ADD_PARAM_STR_OPTL(CODECS, inf->codecs);
-        ADD_PARAM_RES_OPTL(RESOLUTION, inf->resolution);
-        ADD_PARAM_FLOAT_OPTL(FRAMERATE, inf->frame_rate);
-        switch(inf->hdcp_level) {
-            case HDCP_LEVEL_NONE: latest = pgprintf(latest, ",%s=%s", HDCPLEVEL, NONE); break;
-            case HDCP_LEVEL_TYPE0: latest = pgprintf(latest, ",%s=%s", HDCPLEVEL, TYPE0); break;
-        }
-        ADD_PARAM_STR_OPTL(AUDIO, inf->audio);
-        ADD_PARAM_STR_OPTL(VIDEO, inf->video);
-        ADD_PARAM_STR_OPTL(SUBTITLES, inf->subtitles);
-        ADD_PARAM_STR_OPTL(CLOSEDCAPTIONS, inf->closed_captions);
-        END_TAG();
+        ADD_ATTRIBUTES(EXTXSTREAMINF, &stream_inf_schema, inf, NULL);
         if(master->uri) {
             const char *uri = find_relative_path(inf->uri, master->uri);
             ADD_URI(uri);
@@ -164,61 +297,19 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master)
 
     iframe_stream_inf_list_t *if_stream_inf_list = &master->iframe_stream_infs;
     while(if_stream_inf_list && if_stream_inf_list->data) {
-        iframe_stream_inf_t *inf = if_stream_inf_list->data;
-        START_TAG_INT(EXTXIFRAMESTREAMINF, BANDWIDTH, (int)inf->bandwidth);
-        ADD_PARAM_INT_OPTL(AVERAGEBANDWIDTH, (int)inf->avg_bandwidth);
-        ADD_PARAM_STR_OPTL(CODECS, inf->codecs);
-        ADD_PARAM_RES_OPTL(RESOLUTION, inf->resolution);
-        switch(inf->hdcp_level) {
-            case HDCP_LEVEL_NONE: latest = pgprintf(latest, ",%s=%s", HDCPLEVEL, NONE); break;
-            case HDCP_LEVEL_TYPE0: latest = pgprintf(latest, ",%s=%s", HDCPLEVEL, TYPE0); break;
-        }
-        ADD_PARAM_STR_OPTL(VIDEO, inf->video);
-        if(master->uri) {
-            const char *uri = find_relative_path(inf->uri, master->uri);
-            ADD_PARAM_STR(URI, uri);
-        }else{
-            ADD_PARAM_STR(URI, inf->uri);
-        }
-        
-        END_TAG();
+        ADD_ATTRIBUTES(EXTXIFRAMESTREAMINF, &iframe_stream_inf_schema, if_stream_inf_list->data, master->uri);
         if_stream_inf_list = if_stream_inf_list->next;
     } 
 
     session_data_list_t *sess_data = &master->session_data;
     while(sess_data && sess_data->data) {
-        session_data_t *sess = sess_data->data;
-        START_TAG_STR(EXTXSESSIONDATA, DATAID, sess->data_id);
-        ADD_PARAM_STR_OPTL(VALUE, sess->value);
-        if(master->uri) {
-            const char *uri = find_relative_path(sess->uri, master->uri);
-            ADD_PARAM_STR_OPTL(URI, uri);
-        }else{
-            ADD_PARAM_STR_OPTL(URI, sess->uri);
-        }
-        ADD_PARAM_STR_OPTL(LANGUAGE, sess->language);
-        END_TAG();
+        ADD_ATTRIBUTES(EXTXSESSIONDATA, &session_data_schema, sess_data->data, master->uri);
         sess_data = sess_data->next;
     }
 
     key_list_t *key_list = &master->session_keys;
     while(key_list && key_list->data) {
-        hls_key_t *key = key_list->data;
-        switch(key->method) {
-            case KEY_METHOD_NONE: START_TAG_ENUM(EXTXSESSIONKEY, METHOD, NONE); break;
-            case KEY_METHOD_AES128: START_TAG_ENUM(EXTXSESSIONKEY, METHOD, AES128); break;
-            case KEY_METHOD_SAMPLEAES: START_TAG_ENUM(EXTXSESSIONKEY, METHOD, SAMPLEAES); break;
-        }
-        if(master->uri) {
-            const char *uri = find_relative_path(key->uri, master->uri);
-            ADD_PARAM_STR_OPTL(URI, uri);
-        }else {
-            ADD_PARAM_STR_OPTL(URI, key->uri);
-        }
-        ADD_PARAM_HEX_OPTL(KEY_IV, key->iv, 16);
-        ADD_PARAM_STR_OPTL(KEYFORMAT, key->key_format);
-        ADD_PARAM_STR_OPTL(KEYFORMATVERSIONS, key->key_format_versions);
-        END_TAG();
+        ADD_ATTRIBUTES(EXTXSESSIONKEY, &key_schema, key_list->data, master->uri);
         key_list = key_list->next;
     }
 
@@ -226,6 +317,10 @@ HLSCode hlswrite_master(char **dest, int *dest_size, master_t *master)
     
     free_page_root(root);
 
+    if(start) {
+        metrics_write(HLS_TRUE, *dest_size, start);
+    }
+    HLS_PROBE1(write_master_done, *dest_size);
     return HLS_OK;
 }
 
@@ -235,6 +330,13 @@ HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist)
         return HLS_ERROR;
     }
 
+    HLS_PROBE2(write_media_start, playlist, playlist->nb_segments);
+    uint64_t start = hls_metrics_enabled ? metrics_now() : 0;
+
+    if(playlist->lazy_attributes) {
+        hlsparse_media_playlist_decode(playlist);
+    }
+
     page_t *root = create_page(NULL);
     page_t *latest = root;
 
@@ -258,6 +360,15 @@ HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist)
 
     int i;
     int key_idx = -1; // -1 == no key
+    int map_idx = -1; // -1 == no map
+    int daterange_idx = -1; // -1 == no daterange
+    // keys, maps and dateranges are only ever written in order so each list
+    // is walked once alongside the segments
+    key_list_t *key_list = &playlist->keys;
+    int key_list_idx = 0;
+    map_list_t *map_list = &playlist->maps;
+    int map_list_idx = 0;
+    daterange_list_t *daterange_list = &playlist->dateranges;
     segment_list_t *seg = &playlist->segments;
 
     for(i=0; i<playlist->nb_segments; ++i)
@@ -277,31 +388,29 @@ HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist)
             if(seg->data->key_index > key_idx) {
                 key_idx = seg->data->key_index;
                 // find the key
-                int j=0;
-                key_list_t *key_list = &playlist->keys;
-                hls_key_t *key = NULL;  
-                while(key_list && key_list->data && j++ <= key_idx) {
-                    key = key_list->data;
+                while(key_list_idx < key_idx && key_list->next && key_list->next->data) {
                     key_list = key_list->next;
+                    ++key_list_idx;
                 }
+                hls_key_t *key = key_list->data;
 
                 // add key tag
                 if(key) {
-                    switch(key->method) {
-                        case KEY_METHOD_NONE: START_TAG_ENUM(EXTXKEY, METHOD, NONE); break;
-                        case KEY_METHOD_AES128: START_TAG_ENUM(EXTXKEY, METHOD, AES128); break;
-                        case KEY_METHOD_SAMPLEAES: START_TAG_ENUM(EXTXKEY, METHOD, SAMPLEAES); break;
-                    }
-                    if(playlist->uri) {
-                        const char *uri = find_relative_path(key->uri, playlist->uri);
-                        ADD_PARAM_STR_OPTL(URI, uri);
-                    }else{
-                        ADD_PARAM_STR_OPTL(URI, key->uri);
-                    }
-                    ADD_PARAM_HEX_OPTL(KEY_IV, key->iv, 16);
-                    ADD_PARAM_STR_OPTL(KEYFORMAT, key->key_format);
-                    ADD_PARAM_STR_OPTL(KEYFORMATVERSIONS, key->key_format_versions);
-                    END_TAG();
+                    ADD_ATTRIBUTES(EXTXKEY, &key_schema, key, playlist->uri);
+                }
+            }
+
+            // new Map index?
+            if(seg->data->map_index > map_idx) {
+                map_idx = seg->data->map_index;
+                while(map_list_idx < map_idx && map_list->next && map_list->next->data) {
+                    map_list = map_list->next;
+                    ++map_list_idx;
+                }
+                map_t *map = map_list->data;
+
+                if(map) {
+                    ADD_ATTRIBUTES(EXTXMAP, &map_schema, map, playlist->uri);
                 }
             }
 
@@ -310,6 +419,18 @@ HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist)
                 char buf[30];
                 timestamp_to_iso_date(seg->data->pdt, buf, 30);
                 ADD_TAG_ENUM(EXTXPROGRAMDATETIME, buf);
+            }else if(i > 0 && seg->data->pdt_discontinuity == HLS_TRUE) {
+                // the PDT doesn't follow on from the previous segment
+                char buf[30];
+                timestamp_to_iso_date(seg->data->pdt, buf, 30);
+                ADD_TAG_ENUM(EXTXPROGRAMDATETIME, buf);
+            }
+
+            // dateranges which appeared before this segment
+            while(daterange_idx < seg->data->daterange_index && daterange_list && daterange_list->data) {
+                ADD_ATTRIBUTES(EXTXDATERANGE, &daterange_schema, daterange_list->data, NULL);
+                daterange_list = daterange_list->next;
+                ++daterange_idx;
             }
 
             if(seg->data->byte_range.n > 0) {
@@ -340,6 +461,10 @@ HLSCode hlswrite_media(char **dest, int *dest_size, media_playlist_t *playlist)
 
     free_page_root(root);
 
+    if(start) {
+        metrics_write(HLS_FALSE, *dest_size, start);
+    }
+    HLS_PROBE2(write_media_done, *dest_size, playlist->nb_segments);
     return HLS_OK;
 }
 
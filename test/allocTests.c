@@ -0,0 +1,164 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *alloc_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-SESSION-KEY:METHOD=AES-128,URI=\"keys/session.key\",IV=0x0102030405060708090A0B0C0D0E0F10\n"\
+"#EXT-X-SESSION-KEY:METHOD=SAMPLE-AES,URI=\"keys/session2.key\",KEYFORMAT=\"identity\"\n"\
+"#EXT-X-SESSION-DATA:DATA-ID=\"com.example.title\",VALUE=\"title\"\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"aac\",NAME=\"English\",LANGUAGE=\"en\",URI=\"audio/en.m3u8\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=800000,CODECS=\"mp4a.40.2,avc1.4d401e\",AUDIO=\"aac\"\n"\
+"video/800k.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=80000,URI=\"video/800k_iframes.m3u8\"\n";
+
+const char *alloc_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"keys/0.key\"\n"\
+"#EXT-X-MAP:URI=\"init0.mp4\"\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:55.923Z\n"\
+"#EXTINF:6.000,\n"\
+"segment0.m4s\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"keys/1.key\"\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:10:01.923Z\",DURATION=6.000,SCTE35-OUT=0xFC00002F00\n"\
+"#EXTINF:6.000,\n"\
+"segment1.m4s\n"\
+"#EXT-X-MAP:URI=\"init1.mp4\"\n"\
+"#EXT-X-CUSTOM-TAG:value\n"\
+"#EXTINF:6.000,\n"\
+"segment2.m4s\n"\
+"#EXT-X-ENDLIST\n";
+
+static int has_site(const hlsparse_alloc_stats_t *stats, const char *site)
+{
+    int i;
+    for(i = 0; i < stats->nb_sites; ++i) {
+        if(!strcmp(stats->sites[i].site, site)) {
+            return stats->sites[i].nb_allocs > 0;
+        }
+    }
+    return 0;
+}
+
+void alloc_stats_disabled_test(void)
+{
+    hlsparse_alloc_stats_t stats;
+    CU_ASSERT_EQUAL(hlsparse_alloc_stats(&stats), HLS_ERROR);
+    CU_ASSERT_EQUAL(hlsparse_alloc_stats_reset(), HLS_ERROR);
+
+    CU_ASSERT_EQUAL(hlsparse_alloc_stats_enable(HLS_TRUE), HLS_OK);
+    CU_ASSERT_EQUAL(hlsparse_alloc_stats(NULL), HLS_ERROR);
+    CU_ASSERT_EQUAL(hlsparse_alloc_stats(&stats), HLS_OK);
+    CU_ASSERT_EQUAL(stats.nb_allocs, 0);
+    CU_ASSERT_EQUAL(stats.nb_sites, 0);
+
+    // memory allocated before recording started is ignored when freed
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+    char *str = str_utils_dup("untracked");
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hls_free(str);
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT_EQUAL(stats.nb_frees, 0);
+    CU_ASSERT_EQUAL(stats.live_bytes, 0);
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+}
+
+void alloc_stats_master_test(void)
+{
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+
+    master_t master;
+    hlsparse_master_init(&master);
+    master.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    int res = hlsparse_master(alloc_master_src, strlen(alloc_master_src), &master);
+    CU_ASSERT_EQUAL(res, strlen(alloc_master_src));
+    CU_ASSERT_EQUAL(master.nb_session_keys, 2);
+    assert_string_equal(master.session_keys.data->uri, "http://www.example.com/keys/session.key", __func__, __LINE__);
+    assert_string_equal(master.iframe_stream_infs.data->uri, "http://www.example.com/video/800k_iframes.m3u8", __func__, __LINE__);
+
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT(stats.nb_allocs > 0);
+    CU_ASSERT(stats.live_bytes > 0);
+    CU_ASSERT_EQUAL(stats.peak_live_bytes >= stats.live_bytes, 1);
+    CU_ASSERT_EQUAL(has_site(&stats, "str_utils_ndup"), 1);
+
+    hlsparse_master_term(&master);
+
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT_EQUAL(stats.live_bytes, 0);
+    CU_ASSERT_EQUAL(stats.nb_live, 0);
+    CU_ASSERT_EQUAL(stats.nb_allocs, stats.nb_frees);
+
+    int i;
+    for(i = 0; i < stats.nb_sites; ++i) {
+        CU_ASSERT_EQUAL(stats.sites[i].live_bytes, 0);
+        CU_ASSERT_EQUAL(stats.sites[i].nb_allocs, stats.sites[i].nb_frees);
+    }
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+}
+
+void alloc_stats_media_test(void)
+{
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+
+    media_playlist_t media;
+    hlsparse_media_playlist_init(&media);
+    media.uri = str_utils_dup("http://www.example.com/media/index.m3u8");
+    int res = hlsparse_media_playlist(alloc_media_src, strlen(alloc_media_src), &media);
+    CU_ASSERT_EQUAL(res, strlen(alloc_media_src));
+    CU_ASSERT_EQUAL(media.nb_keys, 2);
+    CU_ASSERT_EQUAL(media.nb_maps, 2);
+    CU_ASSERT_EQUAL(media.nb_dateranges, 1);
+    assert_string_equal(media.segments.data->uri, "http://www.example.com/media/segment0.m4s", __func__, __LINE__);
+
+    hlsparse_alloc_stats_t stats;
+    hlsparse_alloc_stats(&stats);
+    size_t parsed = stats.live_bytes;
+    CU_ASSERT(parsed > 0);
+
+    // the writer's allocations can be measured on their own
+    hlsparse_alloc_stats_reset();
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT_EQUAL(stats.nb_allocs, 0);
+    CU_ASSERT_EQUAL(stats.live_bytes, parsed);
+    CU_ASSERT_EQUAL(stats.peak_live_bytes, parsed);
+
+    char *out = NULL;
+    int size = 0;
+    CU_ASSERT_EQUAL(hlswrite_media(&out, &size, &media), HLS_OK);
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT(stats.nb_allocs > 0);
+    CU_ASSERT(stats.peak_live_bytes > parsed);
+    CU_ASSERT_EQUAL(stats.live_bytes, parsed + size + 1);
+    CU_ASSERT_EQUAL(has_site(&stats, "create_page"), 1);
+    hls_free(out);
+
+    hlsparse_media_playlist_term(&media);
+
+    hlsparse_alloc_stats(&stats);
+    CU_ASSERT_EQUAL(stats.live_bytes, 0);
+    CU_ASSERT_EQUAL(stats.nb_live, 0);
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("alloc", NULL, NULL);
+    test("alloc_stats_disabled", alloc_stats_disabled_test);
+    test("alloc_stats_master", alloc_stats_master_test);
+    test("alloc_stats_media", alloc_stats_media_test);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *preroll_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:5\n"\
+"#EXT-X-PLAYLIST-TYPE:VOD\n"\
+"#EXTINF:5.000,\n"\
+"http://ads.example.com/ad0.ts\n"\
+"#EXTINF:5.000,\n"\
+"http://ads.example.com/ad1.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+const char *chapter_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:4\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-PLAYLIST-TYPE:VOD\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"http://www.example.com/key0.key\"\n"\
+"#EXT-X-MAP:URI=\"http://www.example.com/init.mp4\"\n"\
+"#EXTINF:10.000,\n"\
+"http://www.example.com/chapter0.ts\n"\
+"#EXT-X-DATERANGE:ID=\"chapter\",START-DATE=\"2017-12-09T18:09:56.001Z\"\n"\
+"#EXTINF:10.000,\n"\
+"http://www.example.com/chapter1.ts\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"http://www.example.com/key1.key\"\n"\
+"#EXTINF:10.000,\n"\
+"http://www.example.com/chapter2.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+static void parse(const char *src, media_playlist_t *playlist)
+{
+    hlsparse_media_playlist_init(playlist);
+    hlsparse_media_playlist(src, strlen(src), playlist);
+}
+
+void media_playlist_append_test(void)
+{
+    media_playlist_t program, chapter, postroll;
+    parse(preroll_src, &program);
+    parse(chapter_src, &chapter);
+    parse(preroll_src, &postroll);
+
+    HLSCode res = hlsparse_media_playlist_append(&program, &chapter);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(program.nb_segments, 5);
+    CU_ASSERT_EQUAL(program.nb_keys, 2);
+    CU_ASSERT_EQUAL(program.nb_maps, 1);
+    CU_ASSERT_EQUAL(program.nb_dateranges, 1);
+    CU_ASSERT_EQUAL(program.version, 4);
+    CU_ASSERT_EQUAL(program.target_duration, 10);
+    CU_ASSERT_EQUAL(program.duration, 40);
+    CU_ASSERT_EQUAL(program.end_list, HLS_TRUE);
+    assert_string_equal(program.last_segment->uri, "http://www.example.com/chapter2.ts", __func__, __LINE__);
+
+    // the chapter has been taken over by the program
+    CU_ASSERT_EQUAL(chapter.nb_segments, 0);
+    CU_ASSERT_EQUAL(chapter.segments.data, NULL);
+    CU_ASSERT_EQUAL(chapter.keys.data, NULL);
+    CU_ASSERT_EQUAL(chapter.uri, NULL);
+
+    res = hlsparse_media_playlist_append(&program, &postroll);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(program.nb_segments, 7);
+    CU_ASSERT_EQUAL(program.nb_keys, 3);
+    CU_ASSERT_EQUAL(program.keys_tail->data->method, KEY_METHOD_NONE);
+
+    int sequence = 0;
+    segment_list_t *seg = &program.segments;
+    while(seg && seg->data) {
+        CU_ASSERT_EQUAL(seg->data->sequence_num, sequence);
+        ++sequence;
+        seg = seg->next;
+    }
+    CU_ASSERT_EQUAL(sequence, 7);
+    CU_ASSERT_EQUAL(program.segments_tail->data, program.last_segment);
+
+    seg = program.segments.next->next;
+    CU_ASSERT_EQUAL(seg->data->discontinuity, HLS_TRUE);
+    CU_ASSERT_EQUAL(seg->data->key_index, 0);
+    CU_ASSERT_EQUAL(seg->data->map_index, 0);
+    CU_ASSERT_EQUAL(seg->next->data->daterange_index, 0);
+    CU_ASSERT_EQUAL(seg->next->next->data->key_index, 1);
+    seg = seg->next->next->next;
+    CU_ASSERT_EQUAL(seg->data->discontinuity, HLS_TRUE);
+    CU_ASSERT_EQUAL(seg->data->key_index, 2);
+    CU_ASSERT_EQUAL(seg->next->data->key_index, 2);
+
+    char *out = NULL;
+    int size = 0;
+    hlswrite_media(&out, &size, &program);
+    const char *expected = "#EXT-X-ENDLIST\n";
+    CU_ASSERT_NOT_EQUAL(strstr(out, "#EXT-X-KEY:METHOD=NONE\n#EXT-X-DISCONTINUITY\n"), NULL);
+    CU_ASSERT_EQUAL(strcmp(out + size - strlen(expected), expected), 0);
+    hls_free(out);
+
+    res = hlsparse_media_playlist_append(&program, &program);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+    res = hlsparse_media_playlist_append(NULL, &program);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    hlsparse_media_playlist_term(&program);
+}
+
+void media_playlist_append_empty_test(void)
+{
+    media_playlist_t program, chapter;
+    hlsparse_media_playlist_init(&program);
+    parse(chapter_src, &chapter);
+
+    HLSCode res = hlsparse_media_playlist_append(&program, &chapter);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(program.nb_segments, 3);
+    CU_ASSERT_EQUAL(program.nb_keys, 2);
+    CU_ASSERT_EQUAL(program.segments.data->discontinuity, HLS_FALSE);
+    CU_ASSERT_EQUAL(program.segments.data->key_index, 0);
+    assert_string_equal(program.segments.data->uri, "http://www.example.com/chapter0.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(program.segments_tail->data, program.last_segment);
+
+    // appending an empty playlist changes nothing
+    media_playlist_t empty;
+    hlsparse_media_playlist_init(&empty);
+    res = hlsparse_media_playlist_append(&program, &empty);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(program.nb_segments, 3);
+    CU_ASSERT_EQUAL(program.nb_keys, 2);
+
+    hlsparse_media_playlist_term(&program);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("append", NULL, NULL);
+    test("media_playlist_append", media_playlist_append_test);
+    test("media_playlist_append_empty", media_playlist_append_empty_test);
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+// written in the order the writer writes the attributes so it comes back out unchanged
+static const char *attributes_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=CLOSED-CAPTIONS,GROUP-ID=\"cc\",NAME=\"CC\",DEFAULT=YES,INSTREAM-ID=\"SERVICE3\"\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",LANGUAGE=\"en\",ASSOC-LANGUAGE=\"en-GB\",NAME=\"English\",AUTOSELECT=YES,FORCED=YES,CHARACTERISTICS=\"public.accessibility\",CHANNELS=\"2\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,AVERAGE-BANDWIDTH=850000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,FRAME-RATE=29.970,HDCP-LEVEL=TYPE-0,AUDIO=\"aac\",CLOSED-CAPTIONS=NONE\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=64000,CODECS=\"mp4a.40.2\",AUDIO=\"aac\",CLOSED-CAPTIONS=\"cc\"\n"\
+"64.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,RESOLUTION=1280x720,HDCP-LEVEL=NONE,URI=\"iframe.m3u8\"\n"\
+"#EXT-X-SESSION-DATA:DATA-ID=\"com.example.title\",VALUE=\"title\",LANGUAGE=\"en\"\n"\
+"#EXT-X-SESSION-KEY:METHOD=AES-128,URI=\"key.bin\",IV=0x000102030405060708090A0B0C0D0E0F,KEYFORMAT=\"identity\"\n";
+
+static const char *attributes_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:0\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.000Z\n"\
+"#EXT-X-KEY:METHOD=SAMPLE-AES,URI=\"key.bin\",KEYFORMAT=\"com.example\",KEYFORMATVERSIONS=\"1\"\n"\
+"#EXT-X-MAP:URI=\"init.mp4\",BYTERANGE=\"720@0\"\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",CLASS=\"com.example\",START-DATE=\"2017-12-09T18:09:46.000Z\",DURATION=10.000,X-COM-EXAMPLE=\"a\",X-COM-DATA=0xAB01,SCTE35-OUT=0xFC002F00,END-ON-NEXT=YES\n"\
+"#EXTINF:10.000,\n"\
+"segment0.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+static int schema_fields(const attr_schema_t *schema)
+{
+    int fields = 0;
+    int i;
+    for(i = 0; i < schema->nb_attrs; ++i) {
+        // each attribute has a flag of its own
+        CU_ASSERT_EQUAL(fields & schema->attrs[i].field, 0);
+        fields |= schema->attrs[i].field;
+    }
+    return fields;
+}
+
+static void assert_unique_names(const attr_schema_t *schema)
+{
+    int i, j;
+    for(i = 0; i < schema->nb_attrs; ++i) {
+        CU_ASSERT_EQUAL(schema->attrs[i].len, strlen(schema->attrs[i].name));
+        for(j = i + 1; j < schema->nb_attrs; ++j) {
+            CU_ASSERT_NOT_EQUAL(strcmp(schema->attrs[i].name, schema->attrs[j].name), 0);
+        }
+    }
+}
+
+void attributes_schema_test(void)
+{
+    // the lazily parsed tags have a flag for every attribute in the schema
+    CU_ASSERT_EQUAL(schema_fields(&stream_inf_schema), STREAM_INF_ATTR_ALL);
+    CU_ASSERT_EQUAL(schema_fields(&media_schema), MEDIA_ATTR_ALL);
+    CU_ASSERT_EQUAL(schema_fields(&daterange_schema), DATERANGE_ATTR_ALL);
+
+    assert_unique_names(&stream_inf_schema);
+    assert_unique_names(&iframe_stream_inf_schema);
+    assert_unique_names(&media_schema);
+    assert_unique_names(&key_schema);
+    assert_unique_names(&map_schema);
+    assert_unique_names(&session_data_schema);
+    assert_unique_names(&daterange_schema);
+}
+
+void attributes_unknown_test(void)
+{
+    // attributes which only start with a known name, and quoted values holding
+    // known names, are stepped over whole
+    const char *src = "#EXT-X-STREAM-INF:BANDWIDTH=1000,VIDEO-RANGE=PQ,PATHWAY-ID=\"CODECS=x,AUDIO=y\",VIDEO=\"v\",SCORE=2.5";
+    stream_inf_t stream_inf;
+    hlsparse_stream_inf_init(&stream_inf);
+    CU_ASSERT_EQUAL(parse_stream_inf(src, strlen(src), &stream_inf), strlen(src));
+    CU_ASSERT_EQUAL(stream_inf.bandwidth, 1000.f);
+    CU_ASSERT_EQUAL(stream_inf.codecs, NULL);
+    CU_ASSERT_EQUAL(stream_inf.audio, NULL);
+    CU_ASSERT(stream_inf.video && 0 == strcmp(stream_inf.video, "v"));
+    hlsparse_stream_inf_term(&stream_inf);
+
+    // a method which only starts with a known one isn't it
+    hls_key_t key;
+    hlsparse_key_init(&key);
+    const char *key_src = "METHOD=SAMPLE-AES-CBC,URI=\"key.bin\"";
+    CU_ASSERT_EQUAL(parse_key(key_src, strlen(key_src), &key), strlen(key_src));
+    CU_ASSERT_EQUAL(key.method, KEY_METHOD_INVALID);
+    CU_ASSERT(key.uri && 0 == strcmp(key.uri, "key.bin"));
+    hlsparse_key_term(&key);
+}
+
+void attributes_write_master_test(void)
+{
+    master_t master;
+    hlsparse_master_init(&master);
+    master.skip_fields = PARSE_FIELD_RESOLVED_URIS;
+    hlsparse_master(attributes_master_src, strlen(attributes_master_src), &master);
+
+    CU_ASSERT_EQUAL(master.media.data->service_n, 3);
+    CU_ASSERT(0 == strcmp(master.stream_infs.data->closed_captions, NONE));
+
+    char *out = NULL;
+    int size = 0;
+    CU_ASSERT_EQUAL(hlswrite_master(&out, &size, &master), HLS_OK);
+    CU_ASSERT_STRING_EQUAL(out, attributes_master_src);
+    hlsparse_free(out);
+    hlsparse_master_term(&master);
+}
+
+void attributes_write_media_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.skip_fields = PARSE_FIELD_RESOLVED_URIS;
+    hlsparse_media_playlist(attributes_media_src, strlen(attributes_media_src), &playlist);
+
+    CU_ASSERT_EQUAL(playlist.dateranges.data->scte35_out_size, 4);
+    CU_ASSERT_EQUAL(playlist.maps.data->byte_range.n, 720);
+
+    char *out = NULL;
+    int size = 0;
+    CU_ASSERT_EQUAL(hlswrite_media(&out, &size, &playlist), HLS_OK);
+    CU_ASSERT_STRING_EQUAL(out, attributes_media_src);
+    hlsparse_free(out);
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void attributes_key_method_test(void)
+{
+    // SAMPLE-AES-CTR isn't read as the SAMPLE-AES it starts with, its uri is
+    // resolved and it is written back unchanged
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-VERSION:7\n"\
+    "#EXT-X-TARGETDURATION:10\n"\
+    "#EXT-X-MEDIA-SEQUENCE:0\n"\
+    "#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.000Z\n"\
+    "#EXT-X-KEY:METHOD=SAMPLE-AES-CTR,URI=\"k.bin\",KEYFORMAT=\"com.example\"\n"\
+    "#EXTINF:10.000,\n"\
+    "segment0.ts\n"\
+    "#EXT-X-ENDLIST\n";
+
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.uri = str_utils_dup("http://www.example.com/media.m3u8");
+    hlsparse_media_playlist(src, strlen(src), &playlist);
+    CU_ASSERT_EQUAL(playlist.keys.data->method, KEY_METHOD_SAMPLEAESCTR);
+    CU_ASSERT_STRING_EQUAL(playlist.keys.data->uri, "http://www.example.com/k.bin");
+
+    char *out = NULL;
+    int size = 0;
+    CU_ASSERT_EQUAL(hlswrite_media(&out, &size, &playlist), HLS_OK);
+    CU_ASSERT_STRING_EQUAL(out, src);
+    hlsparse_free(out);
+
+    // a key is never written without its method
+    out = NULL;
+    playlist.keys.data->method = KEY_METHOD_INVALID;
+    CU_ASSERT_EQUAL(hlswrite_media(&out, &size, &playlist), HLS_ERROR);
+    CU_ASSERT_EQUAL(out, NULL);
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("attributes", NULL, NULL);
+    test("attributes_schema", attributes_schema_test);
+    test("attributes_unknown", attributes_unknown_test);
+    test("attributes_write_master", attributes_write_master_test);
+    test("attributes_write_media", attributes_write_media_test);
+    test("attributes_key_method", attributes_key_method_test);
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <stdio.h>
+#include <CUnit/Basic.h>
+
+#define SNAPSHOT_PATH "binary_test.snap"
+
+const char *media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:4\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:1034\n"\
+"#EXT-X-PLAYLIST-TYPE:VOD\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.key\",IV=0x0102030405060708090A0B0C0D0E0F10\n"\
+"#EXT-X-MAP:URI=\"init.mp4\",BYTERANGE=\"720@0\"\n"\
+"#EXTINF:10.000,first\n"\
+"segment0.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:56.001Z\",SCTE35-OUT=0xFC002F,X-COM-EXAMPLE=\"value\"\n"\
+"#EXT-CUSTOM-TAG\n"\
+"#EXT-X-BYTERANGE:940@188\n"\
+"#EXTINF:8.500,\n"\
+"segment1.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXTINF:10.000,\n"\
+"segment2.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+const char *master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\",LANGUAGE=\"en\",DEFAULT=YES\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,AUDIO=\"aac\"\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=1500000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1920x1080,AUDIO=\"aac\"\n"\
+"1500.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:URI=\"iframe.m3u8\",BANDWIDTH=90000\n"\
+"#EXT-X-SESSION-DATA:DATA-ID=\"com.example.title\",VALUE=\"title\"\n"\
+"#EXT-X-SESSION-KEY:METHOD=AES-128,URI=\"session.key\"\n"\
+"#EXT-X-INDEPENDENT-SEGMENTS\n";
+
+void media_playlist_binary_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.uri = str_utils_dup("http://www.example.com/variant/playlist.m3u8");
+    hlsparse_media_playlist(media_src, strlen(media_src), &playlist);
+
+    HLSCode res = hlsparse_media_playlist_save_binary(SNAPSHOT_PATH, &playlist);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    media_playlist_t *loaded = NULL;
+    res = hlsparse_media_playlist_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(loaded, NULL);
+
+    CU_ASSERT_EQUAL(loaded->version, 4);
+    CU_ASSERT_EQUAL(loaded->media_sequence, 1034);
+    CU_ASSERT_EQUAL(loaded->nb_segments, 3);
+    CU_ASSERT_EQUAL(loaded->nb_keys, 1);
+    CU_ASSERT_EQUAL(loaded->nb_maps, 1);
+    CU_ASSERT_EQUAL(loaded->nb_dateranges, 1);
+    CU_ASSERT_EQUAL(loaded->end_list, HLS_TRUE);
+    assert_string_equal(loaded->uri, playlist.uri, __func__, __LINE__);
+
+    // segment records are contiguous
+    segment_list_t *seg = &loaded->segments;
+    CU_ASSERT_EQUAL(seg->next->data, seg->data + 1);
+    CU_ASSERT_EQUAL(seg->next->next->data, seg->data + 2);
+    CU_ASSERT_EQUAL(seg->next->next->next, NULL);
+    CU_ASSERT_EQUAL(loaded->last_segment, seg->data + 2);
+
+    assert_string_equal(seg->data->uri, "http://www.example.com/variant/segment0.ts", __func__, __LINE__);
+    assert_string_equal(seg->data->title, "first", __func__, __LINE__);
+    CU_ASSERT_EQUAL(seg->data->pdt, playlist.segments.data->pdt);
+    seg = seg->next;
+    CU_ASSERT_EQUAL(seg->data->byte_range.n, 940);
+    CU_ASSERT_EQUAL(seg->data->byte_range.o, 188);
+    CU_ASSERT_EQUAL(seg->data->daterange_index, 0);
+    assert_string_equal(seg->data->custom_tags.data, "EXT-CUSTOM-TAG", __func__, __LINE__);
+    CU_ASSERT_EQUAL(seg->data->custom_tags.next, NULL);
+    seg = seg->next;
+    CU_ASSERT_EQUAL(seg->data->discontinuity, HLS_TRUE);
+
+    hls_key_t *key = loaded->keys.data;
+    CU_ASSERT_EQUAL(key->method, KEY_METHOD_AES128);
+    assert_string_equal(key->uri, "http://www.example.com/variant/key0.key", __func__, __LINE__);
+    CU_ASSERT_EQUAL(key->iv_size, 16);
+    CU_ASSERT_EQUAL(memcmp(key->iv, playlist.keys.data->iv, 16), 0);
+
+    map_t *map = loaded->maps.data;
+    assert_string_equal(map->uri, "init.mp4", __func__, __LINE__);
+    CU_ASSERT_EQUAL(map->byte_range.n, 720);
+
+    daterange_t *daterange = loaded->dateranges.data;
+    assert_string_equal(daterange->id, "ad", __func__, __LINE__);
+    CU_ASSERT_EQUAL(daterange->scte35_out_size, 3);
+    CU_ASSERT_EQUAL(memcmp(daterange->scte35_out, "\xFC\x00\x2F", 3), 0);
+    assert_string_equal(daterange->client_attributes.key, "X-COM-EXAMPLE", __func__, __LINE__);
+    assert_string_equal(daterange->client_attributes.value.data, "value", __func__, __LINE__);
+
+    // the snapshot writes the same playlist as the original
+    char *out = NULL, *loaded_out = NULL;
+    int size = 0, loaded_size = 0;
+    hlswrite_media(&out, &size, &playlist);
+    hlswrite_media(&loaded_out, &loaded_size, loaded);
+    CU_ASSERT_EQUAL(size, loaded_size);
+    assert_string_equal(out, loaded_out, __func__, __LINE__);
+    hls_free(out);
+    hls_free(loaded_out);
+
+    res = hlsparse_media_playlist_unload_binary(loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    // a media snapshot can't be loaded as a master
+    master_t *master = NULL;
+    res = hlsparse_master_load_binary(SNAPSHOT_PATH, &master);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+    CU_ASSERT_EQUAL(master, NULL);
+
+    remove(SNAPSHOT_PATH);
+    hlsparse_media_playlist_term(&playlist);
+
+    res = hlsparse_media_playlist_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+    res = hlsparse_media_playlist_save_binary(NULL, NULL);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+}
+
+void master_binary_test(void)
+{
+    master_t master;
+    hlsparse_master_init(&master);
+    master.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    hlsparse_master(master_src, strlen(master_src), &master);
+
+    HLSCode res = hlsparse_master_save_binary(SNAPSHOT_PATH, &master);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    master_t *loaded = NULL;
+    res = hlsparse_master_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(loaded, NULL);
+
+    CU_ASSERT_EQUAL(loaded->version, 7);
+    CU_ASSERT_EQUAL(loaded->nb_stream_infs, 2);
+    CU_ASSERT_EQUAL(loaded->nb_iframe_stream_infs, 1);
+    CU_ASSERT_EQUAL(loaded->nb_session_keys, 1);
+    CU_ASSERT_EQUAL(loaded->independent_segments, HLS_TRUE);
+    assert_string_equal(loaded->media.data->group_id, "aac", __func__, __LINE__);
+    CU_ASSERT_EQUAL(loaded->media.data->is_default, HLS_TRUE);
+    assert_string_equal(loaded->stream_infs.next->data->uri, "http://www.example.com/1500.m3u8", __func__, __LINE__);
+    CU_ASSERT_EQUAL(loaded->stream_infs.next->data->resolution.height, 1080);
+    assert_string_equal(loaded->session_data.data->value, "title", __func__, __LINE__);
+    assert_string_equal(loaded->session_keys.data->uri, "http://www.example.com/session.key", __func__, __LINE__);
+
+    char *out = NULL, *loaded_out = NULL;
+    int size = 0, loaded_size = 0;
+    hlswrite_master(&out, &size, &master);
+    hlswrite_master(&loaded_out, &loaded_size, loaded);
+    assert_string_equal(out, loaded_out, __func__, __LINE__);
+    hls_free(out);
+    hls_free(loaded_out);
+
+    res = hlsparse_master_unload_binary(loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    remove(SNAPSHOT_PATH);
+    hlsparse_master_term(&master);
+}
+
+void media_playlist_binary_iv_test(void)
+{
+    // a short IV is kept at its own length
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\",IV=0x0102\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_media_playlist(src, strlen(src), &playlist);
+
+    HLSCode res = hlsparse_media_playlist_save_binary(SNAPSHOT_PATH, &playlist);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    media_playlist_t *loaded = NULL;
+    res = hlsparse_media_playlist_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    if(loaded) {
+        CU_ASSERT_EQUAL(loaded->keys.data->iv_size, 2);
+        CU_ASSERT_EQUAL(memcmp(loaded->keys.data->iv, "\x01\x02", 2), 0);
+        hlsparse_media_playlist_unload_binary(loaded);
+    }
+
+    remove(SNAPSHOT_PATH);
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void master_binary_lazy_test(void)
+{
+    // lazily parsed tags are saved decoded, writing the snapshot mustn't touch it
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\",DEFAULT=YES\n"\
+    "#EXT-X-STREAM-INF:BANDWIDTH=900000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,AUDIO=\"aac\"\n"\
+    "900.m3u8\n";
+
+    master_t eager, lazy;
+    hlsparse_master_init(&eager);
+    hlsparse_master_init(&lazy);
+    lazy.lazy_attributes = HLS_TRUE;
+    eager.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    hlsparse_master(src, strlen(src), &eager);
+    hlsparse_master(src, strlen(src), &lazy);
+
+    HLSCode res = hlsparse_master_save_binary(SNAPSHOT_PATH, &lazy);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(lazy.stream_infs.data->attributes, NULL);
+    CU_ASSERT_NOT_EQUAL(lazy.media.data->attributes, NULL);
+
+    master_t *loaded = NULL;
+    res = hlsparse_master_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    if(loaded) {
+        CU_ASSERT_EQUAL(loaded->stream_infs.data->attributes, NULL);
+        CU_ASSERT_EQUAL(loaded->stream_infs.data->bandwidth, 900000);
+        assert_string_equal(loaded->stream_infs.data->uri, "http://www.example.com/900.m3u8", __func__, __LINE__);
+        CU_ASSERT_EQUAL(loaded->media.data->attributes, NULL);
+        assert_string_equal(loaded->media.data->group_id, "aac", __func__, __LINE__);
+
+        char *expected = NULL, *out = NULL;
+        int expected_size = 0, out_size = 0;
+        CU_ASSERT_EQUAL(hlswrite_master(&expected, &expected_size, &eager), HLS_OK);
+        CU_ASSERT_EQUAL(hlswrite_master(&out, &out_size, loaded), HLS_OK);
+        assert_string_equal(out, expected, __func__, __LINE__);
+        hlsparse_free(expected);
+        hlsparse_free(out);
+
+        res = hlsparse_master_unload_binary(loaded);
+        CU_ASSERT_EQUAL(res, HLS_OK);
+    }
+
+    remove(SNAPSHOT_PATH);
+    hlsparse_master_term(&eager);
+    hlsparse_master_term(&lazy);
+}
+
+void media_playlist_binary_lazy_test(void)
+{
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:10\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+    "#EXTINF:10.000,\n"\
+    "segment0.ts\n"\
+    "#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:56.001Z\",DURATION=30.5,SCTE35-OUT=0xFC002F,X-COM-EXAMPLE=\"value\"\n"\
+    "#EXTINF:10.000,\n"\
+    "segment1.ts\n"\
+    "#EXT-X-ENDLIST\n";
+
+    media_playlist_t eager, lazy;
+    hlsparse_media_playlist_init(&eager);
+    hlsparse_media_playlist_init(&lazy);
+    lazy.lazy_attributes = HLS_TRUE;
+    hlsparse_media_playlist(src, strlen(src), &eager);
+    hlsparse_media_playlist(src, strlen(src), &lazy);
+
+    HLSCode res = hlsparse_media_playlist_save_binary(SNAPSHOT_PATH, &lazy);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(lazy.dateranges.data->attributes, NULL);
+
+    media_playlist_t *loaded = NULL;
+    res = hlsparse_media_playlist_load_binary(SNAPSHOT_PATH, &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    if(loaded) {
+        const daterange_t *dr = loaded->dateranges.data;
+        CU_ASSERT_EQUAL(dr->attributes, NULL);
+        assert_string_equal(dr->id, "ad", __func__, __LINE__);
+        CU_ASSERT_EQUAL(dr->pdt, eager.dateranges.data->pdt);
+        CU_ASSERT_EQUAL(dr->scte35_out_size, 3);
+
+        char *expected = NULL, *out = NULL;
+        int expected_size = 0, out_size = 0;
+        CU_ASSERT_EQUAL(hlswrite_media(&expected, &expected_size, &eager), HLS_OK);
+        CU_ASSERT_EQUAL(hlswrite_media(&out, &out_size, loaded), HLS_OK);
+        assert_string_equal(out, expected, __func__, __LINE__);
+        hlsparse_free(expected);
+        hlsparse_free(out);
+
+        res = hlsparse_media_playlist_unload_binary(loaded);
+        CU_ASSERT_EQUAL(res, HLS_OK);
+    }
+
+    remove(SNAPSHOT_PATH);
+    hlsparse_media_playlist_term(&eager);
+    hlsparse_media_playlist_term(&lazy);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("binary", NULL, NULL);
+    test("media_playlist_binary", media_playlist_binary_test);
+    test("master_binary", master_binary_test);
+    test("media_playlist_binary_iv", media_playlist_binary_iv_test);
+    test("master_binary_lazy", master_binary_lazy_test);
+    test("media_playlist_binary_lazy", media_playlist_binary_lazy_test);
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *live_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXTINF:6.000,\n"\
+"segment100.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment101.ts\n";
+
+const char *live_src2 = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:101\n"\
+"#EXTINF:6.000,\n"\
+"segment101.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment102.ts\n";
+
+const char *master_src = "#EXTM3U\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000\n"\
+"900.m3u8\n";
+
+void hash_test(void)
+{
+    // XXH64 reference values
+    CU_ASSERT_EQUAL(hls_hash64("", 0, 0), 0xEF46DB3751D8E999ULL);
+    CU_ASSERT_EQUAL(hls_hash64("abc", 3, 0), 0x44BC2CF5AD770999ULL);
+    CU_ASSERT_EQUAL(hls_hash64(NULL, 0, 0), 0xEF46DB3751D8E999ULL);
+
+    const char *text = "Nobody inspects the spammish repetition";
+    CU_ASSERT_EQUAL(hls_hash64(text, strlen(text), 0), 0xFBCEA83C8A378BF1ULL);
+    CU_ASSERT_NOT_EQUAL(hls_hash64(text, strlen(text), 1), hls_hash64(text, strlen(text), 0));
+}
+
+void cache_hit_test(void)
+{
+    parse_cache_t cache;
+    HLSCode res = hlsparse_cache_init(&cache, 4, 0);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    media_playlist_t *first = NULL, *second = NULL;
+    res = hlsparse_cache_media_playlist(&cache, "http://www.example.com/live.m3u8", live_src, strlen(live_src), &first);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(first, NULL);
+    CU_ASSERT_EQUAL(first->nb_segments, 2);
+    CU_ASSERT_EQUAL(first->media_sequence, 100);
+    assert_string_equal(first->segments.data->uri, "http://www.example.com/segment100.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(cache.misses, 1);
+    CU_ASSERT_EQUAL(cache.hits, 0);
+    CU_ASSERT_EQUAL(cache.nb_entries, 1);
+    CU_ASSERT_NOT_EQUAL(cache.bytes, 0);
+
+    // the same bytes return the same playlist without parsing
+    res = hlsparse_cache_media_playlist(&cache, "http://www.example.com/live.m3u8", live_src, strlen(live_src), &second);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(first, second);
+    CU_ASSERT_EQUAL(cache.hits, 1);
+    CU_ASSERT_EQUAL(cache.misses, 1);
+
+    res = hlsparse_cache_media_playlist_release(&cache, first);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    res = hlsparse_cache_media_playlist_release(&cache, second);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    res = hlsparse_cache_media_playlist_release(&cache, second);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    // changed bytes are parsed again
+    res = hlsparse_cache_media_playlist(&cache, "http://www.example.com/live.m3u8", live_src2, strlen(live_src2), &second);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(second->media_sequence, 101);
+    CU_ASSERT_EQUAL(cache.misses, 2);
+    CU_ASSERT_EQUAL(cache.nb_entries, 1);
+    hlsparse_cache_media_playlist_release(&cache, second);
+
+    // the same text under another uri is a different entry
+    res = hlsparse_cache_media_playlist(&cache, "http://www.example.com/other.m3u8", live_src2, strlen(live_src2), &first);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(first, second);
+    assert_string_equal(first->segments.data->uri, "http://www.example.com/segment101.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(cache.nb_entries, 2);
+    hlsparse_cache_media_playlist_release(&cache, first);
+
+    master_t *master = NULL;
+    res = hlsparse_cache_master(&cache, "http://www.example.com/master.m3u8", master_src, strlen(master_src), &master);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(master->nb_stream_infs, 1);
+    assert_string_equal(master->stream_infs.data->uri, "http://www.example.com/900.m3u8", __func__, __LINE__);
+    res = hlsparse_cache_master_release(&cache, master);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    res = hlsparse_cache_term(&cache);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(cache.nb_entries, 0);
+
+    res = hlsparse_cache_init(&cache, 0, 0);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+    res = hlsparse_cache_media_playlist(NULL, NULL, NULL, 0, NULL);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+}
+
+void cache_eviction_test(void)
+{
+    parse_cache_t cache;
+    hlsparse_cache_init(&cache, 2, 0);
+
+    media_playlist_t *a = NULL, *b = NULL, *c = NULL;
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/a.m3u8", live_src, strlen(live_src), &a);
+    hlsparse_cache_media_playlist_release(&cache, a);
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/b.m3u8", live_src, strlen(live_src), &b);
+    hlsparse_cache_media_playlist_release(&cache, b);
+
+    // touch a so that b becomes the least recently used
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/a.m3u8", live_src, strlen(live_src), &a);
+    hlsparse_cache_media_playlist_release(&cache, a);
+
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/c.m3u8", live_src, strlen(live_src), &c);
+    hlsparse_cache_media_playlist_release(&cache, c);
+    CU_ASSERT_EQUAL(cache.nb_entries, 2);
+    CU_ASSERT_EQUAL(cache.evictions, 1);
+
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/a.m3u8", live_src, strlen(live_src), &a);
+    hlsparse_cache_media_playlist_release(&cache, a);
+    CU_ASSERT_EQUAL(cache.hits, 2);
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/b.m3u8", live_src, strlen(live_src), &b);
+    CU_ASSERT_EQUAL(cache.misses, 4);
+
+    // a borrowed playlist survives being replaced
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/b.m3u8", live_src2, strlen(live_src2), &c);
+    CU_ASSERT_NOT_EQUAL(b, c);
+    CU_ASSERT_NOT_EQUAL(cache.orphans, NULL);
+    CU_ASSERT_EQUAL(b->media_sequence, 100);
+    CU_ASSERT_EQUAL(c->media_sequence, 101);
+    hlsparse_cache_media_playlist_release(&cache, b);
+    CU_ASSERT_EQUAL(cache.orphans, NULL);
+    hlsparse_cache_media_playlist_release(&cache, c);
+
+    // a memory bound keeps only the latest entry
+    hlsparse_cache_term(&cache);
+    hlsparse_cache_init(&cache, 8, 1);
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/a.m3u8", live_src, strlen(live_src), &a);
+    hlsparse_cache_media_playlist_release(&cache, a);
+    hlsparse_cache_media_playlist(&cache, "http://www.example.com/b.m3u8", live_src, strlen(live_src), &b);
+    hlsparse_cache_media_playlist_release(&cache, b);
+    CU_ASSERT_EQUAL(cache.nb_entries, 1);
+    CU_ASSERT_EQUAL(cache.head->playlist.media.nb_segments, 2);
+
+    hlsparse_cache_term(&cache);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("cache", NULL, NULL);
+    test("hash", hash_test);
+    test("cache_hit", cache_hit_test);
+    test("cache_eviction", cache_eviction_test);
+}
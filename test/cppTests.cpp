@@ -0,0 +1,179 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.hpp"
+#include "tests.h"
+#include <CUnit/Basic.h>
+#include <cstring>
+#include <vector>
+
+static const char *cpp_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:6\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\"\n"\
+"#EXTINF:10.000,zero\n"\
+"segment0.ts\n"\
+"#EXT-X-CUSTOM-TAG:1\n"\
+"#EXTINF:9.500,one\n"\
+"segment1.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:10:00.000Z\",X-COM-EXAMPLE=\"a\",SCTE35-OUT=0xFC002F00\n"\
+"#EXTINF:10.000,two\n"\
+"segment2.ts\n";
+
+static const char *cpp_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,AUDIO=\"aac\"\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=1500000,AUDIO=\"aac\"\n"\
+"1500.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,URI=\"iframe.m3u8\"\n";
+
+void cpp_media_test(void)
+{
+    hls::MediaPlaylist playlist;
+    std::string_view src(cpp_media_src);
+    CU_ASSERT_EQUAL(playlist.parse(src), (int)src.size());
+    CU_ASSERT_EQUAL(playlist->nb_segments, 3);
+
+    // the items are the playlist's own, not copies
+    const char *titles[] = { "zero", "one", "two" };
+    int i = 0;
+    for(const segment_t &segment : std::as_const(playlist).segments()) {
+        CU_ASSERT(hls::view(segment.title) == titles[i]);
+        CU_ASSERT_EQUAL(&segment, i == 0 ? playlist->segments.data : &segment);
+        ++i;
+    }
+    CU_ASSERT_EQUAL(i, 3);
+    CU_ASSERT_EQUAL(playlist.segments().size(), 3);
+    CU_ASSERT_EQUAL(playlist.keys().size(), 1);
+    CU_ASSERT(hls::view(playlist.keys().begin()->uri) == "key0.bin");
+    CU_ASSERT(playlist.maps().empty());
+
+    const segment_t &second = *++playlist.segments().begin();
+    CU_ASSERT_EQUAL(hls::custom_tags(second).size(), 1);
+    CU_ASSERT(*hls::custom_tags(second).begin() == "EXT-X-CUSTOM-TAG:1");
+
+    const daterange_t &daterange = *playlist.dateranges().begin();
+    CU_ASSERT(hls::view(daterange.id) == "ad");
+    CU_ASSERT_EQUAL(hls::client_attributes(daterange).size(), 1);
+    CU_ASSERT(hls::view(hls::client_attributes(daterange).begin()->key) == "X-COM-EXAMPLE");
+    std::span<const uint8_t> out = hls::scte35_out(daterange);
+    CU_ASSERT_EQUAL(out.size(), 4);
+    CU_ASSERT_EQUAL(out[0], 0xFC);
+    CU_ASSERT(hls::scte35_in(daterange).empty());
+
+    // segments can be edited through the range
+    for(segment_t &segment : playlist.segments()) {
+        segment.discontinuity = HLS_TRUE;
+    }
+    CU_ASSERT_EQUAL(playlist->last_segment->discontinuity, HLS_TRUE);
+}
+
+void cpp_master_test(void)
+{
+    // keep the uris as written as there's no master uri to resolve them with
+    hls::Master master;
+    master->skip_fields = PARSE_FIELD_RESOLVED_URIS;
+    master.parse(cpp_master_src);
+    CU_ASSERT_EQUAL(master.stream_infs().size(), 2);
+    CU_ASSERT_EQUAL(master.iframe_stream_infs().size(), 1);
+    CU_ASSERT_EQUAL(master.media().size(), 1);
+    CU_ASSERT(master.session_data().empty());
+    CU_ASSERT(master.session_keys().empty());
+
+    std::vector<std::string_view> uris;
+    for(const stream_inf_t &inf : master.stream_infs()) {
+        uris.push_back(hls::view(inf.uri));
+    }
+    CU_ASSERT_EQUAL(uris.size(), 2);
+    CU_ASSERT(uris[1] == "1500.m3u8");
+    CU_ASSERT(hls::view(master.media().begin()->group_id) == "aac");
+
+    std::string out = master.write();
+    char *expected = NULL;
+    int size = 0;
+    CU_ASSERT_EQUAL(hlswrite_master(&expected, &size, master.get()), HLS_OK);
+    CU_ASSERT(out == std::string_view(expected, size));
+    hlsparse_free(expected);
+}
+
+void cpp_move_test(void)
+{
+    hls::MediaPlaylist playlist = hls::MediaPlaylist::from(cpp_media_src);
+    std::string before = playlist.write();
+
+    // the list tails point into the playlist and have to follow it
+    hls::MediaPlaylist moved(std::move(playlist));
+    CU_ASSERT_EQUAL(moved->nb_segments, 3);
+    CU_ASSERT_EQUAL(moved->keys_tail, &moved->keys);
+    CU_ASSERT_EQUAL(playlist->nb_segments, 0);
+    CU_ASSERT(playlist.segments().empty());
+
+    const char *more = "#EXT-X-KEY:METHOD=AES-128,URI=\"key1.bin\"\n#EXTINF:4.000,three\nsegment3.ts\n";
+    moved.parse(more);
+    CU_ASSERT_EQUAL(moved.keys().size(), 2);
+    CU_ASSERT_EQUAL(moved.segments().size(), 4);
+
+    hls::MediaPlaylist assigned;
+    assigned = std::move(moved);
+    CU_ASSERT_EQUAL(assigned.segments().size(), 4);
+    CU_ASSERT(moved.segments().empty());
+
+    std::vector<hls::MediaPlaylist> playlists;
+    for(int i = 0; i < 8; ++i) {
+        playlists.push_back(hls::MediaPlaylist::from(cpp_media_src));
+    }
+    for(hls::MediaPlaylist &p : playlists) {
+        CU_ASSERT(p.write() == before);
+    }
+}
+
+void cpp_reuse_test(void)
+{
+    hls::MediaPlaylist playlist;
+    playlist->window_size = 2;
+    playlist.parse(cpp_media_src);
+    CU_ASSERT_EQUAL(playlist.segments().size(), 2);
+
+    std::string out;
+    CU_ASSERT_EQUAL(playlist.write(out), HLS_OK);
+    size_t capacity = out.capacity();
+    const char *data = out.data();
+
+    // the options stay and the string's memory is written over
+    playlist.reset();
+    CU_ASSERT_EQUAL(playlist->window_size, 2);
+    CU_ASSERT(playlist.segments().empty());
+    playlist.parse(cpp_media_src);
+    CU_ASSERT_EQUAL(playlist.segments().size(), 2);
+    CU_ASSERT_EQUAL(playlist.write(out), HLS_OK);
+    CU_ASSERT_EQUAL(out.capacity(), capacity);
+    CU_ASSERT_EQUAL(out.data(), data);
+    CU_ASSERT(out == playlist.write());
+
+    hls::Master master;
+    master->skip_fields = PARSE_FIELD_IFRAME_STREAM_INFS;
+    master.parse(cpp_master_src);
+    master.reset();
+    CU_ASSERT_EQUAL(master->skip_fields, PARSE_FIELD_IFRAME_STREAM_INFS);
+    master.parse(cpp_master_src);
+    CU_ASSERT(master.iframe_stream_infs().empty());
+    CU_ASSERT_EQUAL(master.stream_infs().size(), 2);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("cpp", NULL, NULL);
+    test("cpp_media", cpp_media_test);
+    test("cpp_master", cpp_master_test);
+    test("cpp_move", cpp_move_test);
+    test("cpp_reuse", cpp_reuse_test);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *old_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key100.key\"\n"\
+"#EXTINF:6.000,\n"\
+"segment100.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment101.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment102.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment103.ts\n";
+
+const char *new_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:8\n"\
+"#EXT-X-MEDIA-SEQUENCE:102\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key100.key\"\n"\
+"#EXTINF:6.000,\n"\
+"segment102.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment103-replaced.ts\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key104.key\"\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:56.001Z\"\n"\
+"#EXTINF:6.000,\n"\
+"segment104.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment105.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+static void parse(const char *src, media_playlist_t *playlist)
+{
+    hlsparse_media_playlist_init(playlist);
+    hlsparse_media_playlist(src, strlen(src), playlist);
+}
+
+void media_playlist_diff_test(void)
+{
+    media_playlist_t old_playlist, new_playlist;
+    parse(old_src, &old_playlist);
+    parse(new_src, &new_playlist);
+
+    media_playlist_diff_t diff;
+    HLSCode res = hlsparse_media_playlist_diff_init(&diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+
+    res = hlsparse_media_playlist_diff(&old_playlist, &new_playlist, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.nb_expired, 2);
+    CU_ASSERT_EQUAL(diff.nb_prepended, 0);
+    CU_ASSERT_EQUAL(diff.nb_unchanged, 1);
+    CU_ASSERT_EQUAL(diff.nb_changed, 1);
+    CU_ASSERT_EQUAL(diff.changed[0], 103);
+    CU_ASSERT_EQUAL(diff.nb_appended, 2);
+    CU_ASSERT_EQUAL(diff.nb_truncated, 0);
+    CU_ASSERT_NOT_EQUAL(diff.appended, NULL);
+    assert_string_equal(diff.appended->data->uri, "segment104.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(diff.nb_keys_added, 1);
+    CU_ASSERT_EQUAL(diff.nb_keys_removed, 0);
+    CU_ASSERT_EQUAL(diff.nb_maps_added, 0);
+    CU_ASSERT_EQUAL(diff.nb_dateranges_added, 1);
+    CU_ASSERT_EQUAL(diff.nb_dateranges_removed, 0);
+    CU_ASSERT_EQUAL(diff.changes, PLAYLIST_DIFF_TARGET_DURATION | PLAYLIST_DIFF_END_LIST |
+                    PLAYLIST_DIFF_MEDIA_SEQUENCE | PLAYLIST_DIFF_SEGMENTS |
+                    PLAYLIST_DIFF_KEYS | PLAYLIST_DIFF_DATERANGES);
+
+    // comparing the other way round finds a stale playlist
+    res = hlsparse_media_playlist_diff(&new_playlist, &old_playlist, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.nb_expired, 0);
+    CU_ASSERT_EQUAL(diff.nb_prepended, 2);
+    CU_ASSERT_EQUAL(diff.nb_changed, 1);
+    CU_ASSERT_EQUAL(diff.nb_appended, 0);
+    CU_ASSERT_EQUAL(diff.appended, NULL);
+    CU_ASSERT_EQUAL(diff.nb_truncated, 2);
+    CU_ASSERT_EQUAL(diff.nb_keys_removed, 1);
+    CU_ASSERT_EQUAL(diff.nb_dateranges_removed, 1);
+
+    // a playlist doesn't differ from itself
+    res = hlsparse_media_playlist_diff(&old_playlist, &old_playlist, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.changes, 0);
+    CU_ASSERT_EQUAL(diff.nb_unchanged, 4);
+    CU_ASSERT_EQUAL(diff.nb_changed, 0);
+
+    res = hlsparse_media_playlist_diff(NULL, &old_playlist, &diff);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    hlsparse_media_playlist_diff_term(&diff);
+    hlsparse_media_playlist_term(&old_playlist);
+    hlsparse_media_playlist_term(&new_playlist);
+}
+
+void media_playlist_diff_iv_test(void)
+{
+    // keys with short IVs are compared by the bytes they hold
+    const char *a_src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\",IV=0x0102\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+    const char *b_src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\",IV=0x010203\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+
+    media_playlist_t a, b;
+    parse(a_src, &a);
+    parse(b_src, &b);
+
+    media_playlist_diff_t diff;
+    hlsparse_media_playlist_diff_init(&diff);
+    HLSCode res = hlsparse_media_playlist_diff(&a, &a, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.changes, 0);
+
+    res = hlsparse_media_playlist_diff(&a, &b, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.nb_keys_added, 1);
+    CU_ASSERT_EQUAL(diff.nb_keys_removed, 1);
+    CU_ASSERT_EQUAL(diff.nb_changed, 1);
+
+    hlsparse_media_playlist_diff_term(&diff);
+    hlsparse_media_playlist_term(&a);
+    hlsparse_media_playlist_term(&b);
+}
+
+void media_playlist_diff_lazy_test(void)
+{
+    // undecoded dateranges are compared by their attributes
+    const char *a_src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.000Z\n"\
+    "#EXT-X-DATERANGE:ID=\"a\",START-DATE=\"2017-12-09T18:09:46.000Z\",DURATION=10\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+    const char *b_src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.000Z\n"\
+    "#EXT-X-DATERANGE:ID=\"b\",START-DATE=\"2017-12-09T18:09:46.000Z\",DURATION=20\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+
+    media_playlist_t a, b, eager;
+    hlsparse_media_playlist_init(&a);
+    hlsparse_media_playlist_init(&b);
+    a.lazy_attributes = HLS_TRUE;
+    b.lazy_attributes = HLS_TRUE;
+    hlsparse_media_playlist(a_src, strlen(a_src), &a);
+    hlsparse_media_playlist(b_src, strlen(b_src), &b);
+    parse(a_src, &eager);
+
+    media_playlist_diff_t diff;
+    hlsparse_media_playlist_diff_init(&diff);
+    HLSCode res = hlsparse_media_playlist_diff(&a, &b, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.nb_dateranges_added, 1);
+    CU_ASSERT_EQUAL(diff.nb_dateranges_removed, 1);
+    CU_ASSERT_EQUAL(diff.changes, PLAYLIST_DIFF_DATERANGES);
+
+    // a lazy playlist matches its eager parse and isn't decoded by the diff
+    res = hlsparse_media_playlist_diff(&a, &eager, &diff);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(diff.changes, 0);
+    CU_ASSERT_NOT_EQUAL(a.dateranges.data->attributes, NULL);
+    CU_ASSERT_EQUAL(a.dateranges.data->id, NULL);
+
+    hlsparse_media_playlist_diff_term(&diff);
+    hlsparse_media_playlist_term(&a);
+    hlsparse_media_playlist_term(&b);
+    hlsparse_media_playlist_term(&eager);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("diff", NULL, NULL);
+    test("media_playlist_diff", media_playlist_diff_test);
+    test("media_playlist_diff_iv", media_playlist_diff_iv_test);
+    test("media_playlist_diff_lazy", media_playlist_diff_lazy_test);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *fields_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-SESSION-DATA:DATA-ID=\"com.example.title\",VALUE=\"Example\"\n"\
+"#EXT-X-SESSION-KEY:METHOD=AES-128,URI=\"key.bin\"\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\",DEFAULT=YES\n"\
+"#EXT-X-CUSTOM-TAG:1\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,RESOLUTION=1280x720,AUDIO=\"aac\"\n"\
+"900.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,URI=\"iframe.m3u8\"\n";
+
+const char *fields_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:4\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\"\n"\
+"#EXT-X-MAP:URI=\"init.mp4\"\n"\
+"#EXT-X-CUSTOM-TAG:1\n"\
+"#EXTINF:10.000,first\n"\
+"segment0.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:56.001Z\",DURATION=30.5,SCTE35-OUT=0xFC002F\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key1.bin\"\n"\
+"#EXT-X-BYTERANGE:1000@200\n"\
+"#EXTINF:10.000,second\n"\
+"segment1.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+void fields_master_test(void)
+{
+    master_t master;
+    hlsparse_master_init(&master);
+    master.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    master.skip_fields = PARSE_FIELD_SESSION_DATA | PARSE_FIELD_SESSION_KEYS |
+                         PARSE_FIELD_MEDIA | PARSE_FIELD_IFRAME_STREAM_INFS |
+                         PARSE_FIELD_CUSTOM_TAGS;
+
+    int res = hlsparse_master(fields_master_src, strlen(fields_master_src), &master);
+    CU_ASSERT_EQUAL(res, strlen(fields_master_src));
+    CU_ASSERT_EQUAL(master.version, 7);
+    CU_ASSERT_EQUAL(master.nb_stream_infs, 1);
+    CU_ASSERT_EQUAL(master.stream_infs.data->bandwidth, 900000);
+    assert_string_equal(master.stream_infs.data->audio, "aac", __func__, __LINE__);
+    assert_string_equal(master.stream_infs.data->uri, "http://www.example.com/900.m3u8", __func__, __LINE__);
+
+    CU_ASSERT_EQUAL(master.session_data.data, NULL);
+    CU_ASSERT_EQUAL(master.session_keys.data, NULL);
+    CU_ASSERT_EQUAL(master.nb_session_keys, 0);
+    CU_ASSERT_EQUAL(master.media.data, NULL);
+    CU_ASSERT_EQUAL(master.iframe_stream_infs.data, NULL);
+    CU_ASSERT_EQUAL(master.nb_iframe_stream_infs, 0);
+    CU_ASSERT_EQUAL(master.custom_tags.data, NULL);
+
+    hlsparse_master_term(&master);
+}
+
+void fields_media_playlist_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.uri = str_utils_dup("http://www.example.com/media.m3u8");
+    playlist.skip_fields = PARSE_FIELD_TITLES | PARSE_FIELD_CUSTOM_TAGS | PARSE_FIELD_DATERANGES |
+                           PARSE_FIELD_KEYS | PARSE_FIELD_MAPS;
+
+    int res = hlsparse_media_playlist(fields_media_src, strlen(fields_media_src), &playlist);
+    CU_ASSERT_EQUAL(res, strlen(fields_media_src));
+    CU_ASSERT_EQUAL(playlist.nb_segments, 2);
+    CU_ASSERT_EQUAL(playlist.nb_keys, 0);
+    CU_ASSERT_EQUAL(playlist.nb_maps, 0);
+    CU_ASSERT_EQUAL(playlist.nb_dateranges, 0);
+    CU_ASSERT_EQUAL(playlist.nb_custom_tags, 0);
+    CU_ASSERT_EQUAL(playlist.keys.data, NULL);
+    CU_ASSERT_EQUAL(playlist.maps.data, NULL);
+    CU_ASSERT_EQUAL(playlist.dateranges.data, NULL);
+
+    segment_t *seg = playlist.segments.data;
+    CU_ASSERT_EQUAL(seg->duration, 10.f);
+    CU_ASSERT_EQUAL(seg->title, NULL);
+    CU_ASSERT_EQUAL(seg->custom_tags.data, NULL);
+    CU_ASSERT_EQUAL(seg->key_index, -1);
+    CU_ASSERT_EQUAL(seg->map_index, -1);
+    CU_ASSERT_EQUAL(seg->daterange_index, -1);
+    assert_string_equal(seg->uri, "http://www.example.com/segment0.ts", __func__, __LINE__);
+
+    seg = playlist.segments.next->data;
+    CU_ASSERT_EQUAL(seg->title, NULL);
+    CU_ASSERT_EQUAL(seg->key_index, -1);
+    CU_ASSERT_EQUAL(seg->byte_range.n, 1000);
+    CU_ASSERT_EQUAL(seg->byte_range.o, 200);
+    assert_string_equal(seg->uri, "http://www.example.com/segment1.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(seg->pdt, 1512842996001);
+    CU_ASSERT_EQUAL(playlist.duration, 20.f);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void fields_scte35_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.skip_fields = PARSE_FIELD_SCTE35;
+
+    hlsparse_media_playlist(fields_media_src, strlen(fields_media_src), &playlist);
+    CU_ASSERT_EQUAL(playlist.nb_dateranges, 1);
+    CU_ASSERT_EQUAL(playlist.nb_keys, 2);
+    CU_ASSERT_EQUAL(playlist.nb_maps, 1);
+
+    daterange_t *daterange = playlist.dateranges.data;
+    assert_string_equal(daterange->id, "ad", __func__, __LINE__);
+    CU_ASSERT_EQUAL(daterange->duration, 30.5f);
+    CU_ASSERT_EQUAL(daterange->scte35_out, NULL);
+    CU_ASSERT_EQUAL(daterange->scte35_out_size, 0);
+
+    // everything else is unaffected
+    segment_t *seg = playlist.segments.next->data;
+    assert_string_equal(seg->title, "second", __func__, __LINE__);
+    CU_ASSERT_EQUAL(seg->key_index, 1);
+    CU_ASSERT_EQUAL(seg->daterange_index, 0);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void fields_resolved_uris_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.uri = str_utils_dup("http://www.example.com/media.m3u8");
+    playlist.skip_fields = PARSE_FIELD_RESOLVED_URIS;
+
+    hlsparse_media_playlist(fields_media_src, strlen(fields_media_src), &playlist);
+    assert_string_equal(playlist.segments.data->uri, "segment0.ts", __func__, __LINE__);
+    assert_string_equal(playlist.keys.data->uri, "key0.bin", __func__, __LINE__);
+    hlsparse_media_playlist_term(&playlist);
+
+    master_t master;
+    hlsparse_master_init(&master);
+    master.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    master.skip_fields = PARSE_FIELD_RESOLVED_URIS;
+
+    hlsparse_master(fields_master_src, strlen(fields_master_src), &master);
+    assert_string_equal(master.stream_infs.data->uri, "900.m3u8", __func__, __LINE__);
+    assert_string_equal(master.iframe_stream_infs.data->uri, "iframe.m3u8", __func__, __LINE__);
+    assert_string_equal(master.session_keys.data->uri, "key.bin", __func__, __LINE__);
+    hlsparse_master_term(&master);
+}
+
+void fields_allocs_test(void)
+{
+    hlsparse_alloc_stats_t full_stats, skip_stats;
+    media_playlist_t playlist;
+
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_alloc_stats_reset();
+    hlsparse_media_playlist(fields_media_src, strlen(fields_media_src), &playlist);
+    hlsparse_alloc_stats(&full_stats);
+    hlsparse_media_playlist_term(&playlist);
+
+    hlsparse_media_playlist_init(&playlist);
+    playlist.skip_fields = PARSE_FIELD_TITLES | PARSE_FIELD_CUSTOM_TAGS | PARSE_FIELD_DATERANGES |
+                           PARSE_FIELD_KEYS | PARSE_FIELD_MAPS;
+    hlsparse_alloc_stats_reset();
+    hlsparse_media_playlist(fields_media_src, strlen(fields_media_src), &playlist);
+    hlsparse_alloc_stats(&skip_stats);
+    hlsparse_media_playlist_term(&playlist);
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    // two segments, their uris and the second list node, nothing else
+    CU_ASSERT_EQUAL(skip_stats.nb_allocs, 5);
+    CU_ASSERT(skip_stats.nb_allocs < full_stats.nb_allocs);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("fields", NULL, NULL);
+    test("fields_master", fields_master_test);
+    test("fields_media_playlist", fields_media_playlist_test);
+    test("fields_scte35", fields_scte35_test);
+    test("fields_resolved_uris", fields_resolved_uris_test);
+    test("fields_allocs", fields_allocs_test);
+}
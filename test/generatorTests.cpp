@@ -0,0 +1,178 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.hpp"
+#include "hlsparse_generator.hpp"
+#include "tests.h"
+#include <CUnit/Basic.h>
+#include <cstring>
+#include <string>
+
+static const char *generator_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:6\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:2\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\",IV=0x00000000000000000000000000000001\n"\
+"#EXT-X-MAP:URI=\"init0.mp4\",BYTERANGE=\"720@0\"\n"\
+"#EXTINF:10.000,zero\n"\
+"segment0.ts\n"\
+"#EXT-X-BYTERANGE:1000@200\n"\
+"#EXTINF:9.500,one\n"\
+"segment1.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T19:00:00.000Z\n"\
+"#EXT-X-MAP:URI=\"init1.mp4\"\n"\
+"#EXTINF:10.000,\r\n"\
+"segment2.ts\r\n"\
+"#EXT-X-KEY:METHOD=NONE\n"\
+"#EXT-X-BYTERANGE:500\n"\
+"#EXTINF:4.004,three\n"\
+"segment3.ts\n"\
+"#EXT-X-KEY:METHOD=SAMPLE-AES,URI=\"key1.bin\"\n"\
+"#EXTINF:10.000,four\n"\
+"segment4.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+void generator_matches_parser_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.skip_fields = PARSE_FIELD_RESOLVED_URIS;
+    hlsparse_media_playlist(generator_src, strlen(generator_src), &playlist);
+
+    segment_list_t *seg = &playlist.segments;
+    int count = 0;
+    for(const hls::SegmentView &view : hls::segments(generator_src)) {
+        CU_ASSERT(seg && seg->data);
+        if(!seg || !seg->data) {
+            break;
+        }
+        segment_t *segment = seg->data;
+        CU_ASSERT_EQUAL(view.sequence_num, segment->sequence_num);
+        CU_ASSERT_EQUAL(view.duration, segment->duration);
+        CU_ASSERT(view.title == hls::view(segment->title));
+        CU_ASSERT(view.uri == hls::view(segment->uri));
+        CU_ASSERT_EQUAL(view.discontinuity, (bool)segment->discontinuity);
+        CU_ASSERT_EQUAL(view.pdt_discontinuity, (bool)segment->pdt_discontinuity);
+        CU_ASSERT_EQUAL(view.pdt, segment->pdt);
+        CU_ASSERT_EQUAL(view.pdt_end, segment->pdt_end);
+        CU_ASSERT_EQUAL(view.byte_range.n, segment->byte_range.n);
+        CU_ASSERT_EQUAL(view.byte_range.o, segment->byte_range.o);
+
+        // the key and map in force are the ones the parser points the segment at
+        CU_ASSERT_EQUAL(view.key.index, segment->key_index);
+        CU_ASSERT_EQUAL(view.map.index, segment->map_index);
+        key_list_t *key = &playlist.keys;
+        for(int i = 0; i < segment->key_index; ++i) {
+            key = key->next;
+        }
+        CU_ASSERT_EQUAL(view.key.method, key->data->method);
+        CU_ASSERT(view.key.uri == hls::view(key->data->uri));
+        map_list_t *map = &playlist.maps;
+        for(int i = 0; i < segment->map_index; ++i) {
+            map = map->next;
+        }
+        CU_ASSERT(view.map.uri == hls::view(map->data->uri));
+        CU_ASSERT_EQUAL(view.map.byte_range.n, map->data->byte_range.n);
+        CU_ASSERT_EQUAL(view.map.byte_range.o, map->data->byte_range.o);
+
+        seg = seg->next;
+        ++count;
+    }
+    CU_ASSERT_EQUAL(count, playlist.nb_segments);
+    CU_ASSERT_EQUAL(count, 5);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void generator_context_test(void)
+{
+    segment_reader_t reader;
+    CU_ASSERT_EQUAL(hlsparse_segment_reader_init(&reader, generator_src, strlen(generator_src)), HLS_OK);
+
+    // stopping early leaves the rest of the source unread
+    int count = 0;
+    for(const hls::SegmentView &view : hls::segments(reader)) {
+        if(count == 0) {
+            CU_ASSERT(view.uri == "segment0.ts");
+            CU_ASSERT(view.title == "zero");
+            CU_ASSERT_EQUAL(view.key.method, KEY_METHOD_AES128);
+            CU_ASSERT(view.key.iv == "0x00000000000000000000000000000001");
+            CU_ASSERT_EQUAL(view.pdt, 1512842986001);
+        } else {
+            CU_ASSERT(view.uri == "segment1.ts");
+            CU_ASSERT(view.title == "one");
+            break;
+        }
+        ++count;
+    }
+    CU_ASSERT_EQUAL(reader.nb_segments, 2);
+    CU_ASSERT_EQUAL(reader.media_sequence, 100);
+    CU_ASSERT_EQUAL(reader.discontinuity_sequence, 2);
+    CU_ASSERT_EQUAL(reader.target_duration, 10.f);
+    CU_ASSERT_EQUAL(reader.version, 6);
+    CU_ASSERT_EQUAL(reader.end_list, HLS_FALSE);
+    CU_ASSERT(reader.pt == strstr(generator_src, "#EXT-X-DISCONTINUITY\n"));
+
+    // a new generator picks up where the reader stopped
+    count = 0;
+    for(const hls::SegmentView &view : hls::segments(reader)) {
+        if(count == 0) {
+            CU_ASSERT(view.uri == "segment2.ts");
+            CU_ASSERT(view.title.empty());
+            CU_ASSERT_EQUAL(view.discontinuity, true);
+            CU_ASSERT_EQUAL(view.pdt_discontinuity, true);
+        }
+        ++count;
+    }
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(reader.end_list, HLS_TRUE);
+
+    segment_view_t view;
+    CU_ASSERT_EQUAL(hlsparse_segment_reader_next(&reader, &view), 0);
+    CU_ASSERT_EQUAL(hlsparse_segment_reader_next(NULL, &view), 0);
+    CU_ASSERT_EQUAL(hlsparse_segment_reader_init(NULL, generator_src, 0), HLS_ERROR);
+
+    // an EXTINF without a uri is still a segment
+    const char *src = "#EXTM3U\n#EXTINF:6,\n#EXTINF:5,\nb.ts\n#EXTINF:4,\n";
+    count = 0;
+    float durations[] = { 6.f, 5.f, 4.f };
+    for(const hls::SegmentView &segment : hls::segments(src)) {
+        CU_ASSERT_EQUAL(segment.duration, durations[count]);
+        CU_ASSERT(segment.uri == (count == 1 ? "b.ts" : ""));
+        ++count;
+    }
+    CU_ASSERT_EQUAL(count, 3);
+}
+
+void generator_allocs_test(void)
+{
+    hlsparse_alloc_stats_t stats;
+
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hlsparse_alloc_stats_reset();
+    int count = 0;
+    for(const hls::SegmentView &view : hls::segments(generator_src)) {
+        count += view.uri.empty() ? 0 : 1;
+    }
+    hlsparse_alloc_stats(&stats);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    CU_ASSERT_EQUAL(count, 5);
+    CU_ASSERT_EQUAL(stats.nb_allocs, 0);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("generator", NULL, NULL);
+    test("generator_matches_parser", generator_matches_parser_test);
+    test("generator_context", generator_context_test);
+    test("generator_allocs", generator_allocs_test);
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *lazy_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\",LANGUAGE=\"en\",DEFAULT=YES,AUTOSELECT=YES\n"\
+"#EXT-X-MEDIA:TYPE=CLOSED-CAPTIONS,GROUP-ID=\"cc\",NAME=\"CC\",INSTREAM-ID=\"SERVICE3\",CHARACTERISTICS=\"public.accessibility\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,AVERAGE-BANDWIDTH=850000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,AUDIO=\"aac\",FRAME-RATE=29.970,HDCP-LEVEL=TYPE-0\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=1500000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1920x1080,AUDIO=\"aac\",CLOSED-CAPTIONS=\"cc\",SUBTITLES=\"subs\"\n"\
+"1500.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=200000,CLOSED-CAPTIONS=NONE\r\n"\
+"200.m3u8\n";
+
+const char *lazy_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:4\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXTINF:10.000,\n"\
+"segment0.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",CLASS=\"com.example\",START-DATE=\"2017-12-09T18:09:56.001Z\",DURATION=30.5,SCTE35-OUT=0xFC002F,X-COM-EXAMPLE=\"value\",X-NUMBER=12.5,END-ON-NEXT=YES\n"\
+"#EXTINF:10.000,\n"\
+"segment1.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad2\",START-DATE=\"2017-12-09T18:10:06.001Z\",END-DATE=\"2017-12-09T18:10:16.001Z\",SCTE35-IN=0xFC00\n"\
+"#EXTINF:10.000,\n"\
+"segment2.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+static void assert_stream_inf_equal(const stream_inf_t *a, const stream_inf_t *b)
+{
+    CU_ASSERT_EQUAL(a->program_id, b->program_id);
+    CU_ASSERT_EQUAL(a->hdcp_level, b->hdcp_level);
+    CU_ASSERT_EQUAL(a->bandwidth, b->bandwidth);
+    CU_ASSERT_EQUAL(a->avg_bandwidth, b->avg_bandwidth);
+    CU_ASSERT_EQUAL(a->frame_rate, b->frame_rate);
+    CU_ASSERT_EQUAL(a->resolution.width, b->resolution.width);
+    CU_ASSERT_EQUAL(a->resolution.height, b->resolution.height);
+    assert_string_equal(a->codecs, b->codecs, __func__, __LINE__);
+    assert_string_equal(a->audio, b->audio, __func__, __LINE__);
+    assert_string_equal(a->video, b->video, __func__, __LINE__);
+    assert_string_equal(a->subtitles, b->subtitles, __func__, __LINE__);
+    assert_string_equal(a->closed_captions, b->closed_captions, __func__, __LINE__);
+    assert_string_equal(a->uri, b->uri, __func__, __LINE__);
+}
+
+static void assert_media_equal(const media_t *a, const media_t *b)
+{
+    CU_ASSERT_EQUAL(a->type, b->type);
+    CU_ASSERT_EQUAL(a->instream_id, b->instream_id);
+    CU_ASSERT_EQUAL(a->service_n, b->service_n);
+    CU_ASSERT_EQUAL(a->forced, b->forced);
+    CU_ASSERT_EQUAL(a->is_default, b->is_default);
+    CU_ASSERT_EQUAL(a->auto_select, b->auto_select);
+    assert_string_equal(a->name, b->name, __func__, __LINE__);
+    assert_string_equal(a->group_id, b->group_id, __func__, __LINE__);
+    assert_string_equal(a->language, b->language, __func__, __LINE__);
+    assert_string_equal(a->uri, b->uri, __func__, __LINE__);
+    assert_string_equal(a->characteristics, b->characteristics, __func__, __LINE__);
+}
+
+void lazy_stream_inf_test(void)
+{
+    master_t eager, lazy;
+    hlsparse_master_init(&eager);
+    hlsparse_master_init(&lazy);
+    eager.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.lazy_attributes = HLS_TRUE;
+
+    int res = hlsparse_master(lazy_master_src, strlen(lazy_master_src), &eager);
+    CU_ASSERT_EQUAL(hlsparse_master(lazy_master_src, strlen(lazy_master_src), &lazy), res);
+    CU_ASSERT_EQUAL(lazy.nb_stream_infs, 3);
+
+    // only the uri is decoded by the parser
+    stream_inf_t *inf = lazy.stream_infs.data;
+    CU_ASSERT_NOT_EQUAL(inf->attributes, NULL);
+    CU_ASSERT_EQUAL(inf->decoded, 0);
+    CU_ASSERT_EQUAL(inf->bandwidth, 0.f);
+    CU_ASSERT_EQUAL(inf->codecs, NULL);
+    assert_string_equal(inf->uri, "http://www.example.com/900.m3u8", __func__, __LINE__);
+
+    CU_ASSERT_EQUAL(hlsparse_stream_inf_decode(inf, STREAM_INF_ATTR_BANDWIDTH | STREAM_INF_ATTR_RESOLUTION), HLS_OK);
+    CU_ASSERT_EQUAL(inf->bandwidth, 900000.f);
+    CU_ASSERT_EQUAL(inf->resolution.width, 1280);
+    CU_ASSERT_EQUAL(inf->resolution.height, 720);
+    CU_ASSERT_EQUAL(inf->avg_bandwidth, 0.f);
+    CU_ASSERT_EQUAL(inf->codecs, NULL);
+    CU_ASSERT_EQUAL(inf->decoded, STREAM_INF_ATTR_BANDWIDTH | STREAM_INF_ATTR_RESOLUTION);
+
+    // decoded attributes are kept, not decoded again
+    inf->bandwidth = 1.f;
+    hlsparse_stream_inf_decode(inf, STREAM_INF_ATTR_BANDWIDTH | STREAM_INF_ATTR_CODECS);
+    CU_ASSERT_EQUAL(inf->bandwidth, 1.f);
+    assert_string_equal(inf->codecs, "mp4a.40.2,avc1.4d401e", __func__, __LINE__);
+    inf->bandwidth = 900000.f;
+
+    // the attribute list is released once everything is decoded
+    hlsparse_stream_inf_decode(inf, STREAM_INF_ATTR_ALL);
+    CU_ASSERT_EQUAL(inf->attributes, NULL);
+    CU_ASSERT_EQUAL(inf->decoded, STREAM_INF_ATTR_ALL);
+
+    hlsparse_master_decode(&lazy);
+    stream_inf_list_t *a = &eager.stream_infs;
+    stream_inf_list_t *b = &lazy.stream_infs;
+    while(a && a->data && b && b->data) {
+        assert_stream_inf_equal(a->data, b->data);
+        CU_ASSERT_EQUAL(b->data->attributes, NULL);
+        a = a->next;
+        b = b->next;
+    }
+    CU_ASSERT_EQUAL(a, NULL);
+    CU_ASSERT_EQUAL(b, NULL);
+
+    CU_ASSERT_EQUAL(hlsparse_stream_inf_decode(NULL, STREAM_INF_ATTR_ALL), HLS_ERROR);
+
+    // eagerly parsed stream infs have nothing left to decode
+    CU_ASSERT_EQUAL(hlsparse_stream_inf_decode(eager.stream_infs.data, STREAM_INF_ATTR_ALL), HLS_OK);
+    CU_ASSERT_EQUAL(eager.stream_infs.data->bandwidth, 900000.f);
+
+    hlsparse_master_term(&eager);
+    hlsparse_master_term(&lazy);
+}
+
+void lazy_media_test(void)
+{
+    master_t eager, lazy;
+    hlsparse_master_init(&eager);
+    hlsparse_master_init(&lazy);
+    eager.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.lazy_attributes = HLS_TRUE;
+
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &eager);
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &lazy);
+
+    media_t *media = lazy.media.next->data;
+    CU_ASSERT_EQUAL(media->type, MEDIA_TYPE_NONE);
+    hlsparse_media_decode(media, MEDIA_ATTR_TYPE | MEDIA_ATTR_INSTREAM_ID);
+    CU_ASSERT_EQUAL(media->type, MEDIA_TYPE_CLOSEDCAPTIONS);
+    CU_ASSERT_EQUAL(media->instream_id, MEDIA_INSTREAMID_SERVICE);
+    CU_ASSERT_EQUAL(media->service_n, 3);
+    CU_ASSERT_EQUAL(media->group_id, NULL);
+
+    hlsparse_master_decode(&lazy);
+    media_list_t *a = &eager.media;
+    media_list_t *b = &lazy.media;
+    while(a && a->data && b && b->data) {
+        assert_media_equal(a->data, b->data);
+        a = a->next;
+        b = b->next;
+    }
+    CU_ASSERT_EQUAL(a, NULL);
+    CU_ASSERT_EQUAL(b, NULL);
+
+    hlsparse_master_term(&eager);
+    hlsparse_master_term(&lazy);
+}
+
+void lazy_daterange_test(void)
+{
+    media_playlist_t eager, lazy;
+    hlsparse_media_playlist_init(&eager);
+    hlsparse_media_playlist_init(&lazy);
+    lazy.lazy_attributes = HLS_TRUE;
+
+    hlsparse_media_playlist(lazy_media_src, strlen(lazy_media_src), &eager);
+    hlsparse_media_playlist(lazy_media_src, strlen(lazy_media_src), &lazy);
+    CU_ASSERT_EQUAL(lazy.nb_dateranges, 2);
+
+    daterange_t *dr = lazy.dateranges.data;
+    CU_ASSERT_EQUAL(dr->id, NULL);
+    CU_ASSERT_EQUAL(dr->pdt, eager.dateranges.data->pdt);
+
+    hlsparse_daterange_decode(dr, DATERANGE_ATTR_ID | DATERANGE_ATTR_START_DATE);
+    assert_string_equal(dr->id, "ad", __func__, __LINE__);
+    CU_ASSERT_EQUAL(dr->start_date, eager.dateranges.data->start_date);
+    CU_ASSERT_EQUAL(dr->klass, NULL);
+    CU_ASSERT_EQUAL(dr->scte35_out, NULL);
+    CU_ASSERT_EQUAL(dr->client_attributes.value_type, PARAM_TYPE_NONE);
+
+    hlsparse_daterange_decode(dr, DATERANGE_ATTR_CLIENT | DATERANGE_ATTR_SCTE35_OUT);
+    CU_ASSERT_EQUAL(dr->scte35_out_size, 3);
+    CU_ASSERT_EQUAL(memcmp(dr->scte35_out, eager.dateranges.data->scte35_out, 3), 0);
+    assert_string_equal(dr->client_attributes.key, "X-COM-EXAMPLE", __func__, __LINE__);
+    assert_string_equal(dr->client_attributes.value.data, "value", __func__, __LINE__);
+    CU_ASSERT_NOT_EQUAL(dr->client_attributes.next, NULL);
+    if(dr->client_attributes.next) {
+        CU_ASSERT_EQUAL(dr->client_attributes.next->value_type, PARAM_TYPE_FLOAT);
+        CU_ASSERT_EQUAL(dr->client_attributes.next->value.number, 12.5f);
+    }
+    CU_ASSERT_EQUAL(dr->end_on_next, HLS_FALSE);
+
+    // writing decodes the rest, both playlists must write the same text
+    char *eager_out = NULL, *lazy_out = NULL;
+    int eager_size = 0, lazy_size = 0;
+    hlswrite_media(&eager_out, &eager_size, &eager);
+    hlswrite_media(&lazy_out, &lazy_size, &lazy);
+    CU_ASSERT_EQUAL(eager_size, lazy_size);
+    assert_string_equal(eager_out, lazy_out, __func__, __LINE__);
+    CU_ASSERT_EQUAL(lazy.dateranges.data->attributes, NULL);
+    CU_ASSERT_EQUAL(lazy.dateranges.data->end_on_next, HLS_TRUE);
+
+    hls_free(eager_out);
+    hls_free(lazy_out);
+    hlsparse_media_playlist_term(&eager);
+    hlsparse_media_playlist_term(&lazy);
+}
+
+void lazy_write_master_test(void)
+{
+    master_t eager, lazy;
+    hlsparse_master_init(&eager);
+    hlsparse_master_init(&lazy);
+    eager.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.uri = str_utils_dup("http://www.example.com/master.m3u8");
+    lazy.lazy_attributes = HLS_TRUE;
+
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &eager);
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &lazy);
+
+    // some attributes are decoded, the rest are left to the writer
+    hlsparse_stream_inf_decode(lazy.stream_infs.data, STREAM_INF_ATTR_BANDWIDTH);
+
+    char *eager_out = NULL, *lazy_out = NULL;
+    int eager_size = 0, lazy_size = 0;
+    hlswrite_master(&eager_out, &eager_size, &eager);
+    hlswrite_master(&lazy_out, &lazy_size, &lazy);
+    CU_ASSERT_EQUAL(eager_size, lazy_size);
+    assert_string_equal(eager_out, lazy_out, __func__, __LINE__);
+
+    hls_free(eager_out);
+    hls_free(lazy_out);
+    hlsparse_master_term(&eager);
+    hlsparse_master_term(&lazy);
+}
+
+void lazy_allocs_test(void)
+{
+    hlsparse_alloc_stats_t eager_stats, lazy_stats;
+    master_t master;
+
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+
+    hlsparse_master_init(&master);
+    hlsparse_alloc_stats_reset();
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &master);
+    hlsparse_alloc_stats(&eager_stats);
+    hlsparse_master_term(&master);
+
+    hlsparse_master_init(&master);
+    master.lazy_attributes = HLS_TRUE;
+    hlsparse_alloc_stats_reset();
+    hlsparse_master(lazy_master_src, strlen(lazy_master_src), &master);
+    hlsparse_alloc_stats(&lazy_stats);
+    hlsparse_master_term(&master);
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    // one attribute list per tag instead of one string per quoted attribute
+    CU_ASSERT(lazy_stats.nb_allocs < eager_stats.nb_allocs);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("lazy", NULL, NULL);
+    test("lazy_stream_inf", lazy_stream_inf_test);
+    test("lazy_media", lazy_media_test);
+    test("lazy_daterange", lazy_daterange_test);
+    test("lazy_write_master", lazy_write_master_test);
+    test("lazy_allocs", lazy_allocs_test);
+}
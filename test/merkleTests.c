@@ -0,0 +1,177 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "tests.h"
+#include <stdio.h>
+#include <CUnit/Basic.h>
+
+const char *replica_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:200\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\"\n"\
+"#EXTINF:6.000,\n"\
+"segment200.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment201.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment202.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment203.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment204.ts\n";
+
+// segment 203 has a different duration
+const char *diverged_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:200\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\"\n"\
+"#EXTINF:6.000,\n"\
+"segment200.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment201.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment202.ts\n"\
+"#EXTINF:5.000,\n"\
+"segment203.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment204.ts\n";
+
+// the same segments without the last one
+const char *behind_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:200\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\"\n"\
+"#EXTINF:6.000,\n"\
+"segment200.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment201.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment202.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment203.ts\n";
+
+static void parse(const char *src, media_playlist_t *playlist)
+{
+    hlsparse_media_playlist_init(playlist);
+    playlist->segment_hashes = HLS_TRUE;
+    hlsparse_media_playlist(src, strlen(src), playlist);
+}
+
+void merkle_test(void)
+{
+    media_playlist_t a, b, diverged, behind;
+    parse(replica_src, &a);
+    parse(replica_src, &b);
+    parse(diverged_src, &diverged);
+    parse(behind_src, &behind);
+
+    CU_ASSERT_EQUAL(a.nb_merkle_leaves, 5);
+    CU_ASSERT_NOT_EQUAL(a.merkle_tree, NULL);
+    CU_ASSERT_NOT_EQUAL(a.merkle_root, 0);
+    CU_ASSERT_EQUAL(a.merkle_root, b.merkle_root);
+    CU_ASSERT_NOT_EQUAL(a.merkle_root, diverged.merkle_root);
+    CU_ASSERT_NOT_EQUAL(a.merkle_root, behind.merkle_root);
+    CU_ASSERT_NOT_EQUAL(a.segments.data->hash, a.segments.next->data->hash);
+    CU_ASSERT_EQUAL(a.segments.data->hash, diverged.segments.data->hash);
+
+    // 5 leaves, 3 parents, 2 grand parents and the root
+    uint64_t hash = 0;
+    HLSCode res = hlsparse_media_playlist_merkle_node(&a, 0, 4, &hash);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(hash, a.merkle_tree[4]);
+    res = hlsparse_media_playlist_merkle_node(&a, 1, 2, &hash);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(hash, a.merkle_tree[4]);
+    res = hlsparse_media_playlist_merkle_node(&a, 3, 0, &hash);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(hash, a.merkle_root);
+    res = hlsparse_media_playlist_merkle_node(&a, 1, 3, &hash);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    int sequence = 0;
+    res = hlsparse_media_playlist_first_divergence(&a, &b, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(sequence, -1);
+
+    res = hlsparse_media_playlist_first_divergence(&a, &diverged, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(sequence, 203);
+
+    res = hlsparse_media_playlist_first_divergence(&behind, &a, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(sequence, 204);
+
+    res = hlsparse_media_playlist_first_divergence(&diverged, &behind, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(sequence, 203);
+
+    // the tree is kept in binary snapshots
+    res = hlsparse_media_playlist_save_binary("merkle_test.snap", &a);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    media_playlist_t *loaded = NULL;
+    res = hlsparse_media_playlist_load_binary("merkle_test.snap", &loaded);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    res = hlsparse_media_playlist_first_divergence(loaded, &diverged, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(sequence, 203);
+    hlsparse_media_playlist_unload_binary(loaded);
+    remove("merkle_test.snap");
+
+    // playlists parsed without hashes can't be compared
+    media_playlist_t plain;
+    hlsparse_media_playlist_init(&plain);
+    hlsparse_media_playlist(replica_src, strlen(replica_src), &plain);
+    CU_ASSERT_EQUAL(plain.merkle_tree, NULL);
+    res = hlsparse_media_playlist_first_divergence(&a, &plain, &sequence);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    res = hlsparse_media_playlist_hash_segments(&plain);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(plain.merkle_root, a.merkle_root);
+
+    hlsparse_media_playlist_term(&plain);
+    hlsparse_media_playlist_term(&a);
+    hlsparse_media_playlist_term(&b);
+    hlsparse_media_playlist_term(&diverged);
+    hlsparse_media_playlist_term(&behind);
+}
+
+void merkle_iv_test(void)
+{
+    // the IV is hashed to its parsed length, however short
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\",IV=0x0102\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+    const char *other_src = "#EXTM3U\n"\
+    "#EXT-X-TARGETDURATION:6\n"\
+    "#EXT-X-KEY:METHOD=AES-128,URI=\"key.key\",IV=0x0103\n"\
+    "#EXTINF:6.000,\n"\
+    "segment0.ts\n";
+
+    media_playlist_t playlist, other;
+    parse(src, &playlist);
+    parse(other_src, &other);
+    CU_ASSERT_EQUAL(playlist.keys.data->iv_size, 2);
+    CU_ASSERT_NOT_EQUAL(playlist.merkle_root, 0);
+    CU_ASSERT_NOT_EQUAL(playlist.merkle_root, other.merkle_root);
+    hlsparse_media_playlist_term(&playlist);
+    hlsparse_media_playlist_term(&other);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("merkle", NULL, NULL);
+    test("merkle", merkle_test);
+    test("merkle_iv", merkle_iv_test);
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+#include <pthread.h>
+
+const char *metrics_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:10\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"http://www.example.com/0.key\"\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment0.ts\n"\
+"#EXT-X-CUE-OUT:DURATION=6\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment1.ts\n"\
+"#EXT-X-CUE-IN\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment2.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+const char *metrics_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:4\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=800000\n"\
+"http://www.example.com/low.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=1600000\n"\
+"http://www.example.com/high.m3u8\n";
+
+#define METRICS_THREAD_PARSES   100
+#define METRICS_THREAD_ROUNDS   50
+
+static uint64_t histogram_total(const uint64_t *buckets)
+{
+    uint64_t total = 0;
+    int i;
+    for(i = 0; i < HLSPARSE_METRICS_BUCKETS; ++i) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+void metrics_tag_name_test(void)
+{
+    assert_string_equal(hlsparse_metrics_tag_name(METRICS_TAG_EXTINF), EXTINF, __func__, __LINE__);
+    assert_string_equal(hlsparse_metrics_tag_name(METRICS_TAG_EXTXSESSIONKEY), EXTXSESSIONKEY, __func__, __LINE__);
+    assert_string_equal(hlsparse_metrics_tag_name(METRICS_TAG_CUSTOM), "custom", __func__, __LINE__);
+    CU_ASSERT_EQUAL(hlsparse_metrics_tag_name(-1), NULL);
+    CU_ASSERT_EQUAL(hlsparse_metrics_tag_name(METRICS_TAG_COUNT), NULL);
+    CU_ASSERT_EQUAL(hlsparse_metrics(NULL), HLS_ERROR);
+}
+
+void metrics_parse_write_test(void)
+{
+    hlsparse_metrics_t before, after;
+
+    // nothing is counted until metrics are enabled
+    hlsparse_metrics(&before);
+    media_playlist_t media;
+    hlsparse_media_playlist_init(&media);
+    hlsparse_media_playlist(metrics_media_src, strlen(metrics_media_src), &media);
+    hlsparse_media_playlist_term(&media);
+    hlsparse_metrics(&after);
+    CU_ASSERT_EQUAL(memcmp(&before, &after, sizeof(hlsparse_metrics_t)), 0);
+
+    hlsparse_metrics_enable(HLS_TRUE);
+
+    hlsparse_media_playlist_init(&media);
+    hlsparse_media_playlist(metrics_media_src, strlen(metrics_media_src), &media);
+
+    char *out = NULL;
+    int size = 0;
+    hlswrite_media(&out, &size, &media);
+
+    master_t master;
+    hlsparse_master_init(&master);
+    hlsparse_master(metrics_master_src, strlen(metrics_master_src), &master);
+
+    hlsparse_metrics(&after);
+    CU_ASSERT_EQUAL(after.nb_media_parsed - before.nb_media_parsed, 1);
+    CU_ASSERT_EQUAL(after.nb_master_parsed - before.nb_master_parsed, 1);
+    CU_ASSERT_EQUAL(after.bytes_parsed - before.bytes_parsed, strlen(metrics_media_src) + strlen(metrics_master_src));
+    CU_ASSERT_EQUAL(after.nb_media_written - before.nb_media_written, 1);
+    CU_ASSERT_EQUAL(after.nb_master_written - before.nb_master_written, 0);
+    CU_ASSERT_EQUAL(after.bytes_written - before.bytes_written, size);
+
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTM3U] - before.tags[METRICS_TAG_EXTM3U], 2);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTXVERSION] - before.tags[METRICS_TAG_EXTXVERSION], 2);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTINF] - before.tags[METRICS_TAG_EXTINF], 3);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTXKEY] - before.tags[METRICS_TAG_EXTXKEY], 1);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTXMEDIASEQUENCE] - before.tags[METRICS_TAG_EXTXMEDIASEQUENCE], 1);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTXENDLIST] - before.tags[METRICS_TAG_EXTXENDLIST], 1);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTXSTREAMINF] - before.tags[METRICS_TAG_EXTXSTREAMINF], 2);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_CUSTOM] - before.tags[METRICS_TAG_CUSTOM], 2);
+
+    CU_ASSERT_EQUAL(histogram_total(after.parse_latency) - histogram_total(before.parse_latency), 2);
+    CU_ASSERT_EQUAL(histogram_total(after.write_latency) - histogram_total(before.write_latency), 1);
+
+    hlsparse_metrics_enable(HLS_FALSE);
+
+    hls_free(out);
+    hlsparse_media_playlist_term(&media);
+    hlsparse_master_term(&master);
+}
+
+static void *metrics_thread_parse(void *arg)
+{
+    int i;
+    for(i = 0; i < METRICS_THREAD_PARSES; ++i) {
+        media_playlist_t media;
+        hlsparse_media_playlist_init(&media);
+        hlsparse_media_playlist(metrics_media_src, strlen(metrics_media_src), &media);
+        hlsparse_media_playlist_term(&media);
+    }
+    return NULL;
+}
+
+void metrics_threads_test(void)
+{
+    hlsparse_metrics_t before, after;
+    hlsparse_metrics(&before);
+    hlsparse_metrics_enable(HLS_TRUE);
+
+    pthread_t threads[4];
+    int i;
+    for(i = 0; i < 4; ++i) {
+        pthread_create(&threads[i], NULL, metrics_thread_parse, NULL);
+    }
+    for(i = 0; i < 4; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // counts from threads which have exited are kept
+    hlsparse_metrics(&after);
+    CU_ASSERT_EQUAL(after.nb_media_parsed - before.nb_media_parsed, 4 * METRICS_THREAD_PARSES);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTINF] - before.tags[METRICS_TAG_EXTINF], 4 * 3 * METRICS_THREAD_PARSES);
+    CU_ASSERT_EQUAL(after.bytes_parsed - before.bytes_parsed, 4 * strlen(metrics_media_src) * METRICS_THREAD_PARSES);
+    CU_ASSERT_EQUAL(histogram_total(after.parse_latency) - histogram_total(before.parse_latency), 4 * METRICS_THREAD_PARSES);
+
+    hlsparse_metrics_enable(HLS_FALSE);
+}
+
+void metrics_thread_exit_test(void)
+{
+    hlsparse_metrics_t before, after;
+    hlsparse_metrics(&before);
+    hlsparse_metrics_enable(HLS_TRUE);
+    int nb_blocks = metrics_nb_blocks();
+
+    // threads which come and go free their blocks but keep their counts
+    int i, j;
+    for(i = 0; i < METRICS_THREAD_ROUNDS; ++i) {
+        pthread_t threads[4];
+        for(j = 0; j < 4; ++j) {
+            pthread_create(&threads[j], NULL, metrics_thread_parse, NULL);
+        }
+        for(j = 0; j < 4; ++j) {
+            pthread_join(threads[j], NULL);
+        }
+        CU_ASSERT_EQUAL(metrics_nb_blocks(), nb_blocks);
+    }
+
+    hlsparse_metrics(&after);
+    CU_ASSERT_EQUAL(after.nb_media_parsed - before.nb_media_parsed, METRICS_THREAD_ROUNDS * 4 * METRICS_THREAD_PARSES);
+    CU_ASSERT_EQUAL(after.tags[METRICS_TAG_EXTINF] - before.tags[METRICS_TAG_EXTINF], METRICS_THREAD_ROUNDS * 4 * 3 * METRICS_THREAD_PARSES);
+    CU_ASSERT_EQUAL(histogram_total(after.parse_latency) - histogram_total(before.parse_latency), METRICS_THREAD_ROUNDS * 4 * METRICS_THREAD_PARSES);
+
+    hlsparse_metrics_enable(HLS_FALSE);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("metrics", NULL, NULL);
+    test("metrics_tag_name", metrics_tag_name_test);
+    test("metrics_parse_write", metrics_parse_write_test);
+    test("metrics_threads", metrics_threads_test);
+    test("metrics_thread_exit", metrics_thread_exit_test);
+}
@@ -368,6 +368,42 @@ void segment_term_test(void)
     CU_ASSERT_EQUAL(segment.title, NULL);
 }
 
+void list_term_test(void)
+{
+    // more nodes than frames would fit on the stack if the list was recursed
+    const int nb_nodes = 1000000;
+    segment_list_t segments;
+    string_list_t strings;
+    hlsparse_segment_list_init(&segments);
+    hlsparse_string_list_init(&strings);
+
+    segment_list_t *segment = &segments;
+    string_list_t *string = &strings;
+    int i;
+    for(i = 0; i < nb_nodes; ++i) {
+        segment->data = i % 1000 == 0 ? hls_malloc(sizeof(segment_t)) : NULL;
+        if(segment->data) {
+            hlsparse_segment_init(segment->data);
+            segment->data->uri = str_utils_dup("uri");
+        }
+        segment->next = i + 1 < nb_nodes ? hls_malloc(sizeof(segment_list_t)) : NULL;
+        segment = segment->next;
+
+        string->data = i % 1000 == 0 ? str_utils_dup("tag") : NULL;
+        string->next = i + 1 < nb_nodes ? hls_malloc(sizeof(string_list_t)) : NULL;
+        string = string->next;
+    }
+
+    hlsparse_segment_list_term(&segments);
+    CU_ASSERT_EQUAL(segments.data, NULL);
+    CU_ASSERT_EQUAL(segments.next, NULL);
+    hlsparse_string_list_term(&strings);
+    CU_ASSERT_EQUAL(strings.data, NULL);
+    CU_ASSERT_EQUAL(strings.next, NULL);
+
+    hlsparse_segment_list_term(NULL);
+}
+
 void session_data_term_test(void)
 {
     session_data_t session;
@@ -562,6 +598,15 @@ void parse_key_test(void)
     res = parse_key(src4, strlen(src4), &key2);
     CU_ASSERT_EQUAL(res, strlen(src4));
     CU_ASSERT_EQUAL(key2.method, KEY_METHOD_SAMPLEAES);
+
+    // an IV is 16 bytes of binary data, zeros included
+    const char *src5 = "METHOD=AES-128,URI=\"k.key\",IV=0x00000000000000000000000000000001";
+    hlsparse_key_init(&key);
+    res = parse_key(src5, strlen(src5), &key);
+    CU_ASSERT_EQUAL(res, strlen(src5));
+    CU_ASSERT_EQUAL(key.iv_size, 16);
+    CU_ASSERT_EQUAL(memcmp(key.iv, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\1", 16), 0);
+    hlsparse_key_term(&key);
 }
 
 void parse_map_test(void)
@@ -641,6 +686,18 @@ void parse_daterange_test(void)
     CU_ASSERT_EQUAL(item->next, NULL);
 
     hlsparse_daterange_term(&daterange);
+
+    // START-DATE and END-DATE are quoted-strings, the attributes after them
+    // are still parsed
+    const char *quoted = "ID=\"two\",START-DATE=\"2017-12-09T18:09:56.001Z\",END-DATE=\"2017-12-09T18:10:26.501Z\",DURATION=30.5";
+    hlsparse_daterange_init(&daterange);
+    res = parse_daterange(quoted, strlen(quoted), &daterange);
+    CU_ASSERT_EQUAL(res, strlen(quoted));
+    CU_ASSERT_EQUAL(strcmp(daterange.id, "two"), 0);
+    CU_ASSERT_EQUAL(daterange.start_date, 1512842996001);
+    CU_ASSERT_EQUAL(daterange.end_date, 1512843026501);
+    CU_ASSERT_EQUAL(daterange.duration, 30.5f);
+    hlsparse_daterange_term(&daterange);
 }
 
 void parse_media_test(void)
@@ -783,6 +840,33 @@ void parse_segment_test(void)
     CU_ASSERT_EQUAL(seg.duration, 4.f);
     CU_ASSERT_EQUAL(strcmp(seg.title, "bar"), 0);
     CU_ASSERT_EQUAL(seg.uri, NULL);
+
+    // the segment ends its duration, rounded to the millisecond, after its pdt
+    const char *src4 = "#EXTINF:9.97663,";
+    hlsparse_segment_term(&seg);
+    hlsparse_segment_init(&seg);
+    seg.pdt = 1512842986001;
+    res = parse_segment(src4, strlen(src4), &seg);
+    CU_ASSERT_EQUAL(res, strlen(src4));
+    CU_ASSERT_EQUAL(seg.pdt_end, 1512842995978);
+    hlsparse_segment_term(&seg);
+}
+
+void parse_program_date_time_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+
+    // the next segment's pdt is kept to the exact millisecond
+    const char *src = "EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z";
+    parse_media_playlist_tag(src, strlen(src), &playlist);
+    CU_ASSERT_EQUAL(playlist.next_segment_pdt, 1512842986001);
+
+    const char *src2 = "EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:58.123+01:00";
+    parse_media_playlist_tag(src2, strlen(src2), &playlist);
+    CU_ASSERT_EQUAL(playlist.next_segment_pdt, 1512839398123);
+
+    hlsparse_media_playlist_term(&playlist);
 }
 
 void parse_session_data_test(void)
@@ -875,6 +959,7 @@ void setup(void)
     test("media_term", media_term_test);
     test("segment_term", segment_term_test);
     test("session_data_term", session_data_term_test);
+    test("list_term", list_term_test);
 
     suite("parser_tags_parse", NULL, NULL);
     test("parse_byte_range", parse_byte_range_test);
@@ -886,6 +971,7 @@ void setup(void)
     test("parse_daterange", parse_daterange_test);
     test("parse_media", parse_media_test);
     test("parse_segment", parse_segment_test);
+    test("parse_program_date_time", parse_program_date_time_test);
     test("parse_session_data", parse_session_data_test);
     test("parse_start", parse_start_test);
 }
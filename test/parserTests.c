@@ -8,6 +8,7 @@
 #include "../src/parse.h"
 #include "tests.h"
 #include <CUnit/Basic.h>
+#include <stdlib.h>
 
 int init(void)
 {
@@ -133,6 +134,94 @@ void parse_float_test(void)
     CU_ASSERT_EQUAL(res, 0);
 }
 
+void parse_digits_test(void)
+{
+    char src[64];
+    int dest;
+    int i;
+
+    // every length of number either side of the 8 digit words, followed by
+    // characters which are only just outside '0' to '9'
+    for(i = 1; i <= 9; ++i) {
+        snprintf(src, sizeof(src), "%.*s/:9999999999", i, "123456789");
+        int expected = atoi(src);
+        CU_ASSERT_EQUAL(parse_str_to_int(src, &dest, strlen(src)), i);
+        CU_ASSERT_EQUAL(dest, expected);
+        CU_ASSERT_EQUAL(parse_str_to_int(src, &dest, i), i);
+        CU_ASSERT_EQUAL(dest, expected);
+    }
+
+    CU_ASSERT_EQUAL(parse_str_to_int("-2147483648,", &dest, 12), 11);
+    CU_ASSERT_EQUAL(dest, -2147483647 - 1);
+    CU_ASSERT_EQUAL(parse_str_to_int("0000000000000042@0", &dest, 18), 16);
+    CU_ASSERT_EQUAL(dest, 42);
+    // the size ends the number part way through a word
+    CU_ASSERT_EQUAL(parse_str_to_int("1234567890123", &dest, 5), 5);
+    CU_ASSERT_EQUAL(dest, 12345);
+
+    resolution_t resolution;
+    CU_ASSERT_EQUAL(parse_resolution("1920x1080,", 10, &resolution), 9);
+    CU_ASSERT_EQUAL(resolution.width, 1920);
+    CU_ASSERT_EQUAL(resolution.height, 1080);
+
+    byte_range_t byte_range;
+    CU_ASSERT_EQUAL(parse_byte_range("75232@123456789\n", 16, &byte_range), 15);
+    CU_ASSERT_EQUAL(byte_range.n, 75232);
+    CU_ASSERT_EQUAL(byte_range.o, 123456789);
+}
+
+void parse_duration_test(void)
+{
+    static const char *values[] = {
+        "6.006", "10.000", "9.97663", "0.1", "29.970", "0.000001", "4.004",
+        "123456789.123456789", "1.7976931348623157", "0.30000000000000004",
+        "12345678901234567890123.5", "-0.5", "5.005000"
+    };
+    float dest;
+    double seconds;
+    int64_t ms;
+    int i;
+
+    // rounded once to the nearest float, and durations to the nearest double
+    for(i = 0; i < (int)(sizeof(values) / sizeof(values[0])); ++i) {
+        size_t len = strlen(values[i]);
+        CU_ASSERT_EQUAL(parse_str_to_float(values[i], &dest, len), len);
+        CU_ASSERT_EQUAL(dest, strtof(values[i], NULL));
+        CU_ASSERT_EQUAL(parse_str_to_duration(values[i], &seconds, NULL, len), len);
+        CU_ASSERT_EQUAL(seconds, strtod(values[i], NULL));
+    }
+
+    // and to whole milliseconds from the same decimal
+    CU_ASSERT_EQUAL(parse_str_to_duration("9.97663,", &seconds, &ms, 8), 7);
+    CU_ASSERT_EQUAL(seconds, 9.97663);
+    CU_ASSERT_EQUAL(ms, 9977);
+    CU_ASSERT_EQUAL(parse_str_to_duration("9.9765", NULL, &ms, 6), 6);
+    CU_ASSERT_EQUAL(ms, 9977);
+    CU_ASSERT_EQUAL(parse_str_to_duration("7.,", &seconds, &ms, 3), 2);
+    CU_ASSERT_EQUAL(seconds, 7.);
+    CU_ASSERT_EQUAL(ms, 7000);
+    CU_ASSERT_EQUAL(parse_str_to_duration(NULL, &seconds, &ms, 3), 0);
+}
+
+void parse_ticks_test(void)
+{
+    int64_t dest;
+
+    CU_ASSERT_EQUAL(parse_str_to_ticks("46.001Z", &dest, 3, 7), 6);
+    CU_ASSERT_EQUAL(dest, 46001);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("9.97663,", &dest, 3, 8), 7);
+    CU_ASSERT_EQUAL(dest, 9977);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("0.0005", &dest, 3, 6), 6);
+    CU_ASSERT_EQUAL(dest, 1);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("0.00049999", &dest, 3, 10), 10);
+    CU_ASSERT_EQUAL(dest, 0);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("-2.5", &dest, 0, 4), 4);
+    CU_ASSERT_EQUAL(dest, -3);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("6", &dest, 6, 1), 1);
+    CU_ASSERT_EQUAL(dest, 6000000);
+    CU_ASSERT_EQUAL(parse_str_to_ticks("", &dest, 3, 0), 0);
+}
+
 void parse_date_test(void)
 {
     uint64_t dest;
@@ -190,6 +279,22 @@ void parse_date_test(void)
     res = parse_date("1970-08-18T01:28:29.06-01:00, is a date", &dest, 39);
     CU_ASSERT_EQUAL(res, 28);
     CU_ASSERT_EQUAL(dest, 19794509060);
+
+    // milliseconds are exact, a float 46.001 falls short of 46001
+    res = parse_date("2017-12-09T18:09:46.001Z", &dest, 24);
+    CU_ASSERT_EQUAL(res, 23);
+    CU_ASSERT_EQUAL(dest, 1512842986001);
+
+    res = parse_date("2017-12-09T18:09:46.999Z", &dest, 24);
+    CU_ASSERT_EQUAL(dest, 1512842986999);
+
+    // and finer fractions round to the nearest millisecond
+    res = parse_date("2017-12-09T18:09:46.0005Z", &dest, 25);
+    CU_ASSERT_EQUAL(res, 24);
+    CU_ASSERT_EQUAL(dest, 1512842986001);
+
+    res = parse_date("2017-12-09T18:09:59.9996Z", &dest, 25);
+    CU_ASSERT_EQUAL(dest, 1512843000000);
 }
 
 void parse_attrib_str_test(void)
@@ -264,6 +369,31 @@ void parse_attrib_data_test(void)
     res = parse_attrib_data("0x474747 after", &dest, 15);
     CU_ASSERT_EQUAL(res, 8);
     CU_ASSERT_EQUAL(strcmp(dest, "GGG"), 0);
+    hls_free(dest);
+
+    // the data is binary, zero bytes don't end it
+    dest = NULL;
+    res = parse_attrib_data("0x00FC0000ff,", &dest, 13);
+    CU_ASSERT_EQUAL(res, 12);
+    CU_ASSERT_EQUAL(memcmp(dest, "\x00\xFC\x00\x00\xFF", 5), 0);
+    CU_ASSERT_EQUAL(dest[5], '\0');
+    hls_free(dest);
+
+    // longer than the 16 bytes of an IV
+    const char *longer = "0x000102030405060708090A0B0C0D0E0F1011121314";
+    dest = NULL;
+    res = parse_attrib_data(longer, &dest, strlen(longer));
+    CU_ASSERT_EQUAL(res, strlen(longer));
+    int i;
+    for(i = 0; i < 21; ++i) {
+        CU_ASSERT_EQUAL(dest[i], i);
+    }
+
+    // replaces an earlier value, a trailing odd digit is ignored
+    res = parse_attrib_data("0X4748A", &dest, 7);
+    CU_ASSERT_EQUAL(res, 7);
+    CU_ASSERT_EQUAL(strcmp(dest, "GH"), 0);
+    hls_free(dest);
 }
 
 void setup()
@@ -275,6 +405,9 @@ void setup()
     test("parse_line2", parse_line_test2);
     test("parse_int", parse_int_test);
     test("parse_float", parse_float_test);
+    test("parse_digits", parse_digits_test);
+    test("parse_duration", parse_duration_test);
+    test("parse_ticks", parse_ticks_test);
     test("parse_date", parse_date_test);
     test("parse_attrib_str", parse_attrib_str_test);
     test("parse_attrib_data", parse_attrib_data_test);
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *summary_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:6\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:2\n"\
+"#EXT-X-PLAYLIST-TYPE:EVENT\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\"\n"\
+"#EXTINF:10.000,zero\n"\
+"segment0.ts\n"\
+"#EXTINF:9.500,one\n"\
+"segment1.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T19:00:00.000Z\n"\
+"#EXTINF:10.000,two\n"\
+"segment2.ts\n"\
+"#EXTINF:10.000,three\n"\
+"segment3.ts\n"\
+"#EXTINF:4.004,four\r\n"\
+"segment4.ts\r\n"\
+"#EXT-X-ENDLIST";
+
+const char *summary_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,AUDIO=\"aac\"\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=1500000,AUDIO=\"aac\"\n"\
+"1500.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,URI=\"iframe.m3u8\"\n";
+
+void summary_media_test(void)
+{
+    playlist_summary_t summary;
+    media_playlist_t playlist;
+
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(summary_media_src, strlen(summary_media_src), &summary), HLS_OK);
+
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_media_playlist(summary_media_src, strlen(summary_media_src), &playlist);
+
+    CU_ASSERT_EQUAL(summary.m3u, HLS_TRUE);
+    CU_ASSERT_EQUAL(summary.master, HLS_FALSE);
+    CU_ASSERT_EQUAL(summary.version, playlist.version);
+    CU_ASSERT_EQUAL(summary.target_duration, playlist.target_duration);
+    CU_ASSERT_EQUAL(summary.media_sequence, 100);
+    CU_ASSERT_EQUAL(summary.media_sequence, playlist.media_sequence);
+    CU_ASSERT_EQUAL(summary.discontinuity_sequence, 2);
+    CU_ASSERT_EQUAL(summary.discontinuity_sequence, playlist.discontinuity_sequence);
+    CU_ASSERT_EQUAL(summary.playlist_type, PLAYLIST_TYPE_EVENT);
+    CU_ASSERT_EQUAL(summary.end_list, HLS_TRUE);
+    CU_ASSERT_EQUAL(summary.end_list, playlist.end_list);
+    CU_ASSERT_EQUAL(summary.nb_segments, 5);
+    CU_ASSERT_EQUAL(summary.nb_segments, playlist.nb_segments);
+    CU_ASSERT_EQUAL(summary.duration, playlist.duration);
+    CU_ASSERT_EQUAL(summary.last_pdt, playlist.last_segment->pdt);
+    CU_ASSERT_EQUAL(summary.last_pdt, 1512846020000);
+    CU_ASSERT_EQUAL(summary.nb_stream_infs, 0);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void summary_master_test(void)
+{
+    playlist_summary_t summary;
+
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(summary_master_src, strlen(summary_master_src), &summary), HLS_OK);
+    CU_ASSERT_EQUAL(summary.m3u, HLS_TRUE);
+    CU_ASSERT_EQUAL(summary.master, HLS_TRUE);
+    CU_ASSERT_EQUAL(summary.version, 7);
+    CU_ASSERT_EQUAL(summary.nb_stream_infs, 2);
+    CU_ASSERT_EQUAL(summary.nb_segments, 0);
+    CU_ASSERT_EQUAL(summary.media_sequence, 0);
+    CU_ASSERT_EQUAL(summary.last_pdt, 0);
+}
+
+void summary_edge_test(void)
+{
+    playlist_summary_t summary;
+
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(NULL, 0, &summary), HLS_ERROR);
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(summary_media_src, 0, NULL), HLS_ERROR);
+
+    // no program date time
+    const char *src = "#EXTM3U\n#EXT-X-TARGETDURATION:6\n#EXTINF:6,\na.ts\n#EXTINF:6,\nb.ts\n";
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(src, strlen(src), &summary), HLS_OK);
+    CU_ASSERT_EQUAL(summary.nb_segments, 2);
+    CU_ASSERT_EQUAL(summary.duration, 12.f);
+    CU_ASSERT_EQUAL(summary.last_pdt, 0);
+    CU_ASSERT_EQUAL(summary.end_list, HLS_FALSE);
+    CU_ASSERT_EQUAL(summary.playlist_type, PLAYLIST_TYPE_INVALID);
+
+    // a program date time after the last segment doesn't apply to it
+    src = "#EXTM3U\n#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n#EXTINF:6,\na.ts\n"\
+          "#EXT-X-PROGRAM-DATE-TIME:2020-01-01T00:00:00.000Z\n";
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(src, strlen(src), &summary), HLS_OK);
+    CU_ASSERT_EQUAL(summary.last_pdt, 1512842986001);
+
+    // only size bytes are read
+    src = "#EXTM3U\n#EXTINF:6,\na.ts\n#EXTINF:6,\nb.ts\n";
+    CU_ASSERT_EQUAL(hlsparse_media_playlist_summary(src, 20, &summary), HLS_OK);
+    CU_ASSERT_EQUAL(summary.nb_segments, 1);
+}
+
+void summary_allocs_test(void)
+{
+    playlist_summary_t summary;
+    hlsparse_alloc_stats_t stats;
+
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hlsparse_alloc_stats_reset();
+    hlsparse_media_playlist_summary(summary_media_src, strlen(summary_media_src), &summary);
+    hlsparse_media_playlist_summary(summary_master_src, strlen(summary_master_src), &summary);
+    hlsparse_alloc_stats(&stats);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    CU_ASSERT_EQUAL(stats.nb_allocs, 0);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("summary", NULL, NULL);
+    test("summary_media", summary_media_test);
+    test("summary_master", summary_master_test);
+    test("summary_edge", summary_edge_test);
+    test("summary_allocs", summary_allocs_test);
+}
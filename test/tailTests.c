@@ -0,0 +1,205 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *tail_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:6\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:2\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\"\n"\
+"#EXT-X-MAP:URI=\"init0.mp4\"\n"\
+"#EXTINF:10.000,zero\n"\
+"segment0.ts\n"\
+"#EXTINF:9.500,one\n"\
+"segment1.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T19:00:00.000Z\n"\
+"#EXT-X-MAP:URI=\"init1.mp4\"\n"\
+"#EXTINF:10.000,two\n"\
+"segment2.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T19:00:15.000Z\",DURATION=20.0\n"\
+"#EXTINF:10.000,three\n"\
+"segment3.ts\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key1.bin\"\n"\
+"#EXT-X-BYTERANGE:1000@200\n"\
+"#EXTINF:10.000,four\n"\
+"segment4.ts\n"\
+"#EXT-X-CUSTOM-TAG:1\n"\
+"#EXTINF:10.000,five\n"\
+"segment5.ts\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T19:01:00.000Z\n"\
+"#EXT-X-DATERANGE:ID=\"ad2\",START-DATE=\"2017-12-09T19:01:00.000Z\"\n"\
+"#EXTINF:10.000,six\n"\
+"segment6.ts\n"\
+"#EXTINF:10.000,seven\n"\
+"segment7.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+static void assert_playlist_equal(media_playlist_t *a, media_playlist_t *b)
+{
+    CU_ASSERT_EQUAL(a->nb_segments, b->nb_segments);
+    CU_ASSERT_EQUAL(a->nb_keys, b->nb_keys);
+    CU_ASSERT_EQUAL(a->nb_maps, b->nb_maps);
+    CU_ASSERT_EQUAL(a->nb_dateranges, b->nb_dateranges);
+    CU_ASSERT_EQUAL(a->media_sequence, b->media_sequence);
+    CU_ASSERT_EQUAL(a->discontinuity_sequence, b->discontinuity_sequence);
+    CU_ASSERT_EQUAL(a->duration, b->duration);
+    CU_ASSERT_EQUAL(a->next_segment_pdt, b->next_segment_pdt);
+    CU_ASSERT_EQUAL(a->end_list, b->end_list);
+
+    segment_list_t *sa = &a->segments;
+    segment_list_t *sb = &b->segments;
+    while(sa && sa->data && sb && sb->data) {
+        CU_ASSERT_EQUAL(sa->data->sequence_num, sb->data->sequence_num);
+        CU_ASSERT_EQUAL(sa->data->key_index, sb->data->key_index);
+        CU_ASSERT_EQUAL(sa->data->map_index, sb->data->map_index);
+        CU_ASSERT_EQUAL(sa->data->daterange_index, sb->data->daterange_index);
+        CU_ASSERT_EQUAL(sa->data->pdt, sb->data->pdt);
+        CU_ASSERT_EQUAL(sa->data->pdt_end, sb->data->pdt_end);
+        CU_ASSERT_EQUAL(sa->data->pdt_discontinuity, sb->data->pdt_discontinuity);
+        CU_ASSERT_EQUAL(sa->data->discontinuity, sb->data->discontinuity);
+        CU_ASSERT_EQUAL(sa->data->byte_range.n, sb->data->byte_range.n);
+        CU_ASSERT_EQUAL(sa->data->byte_range.o, sb->data->byte_range.o);
+        assert_string_equal(sa->data->title, sb->data->title, __func__, __LINE__);
+        assert_string_equal(sa->data->uri, sb->data->uri, __func__, __LINE__);
+        sa = sa->next;
+        sb = sb->next;
+    }
+
+    char *out_a = NULL, *out_b = NULL;
+    int size_a = 0, size_b = 0;
+    CU_ASSERT_EQUAL(hlswrite_media(&out_a, &size_a, a), HLS_OK);
+    CU_ASSERT_EQUAL(hlswrite_media(&out_b, &size_b, b), HLS_OK);
+    assert_string_equal(out_a, out_b, __func__, __LINE__);
+    hls_free(out_a);
+    hls_free(out_b);
+}
+
+void tail_matches_window_test(void)
+{
+    int count;
+    for(count = 1; count <= 10; ++count) {
+        media_playlist_t window, tail;
+
+        // a full parse trimmed to the same number of segments
+        hlsparse_media_playlist_init(&window);
+        window.window_size = count;
+        hlsparse_media_playlist(tail_src, strlen(tail_src), &window);
+
+        hlsparse_media_playlist_init(&tail);
+        tail.tail_segments = count;
+        int res = hlsparse_media_playlist(tail_src, strlen(tail_src), &tail);
+        CU_ASSERT_EQUAL(res, strlen(tail_src));
+
+        assert_playlist_equal(&window, &tail);
+
+        hlsparse_media_playlist_term(&window);
+        hlsparse_media_playlist_term(&tail);
+    }
+}
+
+void tail_context_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.tail_segments = 2;
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &playlist);
+
+    CU_ASSERT_EQUAL(playlist.nb_segments, 2);
+    CU_ASSERT_EQUAL(playlist.media_sequence, 106);
+    CU_ASSERT_EQUAL(playlist.discontinuity_sequence, 3);
+    CU_ASSERT_EQUAL(playlist.target_duration, 10.f);
+    CU_ASSERT_EQUAL(playlist.version, 6);
+    CU_ASSERT_EQUAL(playlist.end_list, HLS_TRUE);
+    CU_ASSERT_EQUAL(playlist.duration, 20.f);
+
+    // the key and map in use carry over from the skipped segments
+    CU_ASSERT_EQUAL(playlist.nb_keys, 1);
+    CU_ASSERT_EQUAL(playlist.nb_maps, 1);
+    assert_string_equal(playlist.keys.data->uri, "key1.bin", __func__, __LINE__);
+    assert_string_equal(playlist.maps.data->uri, "init1.mp4", __func__, __LINE__);
+
+    segment_t *seg = playlist.segments.data;
+    CU_ASSERT_EQUAL(seg->sequence_num, 6);
+    CU_ASSERT_EQUAL(seg->key_index, 0);
+    CU_ASSERT_EQUAL(seg->map_index, 0);
+    CU_ASSERT_EQUAL(seg->pdt, 1512846060000);
+    CU_ASSERT_EQUAL(seg->pdt_discontinuity, HLS_TRUE);
+    assert_string_equal(seg->title, "six", __func__, __LINE__);
+    assert_string_equal(playlist.dateranges.data->id, "ad2", __func__, __LINE__);
+
+    seg = playlist.segments.next->data;
+    CU_ASSERT_EQUAL(seg->sequence_num, 7);
+    CU_ASSERT_EQUAL(seg->pdt, 1512846070000);
+    CU_ASSERT_EQUAL(seg->pdt_discontinuity, HLS_FALSE);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void tail_short_playlist_test(void)
+{
+    media_playlist_t full, tail;
+
+    hlsparse_media_playlist_init(&full);
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &full);
+
+    // asking for more segments than there are parses the whole playlist
+    hlsparse_media_playlist_init(&tail);
+    tail.tail_segments = 8;
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &tail);
+    assert_playlist_equal(&full, &tail);
+    hlsparse_media_playlist_term(&tail);
+
+    hlsparse_media_playlist_init(&tail);
+    tail.tail_segments = 100;
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &tail);
+    assert_playlist_equal(&full, &tail);
+    hlsparse_media_playlist_term(&tail);
+
+    hlsparse_media_playlist_term(&full);
+}
+
+void tail_allocs_test(void)
+{
+    hlsparse_alloc_stats_t full_stats, tail_stats;
+    media_playlist_t playlist;
+
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_alloc_stats_reset();
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &playlist);
+    hlsparse_alloc_stats(&full_stats);
+    hlsparse_media_playlist_term(&playlist);
+
+    hlsparse_media_playlist_init(&playlist);
+    playlist.tail_segments = 1;
+    hlsparse_alloc_stats_reset();
+    hlsparse_media_playlist(tail_src, strlen(tail_src), &playlist);
+    hlsparse_alloc_stats(&tail_stats);
+    hlsparse_media_playlist_term(&playlist);
+
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    CU_ASSERT(tail_stats.nb_allocs * 4 < full_stats.nb_allocs);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("tail", NULL, NULL);
+    test("tail_matches_window", tail_matches_window_test);
+    test("tail_context", tail_context_test);
+    test("tail_short_playlist", tail_short_playlist_test);
+    test("tail_allocs", tail_allocs_test);
+}
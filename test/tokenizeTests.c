@@ -0,0 +1,143 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+#define MAX_TOKENS  16
+
+typedef struct {
+    int nb;
+    char names[MAX_TOKENS][128];
+    char values[MAX_TOKENS][256];
+} tokens_t;
+
+static void collect(const attr_token_t *token, void *user)
+{
+    tokens_t *tokens = (tokens_t*)user;
+    if(tokens->nb < MAX_TOKENS) {
+        snprintf(tokens->names[tokens->nb], sizeof(tokens->names[0]), "%.*s", (int)token->name_size, token->name);
+        snprintf(tokens->values[tokens->nb], sizeof(tokens->values[0]), "%.*s", (int)token->value_size, token->value);
+    }
+    ++tokens->nb;
+}
+
+static int tokenize(const char *src, size_t size, tokens_t *tokens)
+{
+    memset(tokens, 0, sizeof(*tokens));
+    return tokenize_attributes(src, size, collect, tokens);
+}
+
+void tokenize_spans_test(void)
+{
+    tokens_t tokens;
+
+    // the first name starts with the tag's, commas and equals signs in
+    // quoted-strings belong to the value
+    const char *src = "#EXT-X-STREAM-INF:BANDWIDTH=900000,CODECS=\"mp4a.40.2,avc1.4d401e\",PATHWAY-ID=\"a=b\",AUDIO=\"aac\"\r\nnext.m3u8\n";
+    CU_ASSERT_EQUAL(tokenize(src, strlen(src), &tokens), strchr(src, '\r') - src);
+    CU_ASSERT_EQUAL(tokens.nb, 4);
+    CU_ASSERT_STRING_EQUAL(tokens.names[0], "#EXT-X-STREAM-INF:BANDWIDTH");
+    CU_ASSERT_STRING_EQUAL(tokens.values[0], "900000");
+    CU_ASSERT_STRING_EQUAL(tokens.names[1], "CODECS");
+    CU_ASSERT_STRING_EQUAL(tokens.values[1], "\"mp4a.40.2,avc1.4d401e\"");
+    CU_ASSERT_STRING_EQUAL(tokens.names[2], "PATHWAY-ID");
+    CU_ASSERT_STRING_EQUAL(tokens.values[2], "\"a=b\"");
+    CU_ASSERT_STRING_EQUAL(tokens.names[3], "AUDIO");
+    CU_ASSERT_STRING_EQUAL(tokens.values[3], "\"aac\"");
+
+    // the list stops at the size, anything without an '=' isn't an attribute
+    src = "METHOD=NONE,,TRAILING,URI=\"key.bin\"";
+    CU_ASSERT_EQUAL(tokenize(src, 11, &tokens), 11);
+    CU_ASSERT_EQUAL(tokens.nb, 1);
+    CU_ASSERT_STRING_EQUAL(tokens.values[0], "NONE");
+    CU_ASSERT_EQUAL(tokenize(src, strlen(src), &tokens), strlen(src));
+    CU_ASSERT_EQUAL(tokens.nb, 2);
+    CU_ASSERT_STRING_EQUAL(tokens.names[1], "URI");
+
+    CU_ASSERT_EQUAL(tokenize("", 1, &tokens), 0);
+    CU_ASSERT_EQUAL(tokens.nb, 0);
+    CU_ASSERT_EQUAL(tokenize_attributes(NULL, 10, collect, &tokens), 0);
+}
+
+void tokenize_blocks_test(void)
+{
+    tokens_t tokens;
+    char src[512];
+    char codecs[256];
+    char name[64];
+    int i;
+
+    // a quoted-string running across the 64 byte blocks with a comma and an
+    // equals sign at every offset
+    for(i = 0; i < 200; ++i) {
+        codecs[i] = i % 7 == 0 ? ',' : (i % 11 == 0 ? '=' : 'a' + i % 26);
+    }
+    codecs[i] = '\0';
+    memset(name, 'A', sizeof(name));
+
+    for(i = 0; i < 64; ++i) {
+        int len = snprintf(src, sizeof(src), "X%.*s=1,CODECS=\"%s\",VIDEO=\"v\"\n", i, name, codecs);
+        CU_ASSERT_EQUAL(tokenize(src, sizeof(src), &tokens), len - 1);
+        CU_ASSERT_EQUAL(tokens.nb, 3);
+        CU_ASSERT_EQUAL(strlen(tokens.names[0]), (size_t)i + 1);
+        CU_ASSERT_EQUAL(strlen(tokens.values[1]), strlen(codecs) + 2);
+        CU_ASSERT_STRING_EQUAL(tokens.names[2], "VIDEO");
+        CU_ASSERT_STRING_EQUAL(tokens.values[2], "\"v\"");
+    }
+
+    // an unterminated quoted-string ends with the line
+    const char *open = "URI=\"abc,DEF=1\nURI=\"x\"";
+    CU_ASSERT_EQUAL(tokenize(open, strlen(open), &tokens), strchr(open, '\n') - open);
+    CU_ASSERT_EQUAL(tokens.nb, 1);
+    CU_ASSERT_STRING_EQUAL(tokens.values[0], "\"abc,DEF=1");
+}
+
+void tokenize_parse_test(void)
+{
+    // a CODECS string longer than a block, parsed through the schema
+    const char *src = "#EXT-X-STREAM-INF:CODECS=\"avc1.640028,hvc1.2.4.L123.B0,mp4a.40.2,ec-3,dvh1.05.06,stpp.ttml.im1t\",BANDWIDTH=5000000,CLOSED-CAPTIONS=NONE\n";
+    stream_inf_t stream_inf;
+    hlsparse_stream_inf_init(&stream_inf);
+    CU_ASSERT_EQUAL(parse_stream_inf(src, strlen(src), &stream_inf), strlen(src) - 1);
+    CU_ASSERT_STRING_EQUAL(stream_inf.codecs, "avc1.640028,hvc1.2.4.L123.B0,mp4a.40.2,ec-3,dvh1.05.06,stpp.ttml.im1t");
+    CU_ASSERT_EQUAL(stream_inf.bandwidth, 5000000.f);
+    CU_ASSERT_STRING_EQUAL(stream_inf.closed_captions, NONE);
+    hlsparse_stream_inf_term(&stream_inf);
+
+    // only the selected fields are written
+    hlsparse_stream_inf_init(&stream_inf);
+    CU_ASSERT_EQUAL(parse_stream_inf_fields(src, strlen(src), &stream_inf, STREAM_INF_ATTR_BANDWIDTH), strlen(src) - 1);
+    CU_ASSERT_EQUAL(stream_inf.codecs, NULL);
+    CU_ASSERT_EQUAL(stream_inf.bandwidth, 5000000.f);
+    hlsparse_stream_inf_term(&stream_inf);
+
+    // an empty quoted-string leaves the value unset
+    session_data_t session_data;
+    hlsparse_session_data_init(&session_data);
+    const char *data_src = "DATA-ID=\"com.example\",VALUE=\"\",LANGUAGE=\"en\"\r\n";
+    CU_ASSERT_EQUAL(parse_session_data(data_src, strlen(data_src), &session_data), strlen(data_src) - 2);
+    CU_ASSERT_STRING_EQUAL(session_data.data_id, "com.example");
+    CU_ASSERT_EQUAL(session_data.value, NULL);
+    CU_ASSERT_STRING_EQUAL(session_data.language, "en");
+    hlsparse_session_data_term(&session_data);
+
+    // without a destination the line is only stepped over
+    const char *map_src = "URI=\"init.mp4\",BYTERANGE=\"720@0\"\n";
+    CU_ASSERT_EQUAL(parse_map(map_src, strlen(map_src), NULL), strlen(map_src) - 1);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("tokenize", NULL, NULL);
+    test("tokenize_spans", tokenize_spans_test);
+    test("tokenize_blocks", tokenize_blocks_test);
+    test("tokenize_parse", tokenize_parse_test);
+}
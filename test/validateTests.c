@@ -0,0 +1,334 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_VIOLATIONS  4096
+
+typedef struct {
+    violation_t violations[MAX_VIOLATIONS];
+    int         count;
+} violations_t;
+
+static void collect(const violation_t *violation, void *user)
+{
+    violations_t *collected = user;
+    if(collected->count < MAX_VIOLATIONS) {
+        collected->violations[collected->count++] = *violation;
+    }
+}
+
+static int compare_offsets(const void *a, const void *b)
+{
+    const violation_t *va = a, *vb = b;
+    if(va->offset != vb->offset) {
+        return va->offset < vb->offset ? -1 : 1;
+    }
+    return va->rule - vb->rule;
+}
+
+static void validate(const char *src, violations_t *collected, int nb_threads)
+{
+    playlist_validation_t validation;
+    hlsparse_validation_init(&validation);
+    validation.callback = collect;
+    validation.user = collected;
+    validation.nb_threads = nb_threads;
+
+    memset(collected, 0, sizeof(violations_t));
+    CU_ASSERT_EQUAL(hlsparse_validate(src, strlen(src), &validation), HLS_OK);
+    CU_ASSERT_EQUAL(validation.nb_violations, collected->count);
+    qsort(collected->violations, collected->count, sizeof(violation_t), compare_offsets);
+}
+
+static void assert_violation(violations_t *collected, int index, int rule, const char *src, const char *line)
+{
+    CU_ASSERT(index < collected->count);
+    if(index < collected->count) {
+        CU_ASSERT_EQUAL(collected->violations[index].rule, rule);
+        CU_ASSERT_EQUAL(collected->violations[index].offset, strstr(src, line) - src);
+    }
+}
+
+const char *validate_media_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:6\n"\
+"#EXT-X-TARGETDURATION:10\n"\
+"#EXT-X-MEDIA-SEQUENCE:100\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"key0.bin\",IV=0x00000000000000000000000000000001\n"\
+"#EXT-X-MAP:URI=\"init0.mp4\"\n"\
+"#EXTINF:10.000,zero\n"\
+"segment0.ts\n"\
+"#EXT-X-BYTERANGE:1000@0\n"\
+"#EXTINF:9.500,one\n"\
+"segment1.ts\n"\
+"#EXT-X-BYTERANGE:1000\n"\
+"#EXTINF:9.500,\n"\
+"segment1.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T17:00:00.000Z\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",CLASS=\"ad\",START-DATE=\"2017-12-09T17:00:15.000Z\",END-DATE=\"2017-12-09T17:00:35.000Z\",DURATION=20.0\n"\
+"#EXTINF:10.000,two\r\n"\
+"segment2.ts\r\n"\
+"#EXT-X-KEY:METHOD=NONE\n"\
+"#EXT-X-DATERANGE:ID=\"next\",CLASS=\"ad\",START-DATE=\"2017-12-09T17:00:20.000Z\",END-ON-NEXT=YES\n"\
+"#EXT-X-CUSTOM-TAG:1\n"\
+"#EXTINF:10.400,three\n"\
+"segment3.ts\n"\
+"#EXT-X-ENDLIST\n";
+
+const char *validate_master_src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\",NAME=\"English\"\n"\
+"#EXT-X-MEDIA:TYPE=CLOSED-CAPTIONS,GROUP-ID=\"cc\",NAME=\"English\",INSTREAM-ID=\"CC1\"\n"\
+"#EXT-X-SESSION-KEY:METHOD=AES-128,URI=\"key.bin\"\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=900000,AUDIO=\"aac\",CLOSED-CAPTIONS=\"cc\"\n"\
+"900.m3u8\n"\
+"#EXT-X-STREAM-INF:BANDWIDTH=1500000,AUDIO=\"aac\",CLOSED-CAPTIONS=NONE\n"\
+"1500.m3u8\n"\
+"#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,URI=\"iframe.m3u8\"\n";
+
+void validate_valid_test(void)
+{
+    violations_t collected;
+
+    validate(validate_media_src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 0);
+
+    validate(validate_master_src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 0);
+
+    playlist_validation_t validation;
+    hlsparse_validation_init(&validation);
+    CU_ASSERT_EQUAL(hlsparse_validate(validate_master_src, strlen(validate_master_src), &validation), HLS_OK);
+    CU_ASSERT_EQUAL(validation.master, HLS_TRUE);
+    CU_ASSERT_EQUAL(validation.violations, 0);
+
+    CU_ASSERT_EQUAL(hlsparse_validate(NULL, 0, &validation), HLS_ERROR);
+    CU_ASSERT_EQUAL(hlsparse_validate(validate_media_src, 0, NULL), HLS_ERROR);
+    CU_ASSERT_EQUAL(hlsparse_validation_init(NULL), HLS_ERROR);
+}
+
+void validate_media_rules_test(void)
+{
+    violations_t collected;
+    const char *src = "#EXT-X-VERSION:6\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n"\
+    "#EXT-X-KEY:METHOD=AES-128\n"\
+    "#EXT-X-MAP:BYTERANGE=\"100@0\"\n"\
+    "#EXTINF:10.600,long\n"\
+    "segment0.ts\n"\
+    "#EXT-X-MEDIA-SEQUENCE:5\n"\
+    "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:40.000Z\n"\
+    "#EXT-X-BYTERANGE:1000\n"\
+    "#EXTINF:10.000,\n"\
+    "segment1.ts\n"\
+    "#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:10:00.000Z\",END-DATE=\"2017-12-09T18:09:00.000Z\"\n"\
+    "#EXT-X-KEY:METHOD=NONE,URI=\"key.bin\"\n"\
+    "#EXTINF:9.000,\n"\
+    "#EXT-X-STREAM-INF:BANDWIDTH=900000\n"\
+    "#EXTINF:10.000,\n"\
+    "segment2.ts\n"\
+    "stray.ts\n"\
+    "#EXTINF:8.000,\n";
+
+    validate(src, &collected, 0);
+
+    CU_ASSERT_EQUAL(collected.count, 13);
+    assert_violation(&collected, 0, VIOLATION_EXTM3U, src, "#EXT-X-VERSION");
+    assert_violation(&collected, 1, VIOLATION_TARGET_DURATION, src, "#EXT-X-VERSION");
+    assert_violation(&collected, 2, VIOLATION_KEY, src, "#EXT-X-KEY:METHOD=AES-128");
+    assert_violation(&collected, 3, VIOLATION_MAP, src, "#EXT-X-MAP");
+    assert_violation(&collected, 4, VIOLATION_MEDIA_SEQUENCE, src, "#EXT-X-MEDIA-SEQUENCE");
+    assert_violation(&collected, 5, VIOLATION_PDT_ORDER, src, "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:40");
+    assert_violation(&collected, 6, VIOLATION_BYTE_RANGE, src, "#EXT-X-BYTERANGE");
+    assert_violation(&collected, 7, VIOLATION_DATERANGE, src, "#EXT-X-DATERANGE");
+    assert_violation(&collected, 8, VIOLATION_KEY, src, "#EXT-X-KEY:METHOD=NONE");
+    assert_violation(&collected, 9, VIOLATION_URI, src, "#EXTINF:9.000");
+    assert_violation(&collected, 10, VIOLATION_MIXED_TAGS, src, "#EXT-X-STREAM-INF");
+    assert_violation(&collected, 11, VIOLATION_URI, src, "stray.ts");
+    assert_violation(&collected, 12, VIOLATION_URI, src, "#EXTINF:8.000");
+
+    // a target duration makes segments longer than it a violation
+    src = "#EXTM3U\n#EXT-X-TARGETDURATION:10\n#EXTINF:10.499,\na.ts\n#EXTINF:10.500,\nb.ts\n";
+    validate(src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 1);
+    assert_violation(&collected, 0, VIOLATION_EXTINF_DURATION, src, "#EXTINF:10.500");
+
+    // and the duration is rounded from a double, as a float 10.49999999 is 10.5
+    src = "#EXTM3U\n#EXT-X-TARGETDURATION:10\n#EXTINF:10.49999999,\na.ts\n";
+    validate(src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 0);
+
+    // dateranges need a program date time somewhere in the playlist
+    src = "#EXTM3U\n#EXT-X-TARGETDURATION:10\n#EXTINF:10,\na.ts\n"\
+          "#EXT-X-DATERANGE:ID=\"a\",START-DATE=\"2017-12-09T18:10:00.000Z\",DURATION=-1\n#EXTINF:10,\nb.ts\n";
+    validate(src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 2);
+    assert_violation(&collected, 0, VIOLATION_DATERANGE, src, "#EXT-X-DATERANGE");
+    assert_violation(&collected, 1, VIOLATION_DATERANGE_PDT, src, "#EXT-X-DATERANGE");
+}
+
+void validate_key_iv_test(void)
+{
+    violations_t collected;
+    const char *ivs[] = {
+        "0x0102",
+        "0x000000000000000000000000000000010",
+        "0x0000000000000000000000000000000G",
+        "00000000000000000000000000000000001",
+    };
+    char src[512];
+    int i;
+
+    // only a 128 bit hexadecimal-sequence is an IV
+    for(i = 0; i < (int)(sizeof(ivs) / sizeof(ivs[0])); ++i) {
+        snprintf(src, sizeof(src), "#EXTM3U\n#EXT-X-TARGETDURATION:10\n"\
+                 "#EXT-X-KEY:METHOD=AES-128,URI=\"key.bin\",IV=%s\n#EXTINF:10,\na.ts\n", ivs[i]);
+        validate(src, &collected, 0);
+        CU_ASSERT_EQUAL(collected.count, 1);
+        assert_violation(&collected, 0, VIOLATION_KEY, src, "#EXT-X-KEY");
+    }
+
+    snprintf(src, sizeof(src), "#EXTM3U\n#EXT-X-TARGETDURATION:10\n"\
+             "#EXT-X-KEY:METHOD=SAMPLE-AES-CTR,URI=\"key.bin\",IV=0X0123456789abcdefABCDEF0123456789\n#EXTINF:10,\na.ts\n");
+    validate(src, &collected, 0);
+    CU_ASSERT_EQUAL(collected.count, 0);
+}
+
+void validate_daterange_test(void)
+{
+    violations_t collected;
+    const char *ranges[] = {
+        "ID=\"a\",START-DATE=\"2017-12-09T18:10:00.000Z\",DURATION=10,END-DATE=\"2017-12-09T18:10:20.000Z\"",
+        "START-DATE=\"2017-12-09T18:10:00.000Z\"",
+        "ID=\"a\"",
+        "ID=\"a\",START-DATE=\"2017-12-09T18:10:00.000Z\",PLANNED-DURATION=-5",
+        "ID=\"a\",START-DATE=\"2017-12-09T18:10:00.000Z\",END-ON-NEXT=YES",
+        "ID=\"a\",CLASS=\"c\",START-DATE=\"2017-12-09T18:10:00.000Z\",END-ON-NEXT=YES,DURATION=1",
+    };
+    char src[512];
+    int i;
+
+    for(i = 0; i < (int)(sizeof(ranges) / sizeof(ranges[0])); ++i) {
+        snprintf(src, sizeof(src), "#EXTM3U\n#EXT-X-TARGETDURATION:10\n"\
+                 "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n#EXT-X-DATERANGE:%s\n#EXTINF:10,\na.ts\n", ranges[i]);
+        validate(src, &collected, 0);
+        CU_ASSERT_EQUAL(collected.count, 1);
+        assert_violation(&collected, 0, VIOLATION_DATERANGE, src, "#EXT-X-DATERANGE");
+    }
+}
+
+void validate_master_rules_test(void)
+{
+    violations_t collected;
+    const char *src = "#EXTM3U\n"\
+    "#EXT-X-MEDIA:TYPE=AUDIO,URI=\"audio.m3u8\",GROUP-ID=\"aac\"\n"\
+    "#EXT-X-MEDIA:TYPE=CLOSED-CAPTIONS,GROUP-ID=\"cc\",NAME=\"English\",URI=\"cc.m3u8\"\n"\
+    "#EXT-X-STREAM-INF:AUDIO=\"aac\"\n"\
+    "900.m3u8\n"\
+    "#EXT-X-STREAM-INF:BANDWIDTH=1500000,AUDIO=\"mp3\",SUBTITLES=\"subs\"\n"\
+    "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000\n"\
+    "#EXT-X-TARGETDURATION:10\n"\
+    "stray.m3u8\n";
+
+    validate(src, &collected, 0);
+
+    CU_ASSERT_EQUAL(collected.count, 9);
+    assert_violation(&collected, 0, VIOLATION_MEDIA, src, "#EXT-X-MEDIA:TYPE=AUDIO");
+    assert_violation(&collected, 1, VIOLATION_MEDIA, src, "#EXT-X-MEDIA:TYPE=CLOSED-CAPTIONS");
+    assert_violation(&collected, 2, VIOLATION_STREAM_INF, src, "#EXT-X-STREAM-INF:AUDIO");
+    assert_violation(&collected, 3, VIOLATION_URI, src, "#EXT-X-STREAM-INF:BANDWIDTH=1500000");
+    assert_violation(&collected, 4, VIOLATION_GROUP, src, "#EXT-X-STREAM-INF:BANDWIDTH=1500000");
+    assert_violation(&collected, 5, VIOLATION_GROUP, src, "#EXT-X-STREAM-INF:BANDWIDTH=1500000");
+    assert_violation(&collected, 6, VIOLATION_STREAM_INF, src, "#EXT-X-I-FRAME-STREAM-INF");
+    assert_violation(&collected, 7, VIOLATION_MIXED_TAGS, src, "#EXT-X-TARGETDURATION");
+    assert_violation(&collected, 8, VIOLATION_URI, src, "stray.m3u8");
+}
+
+void validate_threads_test(void)
+{
+    // large enough to be split between every thread
+    const int nb_segments = 40000;
+    size_t size = nb_segments * 128;
+    char *src = malloc(size);
+    char *pt = src;
+    int i;
+
+    pt += sprintf(pt, "#EXTM3U\n#EXT-X-TARGETDURATION:10\n#EXT-X-MEDIA-SEQUENCE:0\n");
+    for(i = 0; i < nb_segments; ++i) {
+        // program date times on every third segment, stepping back now and then
+        if(i % 3 == 0) {
+            int seconds = (i * 10 - (i % 999 == 0 ? 30 : 0)) + 100;
+            pt += sprintf(pt, "#EXT-X-PROGRAM-DATE-TIME:2017-12-09T%02d:%02d:%02d.000Z\n",
+                          seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+        }
+        if(i % 1013 == 0) {
+            pt += sprintf(pt, "#EXT-X-DISCONTINUITY\n");
+        }
+        // pairs of sub-ranges of one uri, with a broken pair now and then
+        if(i % 2 == 0) {
+            pt += sprintf(pt, "#EXT-X-BYTERANGE:1000@0\n#EXTINF:10.000,\nsegment%d.ts\n", i);
+        } else {
+            pt += sprintf(pt, "#EXT-X-BYTERANGE:1000\n#EXTINF:%s,\nsegment%d.ts\n",
+                          i % 4001 == 0 ? "11.000" : "10.000", i - (i % 1007 == 0 ? 0 : 1));
+        }
+    }
+    sprintf(pt, "#EXT-X-ENDLIST\n");
+
+    violations_t *single = malloc(sizeof(violations_t));
+    violations_t *threaded = malloc(sizeof(violations_t));
+    validate(src, single, 1);
+    CU_ASSERT(single->count > 50);
+
+    int nb_threads;
+    for(nb_threads = 2; nb_threads <= 8; nb_threads *= 2) {
+        validate(src, threaded, nb_threads);
+        CU_ASSERT_EQUAL(single->count, threaded->count);
+        CU_ASSERT_EQUAL(0, memcmp(single->violations, threaded->violations, single->count * sizeof(violation_t)));
+    }
+
+    free(single);
+    free(threaded);
+    free(src);
+}
+
+void validate_allocs_test(void)
+{
+    playlist_validation_t validation;
+    hlsparse_alloc_stats_t stats;
+
+    hlsparse_validation_init(&validation);
+    hlsparse_alloc_stats_enable(HLS_TRUE);
+    hlsparse_alloc_stats_reset();
+    hlsparse_validate(validate_media_src, strlen(validate_media_src), &validation);
+    hlsparse_validate(validate_master_src, strlen(validate_master_src), &validation);
+    hlsparse_alloc_stats(&stats);
+    hlsparse_alloc_stats_enable(HLS_FALSE);
+
+    CU_ASSERT_EQUAL(stats.nb_allocs, 0);
+    CU_ASSERT_EQUAL(hlsparse_violation_name(VIOLATION_PDT_ORDER)[0], 'p');
+    CU_ASSERT_EQUAL(hlsparse_violation_name(3), NULL);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("validate", NULL, NULL);
+    test("validate_valid", validate_valid_test);
+    test("validate_media_rules", validate_media_rules_test);
+    test("validate_key_iv", validate_key_iv_test);
+    test("validate_daterange", validate_daterange_test);
+    test("validate_master_rules", validate_master_rules_test);
+    test("validate_threads", validate_threads_test);
+    test("validate_allocs", validate_allocs_test);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2015 Joel Freeman and other contributors
+ * Released under the MIT license http://opensource.org/licenses/MIT
+ * see LICENSE included with package
+ */
+
+#include "hlsparse.h"
+#include "../src/parse.h"
+#include "tests.h"
+#include <CUnit/Basic.h>
+
+const char *live_head = "#EXTM3U\n"\
+"#EXT-X-VERSION:3\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:10\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"http://www.example.com/key0.key\"\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment10.ts\n"\
+"#EXT-X-DISCONTINUITY\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment11.ts\n"\
+"#EXT-X-KEY:METHOD=AES-128,URI=\"http://www.example.com/key1.key\"\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment12.ts\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment13.ts\n";
+
+const char *live_update = "#EXTINF:6.000,\n"\
+"http://www.example.com/segment14.ts\n"\
+"#EXTINF:6.000,\n"\
+"http://www.example.com/segment15.ts\n";
+
+void window_size_test(void)
+{
+    media_playlist_t playlist;
+    hlsparse_media_playlist_init(&playlist);
+    playlist.window_size = 2;
+    hlsparse_media_playlist(live_head, strlen(live_head), &playlist);
+
+    CU_ASSERT_EQUAL(playlist.nb_segments, 2);
+    CU_ASSERT_EQUAL(playlist.media_sequence, 12);
+    CU_ASSERT_EQUAL(playlist.discontinuity_sequence, 1);
+    CU_ASSERT_EQUAL(playlist.duration, 12);
+    assert_string_equal(playlist.segments.data->uri, "http://www.example.com/segment12.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(playlist.segments_tail->data, playlist.last_segment);
+
+    // the first key is no longer used
+    CU_ASSERT_EQUAL(playlist.nb_keys, 1);
+    assert_string_equal(playlist.keys.data->uri, "http://www.example.com/key1.key", __func__, __LINE__);
+    CU_ASSERT_EQUAL(playlist.segments.data->key_index, 0);
+    CU_ASSERT_EQUAL(playlist.last_segment->key_index, 0);
+
+    // the expired records are reused for the next segments
+    segment_t *recycled = playlist.free_segments->data;
+    CU_ASSERT_NOT_EQUAL(recycled, NULL);
+    hlsparse_media_playlist(live_update, strlen(live_update), &playlist);
+    CU_ASSERT_EQUAL(playlist.nb_segments, 2);
+    CU_ASSERT_EQUAL(playlist.media_sequence, 14);
+    CU_ASSERT_EQUAL(playlist.duration, 12);
+    assert_string_equal(playlist.segments.data->uri, "http://www.example.com/segment14.ts", __func__, __LINE__);
+    assert_string_equal(playlist.last_segment->uri, "http://www.example.com/segment15.ts", __func__, __LINE__);
+    CU_ASSERT_EQUAL(playlist.segments.data == recycled || playlist.last_segment == recycled, HLS_TRUE);
+    CU_ASSERT_EQUAL(playlist.last_segment->key_index, 0);
+
+    char *out = NULL;
+    int size = 0;
+    hlswrite_media(&out, &size, &playlist);
+    CU_ASSERT_NOT_EQUAL(strstr(out, "#EXT-X-MEDIA-SEQUENCE:14\n"), NULL);
+    CU_ASSERT_NOT_EQUAL(strstr(out, "#EXT-X-DISCONTINUITY-SEQUENCE:1\n"), NULL);
+    CU_ASSERT_NOT_EQUAL(strstr(out, "key1.key"), NULL);
+    CU_ASSERT_EQUAL(strstr(out, "segment13.ts"), NULL);
+    hls_free(out);
+
+    hlsparse_media_playlist_term(&playlist);
+}
+
+void window_duration_test(void)
+{
+    media_playlist_t playlist, previous;
+    hlsparse_media_playlist_init(&playlist);
+    hlsparse_media_playlist_init(&previous);
+    playlist.window_duration = 12;
+    hlsparse_media_playlist(live_head, strlen(live_head), &playlist);
+    hlsparse_media_playlist(live_head, strlen(live_head), &previous);
+
+    CU_ASSERT_EQUAL(playlist.nb_segments, 2);
+    CU_ASSERT_EQUAL(playlist.media_sequence, 12);
+
+    // expired playlists still line up with their previous version
+    media_playlist_diff_t diff;
+    hlsparse_media_playlist_diff_init(&diff);
+    hlsparse_media_playlist_diff(&previous, &playlist, &diff);
+    CU_ASSERT_EQUAL(diff.nb_expired, 2);
+    CU_ASSERT_EQUAL(diff.nb_unchanged, 2);
+    CU_ASSERT_EQUAL(diff.nb_appended, 0);
+    hlsparse_media_playlist_diff_term(&diff);
+
+    // the latest segment is never expired
+    playlist.window_duration = 1;
+    HLSCode res = hlsparse_media_playlist_expire(&playlist);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(playlist.nb_segments, 1);
+    CU_ASSERT_EQUAL(playlist.media_sequence, 13);
+    CU_ASSERT_EQUAL(playlist.segments.data, playlist.last_segment);
+    CU_ASSERT_EQUAL(playlist.segments_tail, &playlist.segments);
+
+    res = hlsparse_media_playlist_expire(NULL);
+    CU_ASSERT_EQUAL(res, HLS_ERROR);
+
+    hlsparse_media_playlist_term(&playlist);
+    hlsparse_media_playlist_term(&previous);
+}
+
+void setup(void)
+{
+    hlsparse_global_init();
+
+    suite("window", NULL, NULL);
+    test("window_size", window_size_test);
+    test("window_duration", window_duration_test);
+}
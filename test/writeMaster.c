@@ -104,6 +104,7 @@ void write_master_test(void)
     hls_key_t key;
     key.method = KEY_METHOD_AES128;
     key.iv = (char[]){0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0xE, 0x0F, 0x10};
+    key.iv_size = 16;
     key.uri = "http://www.example.com/keys/01.key";
     key.key_format = "identity";
     key.key_format_versions = "1/2/3";
@@ -120,7 +121,7 @@ void write_master_test(void)
 #EXT-X-VERSION:4\n\
 #EXT-X-INDEPENDENT-SEGMENTS\n\
 #EXT-X-START:TIME-OFFSET=-2.000,PRECISE=NO\n\
-#EXT-X-MEDIA:TYPE=VIDEO,GROUP-ID=\"group-one\",LANGUAGE=\"en-US\",ASSOC-LANGUAGE=\"en-US\",ASSOC-LANGUAGE=\"en-GB\",NAME=\"name\",DEFAULT=YES,AUTOSELECT=YES,FORCED=YES,INSTREAM-ID=\"CC3\",CHARACTERISTICS=\"public.accessibility.transcribes-spoken-dialog\",CHANNELS=\"6\"\n\
+#EXT-X-MEDIA:TYPE=VIDEO,GROUP-ID=\"group-one\",LANGUAGE=\"en-US\",ASSOC-LANGUAGE=\"en-GB\",NAME=\"name\",DEFAULT=YES,AUTOSELECT=YES,FORCED=YES,INSTREAM-ID=\"CC3\",CHARACTERISTICS=\"public.accessibility.transcribes-spoken-dialog\",CHANNELS=\"6\"\n\
 #EXT-X-STREAM-INF:BANDWIDTH=800000,AVERAGE-BANDWIDTH=780000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,FRAME-RATE=29.970,HDCP-LEVEL=NONE,AUDIO=\"group-one\",VIDEO=\"group-two\",SUBTITLES=\"group-three\",CLOSED-CAPTIONS=\"cc\"\n\
 http://www.example.com/variant_01.m3u8\n\
 #EXT-X-STREAM-INF:BANDWIDTH=1200000,AVERAGE-BANDWIDTH=1150000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=1280x720,FRAME-RATE=29.970,HDCP-LEVEL=TYPE-0,AUDIO=\"group-one\",VIDEO=\"group-two\",SUBTITLES=\"group-three\",CLOSED-CAPTIONS=\"cc\"\n\
@@ -162,6 +163,7 @@ void write_media_test(void)
     key_list_1.next = NULL;
     keys[0].method = KEY_METHOD_NONE;
     keys[1].iv = (char[]){0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10};
+    keys[1].iv_size = 16;
     keys[1].uri = "https://www.example.com/key0.key";
     keys[1].method = KEY_METHOD_AES128;
 
@@ -281,9 +283,11 @@ void write_media_test2(void)
     key_lists[1].next = NULL;
     keys[0].method = KEY_METHOD_AES128;
     keys[0].iv = (char[]){0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89};
+    keys[0].iv_size = 16;
     keys[0].uri = "https://key-service.com/key?id=123";
     keys[1].method = KEY_METHOD_AES128;
     keys[1].iv = (char[]){0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB};
+    keys[1].iv_size = 16;
     keys[1].uri = "https://key-service.com/key?id=124";
     keys[2].method = KEY_METHOD_NONE;
 
@@ -375,6 +379,179 @@ ADAP/00060/1001_ADAP_00004.ts\n\
 
     CU_ASSERT_EQUAL(strcmp(media_output, out), 0);
 }
+
+void write_media_map_daterange_test(void)
+{
+    // maps, dateranges and PDTs which don't follow on from the previous segment
+    // are written back out as they were parsed
+    const char *src = "#EXTM3U\n\
+#EXT-X-VERSION:6\n\
+#EXT-X-TARGETDURATION:6\n\
+#EXT-X-MEDIA-SEQUENCE:0\n\
+#EXT-X-DISCONTINUITY-SEQUENCE:0\n\
+#EXT-X-PLAYLIST-TYPE:VOD\n\
+#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:46.001Z\n\
+#EXT-X-MAP:URI=\"http://www.example.com/init0.mp4\",BYTERANGE=\"720@0\"\n\
+#EXTINF:6.000,\n\
+http://www.example.com/segment0.m4s\n\
+#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:55.923Z\n\
+#EXT-X-DATERANGE:ID=\"ad\",CLASS=\"com.example.ad\",START-DATE=\"2017-12-09T18:09:55.923Z\",PLANNED-DURATION=6.000,X-AD-ID=\"one\",SCTE35-OUT=0xFC00002F00\n\
+#EXTINF:6.000,\n\
+http://www.example.com/segment1.m4s\n\
+#EXT-X-MAP:URI=\"http://www.example.com/init1.mp4\"\n\
+#EXT-X-DISCONTINUITY\n\
+#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:10:01.923Z\n\
+#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:55.923Z\",END-DATE=\"2017-12-09T18:10:01.923Z\",DURATION=6.000,SCTE35-IN=0xFC00003000,END-ON-NEXT=YES\n\
+#EXTINF:6.000,\n\
+http://www.example.com/segment2.m4s\n\
+#EXT-X-ENDLIST\n";
+
+    media_playlist_t media;
+    hlsparse_media_playlist_init(&media);
+    hlsparse_media_playlist(src, strlen(src), &media);
+    CU_ASSERT_EQUAL(media.nb_maps, 2);
+    CU_ASSERT_EQUAL(media.nb_dateranges, 2);
+    CU_ASSERT_EQUAL(media.dateranges.data->start_date, 1512842995923);
+    CU_ASSERT_EQUAL(media.dateranges.data->scte35_out_size, 5);
+    CU_ASSERT_EQUAL(media.dateranges.data->scte35_out[2], 0);
+
+    char *out = NULL;
+    int size = 0;
+    HLSCode res = hlswrite_media(&out, &size, &media);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_EQUAL(strcmp(src, out), 0);
+
+    hls_free(out);
+    hlsparse_media_playlist_term(&media);
+}
+
+static void assert_media_written(const char *src, const char *expected, const char *func, int line)
+{
+    media_playlist_t media;
+    hlsparse_media_playlist_init(&media);
+    hlsparse_media_playlist(src, strlen(src), &media);
+
+    char *out = NULL;
+    int size = 0;
+    HLSCode res = hlswrite_media(&out, &size, &media);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    assert_string_equal(out, expected, func, line);
+
+    hls_free(out);
+    hlsparse_media_playlist_term(&media);
+}
+
+void write_media_map_test(void)
+{
+    // each EXT-X-MAP is written once, before the first segment it applies to
+    const char *src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:0\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:49.923Z\n"\
+"#EXT-X-MAP:URI=\"init0.mp4\",BYTERANGE=\"720@0\"\n"\
+"#EXTINF:6.000,\n"\
+"segment0.m4s\n"\
+"#EXTINF:6.000,\n"\
+"segment1.m4s\n"\
+"#EXT-X-MAP:URI=\"init1.mp4\"\n"\
+"#EXTINF:6.000,\n"\
+"segment2.m4s\n";
+
+    assert_media_written(src, src, __func__, __LINE__);
+}
+
+void write_media_daterange_test(void)
+{
+    // dateranges are written before the segment that followed them
+    const char *src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:0\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:49.923Z\n"\
+"#EXTINF:6.000,\n"\
+"segment0.ts\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:55.923Z\",DURATION=12.000,X-AD-ID=\"one\",SCTE35-OUT=0xFC0000\n"\
+"#EXT-X-DATERANGE:ID=\"ad\",START-DATE=\"2017-12-09T18:09:55.923Z\",END-DATE=\"2017-12-09T18:10:07.923Z\",SCTE35-IN=0xFC0001\n"\
+"#EXTINF:6.000,\n"\
+"segment1.ts\n";
+
+    assert_media_written(src, src, __func__, __LINE__);
+}
+
+void write_media_pdt_test(void)
+{
+    // a PDT is only written again where it doesn't follow on from the
+    // previous segment
+    const char *src = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:0\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:49.923Z\n"\
+"#EXTINF:6.000,\n"\
+"segment0.ts\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:55.923Z\n"\
+"#EXTINF:6.000,\n"\
+"segment1.ts\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:10:31.000Z\n"\
+"#EXTINF:6.000,\n"\
+"segment2.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment3.ts\n";
+
+    const char *expected = "#EXTM3U\n"\
+"#EXT-X-VERSION:7\n"\
+"#EXT-X-TARGETDURATION:6\n"\
+"#EXT-X-MEDIA-SEQUENCE:0\n"\
+"#EXT-X-DISCONTINUITY-SEQUENCE:0\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:09:49.923Z\n"\
+"#EXTINF:6.000,\n"\
+"segment0.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment1.ts\n"\
+"#EXT-X-PROGRAM-DATE-TIME:2017-12-09T18:10:31.000Z\n"\
+"#EXTINF:6.000,\n"\
+"segment2.ts\n"\
+"#EXTINF:6.000,\n"\
+"segment3.ts\n";
+
+    assert_media_written(src, expected, __func__, __LINE__);
+}
+
+void write_key_iv_size_test(void)
+{
+    // a key built before iv_size existed leaves it 0, its IV is 128 bits
+    master_t master;
+    hlsparse_master_init(&master);
+
+    hls_key_t key;
+    hlsparse_key_init(&key);
+    key.method = KEY_METHOD_AES128;
+    key.uri = "http://www.example.com/keys/01.key";
+    key.iv = (char[]){0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10};
+    master.session_keys.data = &key;
+
+    char *out = NULL;
+    int size = 0;
+    HLSCode res = hlswrite_master(&out, &size, &master);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(strstr(out, ",IV=0x0102030405060708090A0B0C0D0E0F10\n"), NULL);
+    CU_ASSERT_EQUAL(key_iv_size(&key), 16);
+    hls_free(out);
+
+    key.iv_size = 2;
+    res = hlswrite_master(&out, &size, &master);
+    CU_ASSERT_EQUAL(res, HLS_OK);
+    CU_ASSERT_NOT_EQUAL(strstr(out, ",IV=0x0102\n"), NULL);
+    hls_free(out);
+
+    key.iv = NULL;
+    CU_ASSERT_EQUAL(key_iv_size(&key), 0);
+}
+
 void setup()
 {
     hlsparse_global_init();
@@ -383,4 +560,9 @@ void setup()
     test("write_master", write_master_test);
     test("write_media", write_media_test);
     test("write_media", write_media_test2);
+    test("write_media_map_daterange", write_media_map_daterange_test);
+    test("write_media_map", write_media_map_test);
+    test("write_media_daterange", write_media_daterange_test);
+    test("write_media_pdt", write_media_pdt_test);
+    test("write_key_iv_size", write_key_iv_size_test);
 }
\ No newline at end of file